@@ -0,0 +1,1062 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshBuilder.cpp
+// ============
+// generate the vertices and indices of the basic 3D shapes on the CPU
+//
+//	The shapes are the ones ShapeMeshes has always drawn, written into
+//	MESH_DATA instead of being uploaded as they are generated.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshBuilder.h"
+
+#include <algorithm> // Required for std::max
+#include <array> // Required for std::array
+#include <cmath>  // Required for math functions like sqrt and cos
+#include <iostream>
+
+namespace
+{
+	constexpr double Pi = 3.141592653589793;
+
+	// clusters may cost up to 5% more vertices than the cache order
+	const float OVERDRAW_THRESHOLD = 1.05f;
+}
+
+///////////////////////////////////////////////////
+// BuildBox()
+//
+// Builds a box by specifying the vertices.  Normals
+// and texture coordinates are also set.
+//
+// The indices are a triangle list with one part for
+// each face, in the order of the vertices.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildBox(MESH_DATA& mesh)
+{
+	// Box vertex and index data
+	mesh.vertices = {
+		// Positions           // Normals          // Texture Coords
+		// Back Face
+		 0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   0.0f, 1.0f,  // 0
+		 0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   0.0f, 0.0f,  // 1
+		-0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   1.0f, 0.0f,  // 2
+		-0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   1.0f, 1.0f,  // 3
+		// Bottom Face
+		-0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,   0.0f, 1.0f,  // 4
+		-0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,   0.0f, 0.0f,  // 5
+		 0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,   1.0f, 0.0f,  // 6
+		 0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,   1.0f, 1.0f,  // 7
+		 // Left Face
+		-0.5f,  0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,   0.0f, 1.0f,  // 8
+		-0.5f, -0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,   0.0f, 0.0f,  // 9
+		-0.5f, -0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,   1.0f, 0.0f,  // 10
+		-0.5f,  0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,   1.0f, 1.0f,  // 11
+		// Right Face
+		 0.5f,  0.5f,  0.5f,   1.0f,  0.0f,  0.0f,   0.0f, 1.0f,  // 12
+		 0.5f, -0.5f,  0.5f,   1.0f,  0.0f,  0.0f,   0.0f, 0.0f,  // 13
+		 0.5f, -0.5f, -0.5f,   1.0f,  0.0f,  0.0f,   1.0f, 0.0f,  // 14
+		 0.5f,  0.5f, -0.5f,   1.0f,  0.0f,  0.0f,   1.0f, 1.0f,  // 15
+		// Top Face
+		-0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,   0.0f, 1.0f,  // 16
+		-0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,   0.0f, 0.0f,  // 17
+		 0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,   1.0f, 0.0f,  // 18
+		 0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,   1.0f, 1.0f,  // 19
+		// Front Face
+		-0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   0.0f, 1.0f,  // 20
+		-0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   0.0f, 0.0f,  // 21
+		 0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   1.0f, 0.0f,  // 22
+		 0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   1.0f, 1.0f   // 23
+	};
+
+	// Index data
+	mesh.indices = {
+			0, 1, 2, 0, 3, 2,       // Back Face
+			4, 5, 6, 4, 7, 6,       // Bottom Face
+			8, 9, 10, 8, 11, 10,    // Left Face
+			12, 13, 14, 12, 15, 14, // Right Face
+			16, 17, 18, 16, 19, 18, // Top Face
+			20, 21, 22, 20, 23, 22  // Front Face
+	};
+	mesh.partIndexCounts = { 6, 6, 6, 6, 6, 6 };
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildCone()
+//
+//	Builds a cone by specifying the vertices.  The
+//  normals and texture coordinates are also set.
+//
+//  The bottom fan and the side strip are turned
+//  into one triangle list, drawn in two parts:
+//
+//	bottom - fan of vertices 0 to numSlices + 1
+//	sides  - strip of numSlices * 2 vertices after it
+///////////////////////////////////////////////////
+void MeshBuilder::BuildCone(float radius, float height, int numSlices, MESH_DATA& mesh) {
+	std::vector<float>& vertices = mesh.vertices;
+	vertices.reserve((size_t)(numSlices * 3 + 4) * FLOATS_PER_VERTEX);
+
+	// Generate bottom circle vertices
+	float angleStep = 2.0f * Pi / numSlices;
+
+	// Center vertex of bottom circle
+	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
+
+	for (int i = 0; i <= numSlices; ++i) {
+		float angle = i * angleStep;
+		float x = radius * cos(angle);
+		float z = radius * sin(angle);
+		float u = 0.5f + 0.5f * cos(angle);
+		float v = 0.5f + 0.5f * sin(angle);
+		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, u, v });
+	}
+
+	// Generate side vertices
+	for (int i = 0; i <= numSlices; ++i) {
+		float angle = i * angleStep;
+		float x = radius * cos(angle);
+		float z = radius * sin(angle);
+		float nx = cos(angle);
+		float nz = sin(angle);
+
+		// Bottom vertex
+		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
+		// Apex vertex
+		vertices.insert(vertices.end(), { 0.0f, height, 0.0f, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
+	}
+
+	// Triangles of the bottom fan, then the side strip
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_FAN, 0, numSlices + 2, mesh.indices));
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, numSlices + 2, numSlices * 2, mesh.indices));
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildCylinder()
+//
+//	Builds a cylinder by specifying the vertices.  The
+//  normals and texture coordinates are also set.
+//
+//  The fans and the side strip are turned into one
+//  triangle list, drawn in three parts:
+//
+//	bottom - fan of vertices 0 to numSlices + 1
+//	top    - fan of the numSlices + 2 vertices after it
+//	sides  - strip of the (numSlices + 1) * 2 vertices after that
+///////////////////////////////////////////////////
+void MeshBuilder::BuildCylinder(float radius, float height, int numSlices, MESH_DATA& mesh) {
+	std::vector<float>& vertices = mesh.vertices;
+	vertices.reserve((size_t)(numSlices * 4 + 6) * FLOATS_PER_VERTEX);
+
+	// Generate bottom circle vertices
+	float angleStep = 2.0f * Pi / numSlices;
+
+	// Center vertex of bottom circle
+	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
+
+	for (int i = 0; i <= numSlices; ++i) {
+		float angle = i * angleStep;
+		float x = radius * cos(angle);
+		float z = radius * sin(angle);
+		float u = 0.5f + 0.5f * cos(angle);
+		float v = 0.5f + 0.5f * sin(angle);
+		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, u, v });
+	}
+
+	// Generate top circle vertices
+	vertices.insert(vertices.end(), { 0.0f, height, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f });
+
+	for (int i = 0; i <= numSlices; ++i) {
+		float angle = i * angleStep;
+		float x = radius * cos(angle);
+		float z = radius * sin(angle);
+		float u = 0.5f + 0.5f * cos(angle);
+		float v = 0.5f + 0.5f * sin(angle);
+		vertices.insert(vertices.end(), { x, height, z, 0.0f, 1.0f, 0.0f, u, v });
+	}
+
+	// Generate side vertices
+	for (int i = 0; i <= numSlices; ++i) {
+		float angle = i * angleStep;
+		float x = radius * cos(angle);
+		float z = radius * sin(angle);
+		float nx = cos(angle);
+		float nz = sin(angle);
+
+		// Bottom vertex
+		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
+		// Top vertex
+		vertices.insert(vertices.end(), { x, height, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
+	}
+
+	// Triangles of the bottom and top fans, then the side strip
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_FAN, 0, numSlices + 2, mesh.indices));
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_FAN, numSlices + 2, numSlices + 2, mesh.indices));
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, (numSlices + 2) * 2, (numSlices + 1) * 2, mesh.indices));
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildPlane()
+//
+//	Builds a plane by specifying the vertices.  The
+//  normals and texture coordinates are also set.
+//
+//  The indices are a triangle list of two triangles.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildPlane(float width, float height, MESH_DATA& mesh) {
+	// Half dimensions for centering the plane
+	float halfWidth = width / 2.0f;
+	float halfHeight = height / 2.0f;
+
+	// Vertex data: Positions, Normals, Texture Coords
+	mesh.vertices = {
+		// Vertex Positions       // Normals           // Texture Coords
+		-halfWidth, 0.0f, halfHeight,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,  // Bottom-left
+		 halfWidth, 0.0f, halfHeight,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,  // Bottom-right
+		 halfWidth, 0.0f, -halfHeight, 0.0f, 1.0f, 0.0f,  1.0f, 1.0f,  // Top-right
+		-halfWidth, 0.0f, -halfHeight, 0.0f, 1.0f, 0.0f,  0.0f, 1.0f   // Top-left
+	};
+
+	// Index data
+	mesh.indices = {
+		0, 1, 2,  // First triangle
+		0, 2, 3   // Second triangle
+	};
+	mesh.partIndexCounts = { (uint32_t)mesh.indices.size() };
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildPrism()
+//
+//	Builds a prism by specifying the vertices.  The
+//  vertices form one strip, which is turned into a
+//  triangle list.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildPrism(MESH_DATA& mesh)
+{
+	// Vertex data
+	const float verts[] = {
+		//Positions				//Normals
+		// ------------------------------------------------------
+
+		//Back Face				//Negative Z Normal  
+		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
+		0.5f, -0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
+		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
+		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
+		-0.5f,  0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
+		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
+
+		//Bottom Face			//Negative Y Normal
+		0.5f, -0.5f, -0.5f,		0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f,  0.0f,		1.0f, 0.0f,
+		0.0f, -0.5f,  0.5f,		0.0f, -1.0f,  0.0f,		0.5f, 1.0f,
+		-0.5f, -0.5f,  -0.5f,	0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
+
+		//Left Face/slanted		//Normals
+		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
+		-0.5f, 0.5f,  -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 1.0f,
+		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
+		0.0f, -0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 0.0f,
+		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
+
+		//Right Face/slanted	//Normals
+		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
+		0.5f, 0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 1.0f,
+		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
+		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
+		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
+		0.0f, -0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 0.0f,
+		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
+		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
+
+		//Top Face				//Positive Y Normal		//Texture Coords.
+		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
+		0.0f,  0.5f,  0.5f,		0.0f,  1.0f,  0.0f,		0.5f, 1.0f,
+		-0.5f,  0.5f, -0.5f,	0.0f,  1.0f,  0.0f,		1.0f, 0.0f,
+		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
+
+	};
+	mesh.vertices.assign(verts, verts + sizeof(verts) / sizeof(verts[0]));
+
+	// the vertices form one strip, turned into a triangle list
+	uint32_t vertexCount = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, 0, vertexCount, mesh.indices));
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+// BuildPyramid3()
+//
+// Dynamically builds a 3-sided pyramid by specifying
+// the vertices.  The normals and texture coordinates
+// are also set.
+//
+// The vertices form one strip, which is turned into
+// a triangle list.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildPyramid3(MESH_DATA& mesh)
+{
+	constexpr float halfBase = 0.5f; // Half the length of the base
+	constexpr float height = 0.5f;  // Height of the pyramid
+
+	// Define vertices programmatically
+	std::vector<float>& verts = mesh.vertices;
+
+	// Helper for normals
+	auto calculateNormal = [](float x1, float y1, float z1, float x2, float y2, float z2) -> std::array<float, 3> {
+		float nx = y1 * z2 - z1 * y2;
+		float ny = z1 * x2 - x1 * z2;
+		float nz = x1 * y2 - y1 * x2;
+		float length = sqrt(nx * nx + ny * ny + nz * nz);
+		return { nx / length, ny / length, nz / length };
+		};
+
+	// Define the pyramid faces with vertices and normals
+	struct Face {
+		std::array<float, 3> top;      // Top vertex
+		std::array<float, 3> bottom1; // First base vertex
+		std::array<float, 3> bottom2; // Second base vertex
+		std::array<float, 3> normal;  // Normal vector
+	};
+
+	std::vector<Face> faces = {
+		// Left face
+		{{0.0f, height, 0.0f}, {-halfBase, -height, halfBase}, {0.0f, -height, -halfBase},
+		 calculateNormal(-halfBase, -height - height, halfBase - 0.0f, 0.0f, -height - height, -halfBase - halfBase)},
+		 // Right face
+		 {{0.0f, height, 0.0f}, {0.0f, -height, -halfBase}, {halfBase, -height, halfBase},
+		  calculateNormal(0.0f, -height - height, -halfBase - 0.0f, halfBase, -height - height, halfBase - -halfBase)},
+		  // Front face
+		  {{0.0f, height, 0.0f}, {halfBase, -height, halfBase}, {-halfBase, -height, halfBase},
+		   calculateNormal(halfBase, -height - height, halfBase - 0.0f, -halfBase, -height - height, halfBase - halfBase)} };
+
+	for (const auto& face : faces)
+	{
+		// Top point
+		verts.insert(verts.end(), {
+			face.top[0], face.top[1], face.top[2],
+			face.normal[0], face.normal[1], face.normal[2],
+			0.5f, 1.0f });
+
+		// First base vertex
+		verts.insert(verts.end(), {
+			face.bottom1[0], face.bottom1[1], face.bottom1[2],
+			face.normal[0], face.normal[1], face.normal[2],
+			0.0f, 0.0f });
+
+		// Second base vertex
+		verts.insert(verts.end(), {
+			face.bottom2[0], face.bottom2[1], face.bottom2[2],
+			face.normal[0], face.normal[1], face.normal[2],
+			1.0f, 0.0f });
+	}
+
+	// Base (bottom face)
+	verts.insert(verts.end(), {
+		-halfBase, -height, halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+		halfBase, -height, halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f,
+		0.0f, -height, -halfBase, 0.0f, -1.0f, 0.0f, 0.5f, 0.0f });
+
+	uint32_t vertexCount = (uint32_t)(verts.size() / FLOATS_PER_VERTEX);
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, 0, vertexCount, mesh.indices));
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+// BuildPyramid4()
+//
+// Dynamically builds a 4-sided pyramid by specifying
+// vertices, normals, and texture coordinates.
+// The vertices form one strip, which is turned into
+// a triangle list.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildPyramid4(float baseSize, float height, MESH_DATA& mesh)
+{
+	float halfBase = baseSize / 2.0f;
+
+	// Vertex data container
+	std::vector<float>& verts = mesh.vertices;
+
+	// Helper lambda to add vertex data
+	auto addVertex = [&verts](float px, float py, float pz, float nx, float ny, float nz, float u, float v) {
+		verts.insert(verts.end(), { px, py, pz, nx, ny, nz, u, v });
+		};
+
+	// Helper for normal calculation
+	auto calculateNormal = [](float x1, float y1, float z1, float x2, float y2, float z2) -> std::array<float, 3> {
+		float nx = y1 * z2 - z1 * y2;
+		float ny = z1 * x2 - x1 * z2;
+		float nz = x1 * y2 - y1 * x2;
+		float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+		return { nx / length, ny / length, nz / length };
+		};
+
+	// Bottom face (flat quad)
+	addVertex(-halfBase, -halfBase, halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f);  // Front-left
+	addVertex(-halfBase, -halfBase, -halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f); // Back-left
+	addVertex(halfBase, -halfBase, -halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f);  // Back-right
+	addVertex(halfBase, -halfBase, halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f);   // Front-right
+
+	// Pyramid faces (triangular sides)
+	struct Face {
+		std::array<float, 3> top;
+		std::array<float, 3> bottomLeft;
+		std::array<float, 3> bottomRight;
+	};
+
+	std::vector<Face> faces = {
+		{{0.0f, height / 2.0f, 0.0f}, {-halfBase, -halfBase, -halfBase}, {-halfBase, -halfBase, halfBase}},  // Left face
+		{{0.0f, height / 2.0f, 0.0f}, {halfBase, -halfBase, -halfBase}, {-halfBase, -halfBase, -halfBase}}, // Back face
+		{{0.0f, height / 2.0f, 0.0f}, {halfBase, -halfBase, halfBase}, {halfBase, -halfBase, -halfBase}},   // Right face
+		{{0.0f, height / 2.0f, 0.0f}, {-halfBase, -halfBase, halfBase}, {halfBase, -halfBase, halfBase}}    // Front face
+	};
+
+	for (const auto& face : faces)
+	{
+		// Calculate normal for the face
+		auto normal = calculateNormal(
+			face.bottomRight[0] - face.bottomLeft[0], face.bottomRight[1] - face.bottomLeft[1],
+			face.bottomRight[2] - face.bottomLeft[2], face.top[0] - face.bottomLeft[0],
+			face.top[1] - face.bottomLeft[1], face.top[2] - face.bottomLeft[2]);
+
+		// Add vertices for the triangular face
+		addVertex(face.top[0], face.top[1], face.top[2], normal[0], normal[1], normal[2], 0.5f, 1.0f);         // Top vertex
+		addVertex(face.bottomLeft[0], face.bottomLeft[1], face.bottomLeft[2], normal[0], normal[1], normal[2], 0.0f, 0.0f); // Bottom-left
+		addVertex(face.bottomRight[0], face.bottomRight[1], face.bottomRight[2], normal[0], normal[1], normal[2], 1.0f, 0.0f); // Bottom-right
+	}
+
+	uint32_t vertexCount = (uint32_t)(verts.size() / FLOATS_PER_VERTEX);
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, 0, vertexCount, mesh.indices));
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+// BuildSphere()
+//
+// Dynamically builds a sphere with the given latitude
+// and longitude segment counts, including normals and
+// texture coordinates.  The triangles are drawn in two
+// parts, the top half of the sphere and the bottom half.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildSphere(int latitudeSegments, int longitudeSegments, float radius, MESH_DATA& mesh)
+{
+	std::vector<float>& vertices = mesh.vertices;
+	std::vector<uint32_t>& indices = mesh.indices;
+	vertices.reserve((size_t)(latitudeSegments + 1) * (longitudeSegments + 1) * FLOATS_PER_VERTEX);
+	indices.reserve((size_t)latitudeSegments * longitudeSegments * 6);
+
+	// Generate vertices, normals, and texture coordinates
+	for (int lat = 0; lat <= latitudeSegments; ++lat)
+	{
+		float theta = lat * Pi / latitudeSegments; // Latitude angle [0, PI]
+		float sinTheta = sin(theta);
+		float cosTheta = cos(theta);
+
+		for (int lon = 0; lon <= longitudeSegments; ++lon)
+		{
+			float phi = lon * 2 * Pi / longitudeSegments; // Longitude angle [0, 2*PI]
+			float sinPhi = sin(phi);
+			float cosPhi = cos(phi);
+
+			// Compute vertex position
+			float x = radius * sinTheta * cosPhi;
+			float y = radius * cosTheta;
+			float z = radius * sinTheta * sinPhi;
+
+			// Compute normal
+			float nx = sinTheta * cosPhi;
+			float ny = cosTheta;
+			float nz = sinTheta * sinPhi;
+
+			// Compute texture coordinates
+			float u = 1.0f - (float)lon / longitudeSegments;
+			float v = 1.0f - (float)lat / latitudeSegments;
+
+			// Push vertex data
+			vertices.insert(vertices.end(), { x, y, z, nx, ny, nz, u, v });
+		}
+	}
+
+	// Generate indices for GL_TRIANGLES
+	for (int lat = 0; lat < latitudeSegments; ++lat)
+	{
+		for (int lon = 0; lon < longitudeSegments; ++lon)
+		{
+			uint32_t first = lat * (longitudeSegments + 1) + lon;
+			uint32_t second = first + longitudeSegments + 1;
+
+			// Triangle 1
+			indices.insert(indices.end(), { first, second, first + 1 });
+
+			// Triangle 2
+			indices.insert(indices.end(), { second, second + 1, first + 1 });
+		}
+	}
+
+	// the first half of the indices is the half sphere
+	uint32_t halfIndices = (uint32_t)(indices.size() / 2) / 3 * 3;
+	mesh.partIndexCounts = { halfIndices, (uint32_t)indices.size() - halfIndices };
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildTaperedCylinder()
+//
+//	Builds a tapered cylinder by specifying the
+//  vertices.  The normals and texture coordinates
+//  are also set.
+//
+//  The fans and the side strip are turned into one
+//  triangle list, drawn in three parts:
+//
+//	bottom - fan of vertices 0 to 35
+//	top    - fan of the 72 vertices from 36
+//	sides  - strip of the 146 vertices from 72
+///////////////////////////////////////////////////
+void MeshBuilder::BuildTaperedCylinder(MESH_DATA& mesh)
+{
+	const float verts[] = {
+		// cylinder bottom		// normals			// texture coords
+		1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f,1.0f,
+		.98f, 0.0f, -0.17f,		0.0f, -1.0f, 0.0f,	0.41f, 0.983f,
+		.94f, 0.0f, -0.34f,		0.0f, -1.0f, 0.0f,	0.33f, 0.96f,
+		.87f, 0.0f, -0.5f,		0.0f, -1.0f, 0.0f,	0.25f, 0.92f,
+		.77f, 0.0f, -0.64f,		0.0f, -1.0f, 0.0f,	0.17f, 0.87f,
+		.64f, 0.0f, -0.77f,		0.0f, -1.0f, 0.0f,	0.13f, 0.83f,
+		.5f, 0.0f, -0.87f,		0.0f, -1.0f, 0.0f,	0.08f, 0.77f,
+		.34f, 0.0f, -0.94f,		0.0f, -1.0f, 0.0f,	0.04f, 0.68f,
+		.17f, 0.0f, -0.98f,		0.0f, -1.0f, 0.0f,	0.017f, 0.6f,
+		0.0f, 0.0f, -1.0f,		0.0f, -1.0f, 0.0f,	0.0f,0.5f,
+		-.17f, 0.0f, -0.98f,	0.0f, -1.0f, 0.0f,	0.017f, 0.41f,
+		-.34f, 0.0f, -0.94f,	0.0f, -1.0f, 0.0f,	0.04f, 0.33f,
+		-.5f, 0.0f, -0.87f,		0.0f, -1.0f, 0.0f,	0.08f, 0.25f,
+		-.64f, 0.0f, -0.77f,	0.0f, -1.0f, 0.0f,	0.13f, 0.17f,
+		-.77f, 0.0f, -0.64f,	0.0f, -1.0f, 0.0f,	0.17f, 0.13f,
+		-.87f, 0.0f, -0.5f,		0.0f, -1.0f, 0.0f,	0.25f, 0.08f,
+		-.94f, 0.0f, -0.34f,	0.0f, -1.0f, 0.0f,	0.33f, 0.04f,
+		-.98f, 0.0f, -0.17f,	0.0f, -1.0f, 0.0f,	0.41f, 0.017f,
+		-1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f, 0.0f,
+		-.98f, 0.0f, 0.17f,		0.0f, -1.0f, 0.0f,	0.6f, 0.017f,
+		-.94f, 0.0f, 0.34f,		0.0f, -1.0f, 0.0f,	0.68f, 0.04f,
+		-.87f, 0.0f, 0.5f,		0.0f, -1.0f, 0.0f,	0.77f, 0.08f,
+		-.77f, 0.0f, 0.64f,		0.0f, -1.0f, 0.0f,	0.83f, 0.13f,
+		-.64f, 0.0f, 0.77f,		0.0f, -1.0f, 0.0f,	0.87f, 0.17f,
+		-.5f, 0.0f, 0.87f,		0.0f, -1.0f, 0.0f,	0.92f, 0.25f,
+		-.34f, 0.0f, 0.94f,		0.0f, -1.0f, 0.0f,	0.96f, 0.33f,
+		-.17f, 0.0f, 0.98f,		0.0f, -1.0f, 0.0f,	0.983f, 0.41f,
+		0.0f, 0.0f, 1.0f,		0.0f, -1.0f, 0.0f,	1.0f, 0.5f,
+		.17f, 0.0f, 0.98f,		0.0f, -1.0f, 0.0f,	0.983f, 0.6f,
+		.34f, 0.0f, 0.94f,		0.0f, -1.0f, 0.0f,	0.96f, 0.68f,
+		.5f, 0.0f, 0.87f,		0.0f, -1.0f, 0.0f,	0.92f, 0.77f,
+		.64f, 0.0f, 0.77f,		0.0f, -1.0f, 0.0f,	0.87f, 0.83f,
+		.77f, 0.0f, 0.64f,		0.0f, -1.0f, 0.0f,	0.83f, 0.87f,
+		.87f, 0.0f, 0.5f,		0.0f, -1.0f, 0.0f,	0.77f, 0.92f,
+		.94f, 0.0f, 0.34f,		0.0f, -1.0f, 0.0f,	0.68f, 0.96f,
+		.98f, 0.0f, 0.17f,		0.0f, -1.0f, 0.0f,	0.6f, 0.983f,
+
+		// cylinder top			// normals			// texture coords
+		0.5f, 1.0f, 0.0f,		0.0f, 1.0f, 0.0f,	0.5f,1.0f,
+		.49f, 1.0f, -0.085f,	0.0f, 1.0f, 0.0f,	0.41f, 0.983f,
+		.47f, 1.0f, -0.17f,		0.0f, 1.0f, 0.0f,	0.33f, 0.96f,
+		.435f, 1.0f, -0.25f,	0.0f, 1.0f, 0.0f,	0.25f, 0.92f,
+		.385f, 1.0f, -0.32f,	0.0f, 1.0f, 0.0f,	0.17f, 0.87f,
+		.32f, 1.0f, -0.385f,	0.0f, 1.0f, 0.0f,	0.13f, 0.83f,
+		.25f, 1.0f, -0.435f,	0.0f, 1.0f, 0.0f,	0.08f, 0.77f,
+		.17f, 1.0f, -0.47f,		0.0f, 1.0f, 0.0f,	0.04f, 0.68f,
+		.085f, 1.0f, -0.49f,	0.0f, 1.0f, 0.0f,	0.017f, 0.6f,
+		0.0f, 1.0f, -0.5f,		0.0f, 1.0f, 0.0f,	0.0f,0.5f,
+		-.085f, 1.0f, -0.49f,	0.0f, 1.0f, 0.0f,	0.017f, 0.41f,
+		-.17f, 1.0f, -0.47f,	0.0f, 1.0f, 0.0f,	0.04f, 0.33f,
+		-.25f, 1.0f, -0.435f,	0.0f, 1.0f, 0.0f,	0.08f, 0.25f,
+		-.32f, 1.0f, -0.385f,	0.0f, 1.0f, 0.0f,	0.13f, 0.17f,
+		-.385f, 1.0f, -0.32f,	0.0f, 1.0f, 0.0f,	0.17f, 0.13f,
+		-.435f, 1.0f, -0.25f,	0.0f, 1.0f, 0.0f,	0.25f, 0.08f,
+		-.47f, 1.0f, -0.17f,	0.0f, 1.0f, 0.0f,	0.33f, 0.04f,
+		-.49f, 1.0f, -0.085f,	0.0f, 1.0f, 0.0f,	0.41f, 0.017f,
+		-0.5f, 1.0f, 0.0f,		0.0f, 1.0f, 0.0f,	0.5f, 0.0f,
+		-.49f, 1.0f, 0.085f,	0.0f, 1.0f, 0.0f,	0.6f, 0.017f,
+		-.47f, 1.0f, 0.17f,		0.0f, 1.0f, 0.0f,	0.68f, 0.04f,
+		-.435f, 1.0f, 0.25f,	0.0f, 1.0f, 0.0f,	0.77f, 0.08f,
+		-.385f, 1.0f, 0.32f,	0.0f, 1.0f, 0.0f,	0.83f, 0.13f,
+		-.32f, 1.0f, 0.385f,	0.0f, 1.0f, 0.0f,	0.87f, 0.17f,
+		-.25f, 1.0f, 0.435f,	0.0f, 1.0f, 0.0f,	0.92f, 0.25f,
+		-.17f, 1.0f, 0.47f,		0.0f, 1.0f, 0.0f,	0.96f, 0.33f,
+		-.085f, 1.0f, 0.49f,	0.0f, 1.0f, 0.0f,	0.983f, 0.41f,
+		0.0f, 1.0f, 0.5f,		0.0f, 1.0f, 0.0f,	1.0f, 0.5f,
+		.085f, 1.0f, 0.49f,		0.0f, 1.0f, 0.0f,	0.983f, 0.6f,
+		.17f, 1.0f, 0.47f,		0.0f, 1.0f, 0.0f,	0.96f, 0.68f,
+		.25f, 1.0f, 0.435f,		0.0f, 1.0f, 0.0f,	0.92f, 0.77f,
+		.32f, 1.0f, 0.385f,		0.0f, 1.0f, 0.0f,	0.87f, 0.83f,
+		.385f, 1.0f, 0.32f,		0.0f, 1.0f, 0.0f,	0.83f, 0.87f,
+		.435f, 1.0f, 0.25f,		0.0f, 1.0f, 0.0f,	0.77f, 0.92f,
+		.47f, 1.0f, 0.17f,		0.0f, 1.0f, 0.0f,	0.68f, 0.96f,
+		.49f, 1.0f, 0.085f,		0.0f, 1.0f, 0.0f,	0.6f, 0.983f,
+
+		// cylinder body		// normals							// texture coords
+		0.5f, 1.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f,	0.25,1.0,
+		1.0f, 0.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f,	0.0,0.0,
+		.98f, 0.0f, -0.17f,		0.993150651, 0.5f, -0.116841137f,	0.0277,0.0,
+		0.5f, 1.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f, 	0.25,1.0,
+		.49f, 1.0f, -0.085f,	0.993150651, 0.5f, -0.116841137f, 	0.2635,1.0,
+		.98f, 0.0f, -0.17f,		0.993150651, 0.5f, -0.116841137f,	0.0277,0.0,
+		.94f, 0.0f, -0.34f,		0.993417103f, 0.5f, -0.229039446f,	0.0554,0.0,
+		.49f, 1.0f, -0.085f,	0.993417103f, 0.5f, -0.229039446f,	0.2635,1.0,
+		.47f, 1.0f, -0.17f,		0.993417103f, 0.5f, -0.229039446f,	0.277,1.0,
+		.94f, 0.0f, -0.34f,		0.993417103f, 0.5f, -0.229039446f,	0.0554,0.0,
+		.87f, 0.0f, -0.5f,		0.993417103f, 0.5f, -0.229039446f,	0.0831,0.0,
+		.47f, 1.0f, -0.17f,		0.993417103f, 0.5f, -0.229039446f,	0.277,1.0,
+		.435f, 1.0f, -0.25f,	0.813733339f, 0.5f, -0.581238329f,	0.2905,1.0,
+		.87f, 0.0f, -0.5f,		0.813733339f, 0.5f, -0.581238329f,	0.0831,0.0,
+		.77f, 0.0f, -0.64f,		0.813733339f, 0.5f, -0.581238329f,	0.1108,0.0,
+		.435f, 1.0f, -0.25f,	0.813733339f, 0.5f, -0.581238329f,	0.2905,1.0,
+		.385f, 1.0f, -0.32f,	0.813733339f, 0.5f, -0.581238329f,	0.304,1.0,
+		.77f, 0.0f, -0.64f,		0.813733339f, 0.5f, -0.581238329f,	0.1108,0.0,
+		.64f, 0.0f, -0.77f,		0.707106769f, 0.5f, -0.707106769f,	0.1385,0.0,
+		.385f, 1.0f, -0.32f,	0.707106769f, 0.5f, -0.707106769f,	0.304,1.0,
+		.32f, 1.0f, -0.385f,	0.707106769f, 0.5f, -0.707106769f,	0.3175,1.0,
+		.64f, 0.0f, -0.77f,		0.707106769f, 0.5f, -0.707106769f,	0.1385,0.0,
+		.5f, 0.0f, -0.87f,		0.707106769f, 0.5f, -0.707106769f,	0.1662,0.0,
+		.32f, 1.0f, -0.385f,	0.707106769f, 0.5f, -0.707106769f,	0.3175, 1.0,
+		.25f, 1.0f, -0.435f,	0.400818795f, 0.5f, -0.916157305f,	0.331, 1.0,
+		.5f, 0.0f, -0.87f,		0.400818795f, 0.5f, -0.916157305f,	0.1662, 0.0,
+		.34f, 0.0f, -0.94f,		0.400818795f, 0.5f, -0.916157305f,	0.1939, 0.0,
+		.25f, 1.0f, -0.435f,	0.400818795f, 0.5f, -0.916157305f,	0.331, 1.0,
+		.17f, 1.0f, -0.47f,		0.400818795f, 0.5f, -0.916157305f,	0.3445, 1.0,
+		.34f, 0.0f, -0.94f,		0.400818795f, 0.5f, -0.916157305f,	0.1939, 0.0,
+		.17f, 0.0f, -0.98f,		0.229039446f, 0.5f, -0.973417103f,	0.2216, 0.0,
+		.17f, 1.0f, -0.47f,		0.229039446f, 0.5f, -0.973417103f,	0.3445, 1.0,
+		.085f, 1.0f, -0.49f,	0.229039446f, 0.5f, -0.973417103f,	0.358, 1.0,
+		.17f, 0.0f, -0.98f,		0.229039446f, 0.5f, -0.973417103f,	0.2216, 0.0,
+		0.0f, 0.0f, -1.0f,		0.229039446f, 0.5f, -0.973417103f,	0.2493, 0.0,
+		.085f, 1.0f, -0.49f,	0.229039446f, 0.5f, -0.973417103f,	0.358, 1.0,
+		0.0f, 1.0f, -0.5f,		-0.116841137f, 0.5f, -0.993150651f,	0.3715, 1.0,
+		0.0f, 0.0f, -1.0f,		-0.116841137f, 0.5f, -0.993150651f,	0.2493, 0.0,
+		-.17f, 0.0f, -0.98f,	-0.116841137f, 0.5f, -0.993150651f,	0.277, 0.0,
+		0.0f, 1.0f, -0.5f,		-0.116841137f, 0.5f, -0.993150651f,	0.3715, 1.0,
+		-.085f, 1.0f, -0.49f,	-0.116841137f, 0.5f, -0.993150651f,	0.385, 1.0,
+		-.17f, 0.0f, -0.98f,	-0.116841137f, 0.5f, -0.993150651f,	0.277, 0.0,
+		-.34f, 0.0f, -0.94f,	-0.229039446f, 0.5f, -0.973417103f,	0.3047, 0.0,
+		-.085f, 1.0f, -0.49f,	-0.229039446f, 0.5f, -0.973417103f,	0.385, 1.0,
+		-.17f, 1.0f, -0.47f,	-0.229039446f, 0.5f, -0.973417103f,	0.3985, 1.0,
+		-.34f, 0.0f, -0.94f,	-0.229039446f, 0.5f, -0.973417103f,	0.3047, 0.0,
+		-.5f, 0.0f, -0.87f,		-0.229039446f, 0.5f, -0.973417103f,	0.3324, 0.0,
+		-.17f, 1.0f, -0.47f,	-0.229039446f, 0.5f, -0.973417103f,	0.3985, 1.0,
+		-.25f, 1.0f, -0.435f,	-0.581238329f, 0.5f, -0.581238329f,	0.412, 1.0,
+		-.5f, 0.0f, -0.87f,		-0.581238329f, 0.5f, -0.581238329f,	0.3324, 0.0,
+		-.64f, 0.0f, -0.77f,	-0.581238329f, 0.5f, -0.581238329f,	0.3601, 0.0,
+		-.25f, 1.0f, -0.435f,	-0.581238329f, 0.5f, -0.581238329f,	0.412, 1.0,
+		-.32f, 1.0f, -0.385f,	-0.581238329f, 0.5f, -0.581238329f,	0.4255, 1.0,
+		-.64f, 0.0f, -0.77f,	-0.581238329f, 0.5f, -0.581238329f,	0.3601, 0.0,
+		-.77f, 0.0f, -0.64f,	-0.707106769f, 0.5f, -0.707106769f,	0.3878, 0.0,
+		-.32f, 1.0f, -0.385f,	-0.707106769f, 0.5f, -0.707106769f,	0.4255, 1.0,
+		-.385f, 1.0f, -0.32f,	-0.707106769f, 0.5f, -0.707106769f,	0.439, 1.0,
+		-.77f, 0.0f, -0.64f,	-0.707106769f, 0.5f, -0.707106769f,	0.3878, 0.0,
+		-.87f, 0.0f, -0.5f,		-0.707106769f, 0.5f, -0.707106769f,	0.4155, 0.0,
+		-.385f, 1.0f, -0.32f,	-0.707106769f, 0.5f, -0.707106769f,	0.439, 1.0,
+		-.435f, 1.0f, -0.25f,	-0.916157305f, 0.5f, -0.400818795f,	0.4525, 1.0,
+		-.87f, 0.0f, -0.5f,		-0.916157305f, 0.5f, -0.400818795f,	0.4155, 0.0,
+		-.94f, 0.0f, -0.34f,	-0.916157305f, 0.5f, -0.400818795f,	0.4432, 0.0,
+		-.435f, 1.0f, -0.25f,	-0.916157305f, 0.5f, -0.400818795f,	0.4525, 1.0,
+		-.47f, 1.0f, -0.17f,	-0.916157305f, 0.5f, -0.400818795f,	0.466, 1.0,
+		-.94f, 0.0f, -0.34f,	-0.916157305f, 0.5f, -0.400818795f,	0.4432, 0.0,
+		-.98f, 0.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.4709, 0.0,
+		-.47f, 1.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.466, 1.0,
+		-.49f, 1.0f, -0.085f,	-0.973417103f, 0.5f, -0.229039446f,	0.4795, 1.0,
+		-.98f, 0.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.4709, 0.0,
+		-1.0f, 0.0f, 0.0f,		-0.973417103f, 0.5f, -0.229039446f,	0.4986, 0.0,
+		-.49f, 1.0f, -0.085f,	-0.973417103f, 0.5f, -0.229039446f,	0.4795, 1.0,
+		-0.5f, 1.0f, 0.0f,		-0.993150651f, 0.5f, -0.116841137f,	0.493, 1.0,
+		-1.0f, 0.0f, 0.0f,		-0.993150651f, 0.5f, -0.116841137f,	0.4986, 0.0,
+		-.98f, 0.0f, 0.17f,		-0.993150651f, 0.5f, 0.116841137f,	0.5263, 0.0,
+		-0.5f, 1.0f, 0.0f,		-0.993150651f, 0.5f, 0.116841137f,	0.493, 1.0,
+		-.49f, 1.0f, 0.085f,	-0.993150651f, 0.5f, 0.116841137f,	0.5065, 1.0,
+		-.98f, 0.0f, 0.17f,		-0.993150651f, 0.5f, 0.116841137f,	0.5263, 0.0,
+		-.94f, 0.0f, 0.34f,		-0.973417103f, 0.5f, 0.229039446f,	0.554, 0.0,
+		-.49f, 1.0f, 0.085f,	-0.973417103f, 0.5f, 0.229039446f,	0.5065, 1.0,
+		-.47f, 1.0f, 0.17f,		-0.973417103f, 0.5f, 0.229039446f,	0.52, 1.0,
+		-.94f, 0.0f, 0.34f,		-0.973417103f, 0.5f, 0.229039446f,	0.554, 0.0,
+		-.87f, 0.0f, 0.5f,		-0.973417103f, 0.5f, 0.229039446f,	0.5817, 0.0,
+		-.47f, 1.0f, 0.17f,		-0.973417103f, 0.5f, 0.229039446f,	0.52, 1.0,
+		-.435f, 1.0f, 0.25f,	-0.813733339f, 0.5f, 0.581238329f,	0.5335, 1.0,
+		-.87f, 0.0f, 0.5f,		-0.813733339f, 0.5f, 0.581238329f,	0.5817, 0.0,
+		-.77f, 0.0f, 0.64f,		-0.813733339f, 0.5f, 0.581238329f,	0.6094, 0.0,
+		-.435f, 1.0f, 0.25f,	-0.813733339f, 0.5f, 0.581238329f,	0.5335, 1.0,
+		-.385f, 1.0f, 0.32f,	-0.813733339f, 0.5f, 0.581238329f,	0.547, 1.0,
+		-.77f, 0.0f, 0.64f,		-0.813733339f, 0.5f, 0.581238329f,	0.6094, 0.0,
+		-.64f, 0.0f, 0.77f,		-0.707106769f, 0.5f, 0.707106769f,	0.6371, 0.0,
+		-.385f, 1.0f, 0.32f,	-0.707106769f, 0.5f, 0.707106769f,	0.547, 1.0,
+		-.32f, 1.0f, 0.385f,	-0.707106769f, 0.5f, 0.707106769f,	0.5605, 1.0,
+		-.64f, 0.0f, 0.77f,		-0.707106769f, 0.5f, 0.707106769f,	0.6371, 0.0,
+		-.5f, 0.0f, 0.87f,		-0.707106769f, 0.5f, 0.707106769f,	0.6648, 0.0,
+		-.32f, 1.0f, 0.385f,	-0.707106769f, 0.5f, 0.707106769f,	0.5605, 1.0,
+		-.25f, 1.0f, 0.435f,	-0.400818795f, 0.5f, 0.916157305f,	0.574, 1.0,
+		-.5f, 0.0f, 0.87f,		-0.400818795f, 0.5f, 0.916157305f,	0.6648, 0.0,
+		-.34f, 0.0f, 0.94f,		-0.400818795f, 0.5f, 0.916157305f,	0.6925, 0.0,
+		-.25f, 1.0f, 0.435f,	-0.400818795f, 0.5f, 0.916157305f,	0.574, 1.0,
+		-.17f, 1.0f, 0.47f,		-0.400818795f, 0.5f, 0.916157305f,	0.5875, 1.0,
+		-.34f, 0.0f, 0.94f,		-0.400818795f, 0.5f, 0.916157305f,	0.6925, 0.0,
+		-.17f, 0.0f, 0.98f,		-0.229039446f, 0.5f, 0.973417103f,	0.7202, 0.0,
+		-.17f, 1.0f, 0.47f,		-0.229039446f, 0.5f, 0.973417103f,	0.5875, 1.0,
+		-.085f, 1.0f, 0.49f,	-0.229039446f, 0.5f, 0.973417103f,	0.601, 1.0,
+		-.17f, 0.0f, 0.98f,		-0.229039446f, 0.5f, 0.973417103f,	0.7202, 0.0,
+		0.0f, 0.0f, 1.0f,		-0.229039446f, 0.5f, 0.973417103f,	0.7479, 0.0,
+		-.085f, 1.0f, 0.49f,	-0.229039446f, 0.5f, 0.973417103f,	0.601, 1.0,
+		0.0f, 1.0f, 0.5f,		-0.116841137f, 0.5f, 0.993150651f,	0.6145, 1.0,
+		0.0f, 0.0f, 1.0f,		-0.116841137f, 0.5f, 0.993150651f,	0.7479, 0.0,
+		.17f, 0.0f, 0.98f,		0.116841137f, 0.5f, 0.993150651f,	0.7756, 0.0,
+		0.0f, 1.0f, 0.5f,		0.116841137f, 0.5f, 0.993150651f,	0.6145, 1.0,
+		.085f, 1.0f, 0.49f,		0.116841137f, 0.5f, 0.993150651f,	0.628, 1.0,
+		.17f, 0.0f, 0.98f,		0.116841137f, 0.5f, 0.993150651f,	0.7756, 0.0,
+		.34f, 0.0f, 0.94f,		0.229039446f, 0.5f, 0.973417103f,	0.8033, 0.0,
+		.085f, 1.0f, 0.49f,		0.229039446f, 0.5f, 0.973417103f,	0.628, 1.0,
+		.17f, 1.0f, 0.47f,		0.229039446f, 0.5f, 0.973417103f,	0.6415, 1.0,
+		.34f, 0.0f, 0.94f,		0.229039446f, 0.5f, 0.973417103f,	0.8033, 0.0,
+		.5f, 0.0f, 0.87f,		0.229039446f, 0.5f, 0.973417103f,	0.831, 0.0,
+		.17f, 1.0f, 0.47f,		0.229039446f, 0.5f, 0.973417103f,	0.6415, 1.0,
+		.25f, 1.0f, 0.435f,		0.581238329f, 0.5f, 0.813733339f,	0.655, 1.0,
+		.5f, 0.0f, 0.87f,		0.581238329f, 0.5f, 0.813733339f,	0.831, 0.0,
+		.64f, 0.0f, 0.77f,		0.581238329f, 0.5f, 0.813733339f,	0.8587, 0.0,
+		.25f, 1.0f, 0.435f,		0.581238329f, 0.5f, 0.813733339f,	0.655, 1.0,
+		.32f, 1.0f, 0.385f,		0.581238329f, 0.5f, 0.813733339f,	0.6685, 1.0,
+		.64f, 0.0f, 0.77f,		0.581238329f, 0.5f, 0.813733339f,	0.8587, 0.0,
+		.77f, 0.0f, 0.64f,		0.707106769f, 0.5f, 0.707106769f,	0.8864, 0.0,
+		.32f, 1.0f, 0.385f,		0.707106769f, 0.5f, 0.707106769f,	0.6685, 1.0,
+		.385f, 1.0f, 0.32f,		0.707106769f, 0.5f, 0.707106769f,	0.682, 1.0,
+		.77f, 0.0f, 0.64f,		0.707106769f, 0.5f, 0.707106769f,	0.8864, 0.0,
+		.87f, 0.0f, 0.5f,		0.707106769f, 0.5f, 0.707106769f,	0.9141, 0.0,
+		.385f, 1.0f, 0.32f,		0.707106769f, 0.5f, 0.707106769f,	0.682, 1.0,
+		.435f, 1.0f, 0.25f,		0.916157305f, 0.5f, 0.400818795f,	0.6955, 1.0,
+		.87f, 0.0f, 0.5f,		0.916157305f, 0.5f, 0.400818795f,	0.9141, 0.0,
+		.94f, 0.0f, 0.34f,		0.916157305f, 0.5f, 0.400818795f,	0.9418, 0.0,
+		.435f, 1.0f, 0.25f,		0.916157305f, 0.5f, 0.400818795f,	0.6955, 1.0,
+		.47f, 1.0f, 0.17f,		0.916157305f, 0.5f, 0.400818795f,	0.709, 1.0,
+		.94f, 0.0f, 0.34f,		0.916157305f, 0.5f, 0.400818795f,	0.9418, 1.0,
+		.98f, 0.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.9695, 0.0,
+		.47f, 1.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.709, 0.0,
+		.49f, 1.0f, 0.085f,		0.973417103f, 0.5f, 0.229039446f,	0.7225, 1.0,
+		.98f, 0.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.9695, 0.0,
+		1.0f, 0.0f, 0.0f,		0.973417103f, 0.5f, 0.229039446f,	1.0, 0.0,
+		.49f, 1.0f, 0.085f,		0.973417103f, 0.5f, 0.229039446f,	0.7225, 1.0,
+		0.5f, 1.0f, 0.0f,		0.993150651f, 0.5f, 0.116841137f,	0.75, 1.0,
+		1.0f, 0.0f, 0.0f,		0.993150651f, 0.5f, 0.116841137f,	1.0, 0.0
+	};
+	mesh.vertices.assign(verts, verts + sizeof(verts) / sizeof(verts[0]));
+
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_FAN, 0, 36, mesh.indices));	//bottom
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_FAN, 36, 72, mesh.indices));	//top
+	mesh.partIndexCounts.push_back(AppendTriangles(PRIMITIVE_TRIANGLE_STRIP, 72, 146, mesh.indices));	//sides
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildTorus()
+//
+//	Builds a parameterized torus by specifying the
+//	main radius, tube radius, and segment counts.
+//
+//	The triangles are drawn in two parts, the first
+//	half of the ring and the second half.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, MESH_DATA& mesh) {
+	float mainSegmentStep = 2.0f * Pi / mainSegments;
+	float tubeSegmentStep = 2.0f * Pi / tubeSegments;
+
+	std::vector<float>& vertices = mesh.vertices;
+	std::vector<uint32_t>& indices = mesh.indices;
+	vertices.reserve((size_t)(mainSegments + 1) * (tubeSegments + 1) * FLOATS_PER_VERTEX);
+	indices.reserve((size_t)mainSegments * tubeSegments * 6);
+
+	// Generate vertices and normals
+	for (int i = 0; i <= mainSegments; ++i) {
+		float mainAngle = i * mainSegmentStep;
+		float cosMain = cos(mainAngle);
+		float sinMain = sin(mainAngle);
+
+		for (int j = 0; j <= tubeSegments; ++j) {
+			float tubeAngle = j * tubeSegmentStep;
+			float cosTube = cos(tubeAngle);
+			float sinTube = sin(tubeAngle);
+
+			// Vertex position
+			float x = (mainRadius + tubeRadius * cosTube) * cosMain;
+			float y = (mainRadius + tubeRadius * cosTube) * sinMain;
+			float z = tubeRadius * sinTube;
+
+			// Normal vector
+			glm::vec3 center(mainRadius * cosMain, mainRadius * sinMain, 0.0f);
+			glm::vec3 vertex(x, y, z);
+			glm::vec3 normal = glm::normalize(vertex - center);
+
+			// Texture coordinates
+			float u = (float)i / mainSegments;
+			float v = (float)j / tubeSegments;
+
+			// Store interleaved vertex data
+			vertices.insert(vertices.end(), { x, y, z, normal.x, normal.y, normal.z, u, v });
+		}
+	}
+
+	// Generate indices for triangle strips
+	for (int i = 0; i < mainSegments; ++i) {
+		for (int j = 0; j < tubeSegments; ++j) {
+			uint32_t current = i * (tubeSegments + 1) + j;
+			uint32_t next = (i + 1) * (tubeSegments + 1) + j;
+
+			// First triangle
+			indices.insert(indices.end(), { current, next, current + 1 });
+
+			// Second triangle
+			indices.insert(indices.end(), { current + 1, next, next + 1 });
+		}
+	}
+
+	// the first half of the indices is the half torus
+	uint32_t halfIndices = (uint32_t)(indices.size() / 2) / 3 * 3;
+	mesh.partIndexCounts = { halfIndices, (uint32_t)indices.size() - halfIndices };
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	BuildExtraTorus()
+//
+//	Writes the vertices of an extra torus as a grid of
+//	rings, one vertex per ring and tube segment, and
+//	two triangles per quad between neighbouring rings
+//	into the indices.  Both buffers are sized once up
+//	front.  The last ring and the last tube segment
+//	wrap around to the first, so the texture
+//	coordinates run back to 0 across the seams.  The
+//	normals point away from the center of the torus.
+///////////////////////////////////////////////////
+void MeshBuilder::BuildExtraTorus(float thickness, int mainSegments, int tubeSegments, MESH_DATA& mesh)
+{
+	const float mainRadius = 1.0f;
+	float tubeRadius = .1f;
+
+	if (thickness <= 1.0)
+	{
+		tubeRadius = thickness;
+	}
+
+	mesh.vertices.resize((size_t)mainSegments * tubeSegments * FLOATS_PER_VERTEX);
+	mesh.indices.resize((size_t)mainSegments * tubeSegments * 6);
+
+	auto mainSegmentAngleStep = glm::radians(360.0f / float(mainSegments));
+	auto tubeSegmentAngleStep = glm::radians(360.0f / float(tubeSegments));
+	float horizontalStep = 1.0 / mainSegments;
+	float verticalStep = 1.0 / tubeSegments;
+
+	// the angles and texture coordinates are stepped rather than
+	// multiplied, and the sines keep whatever type sin() returns, so
+	// the vertices come out the same as they always have
+	float* vertex = mesh.vertices.data();
+	auto currentMainSegmentAngle = 0.0f;
+	float u = 0.0;
+	for (int i = 0; i < mainSegments; i++)
+	{
+		// Calculate sine and cosine of main segment angle
+		auto sinMainSegment = sin(currentMainSegmentAngle);
+		auto cosMainSegment = cos(currentMainSegmentAngle);
+		auto currentTubeSegmentAngle = 0.0f;
+		float v = 0.0;
+		for (int j = 0; j < tubeSegments; j++)
+		{
+			// Calculate sine and cosine of tube segment angle
+			auto sinTubeSegment = sin(currentTubeSegmentAngle);
+			auto cosTubeSegment = cos(currentTubeSegmentAngle);
+
+			// Calculate vertex position on the surface of torus
+			auto position = glm::vec3(
+				(mainRadius + tubeRadius * cosTubeSegment) * cosMainSegment,
+				(mainRadius + tubeRadius * cosTubeSegment) * sinMainSegment,
+				tubeRadius * sinTubeSegment);
+			glm::vec3 normal = glm::normalize(position);
+
+			vertex[0] = position.x;
+			vertex[1] = position.y;
+			vertex[2] = position.z;
+			vertex[3] = normal.x;
+			vertex[4] = normal.y;
+			vertex[5] = normal.z;
+			vertex[6] = u;
+			vertex[7] = v;
+			vertex += FLOATS_PER_VERTEX;
+
+			// Update current tube angle
+			currentTubeSegmentAngle += tubeSegmentAngleStep;
+			v += verticalStep;
+		}
+
+		// Update main segment angle
+		currentMainSegmentAngle += mainSegmentAngleStep;
+		u += horizontalStep;
+	}
+
+	// connect each quad to the next ring and tube segment
+	uint32_t* index = mesh.indices.data();
+	for (int i = 0; i < mainSegments; i++)
+	{
+		uint32_t ring = (uint32_t)(i * tubeSegments);
+		uint32_t nextRing = (uint32_t)(((i + 1) % mainSegments) * tubeSegments);
+		for (int j = 0; j < tubeSegments; j++)
+		{
+			uint32_t nextSegment = (uint32_t)((j + 1) % tubeSegments);
+
+			index[0] = ring + j;
+			index[1] = ring + nextSegment;
+			index[2] = nextRing + nextSegment;
+			index[3] = ring + j;
+			index[4] = nextRing + j;
+			index[5] = nextRing + nextSegment;
+			index += 6;
+		}
+	}
+
+	mesh.partIndexCounts.push_back((uint32_t)mesh.indices.size());
+
+	FinishMesh(mesh);
+}
+
+///////////////////////////////////////////////////
+//	ComputeBounds()
+//
+//	Computes the box around interleaved vertices of
+//	8 floats each, and the sphere around the center
+//	of that box that holds every vertex.
+///////////////////////////////////////////////////
+MeshBuilder::MESH_BOUNDS MeshBuilder::ComputeBounds(const float* vertices, size_t vertexCount)
+{
+	MESH_BOUNDS bounds = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), -1.0f };
+
+	if ((NULL == vertices) || (vertexCount == 0))
+	{
+		return(bounds);
+	}
+
+	bounds.minimum = glm::vec3(vertices[0], vertices[1], vertices[2]);
+	bounds.maximum = bounds.minimum;
+	for (size_t i = 1; i < vertexCount; i++)
+	{
+		glm::vec3 position = glm::vec3(vertices[i * FLOATS_PER_VERTEX], vertices[i * FLOATS_PER_VERTEX + 1], vertices[i * FLOATS_PER_VERTEX + 2]);
+		bounds.minimum = glm::min(bounds.minimum, position);
+		bounds.maximum = glm::max(bounds.maximum, position);
+	}
+
+	bounds.center = (bounds.minimum + bounds.maximum) * 0.5f;
+	bounds.radius = 0.0f;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 position = glm::vec3(vertices[i * FLOATS_PER_VERTEX], vertices[i * FLOATS_PER_VERTEX + 1], vertices[i * FLOATS_PER_VERTEX + 2]);
+		bounds.radius = std::max(bounds.radius, glm::length(position - bounds.center));
+	}
+
+	return(bounds);
+}
+
+///////////////////////////////////////////////////
+//	AppendTriangles()
+//
+//	Appends the triangles that drawing count vertices
+//	from first as a fan, strip or list would draw.
+//	Every other triangle of a strip is flipped to keep
+//	the winding, as OpenGL does.  Returns the number
+//	of indices appended.
+///////////////////////////////////////////////////
+uint32_t MeshBuilder::AppendTriangles(PRIMITIVE primitive, uint32_t first, uint32_t count, std::vector<uint32_t>& indices)
+{
+	size_t firstIndex = indices.size();
+
+	switch (primitive)
+	{
+	case PRIMITIVE_TRIANGLES:
+		for (uint32_t i = 0; i + 2 < count; i += 3)
+		{
+			indices.insert(indices.end(), { first + i, first + i + 1, first + i + 2 });
+		}
+		break;
+	case PRIMITIVE_TRIANGLE_FAN:
+		for (uint32_t i = 1; i + 1 < count; i++)
+		{
+			indices.insert(indices.end(), { first, first + i, first + i + 1 });
+		}
+		break;
+	case PRIMITIVE_TRIANGLE_STRIP:
+		for (uint32_t i = 0; i + 2 < count; i++)
+		{
+			if ((i % 2) == 0)
+			{
+				indices.insert(indices.end(), { first + i, first + i + 1, first + i + 2 });
+			}
+			else
+			{
+				indices.insert(indices.end(), { first + i + 1, first + i, first + i + 2 });
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	return((uint32_t)(indices.size() - firstIndex));
+}
+
+///////////////////////////////////////////////////
+//	FinishMesh()
+//
+//	Reorders the triangles of each part of a mesh for
+//	the post-transform vertex cache, then reorders
+//	clusters of them so the ones facing out are drawn
+//	first.  Each part keeps its own triangles, so it
+//	can still be drawn on its own.  Records the ACMR
+//	and ATVR of the mesh before and after, and its
+//	bounds.
+///////////////////////////////////////////////////
+void MeshBuilder::FinishMesh(MESH_DATA& mesh)
+{
+	size_t vertexCount = mesh.vertices.size() / FLOATS_PER_VERTEX;
+
+	mesh.cacheBefore = MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+	size_t partCount = 0;
+	uint32_t first = 0;
+	for (uint32_t count : mesh.partIndexCounts)
+	{
+		if ((partCount >= MAX_PARTS) || (first + count > (uint32_t)mesh.indices.size()))
+		{
+			std::cerr << "Error: Mesh parts do not fit the indices of the mesh." << std::endl;
+			break;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(mesh.indices.data() + first, count, vertexCount);
+		MeshOptimizer::OptimizeOverdraw(mesh.indices.data() + first, count, mesh.vertices.data(), vertexCount,
+			FLOATS_PER_VERTEX, OVERDRAW_THRESHOLD);
+		partCount++;
+		first += count;
+	}
+
+	// indices outside of every part would never be drawn
+	mesh.partIndexCounts.resize(partCount);
+	mesh.indices.resize(first);
+
+	mesh.cacheAfter = MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount);
+	mesh.bounds = ComputeBounds(mesh.vertices.data(), vertexCount);
+}
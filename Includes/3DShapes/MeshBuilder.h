@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshBuilder.h
+// ============
+// generate the vertices and indices of the basic 3D shapes on the CPU
+//
+//  Each builder writes a shape into a MESH_DATA - interleaved vertices of
+//  8 floats (position, normal, UV), a triangle list split into the parts
+//  that are drawn on their own, and the bounds of the vertices.  The
+//  triangles of each part are reordered for the vertex cache before they
+//  are handed back.  The builders need no OpenGL context, so they can run
+//  on any thread, and ShapeMeshes only uploads what they return.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshOptimizer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MeshBuilder
+{
+public:
+	// floats in each vertex - position, normal and texture coordinates
+	static const int FLOATS_PER_VERTEX = 8;
+	// most parts a mesh's indices are split into - the six faces of
+	// the box
+	static const int MAX_PARTS = 6;
+	// version of what the builders output - bump it whenever a builder
+	// changes the vertices or indices it makes, so the meshes in the
+	// mesh cache are generated again.  The triangle order is versioned
+	// by MeshOptimizer::OPTIMIZER_VERSION.  The mesh builder tests hash
+	// the scene's meshes and fail when they change without a bump
+	static const uint32_t MESH_GENERATOR_VERSION = 1;
+
+	// bounds of a mesh around the origin of its model space - the
+	// sphere is centered on the box
+	struct MESH_BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+		glm::vec3 center;
+		float radius;        // negative if the mesh is not loaded
+	};
+
+	// a generated mesh
+	struct MESH_DATA
+	{
+		std::vector<float> vertices;
+		// a triangle list, part after part
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> partIndexCounts;
+		MESH_BOUNDS bounds;
+		// how the triangles used the vertex cache before and after
+		// they were reordered
+		MeshOptimizer::CACHE_STATISTICS cacheBefore;
+		MeshOptimizer::CACHE_STATISTICS cacheAfter;
+	};
+
+	// how the vertices given to AppendTriangles() are drawn
+	enum PRIMITIVE
+	{
+		PRIMITIVE_TRIANGLES = 0,
+		PRIMITIVE_TRIANGLE_FAN,
+		PRIMITIVE_TRIANGLE_STRIP
+	};
+
+	// builders for the basic 3D shapes, with the same parameters as
+	// the ShapeMeshes Load methods
+	static void BuildBox(MESH_DATA& mesh);
+	static void BuildCone(float radius, float height, int numSlices, MESH_DATA& mesh);
+	static void BuildCylinder(float radius, float height, int numSlices, MESH_DATA& mesh);
+	static void BuildPlane(float width, float height, MESH_DATA& mesh);
+	static void BuildPrism(MESH_DATA& mesh);
+	static void BuildPyramid3(MESH_DATA& mesh);
+	static void BuildPyramid4(float baseSize, float height, MESH_DATA& mesh);
+	static void BuildSphere(int latitudeSegments, int longitudeSegments, float radius, MESH_DATA& mesh);
+	static void BuildTaperedCylinder(MESH_DATA& mesh);
+	static void BuildTorus(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, MESH_DATA& mesh);
+	static void BuildExtraTorus(float thickness, int mainSegments, int tubeSegments, MESH_DATA& mesh);
+
+	// compute the bounds of interleaved vertices
+	static MESH_BOUNDS ComputeBounds(const float* vertices, size_t vertexCount);
+	// append the triangles that drawing count vertices from first
+	// would draw to a triangle list - returns the number of indices
+	// appended
+	static uint32_t AppendTriangles(PRIMITIVE primitive, uint32_t first, uint32_t count, std::vector<uint32_t>& indices);
+
+private:
+	// reorder the triangles of each part for the vertex cache and for
+	// overdraw, and compute the bounds and the cache statistics
+	static void FinishMesh(MESH_DATA& mesh);
+};
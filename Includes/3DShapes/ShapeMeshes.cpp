@@ -9,6 +9,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "shapemeshes.h"
+#include "GLStateCache.h"
+#include "MeshBuilder.h"
+#include "MeshCache.h"
+#include "VertexLayout.h"
 
 // GLM Math Header inclusions
 #define GLM_ENABLE_EXPERIMENTAL
@@ -17,26 +21,25 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <array> // Required for std::array
+#include <algorithm> // Required for std::find
+#include <atomic> // Required for std::atomic
+#include <chrono> // Required for std::chrono
+#include <cstddef> // Required for offsetof
+#include <cstdio> // Required for snprintf
+#include <thread> // Required for std::thread
 #include <vector> // Required for std::vector
 #include <cmath>  // Required for math functions like sqrt and cos
 
 #include <iostream>
 
-namespace Constants
-{
-	constexpr double Pi = 3.141592653589793;       // Use constexpr for compile-time evaluation
-	constexpr double PiHalf = Pi / 2.0;           // Use computed value for better accuracy
-	constexpr GLuint FloatsPerVertex = 3;         // Number of coordinates per vertex
-	constexpr GLuint FloatsPerNormal = 3;         // Number of components per normal vector
-	constexpr GLuint FloatsPerUV = 2;             // Number of texture coordinate values
-}
-
-using namespace Constants;
-
 ShapeMeshes::ShapeMeshes()
 {
-	m_bMemoryLayoutDone = false;
+	m_bQueueMeshes = false;
+	m_pMeshCache = NULL;
+	m_sharedVertexFormat = VERTEX_FORMAT_SNORM16;
+	m_sharedIndexType = GL_UNSIGNED_INT;
+	m_instanceBuffer = 0;
+	m_indirectBuffer = 0;
 }
 
 //**************************************************************************
@@ -48,1395 +51,383 @@ ShapeMeshes::ShapeMeshes()
 ///////////////////////////////////////////////////
 // LoadBoxMesh()
 //
-// Creates a box mesh by specifying the vertices and 
-// stores it in a VAO/VBO. Normals and texture
-// coordinates are also set.
-//
-// Correct triangle drawing command:
-//
-// glDrawElements(GL_TRIANGLES, meshes.gBoxMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+// Creates a box mesh and stores it in a VAO/VBO.
+// The indices are a triangle list with one part for
+// each face.
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadBoxMesh()
 {
-	// Box vertex and index data
-	const std::vector<GLfloat> verts = {
-		// Positions           // Normals          // Texture Coords
-		// Back Face
-		 0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   0.0f, 1.0f,  // 0
-		 0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   0.0f, 0.0f,  // 1
-		-0.5f, -0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   1.0f, 0.0f,  // 2
-		-0.5f,  0.5f, -0.5f,   0.0f,  0.0f, -1.0f,   1.0f, 1.0f,  // 3
-		// Bottom Face
-		-0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,   0.0f, 1.0f,  // 4
-		-0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,   0.0f, 0.0f,  // 5
-		 0.5f, -0.5f, -0.5f,   0.0f, -1.0f,  0.0f,   1.0f, 0.0f,  // 6
-		 0.5f, -0.5f,  0.5f,   0.0f, -1.0f,  0.0f,   1.0f, 1.0f,  // 7
-		 // Left Face
-		-0.5f,  0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,   0.0f, 1.0f,  // 8
-		-0.5f, -0.5f, -0.5f,  -1.0f,  0.0f,  0.0f,   0.0f, 0.0f,  // 9
-		-0.5f, -0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,   1.0f, 0.0f,  // 10
-		-0.5f,  0.5f,  0.5f,  -1.0f,  0.0f,  0.0f,   1.0f, 1.0f,  // 11
-		// Right Face
-		 0.5f,  0.5f,  0.5f,   1.0f,  0.0f,  0.0f,   0.0f, 1.0f,  // 12
-		 0.5f, -0.5f,  0.5f,   1.0f,  0.0f,  0.0f,   0.0f, 0.0f,  // 13
-		 0.5f, -0.5f, -0.5f,   1.0f,  0.0f,  0.0f,   1.0f, 0.0f,  // 14
-		 0.5f,  0.5f, -0.5f,   1.0f,  0.0f,  0.0f,   1.0f, 1.0f,  // 15
-		// Top Face
-		-0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,   0.0f, 1.0f,  // 16
-		-0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,   0.0f, 0.0f,  // 17
-		 0.5f,  0.5f,  0.5f,   0.0f,  1.0f,  0.0f,   1.0f, 0.0f,  // 18
-		 0.5f,  0.5f, -0.5f,   0.0f,  1.0f,  0.0f,   1.0f, 1.0f,  // 19
-		// Front Face
-		-0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   0.0f, 1.0f,  // 20
-		-0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   0.0f, 0.0f,  // 21
-		 0.5f, -0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   1.0f, 0.0f,  // 22
-		 0.5f,  0.5f,  0.5f,   0.0f,  0.0f,  1.0f,   1.0f, 1.0f   // 23
-	};
-
-	// Index data
-	const std::vector<GLuint> indices = {
-			0, 1, 2, 0, 3, 2,       // Back Face
-			4, 5, 6, 4, 7, 6,       // Bottom Face
-			8, 9, 10, 8, 11, 10,    // Left Face
-			12, 13, 14, 12, 15, 14, // Right Face
-			16, 17, 18, 16, 19, 18, // Top Face
-			20, 21, 22, 20, 23, 22  // Front Face
-	};
-
-	// Calculate vertex and index counts
-	m_BoxMesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
-	m_BoxMesh.nIndices = indices.size();
-
-	// Generate VAO and VBOs
-	glGenVertexArrays(1, &m_BoxMesh.vao);
-	glBindVertexArray(m_BoxMesh.vao);
-
-	glGenBuffers(2, m_BoxMesh.vbos);
-
-	// Upload vertex data
-	glBindBuffer(GL_ARRAY_BUFFER, m_BoxMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-
-	// Upload index data
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_BoxMesh.vbos[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Ensure shader memory layout is set
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	GenerateMesh("box", false, m_BoxMesh, MeshBuilder::BuildBox);
 }
 
 ///////////////////////////////////////////////////
 //	LoadConeMesh()
 //
-//	Create a cone mesh by specifying the vertices and 
-//  store it in a VAO/VBO. The normals and texture
-//  coordinates are also set.
-//
-//  Correct triangle drawing commands:
-//
-//	glDrawArrays(GL_TRIANGLE_FAN, 0, numSlices + 2);	// bottom
-//	glDrawArrays(GL_TRIANGLE_STRIP, numSlices + 2, numSlices * 2);	// sides
-///////////////////////////////////////////////////
-void ShapeMeshes::LoadConeMesh(float radius, float height, int numSlices) {
-	// Validate inputs
-	if (numSlices < 3) numSlices = 3;
-	m_ConeMesh.numSlices = numSlices; // Store number of slices in the mesh structure
-
-	std::vector<GLfloat> vertices;
-
-	// Generate bottom circle vertices
-	float angleStep = 2.0f * Pi / numSlices;
-
-	// Center vertex of bottom circle
-	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
-
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate side vertices
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		float nx = cos(angle);
-		float nz = sin(angle);
-
-		// Bottom vertex
-		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
-		// Apex vertex
-		vertices.insert(vertices.end(), { 0.0f, height, 0.0f, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
+//	Create a cone mesh, or map it from the mesh cache,
+//  and store it in a VAO/VBO.  The bottom and the
+//  sides are drawn as two parts.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadConeMesh(float radius, float height, int numSlices, int detailLevel) {
+	// the coarser tessellations are kept apart from the one drawn
+	// by the Draw methods
+	if ((detailLevel < 0) || (detailLevel >= DETAIL_LEVELS)) {
+		return;
 	}
+	GLMesh& mesh = (detailLevel == 0) ? m_ConeMesh : m_ConeLevels[detailLevel - 1];
 
-	// Store vertex count
-	m_ConeMesh.nVertices = static_cast<GLsizei>(vertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_ConeMesh.nIndices = 0; // Not used since we're drawing with glDrawArrays
-
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_ConeMesh.vao);
-	glBindVertexArray(m_ConeMesh.vao);
-
-	glGenBuffers(1, m_ConeMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ConeMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+	// Validate inputs
+	if (numSlices < 3) numSlices = 3;
+	mesh.numSlices = numSlices; // Store number of slices in the mesh structure
 
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
+	std::string cacheKey = MeshCache::MakeKey("cone", { radius, height, (float)numSlices });
+	if (LoadCachedMesh(cacheKey, mesh)) {
+		return;
 	}
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	GenerateMesh(cacheKey, true, mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildCone(radius, height, numSlices, data);
+	});
 }
 
 ///////////////////////////////////////////////////
 //	LoadCylinderMesh()
 //
-//	Create a cylinder mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
-//  coordinates are also set.
-//
-//  Correct triangle drawing commands:
-//
-//	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-//	glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
-//	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-///////////////////////////////////////////////////
+//	Create a cylinder mesh, or map it from the mesh
+//  cache, and store it in a VAO/VBO.  The bottom,
+//  top and sides are drawn as three parts.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadCylinderMesh(float radius, float height, int numSlices, int detailLevel) {
+	// the coarser tessellations are kept apart from the one drawn
+	// by the Draw methods
+	if ((detailLevel < 0) || (detailLevel >= DETAIL_LEVELS)) {
+		return;
+	}
+	GLMesh& mesh = (detailLevel == 0) ? m_CylinderMesh : m_CylinderLevels[detailLevel - 1];
 
-void ShapeMeshes::LoadCylinderMesh(float radius, float height, int numSlices) {
 	// Validate inputs
 	if (numSlices < 3) numSlices = 3;
-	m_CylinderMesh.numSlices = numSlices; // Store number of slices in the mesh structure
-
-	std::vector<GLfloat> vertices;
-
-	// Generate bottom circle vertices
-	float angleStep = 2.0f * Pi / numSlices;
-
-	// Center vertex of bottom circle
-	vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.5f });
+	mesh.numSlices = numSlices; // Store number of slices in the mesh structure
 
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, 0.0f, z, 0.0f, -1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate top circle vertices
-	vertices.insert(vertices.end(), { 0.0f, height, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f });
-
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		vertices.insert(vertices.end(), { x, height, z, 0.0f, 1.0f, 0.0f, 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle) });
-	}
-
-	// Generate side vertices
-	for (int i = 0; i <= numSlices; ++i) {
-		float angle = i * angleStep;
-		float x = radius * cos(angle);
-		float z = radius * sin(angle);
-		float nx = cos(angle);
-		float nz = sin(angle);
-
-		// Bottom vertex
-		vertices.insert(vertices.end(), { x, 0.0f, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 0.0f });
-		// Top vertex
-		vertices.insert(vertices.end(), { x, height, z, nx, 0.0f, nz, static_cast<float>(i) / numSlices, 1.0f });
-	}
-
-	// Store vertex count
-	m_CylinderMesh.nVertices = static_cast<GLsizei>(vertices.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_CylinderMesh.nIndices = 0; // Not used since we're drawing with glDrawArrays
-
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_CylinderMesh.vao);
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	glGenBuffers(1, m_CylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_CylinderMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
+	std::string cacheKey = MeshCache::MakeKey("cylinder", { radius, height, (float)numSlices });
+	if (LoadCachedMesh(cacheKey, mesh)) {
+		return;
 	}
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	GenerateMesh(cacheKey, true, mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildCylinder(radius, height, numSlices, data);
+	});
 }
 
 ///////////////////////////////////////////////////
 //	LoadPlaneMesh()
 //
-//	Create a plane mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
-//  coordinates are also set.
-// 
-//  Correct triangle drawing command:
-//
-//	glDrawElements(GL_TRIANGLES, meshes.gPlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+//	Create a plane mesh of two triangles and store it
+//  in a VAO/VBO.
 ///////////////////////////////////////////////////
-
 void ShapeMeshes::LoadPlaneMesh(float width, float height) {
-	// Half dimensions for centering the plane
-	float halfWidth = width / 2.0f;
-	float halfHeight = height / 2.0f;
-
-	// Vertex data: Positions, Normals, Texture Coords
-	GLfloat verts[] = {
-		// Vertex Positions       // Normals           // Texture Coords
-		-halfWidth, 0.0f, halfHeight,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,  // Bottom-left
-		 halfWidth, 0.0f, halfHeight,  0.0f, 1.0f, 0.0f,  1.0f, 0.0f,  // Bottom-right
-		 halfWidth, 0.0f, -halfHeight, 0.0f, 1.0f, 0.0f,  1.0f, 1.0f,  // Top-right
-		-halfWidth, 0.0f, -halfHeight, 0.0f, 1.0f, 0.0f,  0.0f, 1.0f   // Top-left
-	};
-
-	// Index data
-	GLuint indices[] = {
-		0, 1, 2,  // First triangle
-		0, 2, 3   // Second triangle
-	};
-
-	// Store vertex and index count
-	m_PlaneMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_PlaneMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-
-	// Generate the VAO for the mesh
-	glGenVertexArrays(1, &m_PlaneMesh.vao);
-	glBindVertexArray(m_PlaneMesh.vao); // Activate the VAO
-
-	// Create VBOs for the mesh
-	glGenBuffers(2, m_PlaneMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PlaneMesh.vbos[0]); // Activate the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Send data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PlaneMesh.vbos[1]); // Activate the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
-
-	// Unbind the VAO for safety
-	glBindVertexArray(0);
+	GenerateMesh("plane", false, m_PlaneMesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildPlane(width, height, data);
+	});
 }
 
+///////////////////////////////////////////////////
+//	LoadPrismMesh()
+//
+//	Create a prism mesh and store it in a VAO/VBO.
+///////////////////////////////////////////////////
 void ShapeMeshes::LoadPrismMesh()
 {
-	// Vertex data
-	GLfloat verts[] = {
-		//Positions				//Normals
-		// ------------------------------------------------------
-
-		//Back Face				//Negative Z Normal  
-		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f,  0.0f, -1.0f,		1.0f, 0.0f,
-		0.5f,  0.5f, -0.5f,		0.0f,  0.0f, -1.0f,		0.0f, 1.0f,
-
-		//Bottom Face			//Negative Y Normal
-		0.5f, -0.5f, -0.5f,		0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.0f, -1.0f,  0.0f,		1.0f, 0.0f,
-		0.0f, -0.5f,  0.5f,		0.0f, -1.0f,  0.0f,		0.5f, 1.0f,
-		-0.5f, -0.5f,  -0.5f,	0.0f, -1.0f,  0.0f,		0.0f, 0.0f,
-
-		//Left Face/slanted		//Normals
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		-0.5f, 0.5f,  -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 1.0f,
-		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-		0.0f, -0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 0.0f,
-		0.0f, 0.5f,  0.5f,		0.894427180f,  0.0f,  -0.447213590f,	1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f,	0.894427180f,  0.0f,  -0.447213590f,	0.0f, 0.0f,
-
-		//Right Face/slanted	//Normals
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.5f, 0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 1.0f,
-		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-		0.0f, -0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 0.0f,
-		0.5f, -0.5f, -0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		1.0f, 0.0f,
-		0.0f, 0.5f, 0.5f,		-0.894427180f,  0.0f,  -0.447213590f,		0.0f, 1.0f,
-
-		//Top Face				//Positive Y Normal		//Texture Coords.
-		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
-		0.0f,  0.5f,  0.5f,		0.0f,  1.0f,  0.0f,		0.5f, 1.0f,
-		-0.5f,  0.5f, -0.5f,	0.0f,  1.0f,  0.0f,		1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f,		0.0f,  1.0f,  0.0f,		0.0f, 0.0f,
-
-	};
-
-	m_PrismMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-
-	glGenVertexArrays(1, &m_PrismMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_PrismMesh.vao);
-
-	// Create 2 buffers: first one for the vertex data; second one for the indices
-	glGenBuffers(1, m_PrismMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PrismMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	GenerateMesh("prism", false, m_PrismMesh, MeshBuilder::BuildPrism);
 }
 
-
 ///////////////////////////////////////////////////
 // LoadPyramid3Mesh()
 //
-// Dynamically create a 3-sided pyramid mesh by specifying
-// vertices and store it in a VAO/VBO. The normals and
-// texture coordinates are also set.
-//
-// Correct triangle drawing command:
-//
-// glDrawArrays(GL_TRIANGLE_STRIP, 0, gPyramid3Mesh.nVertices);
+// Create a 3-sided pyramid mesh and store it in a
+// VAO/VBO.
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPyramid3Mesh()
 {
-	constexpr float halfBase = 0.5f; // Half the length of the base
-	constexpr float height = 0.5f;  // Height of the pyramid
-
-	// Define vertices programmatically
-	std::vector<GLfloat> verts;
-
-	// Helper for normals
-	auto calculateNormal = [](float x1, float y1, float z1, float x2, float y2, float z2) -> std::array<float, 3> {
-		float nx = y1 * z2 - z1 * y2;
-		float ny = z1 * x2 - x1 * z2;
-		float nz = x1 * y2 - y1 * x2;
-		float length = sqrt(nx * nx + ny * ny + nz * nz);
-		return { nx / length, ny / length, nz / length };
-		};
-
-	// Define the pyramid faces with vertices and normals
-	struct Face {
-		std::array<float, 3> top;      // Top vertex
-		std::array<float, 3> bottom1; // First base vertex
-		std::array<float, 3> bottom2; // Second base vertex
-		std::array<float, 3> normal;  // Normal vector
-	};
-
-	std::vector<Face> faces = {
-		// Left face
-		{{0.0f, height, 0.0f}, {-halfBase, -height, halfBase}, {0.0f, -height, -halfBase},
-		 calculateNormal(-halfBase, -height - height, halfBase - 0.0f, 0.0f, -height - height, -halfBase - halfBase)},
-		 // Right face
-		 {{0.0f, height, 0.0f}, {0.0f, -height, -halfBase}, {halfBase, -height, halfBase},
-		  calculateNormal(0.0f, -height - height, -halfBase - 0.0f, halfBase, -height - height, halfBase - -halfBase)},
-		  // Front face
-		  {{0.0f, height, 0.0f}, {halfBase, -height, halfBase}, {-halfBase, -height, halfBase},
-		   calculateNormal(halfBase, -height - height, halfBase - 0.0f, -halfBase, -height - height, halfBase - halfBase)} };
-
-	for (const auto& face : faces)
-	{
-		// Top point
-		verts.insert(verts.end(), {
-			face.top[0], face.top[1], face.top[2],
-			face.normal[0], face.normal[1], face.normal[2],
-			0.5f, 1.0f });
-
-		// First base vertex
-		verts.insert(verts.end(), {
-			face.bottom1[0], face.bottom1[1], face.bottom1[2],
-			face.normal[0], face.normal[1], face.normal[2],
-			0.0f, 0.0f });
-
-		// Second base vertex
-		verts.insert(verts.end(), {
-			face.bottom2[0], face.bottom2[1], face.bottom2[2],
-			face.normal[0], face.normal[1], face.normal[2],
-			1.0f, 0.0f });
-	}
-
-	// Base (bottom face)
-	verts.insert(verts.end(), {
-		-halfBase, -height, halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f,
-		halfBase, -height, halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f,
-		0.0f, -height, -halfBase, 0.0f, -1.0f, 0.0f, 0.5f, 0.0f });
-
-	// Store vertex count
-	m_Pyramid3Mesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
-
-	// Create VAO
-	glGenVertexArrays(1, &m_Pyramid3Mesh.vao);
-	glBindVertexArray(m_Pyramid3Mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_Pyramid3Mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid3Mesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
+	GenerateMesh("pyramid3", false, m_Pyramid3Mesh, MeshBuilder::BuildPyramid3);
 }
 
 ///////////////////////////////////////////////////
 // LoadPyramid4Mesh()
 //
-// Dynamically create a 4-sided pyramid mesh by
-// specifying vertices, normals, and texture coordinates.
-//
+// Create a 4-sided pyramid mesh and store it in a
+// VAO/VBO.
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadPyramid4Mesh(float baseSize, float height)
 {
-	constexpr int FloatsPerVertex = 3;
-	constexpr int FloatsPerNormal = 3;
-	constexpr int FloatsPerUV = 2;
-
-	float halfBase = baseSize / 2.0f;
-
-	// Vertex data container
-	std::vector<GLfloat> verts;
-
-	// Helper lambda to add vertex data
-	auto addVertex = [&verts](float px, float py, float pz, float nx, float ny, float nz, float u, float v) {
-		verts.insert(verts.end(), { px, py, pz, nx, ny, nz, u, v });
-		};
-
-	// Helper for normal calculation
-	auto calculateNormal = [](float x1, float y1, float z1, float x2, float y2, float z2) -> std::array<float, 3> {
-		float nx = y1 * z2 - z1 * y2;
-		float ny = z1 * x2 - x1 * z2;
-		float nz = x1 * y2 - y1 * x2;
-		float length = std::sqrt(nx * nx + ny * ny + nz * nz);
-		return { nx / length, ny / length, nz / length };
-		};
-
-	// Bottom face (flat quad)
-	addVertex(-halfBase, -halfBase, halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f);  // Front-left
-	addVertex(-halfBase, -halfBase, -halfBase, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f); // Back-left
-	addVertex(halfBase, -halfBase, -halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f);  // Back-right
-	addVertex(halfBase, -halfBase, halfBase, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f);   // Front-right
-
-	// Pyramid faces (triangular sides)
-	struct Face {
-		std::array<float, 3> top;
-		std::array<float, 3> bottomLeft;
-		std::array<float, 3> bottomRight;
-	};
-
-	std::vector<Face> faces = {
-		{{0.0f, height / 2.0f, 0.0f}, {-halfBase, -halfBase, -halfBase}, {-halfBase, -halfBase, halfBase}},  // Left face
-		{{0.0f, height / 2.0f, 0.0f}, {halfBase, -halfBase, -halfBase}, {-halfBase, -halfBase, -halfBase}}, // Back face
-		{{0.0f, height / 2.0f, 0.0f}, {halfBase, -halfBase, halfBase}, {halfBase, -halfBase, -halfBase}},   // Right face
-		{{0.0f, height / 2.0f, 0.0f}, {-halfBase, -halfBase, halfBase}, {halfBase, -halfBase, halfBase}}    // Front face
-	};
-
-	for (const auto& face : faces)
-	{
-		// Calculate normal for the face
-		auto normal = calculateNormal(
-			face.bottomRight[0] - face.bottomLeft[0], face.bottomRight[1] - face.bottomLeft[1],
-			face.bottomRight[2] - face.bottomLeft[2], face.top[0] - face.bottomLeft[0],
-			face.top[1] - face.bottomLeft[1], face.top[2] - face.bottomLeft[2]);
-
-		// Add vertices for the triangular face
-		addVertex(face.top[0], face.top[1], face.top[2], normal[0], normal[1], normal[2], 0.5f, 1.0f);         // Top vertex
-		addVertex(face.bottomLeft[0], face.bottomLeft[1], face.bottomLeft[2], normal[0], normal[1], normal[2], 0.0f, 0.0f); // Bottom-left
-		addVertex(face.bottomRight[0], face.bottomRight[1], face.bottomRight[2], normal[0], normal[1], normal[2], 1.0f, 0.0f); // Bottom-right
-	}
-
-	// Store vertex count
-	m_Pyramid4Mesh.nVertices = verts.size() / (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
-
-	// Generate VAO and VBO
-	glGenVertexArrays(1, &m_Pyramid4Mesh.vao);
-	glBindVertexArray(m_Pyramid4Mesh.vao);
-
-	glGenBuffers(1, m_Pyramid4Mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid4Mesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-
-	// Set shader memory layout if not done
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
-
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	GenerateMesh("pyramid4", false, m_Pyramid4Mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildPyramid4(baseSize, height, data);
+	});
 }
 
 ///////////////////////////////////////////////////
 // LoadSphereMesh()
 //
-// Dynamically generate a sphere mesh with the given
-// latitude and longitude segment counts. Store it in
-// a VAO/VBO, including normals and texture coordinates.
+// Create a sphere mesh with the given latitude and
+// longitude segment counts, or map it from the mesh
+// cache, and store it in a VAO/VBO.  The top half
+// and the bottom half are drawn as two parts.
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadSphereMesh(int latitudeSegments, int longitudeSegments, float radius)
+void ShapeMeshes::LoadSphereMesh(int latitudeSegments, int longitudeSegments, float radius, int detailLevel)
 {
-	std::vector<GLfloat> vertices;
-	std::vector<GLuint> indices;
-
-	// Generate vertices, normals, and texture coordinates
-	for (int lat = 0; lat <= latitudeSegments; ++lat)
-	{
-		float theta = lat * Pi / latitudeSegments; // Latitude angle [0, PI]
-		float sinTheta = sin(theta);
-		float cosTheta = cos(theta);
-
-		for (int lon = 0; lon <= longitudeSegments; ++lon)
-		{
-			float phi = lon * 2 * Pi / longitudeSegments; // Longitude angle [0, 2*PI]
-			float sinPhi = sin(phi);
-			float cosPhi = cos(phi);
-
-			// Compute vertex position
-			float x = radius * sinTheta * cosPhi;
-			float y = radius * cosTheta;
-			float z = radius * sinTheta * sinPhi;
-
-			// Compute normal
-			float nx = sinTheta * cosPhi;
-			float ny = cosTheta;
-			float nz = sinTheta * sinPhi;
-
-			// Compute texture coordinates
-			float u = 1.0f - (float)lon / longitudeSegments;
-			float v = 1.0f - (float)lat / latitudeSegments;
-
-			// Push vertex data
-			vertices.push_back(x); // Position
-			vertices.push_back(y);
-			vertices.push_back(z);
-			vertices.push_back(nx); // Normal
-			vertices.push_back(ny);
-			vertices.push_back(nz);
-			vertices.push_back(u); // Texture coordinate
-			vertices.push_back(v);
-		}
-	}
-
-	// Generate indices for GL_TRIANGLES
-	for (int lat = 0; lat < latitudeSegments; ++lat)
-	{
-		for (int lon = 0; lon < longitudeSegments; ++lon)
-		{
-			int first = lat * (longitudeSegments + 1) + lon;
-			int second = first + longitudeSegments + 1;
-
-			// Triangle 1
-			indices.push_back(first);
-			indices.push_back(second);
-			indices.push_back(first + 1);
-
-			// Triangle 2
-			indices.push_back(second);
-			indices.push_back(second + 1);
-			indices.push_back(first + 1);
-		}
+	// the coarser tessellations are kept apart from the one drawn
+	// by the Draw methods
+	if ((detailLevel < 0) || (detailLevel >= DETAIL_LEVELS)) {
+		return;
 	}
+	GLMesh& mesh = (detailLevel == 0) ? m_SphereMesh : m_SphereLevels[detailLevel - 1];
 
-	// Store vertex and index count
-	m_SphereMesh.nVertices = static_cast<GLuint>(vertices.size() / 8); // 8 floats per vertex
-	m_SphereMesh.nIndices = static_cast<GLuint>(indices.size());
-
-	// Create VAO
-	glGenVertexArrays(1, &m_SphereMesh.vao);
-	glBindVertexArray(m_SphereMesh.vao);
-
-	// Create VBO for vertices
-	glGenBuffers(1, &m_SphereMesh.vbos[0]);
-	glBindBuffer(GL_ARRAY_BUFFER, m_SphereMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	// Create EBO for indices
-	glGenBuffers(1, &m_SphereMesh.vbos[1]);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereMesh.vbos[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Ensure shader memory layout is set
-	if (!m_bMemoryLayoutDone)
+	std::string cacheKey = MeshCache::MakeKey("sphere", { (float)latitudeSegments, (float)longitudeSegments, radius });
+	if (LoadCachedMesh(cacheKey, mesh))
 	{
-		SetShaderMemoryLayout();
+		return;
 	}
 
-	// Unbind VAO for safety
-	glBindVertexArray(0);
+	GenerateMesh(cacheKey, true, mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildSphere(latitudeSegments, longitudeSegments, radius, data);
+	});
 }
 
 ///////////////////////////////////////////////////
 //	LoadTaperedCylinderMesh()
 //
-//	Create a tapered cylinder mesh by specifying the 
-//  vertices and store it in a VAO/VBO.  The normals 
-//  and texture coordinates are also set.
-//
-//  Correct triangle drawing commands:
-//
-//	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-//	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
-//	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+//	Create a tapered cylinder mesh and store it in a
+//  VAO/VBO.  The bottom, top and sides are drawn as
+//  three parts.
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTaperedCylinderMesh()
 {
-	GLfloat verts[] = {
-		// cylinder bottom		// normals			// texture coords
-		1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f,1.0f,
-		.98f, 0.0f, -0.17f,		0.0f, -1.0f, 0.0f,	0.41f, 0.983f,
-		.94f, 0.0f, -0.34f,		0.0f, -1.0f, 0.0f,	0.33f, 0.96f,
-		.87f, 0.0f, -0.5f,		0.0f, -1.0f, 0.0f,	0.25f, 0.92f,
-		.77f, 0.0f, -0.64f,		0.0f, -1.0f, 0.0f,	0.17f, 0.87f,
-		.64f, 0.0f, -0.77f,		0.0f, -1.0f, 0.0f,	0.13f, 0.83f,
-		.5f, 0.0f, -0.87f,		0.0f, -1.0f, 0.0f,	0.08f, 0.77f,
-		.34f, 0.0f, -0.94f,		0.0f, -1.0f, 0.0f,	0.04f, 0.68f,
-		.17f, 0.0f, -0.98f,		0.0f, -1.0f, 0.0f,	0.017f, 0.6f,
-		0.0f, 0.0f, -1.0f,		0.0f, -1.0f, 0.0f,	0.0f,0.5f,
-		-.17f, 0.0f, -0.98f,	0.0f, -1.0f, 0.0f,	0.017f, 0.41f,
-		-.34f, 0.0f, -0.94f,	0.0f, -1.0f, 0.0f,	0.04f, 0.33f,
-		-.5f, 0.0f, -0.87f,		0.0f, -1.0f, 0.0f,	0.08f, 0.25f,
-		-.64f, 0.0f, -0.77f,	0.0f, -1.0f, 0.0f,	0.13f, 0.17f,
-		-.77f, 0.0f, -0.64f,	0.0f, -1.0f, 0.0f,	0.17f, 0.13f,
-		-.87f, 0.0f, -0.5f,		0.0f, -1.0f, 0.0f,	0.25f, 0.08f,
-		-.94f, 0.0f, -0.34f,	0.0f, -1.0f, 0.0f,	0.33f, 0.04f,
-		-.98f, 0.0f, -0.17f,	0.0f, -1.0f, 0.0f,	0.41f, 0.017f,
-		-1.0f, 0.0f, 0.0f,		0.0f, -1.0f, 0.0f,	0.5f, 0.0f,
-		-.98f, 0.0f, 0.17f,		0.0f, -1.0f, 0.0f,	0.6f, 0.017f,
-		-.94f, 0.0f, 0.34f,		0.0f, -1.0f, 0.0f,	0.68f, 0.04f,
-		-.87f, 0.0f, 0.5f,		0.0f, -1.0f, 0.0f,	0.77f, 0.08f,
-		-.77f, 0.0f, 0.64f,		0.0f, -1.0f, 0.0f,	0.83f, 0.13f,
-		-.64f, 0.0f, 0.77f,		0.0f, -1.0f, 0.0f,	0.87f, 0.17f,
-		-.5f, 0.0f, 0.87f,		0.0f, -1.0f, 0.0f,	0.92f, 0.25f,
-		-.34f, 0.0f, 0.94f,		0.0f, -1.0f, 0.0f,	0.96f, 0.33f,
-		-.17f, 0.0f, 0.98f,		0.0f, -1.0f, 0.0f,	0.983f, 0.41f,
-		0.0f, 0.0f, 1.0f,		0.0f, -1.0f, 0.0f,	1.0f, 0.5f,
-		.17f, 0.0f, 0.98f,		0.0f, -1.0f, 0.0f,	0.983f, 0.6f,
-		.34f, 0.0f, 0.94f,		0.0f, -1.0f, 0.0f,	0.96f, 0.68f,
-		.5f, 0.0f, 0.87f,		0.0f, -1.0f, 0.0f,	0.92f, 0.77f,
-		.64f, 0.0f, 0.77f,		0.0f, -1.0f, 0.0f,	0.87f, 0.83f,
-		.77f, 0.0f, 0.64f,		0.0f, -1.0f, 0.0f,	0.83f, 0.87f,
-		.87f, 0.0f, 0.5f,		0.0f, -1.0f, 0.0f,	0.77f, 0.92f,
-		.94f, 0.0f, 0.34f,		0.0f, -1.0f, 0.0f,	0.68f, 0.96f,
-		.98f, 0.0f, 0.17f,		0.0f, -1.0f, 0.0f,	0.6f, 0.983f,
-
-		// cylinder top			// normals			// texture coords
-		0.5f, 1.0f, 0.0f,		0.0f, 1.0f, 0.0f,	0.5f,1.0f,
-		.49f, 1.0f, -0.085f,	0.0f, 1.0f, 0.0f,	0.41f, 0.983f,
-		.47f, 1.0f, -0.17f,		0.0f, 1.0f, 0.0f,	0.33f, 0.96f,
-		.435f, 1.0f, -0.25f,	0.0f, 1.0f, 0.0f,	0.25f, 0.92f,
-		.385f, 1.0f, -0.32f,	0.0f, 1.0f, 0.0f,	0.17f, 0.87f,
-		.32f, 1.0f, -0.385f,	0.0f, 1.0f, 0.0f,	0.13f, 0.83f,
-		.25f, 1.0f, -0.435f,	0.0f, 1.0f, 0.0f,	0.08f, 0.77f,
-		.17f, 1.0f, -0.47f,		0.0f, 1.0f, 0.0f,	0.04f, 0.68f,
-		.085f, 1.0f, -0.49f,	0.0f, 1.0f, 0.0f,	0.017f, 0.6f,
-		0.0f, 1.0f, -0.5f,		0.0f, 1.0f, 0.0f,	0.0f,0.5f,
-		-.085f, 1.0f, -0.49f,	0.0f, 1.0f, 0.0f,	0.017f, 0.41f,
-		-.17f, 1.0f, -0.47f,	0.0f, 1.0f, 0.0f,	0.04f, 0.33f,
-		-.25f, 1.0f, -0.435f,	0.0f, 1.0f, 0.0f,	0.08f, 0.25f,
-		-.32f, 1.0f, -0.385f,	0.0f, 1.0f, 0.0f,	0.13f, 0.17f,
-		-.385f, 1.0f, -0.32f,	0.0f, 1.0f, 0.0f,	0.17f, 0.13f,
-		-.435f, 1.0f, -0.25f,	0.0f, 1.0f, 0.0f,	0.25f, 0.08f,
-		-.47f, 1.0f, -0.17f,	0.0f, 1.0f, 0.0f,	0.33f, 0.04f,
-		-.49f, 1.0f, -0.085f,	0.0f, 1.0f, 0.0f,	0.41f, 0.017f,
-		-0.5f, 1.0f, 0.0f,		0.0f, 1.0f, 0.0f,	0.5f, 0.0f,
-		-.49f, 1.0f, 0.085f,	0.0f, 1.0f, 0.0f,	0.6f, 0.017f,
-		-.47f, 1.0f, 0.17f,		0.0f, 1.0f, 0.0f,	0.68f, 0.04f,
-		-.435f, 1.0f, 0.25f,	0.0f, 1.0f, 0.0f,	0.77f, 0.08f,
-		-.385f, 1.0f, 0.32f,	0.0f, 1.0f, 0.0f,	0.83f, 0.13f,
-		-.32f, 1.0f, 0.385f,	0.0f, 1.0f, 0.0f,	0.87f, 0.17f,
-		-.25f, 1.0f, 0.435f,	0.0f, 1.0f, 0.0f,	0.92f, 0.25f,
-		-.17f, 1.0f, 0.47f,		0.0f, 1.0f, 0.0f,	0.96f, 0.33f,
-		-.085f, 1.0f, 0.49f,	0.0f, 1.0f, 0.0f,	0.983f, 0.41f,
-		0.0f, 1.0f, 0.5f,		0.0f, 1.0f, 0.0f,	1.0f, 0.5f,
-		.085f, 1.0f, 0.49f,		0.0f, 1.0f, 0.0f,	0.983f, 0.6f,
-		.17f, 1.0f, 0.47f,		0.0f, 1.0f, 0.0f,	0.96f, 0.68f,
-		.25f, 1.0f, 0.435f,		0.0f, 1.0f, 0.0f,	0.92f, 0.77f,
-		.32f, 1.0f, 0.385f,		0.0f, 1.0f, 0.0f,	0.87f, 0.83f,
-		.385f, 1.0f, 0.32f,		0.0f, 1.0f, 0.0f,	0.83f, 0.87f,
-		.435f, 1.0f, 0.25f,		0.0f, 1.0f, 0.0f,	0.77f, 0.92f,
-		.47f, 1.0f, 0.17f,		0.0f, 1.0f, 0.0f,	0.68f, 0.96f,
-		.49f, 1.0f, 0.085f,		0.0f, 1.0f, 0.0f,	0.6f, 0.983f,
-
-		// cylinder body		// normals							// texture coords
-		0.5f, 1.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f,	0.25,1.0,
-		1.0f, 0.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f,	0.0,0.0,
-		.98f, 0.0f, -0.17f,		0.993150651, 0.5f, -0.116841137f,	0.0277,0.0,
-		0.5f, 1.0f, 0.0f,		0.993150651, 0.5f, -0.116841137f, 	0.25,1.0,
-		.49f, 1.0f, -0.085f,	0.993150651, 0.5f, -0.116841137f, 	0.2635,1.0,
-		.98f, 0.0f, -0.17f,		0.993150651, 0.5f, -0.116841137f,	0.0277,0.0,
-		.94f, 0.0f, -0.34f,		0.993417103f, 0.5f, -0.229039446f,	0.0554,0.0,
-		.49f, 1.0f, -0.085f,	0.993417103f, 0.5f, -0.229039446f,	0.2635,1.0,
-		.47f, 1.0f, -0.17f,		0.993417103f, 0.5f, -0.229039446f,	0.277,1.0,
-		.94f, 0.0f, -0.34f,		0.993417103f, 0.5f, -0.229039446f,	0.0554,0.0,
-		.87f, 0.0f, -0.5f,		0.993417103f, 0.5f, -0.229039446f,	0.0831,0.0,
-		.47f, 1.0f, -0.17f,		0.993417103f, 0.5f, -0.229039446f,	0.277,1.0,
-		.435f, 1.0f, -0.25f,	0.813733339f, 0.5f, -0.581238329f,	0.2905,1.0,
-		.87f, 0.0f, -0.5f,		0.813733339f, 0.5f, -0.581238329f,	0.0831,0.0,
-		.77f, 0.0f, -0.64f,		0.813733339f, 0.5f, -0.581238329f,	0.1108,0.0,
-		.435f, 1.0f, -0.25f,	0.813733339f, 0.5f, -0.581238329f,	0.2905,1.0,
-		.385f, 1.0f, -0.32f,	0.813733339f, 0.5f, -0.581238329f,	0.304,1.0,
-		.77f, 0.0f, -0.64f,		0.813733339f, 0.5f, -0.581238329f,	0.1108,0.0,
-		.64f, 0.0f, -0.77f,		0.707106769f, 0.5f, -0.707106769f,	0.1385,0.0,
-		.385f, 1.0f, -0.32f,	0.707106769f, 0.5f, -0.707106769f,	0.304,1.0,
-		.32f, 1.0f, -0.385f,	0.707106769f, 0.5f, -0.707106769f,	0.3175,1.0,
-		.64f, 0.0f, -0.77f,		0.707106769f, 0.5f, -0.707106769f,	0.1385,0.0,
-		.5f, 0.0f, -0.87f,		0.707106769f, 0.5f, -0.707106769f,	0.1662,0.0,
-		.32f, 1.0f, -0.385f,	0.707106769f, 0.5f, -0.707106769f,	0.3175, 1.0,
-		.25f, 1.0f, -0.435f,	0.400818795f, 0.5f, -0.916157305f,	0.331, 1.0,
-		.5f, 0.0f, -0.87f,		0.400818795f, 0.5f, -0.916157305f,	0.1662, 0.0,
-		.34f, 0.0f, -0.94f,		0.400818795f, 0.5f, -0.916157305f,	0.1939, 0.0,
-		.25f, 1.0f, -0.435f,	0.400818795f, 0.5f, -0.916157305f,	0.331, 1.0,
-		.17f, 1.0f, -0.47f,		0.400818795f, 0.5f, -0.916157305f,	0.3445, 1.0,
-		.34f, 0.0f, -0.94f,		0.400818795f, 0.5f, -0.916157305f,	0.1939, 0.0,
-		.17f, 0.0f, -0.98f,		0.229039446f, 0.5f, -0.973417103f,	0.2216, 0.0,
-		.17f, 1.0f, -0.47f,		0.229039446f, 0.5f, -0.973417103f,	0.3445, 1.0,
-		.085f, 1.0f, -0.49f,	0.229039446f, 0.5f, -0.973417103f,	0.358, 1.0,
-		.17f, 0.0f, -0.98f,		0.229039446f, 0.5f, -0.973417103f,	0.2216, 0.0,
-		0.0f, 0.0f, -1.0f,		0.229039446f, 0.5f, -0.973417103f,	0.2493, 0.0,
-		.085f, 1.0f, -0.49f,	0.229039446f, 0.5f, -0.973417103f,	0.358, 1.0,
-		0.0f, 1.0f, -0.5f,		-0.116841137f, 0.5f, -0.993150651f,	0.3715, 1.0,
-		0.0f, 0.0f, -1.0f,		-0.116841137f, 0.5f, -0.993150651f,	0.2493, 0.0,
-		-.17f, 0.0f, -0.98f,	-0.116841137f, 0.5f, -0.993150651f,	0.277, 0.0,
-		0.0f, 1.0f, -0.5f,		-0.116841137f, 0.5f, -0.993150651f,	0.3715, 1.0,
-		-.085f, 1.0f, -0.49f,	-0.116841137f, 0.5f, -0.993150651f,	0.385, 1.0,
-		-.17f, 0.0f, -0.98f,	-0.116841137f, 0.5f, -0.993150651f,	0.277, 0.0,
-		-.34f, 0.0f, -0.94f,	-0.229039446f, 0.5f, -0.973417103f,	0.3047, 0.0,
-		-.085f, 1.0f, -0.49f,	-0.229039446f, 0.5f, -0.973417103f,	0.385, 1.0,
-		-.17f, 1.0f, -0.47f,	-0.229039446f, 0.5f, -0.973417103f,	0.3985, 1.0,
-		-.34f, 0.0f, -0.94f,	-0.229039446f, 0.5f, -0.973417103f,	0.3047, 0.0,
-		-.5f, 0.0f, -0.87f,		-0.229039446f, 0.5f, -0.973417103f,	0.3324, 0.0,
-		-.17f, 1.0f, -0.47f,	-0.229039446f, 0.5f, -0.973417103f,	0.3985, 1.0,
-		-.25f, 1.0f, -0.435f,	-0.581238329f, 0.5f, -0.581238329f,	0.412, 1.0,
-		-.5f, 0.0f, -0.87f,		-0.581238329f, 0.5f, -0.581238329f,	0.3324, 0.0,
-		-.64f, 0.0f, -0.77f,	-0.581238329f, 0.5f, -0.581238329f,	0.3601, 0.0,
-		-.25f, 1.0f, -0.435f,	-0.581238329f, 0.5f, -0.581238329f,	0.412, 1.0,
-		-.32f, 1.0f, -0.385f,	-0.581238329f, 0.5f, -0.581238329f,	0.4255, 1.0,
-		-.64f, 0.0f, -0.77f,	-0.581238329f, 0.5f, -0.581238329f,	0.3601, 0.0,
-		-.77f, 0.0f, -0.64f,	-0.707106769f, 0.5f, -0.707106769f,	0.3878, 0.0,
-		-.32f, 1.0f, -0.385f,	-0.707106769f, 0.5f, -0.707106769f,	0.4255, 1.0,
-		-.385f, 1.0f, -0.32f,	-0.707106769f, 0.5f, -0.707106769f,	0.439, 1.0,
-		-.77f, 0.0f, -0.64f,	-0.707106769f, 0.5f, -0.707106769f,	0.3878, 0.0,
-		-.87f, 0.0f, -0.5f,		-0.707106769f, 0.5f, -0.707106769f,	0.4155, 0.0,
-		-.385f, 1.0f, -0.32f,	-0.707106769f, 0.5f, -0.707106769f,	0.439, 1.0,
-		-.435f, 1.0f, -0.25f,	-0.916157305f, 0.5f, -0.400818795f,	0.4525, 1.0,
-		-.87f, 0.0f, -0.5f,		-0.916157305f, 0.5f, -0.400818795f,	0.4155, 0.0,
-		-.94f, 0.0f, -0.34f,	-0.916157305f, 0.5f, -0.400818795f,	0.4432, 0.0,
-		-.435f, 1.0f, -0.25f,	-0.916157305f, 0.5f, -0.400818795f,	0.4525, 1.0,
-		-.47f, 1.0f, -0.17f,	-0.916157305f, 0.5f, -0.400818795f,	0.466, 1.0,
-		-.94f, 0.0f, -0.34f,	-0.916157305f, 0.5f, -0.400818795f,	0.4432, 0.0,
-		-.98f, 0.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.4709, 0.0,
-		-.47f, 1.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.466, 1.0,
-		-.49f, 1.0f, -0.085f,	-0.973417103f, 0.5f, -0.229039446f,	0.4795, 1.0,
-		-.98f, 0.0f, -0.17f,	-0.973417103f, 0.5f, -0.229039446f,	0.4709, 0.0,
-		-1.0f, 0.0f, 0.0f,		-0.973417103f, 0.5f, -0.229039446f,	0.4986, 0.0,
-		-.49f, 1.0f, -0.085f,	-0.973417103f, 0.5f, -0.229039446f,	0.4795, 1.0,
-		-0.5f, 1.0f, 0.0f,		-0.993150651f, 0.5f, -0.116841137f,	0.493, 1.0,
-		-1.0f, 0.0f, 0.0f,		-0.993150651f, 0.5f, -0.116841137f,	0.4986, 0.0,
-		-.98f, 0.0f, 0.17f,		-0.993150651f, 0.5f, 0.116841137f,	0.5263, 0.0,
-		-0.5f, 1.0f, 0.0f,		-0.993150651f, 0.5f, 0.116841137f,	0.493, 1.0,
-		-.49f, 1.0f, 0.085f,	-0.993150651f, 0.5f, 0.116841137f,	0.5065, 1.0,
-		-.98f, 0.0f, 0.17f,		-0.993150651f, 0.5f, 0.116841137f,	0.5263, 0.0,
-		-.94f, 0.0f, 0.34f,		-0.973417103f, 0.5f, 0.229039446f,	0.554, 0.0,
-		-.49f, 1.0f, 0.085f,	-0.973417103f, 0.5f, 0.229039446f,	0.5065, 1.0,
-		-.47f, 1.0f, 0.17f,		-0.973417103f, 0.5f, 0.229039446f,	0.52, 1.0,
-		-.94f, 0.0f, 0.34f,		-0.973417103f, 0.5f, 0.229039446f,	0.554, 0.0,
-		-.87f, 0.0f, 0.5f,		-0.973417103f, 0.5f, 0.229039446f,	0.5817, 0.0,
-		-.47f, 1.0f, 0.17f,		-0.973417103f, 0.5f, 0.229039446f,	0.52, 1.0,
-		-.435f, 1.0f, 0.25f,	-0.813733339f, 0.5f, 0.581238329f,	0.5335, 1.0,
-		-.87f, 0.0f, 0.5f,		-0.813733339f, 0.5f, 0.581238329f,	0.5817, 0.0,
-		-.77f, 0.0f, 0.64f,		-0.813733339f, 0.5f, 0.581238329f,	0.6094, 0.0,
-		-.435f, 1.0f, 0.25f,	-0.813733339f, 0.5f, 0.581238329f,	0.5335, 1.0,
-		-.385f, 1.0f, 0.32f,	-0.813733339f, 0.5f, 0.581238329f,	0.547, 1.0,
-		-.77f, 0.0f, 0.64f,		-0.813733339f, 0.5f, 0.581238329f,	0.6094, 0.0,
-		-.64f, 0.0f, 0.77f,		-0.707106769f, 0.5f, 0.707106769f,	0.6371, 0.0,
-		-.385f, 1.0f, 0.32f,	-0.707106769f, 0.5f, 0.707106769f,	0.547, 1.0,
-		-.32f, 1.0f, 0.385f,	-0.707106769f, 0.5f, 0.707106769f,	0.5605, 1.0,
-		-.64f, 0.0f, 0.77f,		-0.707106769f, 0.5f, 0.707106769f,	0.6371, 0.0,
-		-.5f, 0.0f, 0.87f,		-0.707106769f, 0.5f, 0.707106769f,	0.6648, 0.0,
-		-.32f, 1.0f, 0.385f,	-0.707106769f, 0.5f, 0.707106769f,	0.5605, 1.0,
-		-.25f, 1.0f, 0.435f,	-0.400818795f, 0.5f, 0.916157305f,	0.574, 1.0,
-		-.5f, 0.0f, 0.87f,		-0.400818795f, 0.5f, 0.916157305f,	0.6648, 0.0,
-		-.34f, 0.0f, 0.94f,		-0.400818795f, 0.5f, 0.916157305f,	0.6925, 0.0,
-		-.25f, 1.0f, 0.435f,	-0.400818795f, 0.5f, 0.916157305f,	0.574, 1.0,
-		-.17f, 1.0f, 0.47f,		-0.400818795f, 0.5f, 0.916157305f,	0.5875, 1.0,
-		-.34f, 0.0f, 0.94f,		-0.400818795f, 0.5f, 0.916157305f,	0.6925, 0.0,
-		-.17f, 0.0f, 0.98f,		-0.229039446f, 0.5f, 0.973417103f,	0.7202, 0.0,
-		-.17f, 1.0f, 0.47f,		-0.229039446f, 0.5f, 0.973417103f,	0.5875, 1.0,
-		-.085f, 1.0f, 0.49f,	-0.229039446f, 0.5f, 0.973417103f,	0.601, 1.0,
-		-.17f, 0.0f, 0.98f,		-0.229039446f, 0.5f, 0.973417103f,	0.7202, 0.0,
-		0.0f, 0.0f, 1.0f,		-0.229039446f, 0.5f, 0.973417103f,	0.7479, 0.0,
-		-.085f, 1.0f, 0.49f,	-0.229039446f, 0.5f, 0.973417103f,	0.601, 1.0,
-		0.0f, 1.0f, 0.5f,		-0.116841137f, 0.5f, 0.993150651f,	0.6145, 1.0,
-		0.0f, 0.0f, 1.0f,		-0.116841137f, 0.5f, 0.993150651f,	0.7479, 0.0,
-		.17f, 0.0f, 0.98f,		0.116841137f, 0.5f, 0.993150651f,	0.7756, 0.0,
-		0.0f, 1.0f, 0.5f,		0.116841137f, 0.5f, 0.993150651f,	0.6145, 1.0,
-		.085f, 1.0f, 0.49f,		0.116841137f, 0.5f, 0.993150651f,	0.628, 1.0,
-		.17f, 0.0f, 0.98f,		0.116841137f, 0.5f, 0.993150651f,	0.7756, 0.0,
-		.34f, 0.0f, 0.94f,		0.229039446f, 0.5f, 0.973417103f,	0.8033, 0.0,
-		.085f, 1.0f, 0.49f,		0.229039446f, 0.5f, 0.973417103f,	0.628, 1.0,
-		.17f, 1.0f, 0.47f,		0.229039446f, 0.5f, 0.973417103f,	0.6415, 1.0,
-		.34f, 0.0f, 0.94f,		0.229039446f, 0.5f, 0.973417103f,	0.8033, 0.0,
-		.5f, 0.0f, 0.87f,		0.229039446f, 0.5f, 0.973417103f,	0.831, 0.0,
-		.17f, 1.0f, 0.47f,		0.229039446f, 0.5f, 0.973417103f,	0.6415, 1.0,
-		.25f, 1.0f, 0.435f,		0.581238329f, 0.5f, 0.813733339f,	0.655, 1.0,
-		.5f, 0.0f, 0.87f,		0.581238329f, 0.5f, 0.813733339f,	0.831, 0.0,
-		.64f, 0.0f, 0.77f,		0.581238329f, 0.5f, 0.813733339f,	0.8587, 0.0,
-		.25f, 1.0f, 0.435f,		0.581238329f, 0.5f, 0.813733339f,	0.655, 1.0,
-		.32f, 1.0f, 0.385f,		0.581238329f, 0.5f, 0.813733339f,	0.6685, 1.0,
-		.64f, 0.0f, 0.77f,		0.581238329f, 0.5f, 0.813733339f,	0.8587, 0.0,
-		.77f, 0.0f, 0.64f,		0.707106769f, 0.5f, 0.707106769f,	0.8864, 0.0,
-		.32f, 1.0f, 0.385f,		0.707106769f, 0.5f, 0.707106769f,	0.6685, 1.0,
-		.385f, 1.0f, 0.32f,		0.707106769f, 0.5f, 0.707106769f,	0.682, 1.0,
-		.77f, 0.0f, 0.64f,		0.707106769f, 0.5f, 0.707106769f,	0.8864, 0.0,
-		.87f, 0.0f, 0.5f,		0.707106769f, 0.5f, 0.707106769f,	0.9141, 0.0,
-		.385f, 1.0f, 0.32f,		0.707106769f, 0.5f, 0.707106769f,	0.682, 1.0,
-		.435f, 1.0f, 0.25f,		0.916157305f, 0.5f, 0.400818795f,	0.6955, 1.0,
-		.87f, 0.0f, 0.5f,		0.916157305f, 0.5f, 0.400818795f,	0.9141, 0.0,
-		.94f, 0.0f, 0.34f,		0.916157305f, 0.5f, 0.400818795f,	0.9418, 0.0,
-		.435f, 1.0f, 0.25f,		0.916157305f, 0.5f, 0.400818795f,	0.6955, 1.0,
-		.47f, 1.0f, 0.17f,		0.916157305f, 0.5f, 0.400818795f,	0.709, 1.0,
-		.94f, 0.0f, 0.34f,		0.916157305f, 0.5f, 0.400818795f,	0.9418, 1.0,
-		.98f, 0.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.9695, 0.0,
-		.47f, 1.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.709, 0.0,
-		.49f, 1.0f, 0.085f,		0.973417103f, 0.5f, 0.229039446f,	0.7225, 1.0,
-		.98f, 0.0f, 0.17f,		0.973417103f, 0.5f, 0.229039446f,	0.9695, 0.0,
-		1.0f, 0.0f, 0.0f,		0.973417103f, 0.5f, 0.229039446f,	1.0, 0.0,
-		.49f, 1.0f, 0.085f,		0.973417103f, 0.5f, 0.229039446f,	0.7225, 1.0,
-		0.5f, 1.0f, 0.0f,		0.993150651f, 0.5f, 0.116841137f,	0.75, 1.0,
-		1.0f, 0.0f, 0.0f,		0.993150651f, 0.5f, 0.116841137f,	1.0, 0.0
-	};
-
-	// store vertex and index count
-	m_TaperedCylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV));
-	m_TaperedCylinderMesh.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TaperedCylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_TaperedCylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_TaperedCylinderMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	GenerateMesh("tapered cylinder", false, m_TaperedCylinderMesh, MeshBuilder::BuildTaperedCylinder);
 }
 
 ///////////////////////////////////////////////////
 //	LoadTorusMesh()
 //
 //	Create a parameterized torus mesh by specifying the
-//	main radius, tube radius, and segment counts. Store
-//	the generated data in a VAO/VBO.
+//	main radius, tube radius, and segment counts, or
+//	map it from the mesh cache.  Store it in a VAO/VBO.
 //
-//	Correct triangle drawing command:
-//
-//	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
+//	The triangles are drawn in two parts, the first
+//	half of the ring and the second half.
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadTorusMesh(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments) {
+void ShapeMeshes::LoadTorusMesh(float mainRadius, float tubeRadius, int mainSegments, int tubeSegments, int detailLevel) {
+	// the coarser tessellations are kept apart from the one drawn
+	// by the Draw methods
+	if ((detailLevel < 0) || (detailLevel >= DETAIL_LEVELS)) {
+		return;
+	}
+	GLMesh& mesh = (detailLevel == 0) ? m_TorusMesh : m_TorusLevels[detailLevel - 1];
+
 	// Validate input parameters
 	mainSegments = std::max(3, mainSegments);
 	tubeSegments = std::max(3, tubeSegments);
 	tubeRadius = std::max(0.01f, tubeRadius);
 
-	float mainSegmentStep = 2.0f * Pi / mainSegments;
-	float tubeSegmentStep = 2.0f * Pi / tubeSegments;
-
-	std::vector<GLfloat> vertices;
-	std::vector<GLuint> indices;
-
-	// Generate vertices and normals
-	for (int i = 0; i <= mainSegments; ++i) {
-		float mainAngle = i * mainSegmentStep;
-		float cosMain = cos(mainAngle);
-		float sinMain = sin(mainAngle);
-
-		for (int j = 0; j <= tubeSegments; ++j) {
-			float tubeAngle = j * tubeSegmentStep;
-			float cosTube = cos(tubeAngle);
-			float sinTube = sin(tubeAngle);
-
-			// Vertex position
-			float x = (mainRadius + tubeRadius * cosTube) * cosMain;
-			float y = (mainRadius + tubeRadius * cosTube) * sinMain;
-			float z = tubeRadius * sinTube;
-
-			// Normal vector
-			glm::vec3 center(mainRadius * cosMain, mainRadius * sinMain, 0.0f);
-			glm::vec3 vertex(x, y, z);
-			glm::vec3 normal = glm::normalize(vertex - center);
-
-			// Texture coordinates
-			float u = (float)i / mainSegments;
-			float v = (float)j / tubeSegments;
-
-			// Store interleaved vertex data
-			vertices.push_back(x);    // Position x
-			vertices.push_back(y);    // Position y
-			vertices.push_back(z);    // Position z
-			vertices.push_back(normal.x); // Normal x
-			vertices.push_back(normal.y); // Normal y
-			vertices.push_back(normal.z); // Normal z
-			vertices.push_back(u);    // Texture u
-			vertices.push_back(v);    // Texture v
-		}
-	}
-
-	// Generate indices for triangle strips
-	for (int i = 0; i < mainSegments; ++i) {
-		for (int j = 0; j < tubeSegments; ++j) {
-			int current = i * (tubeSegments + 1) + j;
-			int next = (i + 1) * (tubeSegments + 1) + j;
-
-			// First triangle
-			indices.push_back(current);
-			indices.push_back(next);
-			indices.push_back(current + 1);
-
-			// Second triangle
-			indices.push_back(current + 1);
-			indices.push_back(next);
-			indices.push_back(next + 1);
-		}
+	std::string cacheKey = MeshCache::MakeKey("torus", { mainRadius, tubeRadius, (float)mainSegments, (float)tubeSegments });
+	if (LoadCachedMesh(cacheKey, mesh)) {
+		return;
 	}
 
-	// Store vertex and index counts
-	m_TorusMesh.nVertices = static_cast<GLuint>(vertices.size() / 8); // 8 floats per vertex
-	m_TorusMesh.nIndices = static_cast<GLuint>(indices.size());
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TorusMesh.vao);
-	glBindVertexArray(m_TorusMesh.vao);
-
-	// Create VBO for vertices
-	GLuint vertexBuffer;
-	glGenBuffers(1, &vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-	// Create EBO for indices
-	GLuint indexBuffer;
-	glGenBuffers(1, &indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-	// Define vertex attributes
-	GLint stride = sizeof(GLfloat) * 8;
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);                      // Position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat))); // Normal
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat))); // Texture coords
-	glEnableVertexAttribArray(2);
-
-	// Unbind VAO for safety
-	glBindVertexArray(0);
-
-	// Mark memory layout as complete
-	if (!m_bMemoryLayoutDone) {
-		SetShaderMemoryLayout();
-	}
+	GenerateMesh(cacheKey, true, mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildTorus(mainRadius, tubeRadius, mainSegments, tubeSegments, data);
+	});
 }
 
 
 ///////////////////////////////////////////////////
 //	LoadExtraTorusMesh1()
 //
-//	Create a torus mesh by specifying the vertices and 
+//	Create a torus mesh by specifying the vertices and
 //  store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadExtraTorusMesh1(float thickness, int mainSegments, int tubeSegments)
+{
+	LoadExtraTorusMesh("extra torus 1", m_ExtraTorusMesh1, thickness, mainSegments, tubeSegments);
+}
+
+///////////////////////////////////////////////////
+//	LoadExtraTorusMesh2()
 //
-//	Correct triangle drawing command:
+//	Create a torus mesh by specifying the vertices and
+//  store it in a VAO/VBO.  The normals and texture
+//  coordinates are also set.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadExtraTorusMesh2(float thickness, int mainSegments, int tubeSegments)
+{
+	LoadExtraTorusMesh("extra torus 2", m_ExtraTorusMesh2, thickness, mainSegments, tubeSegments);
+}
+
+///////////////////////////////////////////////////
+//	LoadExtraTorusMesh()
 //
-//	glDrawArrays(GL_TRIANGLES, 0, meshes.gExtraTorusMesh1.nVertices);
+//	Loads one of the extra tori from the mesh cache,
+//	or generates it and stores it in a VAO/VBO.
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadExtraTorusMesh1(float thickness)
+void ShapeMeshes::LoadExtraTorusMesh(const char* name, GLMesh& mesh, float thickness, int mainSegments, int tubeSegments)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
+	mainSegments = std::max(3, mainSegments);
+	tubeSegments = std::max(3, tubeSegments);
 
-	if (thickness <= 1.0)
+	std::string cacheKey = MeshCache::MakeKey(name, { thickness, (float)mainSegments, (float)tubeSegments });
+	if (LoadCachedMesh(cacheKey, mesh))
 	{
-		_tubeRadius = thickness;
+		return;
 	}
 
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+	GenerateMesh(cacheKey, true, mesh, [=](MeshBuilder::MESH_DATA& data) {
+		MeshBuilder::BuildExtraTorus(thickness, mainSegments, tubeSegments, data);
+	});
+}
 
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
+///////////////////////////////////////////////////
+//	BeginMeshLoading()
+//
+//	Starts queueing the meshes that are not in the
+//	mesh cache, instead of generating each one when
+//	its Load method is called.
+///////////////////////////////////////////////////
+void ShapeMeshes::BeginMeshLoading()
+{
+	m_bQueueMeshes = true;
+}
 
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
+///////////////////////////////////////////////////
+//	FinishMeshLoading()
+//
+//	Runs the builders of the queued meshes on a pool
+//	of worker threads, with the calling thread taking
+//	its share, then uploads the meshes in the order
+//	they were queued.  Only the uploads need the
+//	OpenGL context.
+///////////////////////////////////////////////////
+void ShapeMeshes::FinishMeshLoading()
+{
+	m_bQueueMeshes = false;
+	if (m_pendingMeshes.empty())
 	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
-
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
+		return;
+	}
 
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
+	std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
 
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
+	int threadCount = (int)std::thread::hardware_concurrency();
+	if (threadCount < 1)
+	{
+		threadCount = 1;
+	}
+	if (threadCount > (int)m_pendingMeshes.size())
+	{
+		threadCount = (int)m_pendingMeshes.size();
 	}
 
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
-
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
+	// each thread takes the next mesh nobody has taken yet
+	std::atomic<size_t> nextMesh(0);
+	auto buildMeshes = [this, &nextMesh]()
 	{
-		for (int j = 0; j < _tubeSegments; j++)
+		for (size_t i = nextMesh++; i < m_pendingMeshes.size(); i = nextMesh++)
 		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-
-			}
-			v += verticalStep;
+			m_pendingMeshes[i].builder(m_pendingMeshes[i].data);
 		}
-		v = 0.0;
-		u += horizontalStep;
-	}
-
-	std::vector<GLfloat> combined_values;
+	};
 
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadCount; i++)
 	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
+		workers.push_back(std::thread(buildMeshes));
+	}
+	buildMeshes();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
 	}
 
-	// store vertex and index count
-	m_ExtraTorusMesh1.nVertices = vertex_list.size();
-	m_ExtraTorusMesh1.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh1.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh1.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh1.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
+	std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+	for (PENDING_MESH& pending : m_pendingMeshes)
 	{
-		SetShaderMemoryLayout();
+		UploadMesh(pending.name, pending.bCacheMesh, *pending.pMesh, pending.data);
 	}
+	std::chrono::steady_clock::time_point uploadEnd = std::chrono::steady_clock::now();
+
+	std::cout << "Mesh generation:" << m_pendingMeshes.size() << " meshes on " << threadCount
+		<< " threads, build ms:" << std::chrono::duration<double, std::milli>(uploadStart - buildStart).count()
+		<< ", upload ms:" << std::chrono::duration<double, std::milli>(uploadEnd - uploadStart).count() << std::endl;
+
+	m_pendingMeshes.clear();
 }
 
 ///////////////////////////////////////////////////
-//	LoadExtraTorusMesh2()
-//
-//	Create a torus mesh by specifying the vertices and 
-//  store it in a VAO/VBO.  The normals and texture
-//  coordinates are also set.
-//
-//	Correct triangle drawing command:
+//	GenerateMesh()
 //
-//	glDrawArrays(GL_TRIANGLES, 0, meshes.gExtraTorusMesh1.nVertices);
+//	Runs the builder of a mesh and uploads what it
+//	built, or queues it for FinishMeshLoading() while
+//	meshes are being queued.
 ///////////////////////////////////////////////////
-void ShapeMeshes::LoadExtraTorusMesh2(float thickness)
+void ShapeMeshes::GenerateMesh(const std::string& name, bool bCacheMesh, GLMesh& mesh, const MESH_BUILDER& builder)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
+	PENDING_MESH pending;
+	pending.name = name;
+	pending.bCacheMesh = bCacheMesh;
+	pending.pMesh = &mesh;
+	pending.builder = builder;
 
-	if (thickness <= 1.0)
+	if (m_bQueueMeshes)
 	{
-		_tubeRadius = thickness;
+		m_pendingMeshes.push_back(pending);
+		return;
 	}
 
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
-
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
+	builder(pending.data);
+	UploadMesh(name, bCacheMesh, mesh, pending.data);
+}
 
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
+///////////////////////////////////////////////////
+//	UploadMesh()
+//
+//	Uploads the vertices and indices of a built mesh
+//	into a new VAO/VBO, sets the mesh's counts, parts
+//	and bounds, logs how its triangles use the vertex
+//	cache, and writes it to the mesh cache if asked.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadMesh(const std::string& name, bool bCacheMesh, GLMesh& mesh, const MeshBuilder::MESH_DATA& data)
+{
+	mesh.nVertices = (GLuint)(data.vertices.size() / MeshBuilder::FLOATS_PER_VERTEX);
+	mesh.nIndices = (GLuint)data.indices.size();
+	mesh.nParts = (int)data.partIndexCounts.size();
+	for (int i = 0; i < mesh.nParts; i++)
 	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
-
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
-
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
-
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
+		mesh.partIndexCounts[i] = data.partIndexCounts[i];
 	}
+	mesh.bounds = data.bounds;
 
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
-
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
-	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
+	char statistics[96];
+	snprintf(statistics, sizeof(statistics), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+		data.cacheBefore.acmr, data.cacheAfter.acmr, data.cacheBefore.atvr, data.cacheAfter.atvr);
+	std::cout << "Mesh indices:" << name << " " << mesh.nIndices / 3 << " triangles in "
+		<< mesh.nParts << " parts, " << statistics << std::endl;
 
-			}
-			v += verticalStep;
-		}
-		v = 0.0;
-		u += horizontalStep;
-	}
+	// Generate VAO and VBOs
+	glGenVertexArrays(1, &mesh.vao);
+	GLStateCache::BindVertexArray(mesh.vao);
 
-	std::vector<GLfloat> combined_values;
+	glGenBuffers(2, mesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(GLfloat), data.vertices.data(), GL_STATIC_DRAW);
+	UploadMeshIndices(mesh, data.indices.data());
 
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
+	if (bCacheMesh)
 	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
+		StoreCachedMesh(name, mesh, data.vertices.data(), data.indices.data());
 	}
 
-	// store vertex and index count
-	m_ExtraTorusMesh2.nVertices = vertex_list.size();
-	m_ExtraTorusMesh2.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh2.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh2.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh2.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	SetShaderMemoryLayout();
 
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// Unbind VAO for safety
+	GLStateCache::BindVertexArray(0);
 }
 
 //**************************************************************************
@@ -1456,17 +447,16 @@ void ShapeMeshes::DrawBoxMesh() const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
-	glDrawElements(GL_TRIANGLES, m_BoxMesh.nIndices, GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+	GLStateCache::BindVertexArray(m_BoxMesh.vao);
+	DrawMeshParts(m_BoxMesh, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
 // DrawBoxMeshSide()
 //
-// Draws a specific side of the box mesh using 
-// triangle fan mode. Each side can be textured 
-// differently before drawing.
+// Draws a specific side of the box mesh, the part
+// of its triangles for that face. Each side can be
+// textured differently before drawing.
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawBoxMeshSide(BoxSide side) const
 {
@@ -1475,26 +465,16 @@ void ShapeMeshes::DrawBoxMeshSide(BoxSide side) const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
-
-	// Mapping side to starting vertex index
-	constexpr GLint sideStartIndices[] = {
-		0,   // back
-		4,   // bottom
-		8,   // left
-		12,  // right
-		16,  // top
-		20   // front
-	};
+	GLStateCache::BindVertexArray(m_BoxMesh.vao);
 
-	if (side < back || side > front) {
+	// each side is the part of the face whose four vertices
+	// start at side * 4
+	if (side < front || side > bottom) {
 		std::cerr << "Error: Invalid box side specified." << std::endl;
-		glBindVertexArray(0);
 		return;
 	}
 
-	glDrawArrays(GL_TRIANGLE_FAN, sideStartIndices[side], 4);
-	glBindVertexArray(0);
+	DrawMeshParts(m_BoxMesh, 1u << side);
 }
 
 
@@ -1511,13 +491,10 @@ void ShapeMeshes::DrawBoxMeshLines() const
 		return;
 	}
 
-	glBindVertexArray(m_BoxMesh.vao);
+	GLStateCache::BindVertexArray(m_BoxMesh.vao);
 
 	// Draw the box using line primitives for outlining edges
-	glDrawElements(GL_LINE_STRIP, m_BoxMesh.nIndices, GL_UNSIGNED_INT, nullptr);
-
-	glBindVertexArray(0);
-	glBindVertexArray(0);
+	glDrawElements(GL_LINE_STRIP, m_BoxMesh.nIndices, m_BoxMesh.indexType, nullptr);
 }
 
 
@@ -1528,19 +505,10 @@ void ShapeMeshes::DrawBoxMeshLines() const
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawConeMesh(bool bDrawBottom) {
-	glBindVertexArray(m_ConeMesh.vao);
+	GLStateCache::BindVertexArray(m_ConeMesh.vao);
 
-	// Bottom circle vertex count: numSlices + 2 (center + all slices + closing slice)
-	int bottomVertexCount = m_ConeMesh.numSlices + 2;
-	// Side vertex count: 2 vertices per slice
-	int sideVertexCount = m_ConeMesh.numSlices * 2;
-
-	if (bDrawBottom) {
-		glDrawArrays(GL_TRIANGLE_FAN, 0, bottomVertexCount); // Bottom circle
-	}
-	glDrawArrays(GL_TRIANGLE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
-
-	glBindVertexArray(0);
+	// part 0 is the bottom circle, part 1 the cone sides
+	DrawMeshParts(m_ConeMesh, (bDrawBottom ? 1u : 0u) | 2u);
 }
 
 ///////////////////////////////////////////////////
@@ -1550,7 +518,7 @@ void ShapeMeshes::DrawConeMesh(bool bDrawBottom) {
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawConeMeshLines(bool bDrawBottom) {
-	glBindVertexArray(m_ConeMesh.vao);
+	GLStateCache::BindVertexArray(m_ConeMesh.vao);
 
 	// Bottom circle vertex count: numSlices + 2 (center + all slices + closing slice)
 	int bottomVertexCount = m_ConeMesh.numSlices + 2;
@@ -1562,7 +530,6 @@ void ShapeMeshes::DrawConeMeshLines(bool bDrawBottom) {
 	}
 	glDrawArrays(GL_LINE_STRIP, bottomVertexCount, sideVertexCount); // Cone sides
 
-	glBindVertexArray(0);
 }
 
 
@@ -1577,29 +544,10 @@ void ShapeMeshes::DrawCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	// Calculate vertex counts
-	int bottomVertexCount = m_CylinderMesh.numSlices + 2; // Center + all slices + closing slice
-	int topVertexCount = m_CylinderMesh.numSlices + 2;    // Same as bottom
-	int sideVertexCount = (m_CylinderMesh.numSlices + 1) * 2; // Two vertices per slice, +1 for closing strip
-
-	// Draw the bottom circle
-	if (bDrawBottom) {
-		glDrawArrays(GL_TRIANGLE_FAN, 0, bottomVertexCount);
-	}
-
-	// Draw the top circle
-	if (bDrawTop) {
-		glDrawArrays(GL_TRIANGLE_FAN, bottomVertexCount, topVertexCount);
-	}
-
-	// Draw the sides
-	if (bDrawSides) {
-		glDrawArrays(GL_TRIANGLE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
-	}
+	GLStateCache::BindVertexArray(m_CylinderMesh.vao);
 
-	glBindVertexArray(0);
+	// parts 0, 1 and 2 are the bottom circle, the top circle and the sides
+	DrawMeshParts(m_CylinderMesh, (bDrawBottom ? 1u : 0u) | (bDrawTop ? 2u : 0u) | (bDrawSides ? 4u : 0u));
 }
 
 ///////////////////////////////////////////////////
@@ -1614,7 +562,7 @@ void ShapeMeshes::DrawCylinderMeshLines(
 	bool bDrawSides
 )
 {
-	glBindVertexArray(m_CylinderMesh.vao);
+	GLStateCache::BindVertexArray(m_CylinderMesh.vao);
 
 	// Calculate vertex counts
 	int bottomVertexCount = m_CylinderMesh.numSlices + 2; // Center + all slices + closing slice
@@ -1636,7 +584,6 @@ void ShapeMeshes::DrawCylinderMeshLines(
 		glDrawArrays(GL_LINE_STRIP, bottomVertexCount + topVertexCount, sideVertexCount);
 	}
 
-	glBindVertexArray(0);
 }
 
 
@@ -1648,11 +595,9 @@ void ShapeMeshes::DrawCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMesh()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	GLStateCache::BindVertexArray(m_PlaneMesh.vao);
 
-	glDrawElements(GL_TRIANGLE_STRIP, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-	
-	glBindVertexArray(0);
+	DrawMeshParts(m_PlaneMesh, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1663,11 +608,9 @@ void ShapeMeshes::DrawPlaneMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMeshLines()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
-
-	glDrawElements(GL_LINE_STRIP, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	GLStateCache::BindVertexArray(m_PlaneMesh.vao);
 
-	glBindVertexArray(0);
+	glDrawElements(GL_LINE_STRIP, m_PlaneMesh.nIndices, m_PlaneMesh.indexType, (void*)0);
 }
 
 ///////////////////////////////////////////////////
@@ -1677,12 +620,10 @@ void ShapeMeshes::DrawPlaneMeshLines()
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMesh() {
-	glBindVertexArray(m_PrismMesh.vao);
+	GLStateCache::BindVertexArray(m_PrismMesh.vao);
 
 	// Draw the base and slanted faces
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
-
-	glBindVertexArray(0); // Unbind the VAO after drawing
+	DrawMeshParts(m_PrismMesh, ALL_MESH_PARTS);
 }
 
 
@@ -1693,12 +634,10 @@ void ShapeMeshes::DrawPrismMesh() {
 //
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMeshLines() {
-	glBindVertexArray(m_PrismMesh.vao);
+	GLStateCache::BindVertexArray(m_PrismMesh.vao);
 
 	// Use GL_LINE_LOOP or GL_LINE_STRIP for wireframe rendering
 	glDrawArrays(GL_LINE_STRIP, 0, m_PrismMesh.nVertices);
-
-	glBindVertexArray(0); // Unbind the VAO after drawing
 }
 
 ///////////////////////////////////////////////////
@@ -1714,11 +653,9 @@ void ShapeMeshes::DrawPyramid3Mesh()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	GLStateCache::BindVertexArray(m_Pyramid3Mesh.vao);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
-
-	glBindVertexArray(0);
+	DrawMeshParts(m_Pyramid3Mesh, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1734,11 +671,9 @@ void ShapeMeshes::DrawPyramid3MeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	GLStateCache::BindVertexArray(m_Pyramid3Mesh.vao);
 
 	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid3Mesh.nVertices);
-
-	glBindVertexArray(0);
 }
 
 ///////////////////////////////////////////////////
@@ -1754,11 +689,9 @@ void ShapeMeshes::DrawPyramid4Mesh()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	GLStateCache::BindVertexArray(m_Pyramid4Mesh.vao);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
-
-	glBindVertexArray(0);
+	DrawMeshParts(m_Pyramid4Mesh, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1774,11 +707,9 @@ void ShapeMeshes::DrawPyramid4MeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	GLStateCache::BindVertexArray(m_Pyramid4Mesh.vao);
 
 	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid4Mesh.nVertices);
-
-	glBindVertexArray(0);
 }
 
 
@@ -1790,21 +721,17 @@ void ShapeMeshes::DrawSphereMesh()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
+	GLStateCache::BindVertexArray(m_SphereMesh.vao);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices, GL_UNSIGNED_INT, nullptr);
-
-	glBindVertexArray(0);
+	DrawMeshParts(m_SphereMesh, ALL_MESH_PARTS);
 }
 
 
 void ShapeMeshes::DrawSphereMeshLines()
 {
-	glBindVertexArray(m_SphereMesh.vao);
-
-	glDrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	GLStateCache::BindVertexArray(m_SphereMesh.vao);
 
-	glBindVertexArray(0);
+	glDrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices, m_SphereMesh.indexType, (void*)0);
 }
 
 void ShapeMeshes::DrawHalfSphereMesh()
@@ -1815,11 +742,10 @@ void ShapeMeshes::DrawHalfSphereMesh()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
+	GLStateCache::BindVertexArray(m_SphereMesh.vao);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices / 2, GL_UNSIGNED_INT, nullptr);
-
-	glBindVertexArray(0);
+	// part 0 is the top half
+	DrawMeshParts(m_SphereMesh, 1u);
 }
 
 void ShapeMeshes::DrawHalfSphereMeshLines()
@@ -1830,11 +756,9 @@ void ShapeMeshes::DrawHalfSphereMeshLines()
 		return;
 	}
 
-	glBindVertexArray(m_SphereMesh.vao);
-
-	glDrawElements(GL_LINES, m_SphereMesh.nIndices / 2, GL_UNSIGNED_INT, nullptr);
+	GLStateCache::BindVertexArray(m_SphereMesh.vao);
 
-	glBindVertexArray(0);
+	glDrawElements(GL_LINES, m_SphereMesh.partIndexCounts[0], m_SphereMesh.indexType, nullptr);
 }
 
 ///////////////////////////////////////////////////
@@ -1848,22 +772,10 @@ void ShapeMeshes::DrawTaperedCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	GLStateCache::BindVertexArray(m_TaperedCylinderMesh.vao);
 
-	if (bDrawBottom == true)
-	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
-	}
-	if (bDrawTop == true)
-	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
-	}
-	if (bDrawSides == true)
-	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-	}
-
-	glBindVertexArray(0);
+	// parts 0, 1 and 2 are the bottom, the top and the sides
+	DrawMeshParts(m_TaperedCylinderMesh, (bDrawBottom ? 1u : 0u) | (bDrawTop ? 2u : 0u) | (bDrawSides ? 4u : 0u));
 }
 
 ///////////////////////////////////////////////////
@@ -1877,7 +789,7 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	GLStateCache::BindVertexArray(m_TaperedCylinderMesh.vao);
 
 	if (bDrawBottom == true)
 	{
@@ -1892,7 +804,6 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 		glDrawArrays(GL_LINE_STRIP, 72, 146);	//sides
 	}
 
-	glBindVertexArray(0);
 }
 
 ///////////////////////////////////////////////////
@@ -1903,12 +814,10 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	GLStateCache::BindVertexArray(m_TorusMesh.vao);
 
 	// Use indexed drawing
-	glDrawElements(GL_TRIANGLES, m_TorusMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	glBindVertexArray(0);
+	DrawMeshParts(m_TorusMesh, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1919,12 +828,10 @@ void ShapeMeshes::DrawTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	GLStateCache::BindVertexArray(m_TorusMesh.vao);
 
 	// Use indexed drawing for lines
-	glDrawElements(GL_LINES, m_TorusMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-
-	glBindVertexArray(0);
+	glDrawElements(GL_LINES, m_TorusMesh.nIndices, m_TorusMesh.indexType, (void*)0);
 }
 
 
@@ -1936,11 +843,9 @@ void ShapeMeshes::DrawTorusMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh1()
 {
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
+	GLStateCache::BindVertexArray(m_ExtraTorusMesh1.vao);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh1.nVertices);
-
-	glBindVertexArray(0);
+	DrawMeshParts(m_ExtraTorusMesh1, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1951,11 +856,9 @@ void ShapeMeshes::DrawExtraTorusMesh1()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh2()
 {
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
-
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh2.nVertices);
+	GLStateCache::BindVertexArray(m_ExtraTorusMesh2.vao);
 
-	glBindVertexArray(0);
+	DrawMeshParts(m_ExtraTorusMesh2, ALL_MESH_PARTS);
 }
 
 ///////////////////////////////////////////////////
@@ -1966,12 +869,10 @@ void ShapeMeshes::DrawExtraTorusMesh2()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	GLStateCache::BindVertexArray(m_TorusMesh.vao);
 
-	// Use indexed drawing for half the indices
-	glDrawElements(GL_TRIANGLES, m_TorusMesh.nIndices / 2, GL_UNSIGNED_INT, (void*)0);
-
-	glBindVertexArray(0);
+	// Use indexed drawing for the first half, part 0
+	DrawMeshParts(m_TorusMesh, 1u);
 }
 
 ///////////////////////////////////////////////////
@@ -1982,94 +883,1344 @@ void ShapeMeshes::DrawHalfTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	GLStateCache::BindVertexArray(m_TorusMesh.vao);
 
 	// Use indexed drawing for half the indices in line mode
-	glDrawElements(GL_LINES, m_TorusMesh.nIndices / 2, GL_UNSIGNED_INT, (void*)0);
+	glDrawElements(GL_LINES, m_TorusMesh.partIndexCounts[0], m_TorusMesh.indexType, (void*)0);
+}
 
-	glBindVertexArray(0);
+
+//**************************************************************************
+// The following set of methods are called to draw many copies of the basic
+// 3D shapes with one instanced draw call.  The vertex shader reads the model
+// matrix, UV scale and material of each copy from the instance buffer.
+//**************************************************************************
+
+///////////////////////////////////////////////////
+// DrawBoxMeshInstanced()
+//
+// Draws a copy of the entire box for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawBoxMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_BoxMesh.vao == 0 || m_BoxMesh.nIndices == 0) {
+		std::cerr << "Error: Box mesh not initialized properly." << std::endl;
+		return;
+	}
+
+	if (BindInstances(m_BoxMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_BoxMesh, ALL_MESH_PARTS, instanceCount);
+	}
 }
 
+///////////////////////////////////////////////////
+//	DrawConeMeshInstanced()
+//
+//	Draws a copy of the cone for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawConeMeshInstanced(const INSTANCE_DATA* instances, int instanceCount, bool bDrawBottom)
+{
+	if (!BindInstances(m_ConeMesh, instances, instanceCount))
+	{
+		return;
+	}
+
+	DrawMeshParts(m_ConeMesh, (bDrawBottom ? 1u : 0u) | 2u, instanceCount);
+}
 
-glm::vec3 ShapeMeshes::QuadCrossProduct(
-	glm::vec3 pnt0, glm::vec3 pnt1, glm::vec3 pnt2, glm::vec3 pnt3)
+///////////////////////////////////////////////////
+//	DrawCylinderMeshInstanced()
+//
+//	Draws a copy of the cylinder for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawCylinderMeshInstanced(
+	const INSTANCE_DATA* instances,
+	int instanceCount,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
 {
-	glm::vec3 Normal(0, 0, 0);
-	
-	Normal = glm::cross((pnt3 - pnt0), (pnt2 - pnt1));
+	if (!BindInstances(m_CylinderMesh, instances, instanceCount))
+	{
+		return;
+	}
 
-	return Normal;
+	DrawMeshParts(m_CylinderMesh, (bDrawBottom ? 1u : 0u) | (bDrawTop ? 2u : 0u) | (bDrawSides ? 4u : 0u), instanceCount);
 }
 
-glm::vec3 ShapeMeshes::CalculateTriangleNormal(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3)
+///////////////////////////////////////////////////
+//	DrawPlaneMeshInstanced()
+//
+//	Draws a copy of the plane for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPlaneMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
 {
-	glm::vec3 Normal(0, 0, 0);
-	glm::vec3 v1;
-	glm::vec3 v2;
-	float magnitude = 0;
+	if (BindInstances(m_PlaneMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_PlaneMesh, ALL_MESH_PARTS, instanceCount);
+	}
+}
 
-	v1 = (p2 - p1);
-	v2 = (p3 - p1);
+///////////////////////////////////////////////////
+// DrawPrismMeshInstanced()
+//
+// Draws a copy of the prism for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPrismMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (BindInstances(m_PrismMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_PrismMesh, ALL_MESH_PARTS, instanceCount);
+	}
+}
 
-	Normal.x = (v1.y * v2.z) - (v1.z * v2.y);
-	Normal.y = (v1.z * v2.x) - (v1.x * v2.z);
-	Normal.z = (v1.x * v2.y) - (v1.y * v2.x);
+///////////////////////////////////////////////////
+// DrawPyramid3MeshInstanced()
+//
+// Draws a copy of the 3-sided pyramid for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPyramid3MeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_Pyramid3Mesh.nVertices == 0)
+	{
+		std::cerr << "Error: Pyramid mesh not loaded or empty!" << std::endl;
+		return;
+	}
 
-	magnitude = (float)sqrt(Normal.x * Normal.x + Normal.y * Normal.y + Normal.z * Normal.z);
-	if (magnitude == 0)
+	if (BindInstances(m_Pyramid3Mesh, instances, instanceCount))
 	{
-		//throw Exception();
+		DrawMeshParts(m_Pyramid3Mesh, ALL_MESH_PARTS, instanceCount);
 	}
-	else
+}
+
+///////////////////////////////////////////////////
+// DrawPyramid4MeshInstanced()
+//
+// Draws a copy of the 4-sided pyramid for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawPyramid4MeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_Pyramid4Mesh.nVertices == 0)
 	{
-		Normal.x /= magnitude;
-		Normal.y /= magnitude;
-		Normal.z /= magnitude;
+		std::cerr << "Error: Pyramid mesh not loaded or has no vertices!" << std::endl;
+		return;
 	}
 
-	return(Normal);
-	
+	if (BindInstances(m_Pyramid4Mesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_Pyramid4Mesh, ALL_MESH_PARTS, instanceCount);
+	}
 }
-void ShapeMeshes::SetShaderMemoryLayout()
+
+///////////////////////////////////////////////////
+// DrawSphereMeshInstanced()
+//
+// Draws a copy of the sphere for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawSphereMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_SphereMesh.vao == 0 || m_SphereMesh.nIndices == 0)
+	{
+		std::cerr << "Error: Sphere mesh VAO or indices not properly initialized." << std::endl;
+		return;
+	}
+
+	if (BindInstances(m_SphereMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_SphereMesh, ALL_MESH_PARTS, instanceCount);
+	}
+}
+
+///////////////////////////////////////////////////
+// DrawHalfSphereMeshInstanced()
+//
+// Draws a copy of the half sphere for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawHalfSphereMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (m_SphereMesh.vao == 0 || m_SphereMesh.nIndices == 0)
+	{
+		std::cerr << "Error: Sphere mesh VAO or indices not properly initialized." << std::endl;
+		return;
+	}
+
+	if (BindInstances(m_SphereMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_SphereMesh, 1u, instanceCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawTaperedCylinderMeshInstanced()
+//
+//	Draws a copy of the tapered cylinder for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTaperedCylinderMeshInstanced(
+	const INSTANCE_DATA* instances,
+	int instanceCount,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	if (!BindInstances(m_TaperedCylinderMesh, instances, instanceCount))
+	{
+		return;
+	}
+
+	DrawMeshParts(m_TaperedCylinderMesh, (bDrawBottom ? 1u : 0u) | (bDrawTop ? 2u : 0u) | (bDrawSides ? 4u : 0u), instanceCount);
+}
+
+///////////////////////////////////////////////////
+//	DrawTorusMeshInstanced()
+//
+//	Draws a copy of the torus for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTorusMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (BindInstances(m_TorusMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_TorusMesh, ALL_MESH_PARTS, instanceCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawHalfTorusMeshInstanced()
+//
+//	Draws a copy of the half torus for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawHalfTorusMeshInstanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (BindInstances(m_TorusMesh, instances, instanceCount))
+	{
+		DrawMeshParts(m_TorusMesh, 1u, instanceCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawExtraTorusMesh1Instanced()
+//
+//	Draws a copy of the first extra torus for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawExtraTorusMesh1Instanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (BindInstances(m_ExtraTorusMesh1, instances, instanceCount))
+	{
+		DrawMeshParts(m_ExtraTorusMesh1, ALL_MESH_PARTS, instanceCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawExtraTorusMesh2Instanced()
+//
+//	Draws a copy of the second extra torus for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawExtraTorusMesh2Instanced(const INSTANCE_DATA* instances, int instanceCount)
+{
+	if (BindInstances(m_ExtraTorusMesh2, instances, instanceCount))
+	{
+		DrawMeshParts(m_ExtraTorusMesh2, ALL_MESH_PARTS, instanceCount);
+	}
+}
+
+//**************************************************************************
+// The following methods pack the loaded meshes and the static batches into
+// one vertex buffer and one index buffer, so any mix of meshes can be drawn
+// with a single multi-draw call.  Every part is stored as a triangle list.
+//**************************************************************************
+
+///////////////////////////////////////////////////
+//	CollectSharedGeometry()
+//
+//	Reads the vertices and indices of every loaded
+//	mesh back into the shared vertices and indices.
+//	The meshes are already triangle lists with their
+//	parts in the order they are drawn in, so
+//	neighbouring parts can be drawn as one range.
+//	Meshes that are not loaded get an empty range.
+//	The cone, cylinder, sphere and torus are collected
+//	at each detail level.
+///////////////////////////////////////////////////
+bool ShapeMeshes::CollectSharedGeometry()
+{
+	std::vector<GLfloat>& vertices = m_sharedVertices;
+	std::vector<GLuint>& indices = m_sharedIndices;
+	std::vector<GLuint> meshIndices;
+	GLint baseVertex = 0;
+
+	if (!m_sharedRanges.empty())
+	{
+		return(true);
+	}
+
+	SHARED_RANGE emptyRange = { 0, 0, 0 };
+	m_sharedRanges.assign(SHARED_MESH_COUNT * DETAIL_LEVELS, emptyRange);
+
+	// box
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("box", m_BoxMesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_BOX, m_BoxMesh, meshIndices, 0, m_BoxMesh.nParts, baseVertex, indices);
+
+	// cone, cylinder, sphere and torus at every detail level
+	for (int level = 0; level < DETAIL_LEVELS; level++)
+	{
+		AppendSharedDetailLevel(level, vertices, indices);
+	}
+
+	// plane
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("plane", m_PlaneMesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_PLANE, m_PlaneMesh, meshIndices, 0, m_PlaneMesh.nParts, baseVertex, indices);
+
+	// prism and pyramids
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("prism", m_PrismMesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_PRISM, m_PrismMesh, meshIndices, 0, m_PrismMesh.nParts, baseVertex, indices);
+
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("pyramid3", m_Pyramid3Mesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_PYRAMID3, m_Pyramid3Mesh, meshIndices, 0, m_Pyramid3Mesh.nParts, baseVertex, indices);
+
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("pyramid4", m_Pyramid4Mesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_PYRAMID4, m_Pyramid4Mesh, meshIndices, 0, m_Pyramid4Mesh.nParts, baseVertex, indices);
+
+	// tapered cylinder - bottom and top, then the sides
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("tapered cylinder", m_TaperedCylinderMesh, vertices, meshIndices);
+	AppendSharedRange(SHARED_TAPERED_CYLINDER_BOTTOM, m_TaperedCylinderMesh, meshIndices, 0, 1, baseVertex, indices);
+	AppendSharedRange(SHARED_TAPERED_CYLINDER_TOP, m_TaperedCylinderMesh, meshIndices, 1, 1, baseVertex, indices);
+	AppendSharedRange(SHARED_TAPERED_CYLINDER_SIDES, m_TaperedCylinderMesh, meshIndices, 2, 1, baseVertex, indices);
+
+	// extra tori
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("extra torus 1", m_ExtraTorusMesh1, vertices, meshIndices);
+	AppendSharedRange(SHARED_EXTRA_TORUS1, m_ExtraTorusMesh1, meshIndices, 0, m_ExtraTorusMesh1.nParts, baseVertex, indices);
+
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("extra torus 2", m_ExtraTorusMesh2, vertices, meshIndices);
+	AppendSharedRange(SHARED_EXTRA_TORUS2, m_ExtraTorusMesh2, meshIndices, 0, m_ExtraTorusMesh2.nParts, baseVertex, indices);
+
+	if (vertices.empty() || indices.empty())
+	{
+		std::cerr << "Error: No loaded meshes to build the shared geometry from." << std::endl;
+		m_sharedRanges.clear();
+		m_sharedBlocks.clear();
+		vertices.clear();
+		indices.clear();
+		return(false);
+	}
+
+	return(true);
+}
+
+///////////////////////////////////////////////////
+//	AppendSharedDetailLevel()
+//
+//	Appends the cone, cylinder, sphere and torus
+//	loaded at a detail level to the shared geometry.
+//	The half sphere and half torus are the first part
+//	of the indices of the whole mesh.
+///////////////////////////////////////////////////
+void ShapeMeshes::AppendSharedDetailLevel(
+	int detailLevel,
+	std::vector<GLfloat>& vertices,
+	std::vector<GLuint>& indices)
+{
+	std::vector<GLuint> meshIndices;
+	GLint baseVertex = 0;
+
+	if ((detailLevel < 0) || (detailLevel >= DETAIL_LEVELS))
+	{
+		return;
+	}
+
+	const GLMesh& cone = (detailLevel == 0) ? m_ConeMesh : m_ConeLevels[detailLevel - 1];
+	const GLMesh& cylinder = (detailLevel == 0) ? m_CylinderMesh : m_CylinderLevels[detailLevel - 1];
+	const GLMesh& sphere = (detailLevel == 0) ? m_SphereMesh : m_SphereLevels[detailLevel - 1];
+	const GLMesh& torus = (detailLevel == 0) ? m_TorusMesh : m_TorusLevels[detailLevel - 1];
+	SHARED_RANGE* ranges = &m_sharedRanges[detailLevel * SHARED_MESH_COUNT];
+	std::string levelName = (detailLevel == 0) ? "" : " level " + std::to_string(detailLevel);
+
+	// cone - bottom, then the sides
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("cone" + levelName, cone, vertices, meshIndices);
+	AppendSharedRange(SHARED_CONE_BOTTOM, cone, meshIndices, 0, 1, baseVertex, indices, detailLevel);
+	AppendSharedRange(SHARED_CONE_SIDES, cone, meshIndices, 1, 1, baseVertex, indices, detailLevel);
+
+	// cylinder - bottom and top, then the sides
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("cylinder" + levelName, cylinder, vertices, meshIndices);
+	AppendSharedRange(SHARED_CYLINDER_BOTTOM, cylinder, meshIndices, 0, 1, baseVertex, indices, detailLevel);
+	AppendSharedRange(SHARED_CYLINDER_TOP, cylinder, meshIndices, 1, 1, baseVertex, indices, detailLevel);
+	AppendSharedRange(SHARED_CYLINDER_SIDES, cylinder, meshIndices, 2, 1, baseVertex, indices, detailLevel);
+
+	// sphere
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("sphere" + levelName, sphere, vertices, meshIndices);
+	AppendSharedRange(SHARED_SPHERE, sphere, meshIndices, 0, sphere.nParts, baseVertex, indices, detailLevel);
+	ranges[SHARED_HALF_SPHERE] = ranges[SHARED_SPHERE];
+	ranges[SHARED_HALF_SPHERE].indexCount = std::min(
+		ranges[SHARED_SPHERE].indexCount, sphere.partIndexCounts[0]);
+
+	// torus
+	baseVertex = (GLint)(vertices.size() / 8);
+	AppendSharedMesh("torus" + levelName, torus, vertices, meshIndices);
+	AppendSharedRange(SHARED_TORUS, torus, meshIndices, 0, torus.nParts, baseVertex, indices, detailLevel);
+	ranges[SHARED_HALF_TORUS] = ranges[SHARED_TORUS];
+	ranges[SHARED_HALF_TORUS].indexCount = std::min(
+		ranges[SHARED_TORUS].indexCount, torus.partIndexCounts[0]);
+}
+
+///////////////////////////////////////////////////
+//	BuildSharedGeometry()
+//
+//	Uploads the shared vertices and indices, with the
+//	static batches added so far, into one vertex buffer
+//	and one index buffer behind a single VAO.
+///////////////////////////////////////////////////
+bool ShapeMeshes::BuildSharedGeometry()
 {
-    // Attribute location definitions
-    constexpr GLuint POSITION_ATTR_LOCATION = 0;
-    constexpr GLuint NORMAL_ATTR_LOCATION = 1;
-    constexpr GLuint UV_ATTR_LOCATION = 2;
-
-    // Calculate stride as the size of all vertex attributes combined
-    GLint stride = sizeof(float) * (FloatsPerVertex + FloatsPerNormal + FloatsPerUV);
-
-    // Set up the position attribute
-    glVertexAttribPointer(
-        POSITION_ATTR_LOCATION,     // Attribute location in the shader
-        FloatsPerVertex,            // Number of floats per vertex attribute
-        GL_FLOAT,                   // Data type of each component
-        GL_FALSE,                   // Normalize flag
-        stride,                     // Stride (distance between consecutive attributes)
-        reinterpret_cast<void*>(0)  // Offset from the beginning of the buffer
-    );
-    glEnableVertexAttribArray(POSITION_ATTR_LOCATION);
-
-    // Set up the normal attribute
-    glVertexAttribPointer(
-        NORMAL_ATTR_LOCATION,       // Attribute location in the shader
-        FloatsPerNormal,            // Number of floats per normal attribute
-        GL_FLOAT,                   // Data type of each component
-        GL_FALSE,                   // Normalize flag
-        stride,                     // Stride
-        reinterpret_cast<void*>(sizeof(float) * FloatsPerVertex)  // Offset
-    );
-    glEnableVertexAttribArray(NORMAL_ATTR_LOCATION);
-
-    // Set up the UV attribute
-    glVertexAttribPointer(
-        UV_ATTR_LOCATION,           // Attribute location in the shader
-        FloatsPerUV,                // Number of floats per UV attribute
-        GL_FLOAT,                   // Data type of each component
-        GL_FALSE,                   // Normalize flag
-        stride,                     // Stride
-        reinterpret_cast<void*>(sizeof(float) * (FloatsPerVertex + FloatsPerNormal))  // Offset
-    );
-    glEnableVertexAttribArray(UV_ATTR_LOCATION);
+	if (!CollectSharedGeometry())
+	{
+		return(false);
+	}
+
+	// replace the shared geometry if it was built before
+	if (m_SharedMesh.vao != 0)
+	{
+		GLStateCache::DeleteVertexArrays(1, &m_SharedMesh.vao);
+		glDeleteBuffers(2, m_SharedMesh.vbos);
+		m_instancedVertexArrays.erase(
+			std::remove(m_instancedVertexArrays.begin(), m_instancedVertexArrays.end(), m_SharedMesh.vao),
+			m_instancedVertexArrays.end());
+	}
+
+	m_SharedMesh.nVertices = (GLuint)(m_sharedVertices.size() / 8);
+	m_SharedMesh.nIndices = (GLuint)m_sharedIndices.size();
+
+	// the vertices are kept as floats for the static batches and the
+	// occluders, only the uploaded copy is packed
+	std::vector<unsigned char> packedVertices;
+	GLsizei stride = PackSharedVertices(packedVertices);
+
+	glGenVertexArrays(1, &m_SharedMesh.vao);
+	GLStateCache::BindVertexArray(m_SharedMesh.vao);
+
+	glGenBuffers(2, m_SharedMesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, m_SharedMesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, packedVertices.size(), packedVertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SharedMesh.vbos[1]);
+
+	// every range is drawn from its own base vertex, so the indices
+	// fit in 16 bits unless a mesh or batch has more vertices than that
+	GLuint highestIndex = m_sharedIndices.empty() ? 0 :
+		*std::max_element(m_sharedIndices.begin(), m_sharedIndices.end());
+	if (highestIndex <= 0xFFFF)
+	{
+		std::vector<GLushort> shortIndices(m_sharedIndices.begin(), m_sharedIndices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * shortIndices.size(), shortIndices.data(), GL_STATIC_DRAW);
+		m_sharedIndexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * m_sharedIndices.size(), m_sharedIndices.data(), GL_STATIC_DRAW);
+		m_sharedIndexType = GL_UNSIGNED_INT;
+	}
+
+	SetSharedMemoryLayout();
+
+	GLStateCache::BindVertexArray(0);
+
+	// bytes per vertex of every mesh, against the full floats
+	size_t fullBytes = (size_t)VertexLayout::Full::Stride * m_SharedMesh.nVertices;
+	for (const SHARED_BLOCK& block : m_sharedBlocks)
+	{
+		std::cout << "Shared vertices:" << block.name << " " << block.vertexCount << " vertices, "
+			<< stride << " bytes per vertex, "
+			<< (size_t)(VertexLayout::Full::Stride - stride) * block.vertexCount << " bytes saved" << std::endl;
+	}
+	std::cout << "Shared geometry:" << m_SharedMesh.nVertices << " vertices, "
+		<< m_SharedMesh.nIndices << ((m_sharedIndexType == GL_UNSIGNED_SHORT) ? " 16-bit" : " 32-bit") << " indices, "
+		<< m_staticBatchRanges.size() << " static batches, "
+		<< packedVertices.size() << " vertex bytes (" << fullBytes - packedVertices.size() << " saved)" << std::endl;
+
+	return(true);
+}
+
+///////////////////////////////////////////////////
+//	PackSharedVertices()
+//
+//	Encodes the shared vertices into the shared vertex
+//	format.  Each mesh and static batch is packed
+//	relative to its own box and largest texture
+//	coordinate, and its decode is recorded for the
+//	vertex shader.  16-bit texture coordinates can not
+//	be negative, so the full floats are kept if any
+//	are.  Returns the bytes per vertex.
+///////////////////////////////////////////////////
+GLsizei ShapeMeshes::PackSharedVertices(std::vector<unsigned char>& packed)
+{
+	const size_t floatsPerVertex = VertexLayout::SOURCE_FLOATS;
+	size_t vertexCount = m_sharedVertices.size() / floatsPerVertex;
+
+	if (m_sharedVertexFormat != VERTEX_FORMAT_FULL)
+	{
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			if ((m_sharedVertices[i * floatsPerVertex + 6] < 0.0f) || (m_sharedVertices[i * floatsPerVertex + 7] < 0.0f))
+			{
+				std::cerr << "Error: Negative texture coordinates, the shared vertices are not packed." << std::endl;
+				m_sharedVertexFormat = VERTEX_FORMAT_FULL;
+				break;
+			}
+		}
+	}
+
+	GLsizei stride = VertexLayout::Full::Stride;
+	switch (m_sharedVertexFormat)
+	{
+	case VERTEX_FORMAT_HALF:
+		stride = VertexLayout::Half::Stride;
+		break;
+	case VERTEX_FORMAT_SNORM16:
+		stride = VertexLayout::Snorm16::Stride;
+		break;
+	default:
+		break;
+	}
+	packed.assign(vertexCount * stride, 0);
+
+	for (SHARED_BLOCK& block : m_sharedBlocks)
+	{
+		const GLfloat* vertices = m_sharedVertices.data() + (size_t)block.baseVertex * floatsPerVertex;
+		unsigned char* output = packed.data() + (size_t)block.baseVertex * stride;
+
+		// the box around the block's positions and its largest
+		// texture coordinate
+		MESH_BOUNDS bounds = MeshBuilder::ComputeBounds(vertices, block.vertexCount);
+		VertexLayout::PACKING_RANGE range;
+		range.center = bounds.center;
+		range.halfSize = (bounds.maximum - bounds.minimum) * 0.5f;
+		range.uvScale = 0.0f;
+		for (GLuint i = 0; i < block.vertexCount; i++)
+		{
+			range.uvScale = std::max(range.uvScale,
+				std::max(vertices[i * floatsPerVertex + 6], vertices[i * floatsPerVertex + 7]));
+		}
+
+		block.decode = GetFullVertexDecode();
+		switch (m_sharedVertexFormat)
+		{
+		case VERTEX_FORMAT_HALF:
+			VertexLayout::Half::Encode(vertices, block.vertexCount, range, output);
+			break;
+		case VERTEX_FORMAT_SNORM16:
+			VertexLayout::Snorm16::Encode(vertices, block.vertexCount, range, output);
+			break;
+		default:
+			VertexLayout::Full::Encode(vertices, block.vertexCount, range, output);
+			continue;
+		}
+		block.decode.offset = glm::vec4(range.center, 1.0f);
+		block.decode.scale = glm::vec4(range.halfSize, range.uvScale);
+	}
+
+	return(stride);
+}
+
+///////////////////////////////////////////////////
+//	GetSharedVertexDecode()
+//
+//	Returns how the shared vertices from a base vertex
+//	on are decoded, which is the decode of the mesh or
+//	static batch they start in.
+///////////////////////////////////////////////////
+ShapeMeshes::VERTEX_DECODE ShapeMeshes::GetSharedVertexDecode(GLint baseVertex) const
+{
+	// the blocks are appended in order, so the last one starting at
+	// or before the base vertex holds it
+	std::vector<SHARED_BLOCK>::const_iterator block = std::upper_bound(
+		m_sharedBlocks.begin(), m_sharedBlocks.end(), baseVertex,
+		[](GLint vertex, const SHARED_BLOCK& other) { return(vertex < other.baseVertex); });
+	if (block == m_sharedBlocks.begin())
+	{
+		return(GetFullVertexDecode());
+	}
+
+	return((block - 1)->decode);
+}
+
+///////////////////////////////////////////////////
+//	GetFullVertexDecode()
+//
+//	Returns the decode of full float vertices, which
+//	the vertex shader uses as they are.
+///////////////////////////////////////////////////
+ShapeMeshes::VERTEX_DECODE ShapeMeshes::GetFullVertexDecode()
+{
+	VERTEX_DECODE decode;
+	decode.offset = glm::vec4(0.0f);
+	decode.scale = glm::vec4(1.0f);
+
+	return(decode);
+}
+
+///////////////////////////////////////////////////
+//	GetSharedRange()
+//
+//	Returns where a mesh part is stored in the shared
+//	index buffer.  The range is empty if the mesh was
+//	not loaded or the shared geometry is not built.
+//	A detail level the mesh was not loaded at gets
+//	the range of the finest level.
+///////////////////////////////////////////////////
+ShapeMeshes::SHARED_RANGE ShapeMeshes::GetSharedRange(SHARED_MESH part, int detailLevel) const
+{
+	SHARED_RANGE range = { 0, 0, 0 };
+
+	if ((part < 0) || (part >= SHARED_MESH_COUNT) || m_sharedRanges.empty())
+	{
+		return(range);
+	}
+
+	if ((detailLevel > 0) && (detailLevel < DETAIL_LEVELS))
+	{
+		range = m_sharedRanges[detailLevel * SHARED_MESH_COUNT + part];
+	}
+	if (range.indexCount == 0)
+	{
+		range = m_sharedRanges[part];
+	}
+
+	return(range);
+}
+
+///////////////////////////////////////////////////
+//	GetMeshBounds()
+//
+//	Returns the bounds of the mesh a part is drawn
+//	from.  The half meshes and the top, bottom and
+//	sides of a mesh all get the bounds of the whole
+//	mesh, which always contain them.
+///////////////////////////////////////////////////
+ShapeMeshes::MESH_BOUNDS ShapeMeshes::GetMeshBounds(SHARED_MESH part) const
+{
+	switch (part)
+	{
+	case SHARED_BOX:
+		return(m_BoxMesh.bounds);
+	case SHARED_CONE_BOTTOM:
+	case SHARED_CONE_SIDES:
+		return(m_ConeMesh.bounds);
+	case SHARED_CYLINDER_BOTTOM:
+	case SHARED_CYLINDER_TOP:
+	case SHARED_CYLINDER_SIDES:
+		return(m_CylinderMesh.bounds);
+	case SHARED_PLANE:
+		return(m_PlaneMesh.bounds);
+	case SHARED_PRISM:
+		return(m_PrismMesh.bounds);
+	case SHARED_PYRAMID3:
+		return(m_Pyramid3Mesh.bounds);
+	case SHARED_PYRAMID4:
+		return(m_Pyramid4Mesh.bounds);
+	case SHARED_SPHERE:
+	case SHARED_HALF_SPHERE:
+		return(m_SphereMesh.bounds);
+	case SHARED_TAPERED_CYLINDER_BOTTOM:
+	case SHARED_TAPERED_CYLINDER_TOP:
+	case SHARED_TAPERED_CYLINDER_SIDES:
+		return(m_TaperedCylinderMesh.bounds);
+	case SHARED_TORUS:
+	case SHARED_HALF_TORUS:
+		return(m_TorusMesh.bounds);
+	case SHARED_EXTRA_TORUS1:
+		return(m_ExtraTorusMesh1.bounds);
+	case SHARED_EXTRA_TORUS2:
+		return(m_ExtraTorusMesh2.bounds);
+	default:
+		break;
+	}
+
+	MESH_BOUNDS bounds = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), -1.0f };
+	return(bounds);
+}
+
+///////////////////////////////////////////////////
+//	GetSharedTriangles()
+//
+//	Copies the vertices used by a mesh part and its
+//	triangles.  The indices are changed to start at
+//	the first copied vertex.
+///////////////////////////////////////////////////
+bool ShapeMeshes::GetSharedTriangles(
+	SHARED_MESH part,
+	std::vector<GLfloat>& vertices,
+	std::vector<GLuint>& indices)
+{
+	vertices.clear();
+	indices.clear();
+
+	if ((!CollectSharedGeometry()) || (part < 0) || (part >= SHARED_MESH_COUNT))
+	{
+		return(false);
+	}
+
+	const SHARED_RANGE& range = m_sharedRanges[part];
+	if (range.indexCount == 0)
+	{
+		return(false);
+	}
+
+	std::vector<GLuint>::const_iterator first = m_sharedIndices.begin() + range.firstIndex;
+	std::vector<GLuint>::const_iterator last = first + range.indexCount;
+	GLuint lowest = *std::min_element(first, last);
+	GLuint highest = *std::max_element(first, last);
+
+	size_t firstFloat = ((size_t)range.baseVertex + lowest) * 8;
+	size_t lastFloat = ((size_t)range.baseVertex + highest + 1) * 8;
+	vertices.assign(m_sharedVertices.begin() + firstFloat, m_sharedVertices.begin() + lastFloat);
+
+	indices.reserve(range.indexCount);
+	for (std::vector<GLuint>::const_iterator index = first; index != last; ++index)
+	{
+		indices.push_back(*index - lowest);
+	}
+
+	return(true);
+}
+
+///////////////////////////////////////////////////
+//	AddStaticBatch()
+//
+//	Appends a triangle list, usually transformed into
+//	world space, to the shared vertices and indices.
+//	It is uploaded by the next BuildSharedGeometry().
+//	Returns the batch index, or -1 on failure.
+///////////////////////////////////////////////////
+int ShapeMeshes::AddStaticBatch(
+	const std::vector<GLfloat>& vertices,
+	const std::vector<GLuint>& indices)
+{
+	if ((!CollectSharedGeometry()) || (vertices.empty()) || (indices.empty()))
+	{
+		return(-1);
+	}
+
+	SHARED_RANGE range;
+	range.firstIndex = (GLuint)m_sharedIndices.size();
+	range.indexCount = (GLuint)indices.size();
+	range.baseVertex = (GLint)(m_sharedVertices.size() / 8);
+
+	m_sharedVertices.insert(m_sharedVertices.end(), vertices.begin(), vertices.end());
+	m_sharedIndices.insert(m_sharedIndices.end(), indices.begin(), indices.end());
+	m_staticBatchRanges.push_back(range);
+	m_staticBatchBounds.push_back(MeshBuilder::ComputeBounds(vertices.data(), vertices.size() / 8));
+
+	SHARED_BLOCK block = { "static batch " + std::to_string(m_staticBatchRanges.size() - 1),
+		range.baseVertex, (GLuint)(vertices.size() / 8), GetFullVertexDecode() };
+	m_sharedBlocks.push_back(block);
+
+	return((int)m_staticBatchRanges.size() - 1);
+}
+
+///////////////////////////////////////////////////
+//	GetStaticBatchRange()
+//
+//	Returns where a static batch is stored in the
+//	shared index buffer, empty for an unknown batch.
+///////////////////////////////////////////////////
+ShapeMeshes::SHARED_RANGE ShapeMeshes::GetStaticBatchRange(int batch) const
+{
+	SHARED_RANGE range = { 0, 0, 0 };
+
+	if ((batch >= 0) && (batch < (int)m_staticBatchRanges.size()))
+	{
+		range = m_staticBatchRanges[batch];
+	}
+
+	return(range);
+}
+
+///////////////////////////////////////////////////
+//	GetStaticBatchBounds()
+//
+//	Returns the bounds of a static batch, with a
+//	negative radius for an unknown batch.
+///////////////////////////////////////////////////
+ShapeMeshes::MESH_BOUNDS ShapeMeshes::GetStaticBatchBounds(int batch) const
+{
+	MESH_BOUNDS bounds = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), -1.0f };
+
+	if ((batch >= 0) && (batch < (int)m_staticBatchBounds.size()))
+	{
+		bounds = m_staticBatchBounds[batch];
+	}
+
+	return(bounds);
+}
+
+///////////////////////////////////////////////////
+//	DrawStaticBatch()
+//
+//	Draws a static batch from the shared geometry.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawStaticBatch(int batch)
+{
+	SHARED_RANGE range = GetStaticBatchRange(batch);
+	if ((m_SharedMesh.vao == 0) || (range.indexCount == 0))
+	{
+		return;
+	}
+
+	size_t indexSize = (m_sharedIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	GLStateCache::BindVertexArray(m_SharedMesh.vao);
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, m_sharedIndexType,
+		reinterpret_cast<void*>(indexSize * range.firstIndex), range.baseVertex);
+}
+
+///////////////////////////////////////////////////
+//	DrawStaticBatchInstanced()
+//
+//	Draws a copy of a static batch for each instance.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawStaticBatchInstanced(int batch, const INSTANCE_DATA* instances, int instanceCount)
+{
+	SHARED_RANGE range = GetStaticBatchRange(batch);
+	size_t indexSize = (m_sharedIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	if ((range.indexCount != 0) && (BindInstances(m_SharedMesh, instances, instanceCount)))
+	{
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, m_sharedIndexType,
+			reinterpret_cast<void*>(indexSize * range.firstIndex), instanceCount, range.baseVertex);
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawSharedMeshesIndirect()
+//
+//	Draws every command from the shared geometry with
+//	one multi-draw call.  The commands are read from a
+//	buffer by OpenGL, so the number of meshes drawn
+//	does not change the number of calls made.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawSharedMeshesIndirect(
+	const INSTANCE_DATA* instances,
+	int instanceCount,
+	const DRAW_ELEMENTS_COMMAND* commands,
+	int commandCount)
+{
+	if ((NULL == commands) || (commandCount <= 0))
+	{
+		return;
+	}
+	if (!BindInstances(m_SharedMesh, instances, instanceCount))
+	{
+		return;
+	}
+
+	if (m_indirectBuffer == 0)
+	{
+		glGenBuffers(1, &m_indirectBuffer);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DRAW_ELEMENTS_COMMAND) * commandCount, commands, GL_STREAM_DRAW);
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, m_sharedIndexType, nullptr, commandCount, 0);
+}
+
+glm::vec3 ShapeMeshes::QuadCrossProduct(
+	glm::vec3 pnt0, glm::vec3 pnt1, glm::vec3 pnt2, glm::vec3 pnt3)
+{
+	glm::vec3 Normal(0, 0, 0);
+	
+	Normal = glm::cross((pnt3 - pnt0), (pnt2 - pnt1));
+
+	return Normal;
+}
+
+glm::vec3 ShapeMeshes::CalculateTriangleNormal(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3)
+{
+	glm::vec3 Normal(0, 0, 0);
+	glm::vec3 v1;
+	glm::vec3 v2;
+	float magnitude = 0;
+
+	v1 = (p2 - p1);
+	v2 = (p3 - p1);
+
+	Normal.x = (v1.y * v2.z) - (v1.z * v2.y);
+	Normal.y = (v1.z * v2.x) - (v1.x * v2.z);
+	Normal.z = (v1.x * v2.y) - (v1.y * v2.x);
+
+	magnitude = (float)sqrt(Normal.x * Normal.x + Normal.y * Normal.y + Normal.z * Normal.z);
+	if (magnitude == 0)
+	{
+		//throw Exception();
+	}
+	else
+	{
+		Normal.x /= magnitude;
+		Normal.y /= magnitude;
+		Normal.z /= magnitude;
+	}
+
+	return(Normal);
+	
+}
+
+///////////////////////////////////////////////////
+//	UploadMeshIndices()
+//
+//	Uploads a mesh's indices into its index buffer,
+//	creating the buffer if the mesh has none.  They
+//	are stored as 16-bit indices when the mesh has
+//	few enough vertices, which halves the index
+//	memory read by every draw.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadMeshIndices(GLMesh& mesh, const GLuint* indices)
+{
+	if (mesh.vbos[1] == 0)
+	{
+		glGenBuffers(1, &mesh.vbos[1]);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
+
+	if (mesh.nVertices <= 0x10000)
+	{
+		std::vector<GLushort> shortIndices(indices, indices + mesh.nIndices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * shortIndices.size(), shortIndices.data(), GL_STATIC_DRAW);
+		mesh.indexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * mesh.nIndices, indices, GL_STATIC_DRAW);
+		mesh.indexType = GL_UNSIGNED_INT;
+	}
+}
+
+///////////////////////////////////////////////////
+//	DrawMeshParts()
+//
+//	Draws the parts of the bound mesh whose bits are
+//	set in the mask.  Neighbouring parts are drawn as
+//	one range, so a whole mesh is one call, and parts
+//	with a gap between them are drawn with a single
+//	multi-draw call.  Instanced draws take one call
+//	per range.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawMeshParts(const GLMesh& mesh, unsigned int partMask, int instanceCount)
+{
+	GLsizei counts[MAX_MESH_PARTS];
+	const void* offsets[MAX_MESH_PARTS];
+	size_t indexSize = (mesh.indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	int rangeCount = 0;
+	bool bInRange = false;
+	GLuint first = 0;
+
+	for (int part = 0; part < mesh.nParts; part++)
+	{
+		if ((partMask & (1u << part)) == 0)
+		{
+			bInRange = false;
+		}
+		else if (bInRange)
+		{
+			counts[rangeCount - 1] += mesh.partIndexCounts[part];
+		}
+		else
+		{
+			counts[rangeCount] = mesh.partIndexCounts[part];
+			offsets[rangeCount] = reinterpret_cast<const void*>(indexSize * first);
+			rangeCount++;
+			bInRange = true;
+		}
+		first += mesh.partIndexCounts[part];
+	}
+
+	if (instanceCount > 0)
+	{
+		for (int range = 0; range < rangeCount; range++)
+		{
+			glDrawElementsInstanced(GL_TRIANGLES, counts[range], mesh.indexType, offsets[range], instanceCount);
+		}
+	}
+	else if (rangeCount == 1)
+	{
+		glDrawElements(GL_TRIANGLES, counts[0], mesh.indexType, offsets[0]);
+	}
+	else if (rangeCount > 1)
+	{
+		glMultiDrawElements(GL_TRIANGLES, counts, mesh.indexType, offsets, rangeCount);
+	}
+}
+
+///////////////////////////////////////////////////
+//	SetMeshCache()
+//
+//	Sets the cache the parametric meshes are mapped
+//	from when they were generated by an earlier run,
+//	and written to when they are generated here.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetMeshCache(MeshCache* pMeshCache)
+{
+	m_pMeshCache = pMeshCache;
+}
+
+///////////////////////////////////////////////////
+//	GetGeneratorVersion()
+//
+//	Returns the version of the meshes the builders
+//	output, which covers both the builders and the
+//	optimizer that orders their triangles, so the
+//	meshes cached by older code are generated again.
+///////////////////////////////////////////////////
+uint32_t ShapeMeshes::GetGeneratorVersion()
+{
+	return((MeshBuilder::MESH_GENERATOR_VERSION << 16) | MeshOptimizer::OPTIMIZER_VERSION);
+}
+
+///////////////////////////////////////////////////
+//	LoadCachedMesh()
+//
+//	Maps the cached mesh for a key and uploads its
+//	vertices straight from the mapping, and its
+//	indices as 16-bit indices when they fit.
+//	Returns false if the mesh is not cached, and it
+//	has to be generated.
+///////////////////////////////////////////////////
+bool ShapeMeshes::LoadCachedMesh(const std::string& key, GLMesh& mesh)
+{
+	MeshCache::MESH_DATA data;
+	if ((NULL == m_pMeshCache) || (!m_pMeshCache->Map(key, data)))
+	{
+		return(false);
+	}
+
+	mesh.nVertices = data.vertexCount;
+	mesh.nIndices = data.indexCount;
+	mesh.nParts = (int)std::min(data.partCount, (uint32_t)MAX_MESH_PARTS);
+	for (int i = 0; i < mesh.nParts; i++)
+	{
+		mesh.partIndexCounts[i] = data.partIndexCounts[i];
+	}
+	mesh.numSlices = data.numSlices;
+	mesh.bounds.minimum = data.minimum;
+	mesh.bounds.maximum = data.maximum;
+	mesh.bounds.center = data.center;
+	mesh.bounds.radius = data.radius;
+
+	glGenVertexArrays(1, &mesh.vao);
+	GLStateCache::BindVertexArray(mesh.vao);
+
+	glGenBuffers(1, mesh.vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 8 * data.vertexCount, data.vertices, GL_STATIC_DRAW);
+	if (data.indexCount > 0)
+	{
+		UploadMeshIndices(mesh, data.indices);
+	}
+
+	SetShaderMemoryLayout();
+	GLStateCache::BindVertexArray(0);
+
+	m_pMeshCache->Unmap(data);
+	return(true);
+}
+
+///////////////////////////////////////////////////
+//	StoreCachedMesh()
+//
+//	Writes a generated mesh to the cache, so the next
+//	run maps it instead of generating it again.
+///////////////////////////////////////////////////
+void ShapeMeshes::StoreCachedMesh(const std::string& key, const GLMesh& mesh, const GLfloat* vertices, const GLuint* indices)
+{
+	if (NULL == m_pMeshCache)
+	{
+		return;
+	}
+
+	MeshCache::MESH_DATA data = MeshCache::MESH_DATA();
+	data.vertices = vertices;
+	data.vertexCount = mesh.nVertices;
+	data.indices = (mesh.nIndices > 0) ? indices : NULL;
+	data.indexCount = mesh.nIndices;
+	data.partCount = (uint32_t)std::min(mesh.nParts, (int)MeshCache::MAX_PARTS);
+	for (uint32_t i = 0; i < data.partCount; i++)
+	{
+		data.partIndexCounts[i] = mesh.partIndexCounts[i];
+	}
+	data.numSlices = mesh.numSlices;
+	data.minimum = mesh.bounds.minimum;
+	data.maximum = mesh.bounds.maximum;
+	data.center = mesh.bounds.center;
+	data.radius = mesh.bounds.radius;
+	m_pMeshCache->Store(key, data);
+}
+
+///////////////////////////////////////////////////
+//	SetShaderMemoryLayout()
+//
+//	Sets the attribute pointers of the bound VAO for
+//	the full float vertices the generators write.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetShaderMemoryLayout()
+{
+	VertexLayout::Full::SetAttributePointers();
+}
+
+///////////////////////////////////////////////////
+//	SetSharedMemoryLayout()
+//
+//	Sets the attribute pointers of the bound VAO for
+//	the format the shared geometry is packed in.
+///////////////////////////////////////////////////
+void ShapeMeshes::SetSharedMemoryLayout()
+{
+	switch (m_sharedVertexFormat)
+	{
+	case VERTEX_FORMAT_HALF:
+		VertexLayout::Half::SetAttributePointers();
+		break;
+	case VERTEX_FORMAT_SNORM16:
+		VertexLayout::Snorm16::SetAttributePointers();
+		break;
+	default:
+		VertexLayout::Full::SetAttributePointers();
+		break;
+	}
+}
+
+///////////////////////////////////////////////////
+//	BindInstances()
+//
+//	Uploads the instances of an instanced draw into
+//	the instance buffer and binds the mesh's VAO.  The
+//	instance attributes are attached to a VAO the first
+//	time it is drawn instanced, and stay attached.
+///////////////////////////////////////////////////
+bool ShapeMeshes::BindInstances(const GLMesh& mesh, const INSTANCE_DATA* instances, int instanceCount)
+{
+	// Attribute location definitions, the model matrix takes four
+	constexpr GLuint MODEL_ATTR_LOCATION = 3;
+	constexpr GLuint COLOR_ATTR_LOCATION = 7;
+	constexpr GLuint UV_SCALE_ATTR_LOCATION = 8;
+	constexpr GLuint SURFACE_ATTR_LOCATION = 9;
+	constexpr GLuint DECODE_ATTR_LOCATION = 10;
+	constexpr GLuint NORMAL_MATRIX_ATTR_LOCATION = 12;
+
+	if ((mesh.vao == 0) || (NULL == instances) || (instanceCount <= 0))
+	{
+		return(false);
+	}
+
+	GLStateCache::BindVertexArray(mesh.vao);
+
+	// new storage is allocated for every upload, writing into storage
+	// that earlier draws are still reading would wait for those draws
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(INSTANCE_DATA) * instanceCount, instances, GL_STREAM_DRAW);
+
+	if (std::find(m_instancedVertexArrays.begin(), m_instancedVertexArrays.end(), mesh.vao) == m_instancedVertexArrays.end())
+	{
+		GLsizei stride = sizeof(INSTANCE_DATA);
+
+		// one column of the model matrix per attribute location
+		for (GLuint column = 0; column < 4; column++)
+		{
+			glVertexAttribPointer(
+				MODEL_ATTR_LOCATION + column,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				stride,
+				reinterpret_cast<void*>(offsetof(INSTANCE_DATA, model) + sizeof(glm::vec4) * column));
+			glEnableVertexAttribArray(MODEL_ATTR_LOCATION + column);
+			glVertexAttribDivisor(MODEL_ATTR_LOCATION + column, 1);
+		}
+
+		glVertexAttribPointer(
+			COLOR_ATTR_LOCATION,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			reinterpret_cast<void*>(offsetof(INSTANCE_DATA, color)));
+		glEnableVertexAttribArray(COLOR_ATTR_LOCATION);
+		glVertexAttribDivisor(COLOR_ATTR_LOCATION, 1);
+
+		glVertexAttribPointer(
+			UV_SCALE_ATTR_LOCATION,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			stride,
+			reinterpret_cast<void*>(offsetof(INSTANCE_DATA, UVscale)));
+		glEnableVertexAttribArray(UV_SCALE_ATTR_LOCATION);
+		glVertexAttribDivisor(UV_SCALE_ATTR_LOCATION, 1);
+
+		// the material index, texture array, texture layer and mirror
+		// flag are read as integers, not converted to float
+		glVertexAttribIPointer(
+			SURFACE_ATTR_LOCATION,
+			4,
+			GL_INT,
+			stride,
+			reinterpret_cast<void*>(offsetof(INSTANCE_DATA, materialIndex)));
+		glEnableVertexAttribArray(SURFACE_ATTR_LOCATION);
+		glVertexAttribDivisor(SURFACE_ATTR_LOCATION, 1);
+
+		// the offset and scale the vertices are decoded with
+		for (GLuint column = 0; column < 2; column++)
+		{
+			glVertexAttribPointer(
+				DECODE_ATTR_LOCATION + column,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				stride,
+				reinterpret_cast<void*>(offsetof(INSTANCE_DATA, decode) + sizeof(glm::vec4) * column));
+			glEnableVertexAttribArray(DECODE_ATTR_LOCATION + column);
+			glVertexAttribDivisor(DECODE_ATTR_LOCATION + column, 1);
+		}
+
+		// one column of the normal matrix per attribute location
+		for (GLuint column = 0; column < 3; column++)
+		{
+			glVertexAttribPointer(
+				NORMAL_MATRIX_ATTR_LOCATION + column,
+				3,
+				GL_FLOAT,
+				GL_FALSE,
+				stride,
+				reinterpret_cast<void*>(offsetof(INSTANCE_DATA, normalMatrix) + sizeof(glm::vec3) * column));
+			glEnableVertexAttribArray(NORMAL_MATRIX_ATTR_LOCATION + column);
+			glVertexAttribDivisor(NORMAL_MATRIX_ATTR_LOCATION + column, 1);
+		}
+
+		m_instancedVertexArrays.push_back(mesh.vao);
+	}
+
+	return(true);
+}
+
+///////////////////////////////////////////////////
+//	AppendSharedMesh()
+//
+//	Reads the vertices of a loaded mesh back from its
+//	vertex buffer and appends them to the shared
+//	vertices.  The mesh's indices are read into
+//	meshIndices, as 32-bit indices whatever type they
+//	were uploaded as.  Nothing is appended if the mesh
+//	is not loaded or does not use the common vertex
+//	layout.
+///////////////////////////////////////////////////
+GLuint ShapeMeshes::AppendSharedMesh(
+	const std::string& name,
+	const GLMesh& mesh,
+	std::vector<GLfloat>& vertices,
+	std::vector<GLuint>& meshIndices)
+{
+	const GLint stride = VertexLayout::Full::Stride;
+	GLint vertexBuffer = 0;
+	GLint indexBuffer = 0;
+	GLint vertexStride = 0;
+	GLint bufferSize = 0;
+
+	meshIndices.clear();
+	if (mesh.vao == 0)
+	{
+		return(0);
+	}
+
+	// the buffers are found through the VAO, since not every mesh
+	// keeps its buffer handles
+	GLStateCache::BindVertexArray(mesh.vao);
+	glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vertexBuffer);
+	glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &vertexStride);
+	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBuffer);
+	GLStateCache::BindVertexArray(0);
+
+	if ((vertexBuffer == 0) || (vertexStride != stride) || (indexBuffer == 0))
+	{
+		std::cerr << "Error: Mesh can not be added to the shared geometry." << std::endl;
+		return(0);
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+	glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+	GLuint vertexCount = (GLuint)(bufferSize / stride);
+	size_t firstFloat = vertices.size();
+	vertices.resize(firstFloat + (size_t)vertexCount * (stride / sizeof(GLfloat)));
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)vertexCount * stride, vertices.data() + firstFloat);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, indexBuffer);
+	if (mesh.indexType == GL_UNSIGNED_SHORT)
+	{
+		std::vector<GLushort> shortIndices(mesh.nIndices);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLushort) * shortIndices.size(), shortIndices.data());
+		meshIndices.assign(shortIndices.begin(), shortIndices.end());
+	}
+	else
+	{
+		meshIndices.resize(mesh.nIndices);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(GLuint) * meshIndices.size(), meshIndices.data());
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	SHARED_BLOCK block = { name, (GLint)(firstFloat / VertexLayout::SOURCE_FLOATS), vertexCount, GetFullVertexDecode() };
+	m_sharedBlocks.push_back(block);
+
+	return(vertexCount);
+}
+
+///////////////////////////////////////////////////
+//	AppendSharedRange()
+//
+//	Appends neighbouring parts of a mesh's triangle
+//	list to the shared indices and records them as
+//	one range.  The indices are relative to the mesh's
+//	base vertex.  Parts the mesh does not have are
+//	left out.
+///////////////////////////////////////////////////
+void ShapeMeshes::AppendSharedRange(
+	SHARED_MESH part,
+	const GLMesh& mesh,
+	const std::vector<GLuint>& meshIndices,
+	int firstPart,
+	int partCount,
+	GLint baseVertex,
+	std::vector<GLuint>& indices,
+	int detailLevel)
+{
+	SHARED_RANGE range = { (GLuint)indices.size(), 0, baseVertex };
+
+	// the parts are stored one after the other
+	GLuint first = 0;
+	GLuint count = 0;
+	for (int i = 0; (i < mesh.nParts) && (i < firstPart + partCount); i++)
+	{
+		if (i < firstPart)
+		{
+			first += mesh.partIndexCounts[i];
+		}
+		else
+		{
+			count += mesh.partIndexCounts[i];
+		}
+	}
+	if (first + count > (GLuint)meshIndices.size())
+	{
+		count = 0;
+	}
+
+	indices.insert(indices.end(), meshIndices.begin() + first, meshIndices.begin() + first + count);
+
+	range.indexCount = count;
+	m_sharedRanges[detailLevel * SHARED_MESH_COUNT + part] = range;
 }
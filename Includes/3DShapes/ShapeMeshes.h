@@ -10,10 +10,18 @@
 
 #pragma once
 
+#include "MeshBuilder.h"
+
 #include <GL/glew.h>
 
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <string>
+#include <vector>
+
+class MeshCache;
+
 /***********************************************************
  *  ShapeMeshes
  *
@@ -26,16 +34,56 @@ public:
 	// constructor
 	ShapeMeshes();
 
+	// bounds of a mesh around the origin of its model space - the
+	// sphere is centered on the box
+	typedef MeshBuilder::MESH_BOUNDS MESH_BOUNDS;
+
+	// tessellations the cone, cylinder, sphere and torus can be loaded
+	// at, 0 is the finest and the one the Draw methods use
+	static const int DETAIL_LEVELS = 3;
+
+	// formats the shared geometry can be packed in - the meshes' own
+	// buffers always keep the full floats the generators write
+	enum VERTEX_FORMAT
+	{
+		VERTEX_FORMAT_FULL = 0,   // float position, normal and UV, 32 bytes
+		VERTEX_FORMAT_HALF,       // half float position, octahedral normal, 16-bit UV, 16 bytes
+		VERTEX_FORMAT_SNORM16     // 16-bit position, octahedral normal, 16-bit UV, 16 bytes
+	};
+
+	// how the vertex shader decodes the vertices of a mesh - packed
+	// positions are offset + scale * the stored position, packed UVs
+	// are multiplied by scale.w, and offset.w is 1 for packed vertices
+	// and 0 for full floats, which are used as they are
+	struct VERTEX_DECODE
+	{
+		glm::vec4 offset;
+		glm::vec4 scale;
+	};
+
 private:
 
+	// most parts a mesh's indices are split into - the six faces of
+	// the box
+	static const int MAX_MESH_PARTS = MeshBuilder::MAX_PARTS;
+	// every part of a mesh, for the part masks of DrawMeshParts()
+	static const unsigned int ALL_MESH_PARTS = (1u << MAX_MESH_PARTS) - 1;
+
 	// stores the GL data relative to a given mesh
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
-		GLuint vbos[2];     // Handles for the vertex buffer objects
-		GLuint nVertices;	// Number of vertices for the mesh
-		GLuint nIndices;    // Number of indices for the mesh
-		int numSlices;      // Number of slices (specific to cone or other parameterized shapes)
+		GLuint vao = 0;         // Handle for the vertex array object
+		GLuint vbos[2] = { 0, 0 };  // Handles for the vertex buffer objects
+		GLuint nVertices = 0;	// Number of vertices for the mesh
+		GLuint nIndices = 0;    // Number of indices for the mesh
+		GLenum indexType = GL_UNSIGNED_INT;  // GL_UNSIGNED_SHORT when every index fits
+		// the indices are a triangle list split into parts that can be
+		// drawn on their own, such as the top, bottom and sides of a
+		// cylinder, stored one after the other
+		int nParts = 0;
+		GLuint partIndexCounts[MAX_MESH_PARTS] = { 0, 0, 0, 0, 0, 0 };
+		int numSlices = 0;      // Number of slices (specific to cone or other parameterized shapes)
+		MESH_BOUNDS bounds = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), -1.0f };
 	};
 
 	// the available 3D shapes
@@ -52,10 +100,99 @@ private:
 	// the following torus meshes are provided in case multiple tori of different thicknesses are needed
 	GLMesh m_ExtraTorusMesh1;
 	GLMesh m_ExtraTorusMesh2;
+	// coarser tessellations of the parametric meshes, by detail level - 1,
+	// only drawn from the shared geometry
+	GLMesh m_ConeLevels[DETAIL_LEVELS - 1];
+	GLMesh m_CylinderLevels[DETAIL_LEVELS - 1];
+	GLMesh m_SphereLevels[DETAIL_LEVELS - 1];
+	GLMesh m_TorusLevels[DETAIL_LEVELS - 1];
 
-	bool m_bMemoryLayoutDone;
+	// builds a mesh into the data it is passed
+	typedef std::function<void(MeshBuilder::MESH_DATA&)> MESH_BUILDER;
+	// a mesh waiting for FinishMeshLoading() to build and upload it
+	struct PENDING_MESH
+	{
+		std::string name;
+		bool bCacheMesh;
+		GLMesh* pMesh;
+		MESH_BUILDER builder;
+		MeshBuilder::MESH_DATA data;
+	};
+	// true between BeginMeshLoading() and FinishMeshLoading()
+	bool m_bQueueMeshes;
+	std::vector<PENDING_MESH> m_pendingMeshes;
+
+	// cache the parametric meshes are mapped from, NULL to generate them
+	MeshCache* m_pMeshCache;
+
+	// buffer holding the per-instance data of the last instanced draw
+	GLuint m_instanceBuffer;
+	// vertex arrays with the instance attributes attached
+	std::vector<GLuint> m_instancedVertexArrays;
 
 public:
+	// per-instance data read by the vertex shader for instanced draws
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;      // attribute locations 3 to 6
+		glm::vec4 color;      // attribute location 7, used without a texture
+		glm::vec2 UVscale;    // attribute location 8
+		// attribute location 9
+		GLint materialIndex;
+		GLint textureArray;   // -1 to draw with the color instead
+		GLint textureLayer;
+		GLint bMirrorTexture;
+		// attribute locations 10 and 11
+		VERTEX_DECODE decode;
+		// attribute locations 12 to 14, the inverse transpose of the
+		// model so the shader does not invert it for every vertex
+		glm::mat3 normalMatrix;
+	};
+
+	// parts of the meshes in the shared geometry, each a triangle list
+	enum SHARED_MESH
+	{
+		SHARED_BOX = 0,
+		SHARED_CONE_BOTTOM,
+		SHARED_CONE_SIDES,
+		SHARED_CYLINDER_BOTTOM,
+		SHARED_CYLINDER_TOP,
+		SHARED_CYLINDER_SIDES,
+		SHARED_PLANE,
+		SHARED_PRISM,
+		SHARED_PYRAMID3,
+		SHARED_PYRAMID4,
+		SHARED_SPHERE,
+		SHARED_HALF_SPHERE,
+		SHARED_TAPERED_CYLINDER_BOTTOM,
+		SHARED_TAPERED_CYLINDER_TOP,
+		SHARED_TAPERED_CYLINDER_SIDES,
+		SHARED_TORUS,
+		SHARED_HALF_TORUS,
+		SHARED_EXTRA_TORUS1,
+		SHARED_EXTRA_TORUS2,
+		SHARED_MESH_COUNT
+	};
+
+	// where a part is stored in the shared geometry, no indices if the
+	// mesh was not loaded
+	struct SHARED_RANGE
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+	};
+
+	// one draw of an indirect draw, laid out as OpenGL reads it
+	struct DRAW_ELEMENTS_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;   // first entry of the instance data
+	};
+
         enum BoxSide
 	{
 		front,
@@ -67,20 +204,33 @@ public:
 	}; 
 
 	// methods for loading the shape mesh data 
-	// into memory
+	// into memory - the parametric meshes can be loaded again with fewer
+	// segments at a coarser detail level
 	void LoadBoxMesh();
-	void LoadConeMesh(float radius = 1.0f, float height = 1.0f, int numSlices = 36);
-	void LoadCylinderMesh(float radius = 1.0f, float height = 1.0f, int numSlices = 36);
+	void LoadConeMesh(float radius = 1.0f, float height = 1.0f, int numSlices = 36, int detailLevel = 0);
+	void LoadCylinderMesh(float radius = 1.0f, float height = 1.0f, int numSlices = 36, int detailLevel = 0);
 	void LoadPlaneMesh(float width = 2.0f, float height = 2.0f);
 	void LoadPrismMesh();
 	void LoadPyramid3Mesh();
 	void LoadPyramid4Mesh(float baseSize = 1.0f, float height = 1.0f);
-	void LoadSphereMesh(int latitudeSegments = 16, int longitudeSegments = 16, float radius = 1.0f);
+	void LoadSphereMesh(int latitudeSegments = 16, int longitudeSegments = 16, float radius = 1.0f, int detailLevel = 0);
 	void LoadTaperedCylinderMesh();
-	void LoadTorusMesh(float mainRadius = 1.0f, float tubeRadius = 0.3f, int mainSegments = 30, int tubeSegments = 30);
+	void LoadTorusMesh(float mainRadius = 1.0f, float tubeRadius = 0.3f, int mainSegments = 30, int tubeSegments = 30, int detailLevel = 0);
 	// the following torus meshes are provided in case multiple tori of different thicknesses are needed
-	void LoadExtraTorusMesh1(float thickness = 0.4);
-	void LoadExtraTorusMesh2(float thickness = 0.6);
+	void LoadExtraTorusMesh1(float thickness = 0.4, int mainSegments = 30, int tubeSegments = 30);
+	void LoadExtraTorusMesh2(float thickness = 0.6, int mainSegments = 30, int tubeSegments = 30);
+
+	// the meshes loaded between these calls are built together on
+	// worker threads when loading is finished, and then uploaded on
+	// the calling thread, which has to own the OpenGL context
+	void BeginMeshLoading();
+	void FinishMeshLoading();
+
+	// map the cone, cylinder, sphere and tori from this cache instead of
+	// generating them, set before the meshes are loaded
+	void SetMeshCache(MeshCache* pMeshCache);
+	// version of the generated meshes, for the mesh cache
+	static uint32_t GetGeneratorVersion();
 
 	// methods for drawing the filled shape mesh in the
 	// display window
@@ -124,9 +274,102 @@ public:
 	void DrawExtraTorusMesh1();
 	void DrawExtraTorusMesh2();
 
+	// methods for drawing many copies of a filled shape mesh with a
+	// single instanced draw call - the model matrix, UV scale and
+	// material of each copy are taken from the passed in instances
+	void DrawBoxMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawConeMeshInstanced(const INSTANCE_DATA* instances, int instanceCount, bool bDrawBottom = true);
+	void DrawCylinderMeshInstanced(const INSTANCE_DATA* instances, int instanceCount, bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawPlaneMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawPrismMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawPyramid3MeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawPyramid4MeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawSphereMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawHalfSphereMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawTaperedCylinderMeshInstanced(
+		const INSTANCE_DATA* instances,
+		int instanceCount,
+		bool bDrawTop = true,
+		bool bDrawBottom = true,
+		bool bDrawSides = true);
+	void DrawTorusMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawHalfTorusMeshInstanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawExtraTorusMesh1Instanced(const INSTANCE_DATA* instances, int instanceCount);
+	void DrawExtraTorusMesh2Instanced(const INSTANCE_DATA* instances, int instanceCount);
+
+	// method for packing the loaded meshes and the static batches into
+	// one vertex and index buffer, called once every mesh is loaded
+	bool BuildSharedGeometry();
+	bool HasSharedGeometry() const { return(m_SharedMesh.vao != 0); }
+	// the format the shared geometry is packed in, set before it is built
+	void SetSharedVertexFormat(VERTEX_FORMAT format) { m_sharedVertexFormat = format; }
+	VERTEX_FORMAT GetSharedVertexFormat() const { return(m_sharedVertexFormat); }
+	// how the vertices of the shared geometry starting at a range's
+	// base vertex are decoded
+	VERTEX_DECODE GetSharedVertexDecode(GLint baseVertex) const;
+	// the decode of vertices that are full floats
+	static VERTEX_DECODE GetFullVertexDecode();
+	// the range of the shared index buffer holding a mesh part, the
+	// finest level is returned for a level that was not loaded
+	SHARED_RANGE GetSharedRange(SHARED_MESH part, int detailLevel = 0) const;
+	// copy the triangles of a mesh part, the indices start at the
+	// first copied vertex - the meshes have to be loaded
+	bool GetSharedTriangles(SHARED_MESH part, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+
+	// the bounds of the mesh a part is drawn from - the parts of a mesh
+	// share the bounds of the whole mesh
+	MESH_BOUNDS GetMeshBounds(SHARED_MESH part) const;
+
+	// method for adding pre-transformed geometry to the shared geometry,
+	// returns the batch index - call before BuildSharedGeometry()
+	int AddStaticBatch(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices);
+	int GetStaticBatchCount() const { return((int)m_staticBatchRanges.size()); }
+	// the range of the shared index buffer holding a static batch
+	SHARED_RANGE GetStaticBatchRange(int batch) const;
+	// the bounds of a static batch, in the space it was baked in
+	MESH_BOUNDS GetStaticBatchBounds(int batch) const;
+	// draw a static batch from the shared geometry, once or per instance
+	void DrawStaticBatch(int batch);
+	void DrawStaticBatchInstanced(int batch, const INSTANCE_DATA* instances, int instanceCount);
+	// draw any number of mesh parts from the shared geometry with one
+	// multi-draw call - each command reads its instances starting at
+	// its baseInstance
+	void DrawSharedMeshesIndirect(
+		const INSTANCE_DATA* instances,
+		int instanceCount,
+		const DRAW_ELEMENTS_COMMAND* commands,
+		int commandCount);
+
 
 private:
 
+	// every loaded mesh packed into one vertex and one index buffer
+	GLMesh m_SharedMesh;
+	// triangle list ranges of the shared index buffer, by detail level
+	// * SHARED_MESH_COUNT + SHARED_MESH
+	std::vector<SHARED_RANGE> m_sharedRanges;
+	// ranges of the static batches in the shared index buffer
+	std::vector<SHARED_RANGE> m_staticBatchRanges;
+	std::vector<MESH_BOUNDS> m_staticBatchBounds;
+	// the shared vertices and indices, kept for the static batches
+	std::vector<GLfloat> m_sharedVertices;
+	std::vector<GLuint> m_sharedIndices;
+	// the type the shared indices are uploaded as
+	GLenum m_sharedIndexType;
+	// a mesh or static batch in the shared vertices, in the order
+	// they were appended
+	struct SHARED_BLOCK
+	{
+		std::string name;
+		GLint baseVertex;
+		GLuint vertexCount;
+		VERTEX_DECODE decode;
+	};
+	std::vector<SHARED_BLOCK> m_sharedBlocks;
+	VERTEX_FORMAT m_sharedVertexFormat;
+	// buffer holding the commands of the last indirect draw
+	GLuint m_indirectBuffer;
+
 	// called to calculate the normal for 
 	// the passed in coordinates
 	glm::vec3 QuadCrossProduct(
@@ -135,7 +378,61 @@ private:
 
 	glm::vec3 CalculateTriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2);
 
+	// called to build a mesh and upload it, or to queue it while
+	// meshes are being queued - the name is its cache key when it is
+	// stored in the mesh cache
+	void GenerateMesh(const std::string& name, bool bCacheMesh, GLMesh& mesh, const MESH_BUILDER& builder);
+	// called to upload a built mesh into a new VAO and set its counts,
+	// parts and bounds - the cache statistics are logged under the name
+	void UploadMesh(const std::string& name, bool bCacheMesh, GLMesh& mesh, const MeshBuilder::MESH_DATA& data);
+	// called to upload a mesh's indices into its index buffer, as
+	// 16-bit indices when every vertex can be reached with them - the
+	// mesh's VAO has to be bound
+	static void UploadMeshIndices(GLMesh& mesh, const GLuint* indices);
+	// called to draw the parts of the bound mesh set in a mask, as one
+	// call per run of neighbouring parts or once per instance
+	static void DrawMeshParts(const GLMesh& mesh, unsigned int partMask, int instanceCount = 0);
+
+	// called to upload a mesh straight from the mesh cache, false if
+	// it is not cached
+	bool LoadCachedMesh(const std::string& key, GLMesh& mesh);
+	// called to write a generated mesh to the mesh cache, after its
+	// counts and bounds are set
+	void StoreCachedMesh(const std::string& key, const GLMesh& mesh, const GLfloat* vertices, const GLuint* indices);
+
+	// called to load one of the extra tori, from the mesh cache or
+	// generated, under the name of its cache key
+	void LoadExtraTorusMesh(const char* name, GLMesh& mesh, float thickness, int mainSegments, int tubeSegments);
+
 	// called to set the memory layout 
 	// template for shader data
 	void SetShaderMemoryLayout();
+
+	// called to upload the instances of an instanced draw and bind
+	// the mesh with the instance attributes attached
+	bool BindInstances(const GLMesh& mesh, const INSTANCE_DATA* instances, int instanceCount);
+
+	// called to read the loaded meshes into the shared vertices and
+	// indices, if that was not done yet
+	bool CollectSharedGeometry();
+	// called to append a loaded mesh to the shared geometry
+	// returns the number of vertices appended, and fills meshIndices with
+	// the mesh's own indices
+	GLuint AppendSharedMesh(const std::string& name, const GLMesh& mesh,
+		std::vector<GLfloat>& vertices, std::vector<GLuint>& meshIndices);
+	// called to encode the shared vertices into the shared vertex
+	// format, filling in the decode of every block - returns the
+	// bytes per vertex
+	GLsizei PackSharedVertices(std::vector<unsigned char>& packed);
+	// called to set the attribute pointers of the shared geometry's VAO
+	// for the shared vertex format
+	void SetSharedMemoryLayout();
+	// called to append the cone, cylinder, sphere and torus of a detail
+	// level to the shared geometry
+	void AppendSharedDetailLevel(int detailLevel, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+	// called to append neighbouring parts of a mesh to the shared index
+	// buffer as one range
+	void AppendSharedRange(SHARED_MESH part, const GLMesh& mesh, const std::vector<GLuint>& meshIndices,
+		int firstPart, int partCount, GLint baseVertex, std::vector<GLuint>& indices,
+		int detailLevel = 0);
 };
\ No newline at end of file
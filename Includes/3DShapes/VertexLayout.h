@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// VertexLayout.h
+// ============
+// compile-time descriptions of the vertex formats the meshes are stored in
+//
+//  A layout is a list of attribute types.  Each attribute type names its
+//  shader location, how OpenGL reads it, and how it is encoded from the
+//  8 float vertices the shape generators write (position, normal, UV).
+//  The layout adds up the stride and offsets, sets the attribute pointers
+//  of the bound VAO, and encodes whole vertex buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace VertexLayout
+{
+	// shader locations of the vertex attributes
+	constexpr GLuint POSITION_LOCATION = 0;
+	constexpr GLuint NORMAL_LOCATION = 1;
+	constexpr GLuint UV_LOCATION = 2;
+	// floats in each vertex written by the shape generators
+	constexpr size_t SOURCE_FLOATS = 8;
+
+	// the range packed vertices are stored relative to - positions are
+	// divided into the half size of the mesh's box around its center,
+	// and texture coordinates into the largest one of the mesh
+	struct PACKING_RANGE
+	{
+		glm::vec3 center;
+		glm::vec3 halfSize;
+		float uvScale;
+	};
+
+	// scale a value into -1 to 1 of a range, 0 for an empty range
+	inline float ToUnitRange(float value, float center, float halfSize)
+	{
+		return((halfSize > 0.0f) ? glm::clamp((value - center) / halfSize, -1.0f, 1.0f) : 0.0f);
+	}
+
+	// map a unit vector onto the octahedron and unfold it into a square
+	// of -1 to 1, so a normal takes two values instead of three
+	inline glm::vec2 EncodeOctahedral(const glm::vec3& normal)
+	{
+		float length = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+		if (length <= 0.0f)
+		{
+			return(glm::vec2(0.0f));
+		}
+
+		glm::vec2 folded = glm::vec2(normal.x, normal.y) / length;
+		if (normal.z < 0.0f)
+		{
+			glm::vec2 sign = glm::vec2((folded.x >= 0.0f) ? 1.0f : -1.0f, (folded.y >= 0.0f) ? 1.0f : -1.0f);
+			folded = (glm::vec2(1.0f) - glm::abs(glm::vec2(folded.y, folded.x))) * sign;
+		}
+
+		return(folded);
+	}
+
+	// float position, as generated
+	struct PositionFloat3
+	{
+		static constexpr GLuint Location = POSITION_LOCATION;
+		static constexpr GLint Components = 3;
+		static constexpr GLenum Type = GL_FLOAT;
+		static constexpr GLboolean Normalized = GL_FALSE;
+		static constexpr bool Packed = false;
+		GLfloat value[3];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE&)
+		{
+			memcpy(value, vertex, sizeof(value));
+		}
+	};
+
+	// half float position in -1 to 1 of the mesh's box, padded to 8 bytes
+	struct PositionHalf4
+	{
+		static constexpr GLuint Location = POSITION_LOCATION;
+		static constexpr GLint Components = 3;
+		static constexpr GLenum Type = GL_HALF_FLOAT;
+		static constexpr GLboolean Normalized = GL_FALSE;
+		static constexpr bool Packed = true;
+		uint16_t value[4];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE& range)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				value[i] = glm::packHalf1x16(ToUnitRange(vertex[i], range.center[i], range.halfSize[i]));
+			}
+			value[3] = 0;
+		}
+	};
+
+	// signed normalized 16-bit position in the mesh's box, padded to 8 bytes
+	struct PositionSnorm16x4
+	{
+		static constexpr GLuint Location = POSITION_LOCATION;
+		static constexpr GLint Components = 3;
+		static constexpr GLenum Type = GL_SHORT;
+		static constexpr GLboolean Normalized = GL_TRUE;
+		static constexpr bool Packed = true;
+		uint16_t value[4];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE& range)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				value[i] = glm::packSnorm1x16(ToUnitRange(vertex[i], range.center[i], range.halfSize[i]));
+			}
+			value[3] = 0;
+		}
+	};
+
+	// float normal, as generated
+	struct NormalFloat3
+	{
+		static constexpr GLuint Location = NORMAL_LOCATION;
+		static constexpr GLint Components = 3;
+		static constexpr GLenum Type = GL_FLOAT;
+		static constexpr GLboolean Normalized = GL_FALSE;
+		static constexpr bool Packed = false;
+		GLfloat value[3];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE&)
+		{
+			memcpy(value, vertex + 3, sizeof(value));
+		}
+	};
+
+	// octahedral normal in two signed normalized 16-bit values
+	struct NormalOctahedralSnorm16x2
+	{
+		static constexpr GLuint Location = NORMAL_LOCATION;
+		static constexpr GLint Components = 2;
+		static constexpr GLenum Type = GL_SHORT;
+		static constexpr GLboolean Normalized = GL_TRUE;
+		static constexpr bool Packed = true;
+		uint16_t value[2];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE&)
+		{
+			glm::vec2 octahedral = EncodeOctahedral(glm::vec3(vertex[3], vertex[4], vertex[5]));
+			value[0] = glm::packSnorm1x16(octahedral.x);
+			value[1] = glm::packSnorm1x16(octahedral.y);
+		}
+	};
+
+	// float texture coordinates, as generated
+	struct UVFloat2
+	{
+		static constexpr GLuint Location = UV_LOCATION;
+		static constexpr GLint Components = 2;
+		static constexpr GLenum Type = GL_FLOAT;
+		static constexpr GLboolean Normalized = GL_FALSE;
+		static constexpr bool Packed = false;
+		GLfloat value[2];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE&)
+		{
+			memcpy(value, vertex + 6, sizeof(value));
+		}
+	};
+
+	// unsigned normalized 16-bit texture coordinates, divided by the
+	// largest of the mesh so coordinates past 1 still fit
+	struct UVUnorm16x2
+	{
+		static constexpr GLuint Location = UV_LOCATION;
+		static constexpr GLint Components = 2;
+		static constexpr GLenum Type = GL_UNSIGNED_SHORT;
+		static constexpr GLboolean Normalized = GL_TRUE;
+		static constexpr bool Packed = true;
+		uint16_t value[2];
+
+		void Encode(const GLfloat* vertex, const PACKING_RANGE& range)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				value[i] = glm::packUnorm1x16((range.uvScale > 0.0f) ? vertex[6 + i] / range.uvScale : 0.0f);
+			}
+		}
+	};
+
+	// a vertex made of the listed attributes, in order
+	template<typename... Attributes>
+	struct Layout
+	{
+		// bytes per vertex
+		static constexpr GLsizei Stride = (GLsizei)(0 + ... + sizeof(Attributes));
+		// true if any attribute has to be decoded by the vertex shader
+		static constexpr bool Packed = (false || ... || Attributes::Packed);
+
+		static_assert(Stride % 4 == 0, "vertex attributes have to stay 4 byte aligned");
+
+		// set and enable the attribute pointers of the bound VAO for
+		// vertices starting at the beginning of the bound array buffer
+		static void SetAttributePointers()
+		{
+			size_t offset = 0;
+			(SetAttributePointer<Attributes>(offset), ...);
+		}
+
+		// encode generated vertices of 8 floats into this layout, the
+		// output has to hold Stride bytes for every vertex
+		static void Encode(const GLfloat* vertices, size_t vertexCount, const PACKING_RANGE& range, unsigned char* output)
+		{
+			for (size_t i = 0; i < vertexCount; i++)
+			{
+				size_t offset = 0;
+				(EncodeAttribute<Attributes>(vertices + i * SOURCE_FLOATS, range, output + i * Stride, offset), ...);
+			}
+		}
+
+	private:
+		template<typename Attribute>
+		static void SetAttributePointer(size_t& offset)
+		{
+			glVertexAttribPointer(
+				Attribute::Location,
+				Attribute::Components,
+				Attribute::Type,
+				Attribute::Normalized,
+				Stride,
+				reinterpret_cast<void*>(offset));
+			glEnableVertexAttribArray(Attribute::Location);
+			offset += sizeof(Attribute);
+		}
+
+		template<typename Attribute>
+		static void EncodeAttribute(const GLfloat* vertex, const PACKING_RANGE& range, unsigned char* output, size_t& offset)
+		{
+			Attribute attribute;
+			attribute.Encode(vertex, range);
+			memcpy(output + offset, &attribute, sizeof(Attribute));
+			offset += sizeof(Attribute);
+		}
+	};
+
+	// the layout the shape generators write, 32 bytes
+	typedef Layout<PositionFloat3, NormalFloat3, UVFloat2> Full;
+	// half float positions, octahedral normals and 16-bit UVs, 16 bytes
+	typedef Layout<PositionHalf4, NormalOctahedralSnorm16x2, UVUnorm16x2> Half;
+	// 16-bit positions, octahedral normals and 16-bit UVs, 16 bytes
+	typedef Layout<PositionSnorm16x4, NormalOctahedralSnorm16x2, UVUnorm16x2> Snorm16;
+}
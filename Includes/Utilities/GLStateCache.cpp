@@ -0,0 +1,470 @@
+/******************************************************************************
+ * GLStateCache.cpp
+ * ==================
+ * Keeps a copy of the OpenGL state set through the cache and skips the calls
+ * that would not change it.
+ *
+ * PURPOSE:
+ * - Avoid passing redundant state changes and uniform uploads to the driver.
+ * - Count the issued and skipped calls for the frame statistics.
+ *
+ * FEATURES:
+ * - Every cached value starts out unknown, so the first call of each kind
+ *   is always issued and the cache never relies on OpenGL defaults.
+ * - Uniform values are shadowed as raw bytes per program and per location,
+ *   so the comparison is exact - a uniform is only skipped when the value
+ *   already in the program is bit for bit the same.
+ * - The state is thread local, as each OpenGL context is current on one
+ *   thread only. The loader thread's context has its own copy.
+ *
+ ******************************************************************************/
+
+
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "GLStateCache.h"
+
+namespace
+{
+	// marks a cached object binding that is not known yet
+	const GLuint UNKNOWN_OBJECT = 0xFFFFFFFF;
+	// marks a cached enum value that is not known yet
+	const GLenum UNKNOWN_ENUM = 0;
+	// texture units with cached bindings, others are passed straight on
+	const int MAX_TEXTURE_UNITS = 32;
+	// largest uniform value that is shadowed, a 4x4 float matrix
+	const int MAX_UNIFORM_BYTES = 16 * sizeof(GLfloat);
+
+	// textures bound to one texture unit
+	struct TEXTURE_UNIT
+	{
+		GLuint texture2D = UNKNOWN_OBJECT;
+		GLuint textureArray = UNKNOWN_OBJECT;
+	};
+
+	// last value uploaded to one uniform location, no bytes when unknown
+	struct UNIFORM_VALUE
+	{
+		GLsizei bytes = 0;
+		unsigned char data[MAX_UNIFORM_BYTES];
+	};
+
+	// the cached state of the OpenGL context current on this thread
+	struct GL_STATE
+	{
+		GLuint vertexArray = UNKNOWN_OBJECT;
+		GLuint program = UNKNOWN_OBJECT;
+		GLenum activeTexture = UNKNOWN_ENUM;
+		TEXTURE_UNIT textureUnits[MAX_TEXTURE_UNITS];
+		// capability -> enabled, missing when unknown
+		std::unordered_map<GLenum, bool> capabilities;
+		GLenum blendSource = UNKNOWN_ENUM;
+		GLenum blendDestination = UNKNOWN_ENUM;
+		// program -> uniform values indexed by location
+		std::unordered_map<GLuint, std::vector<UNIFORM_VALUE>> uniforms;
+		// uniform values of the program in use, NULL when it is unknown
+		std::vector<UNIFORM_VALUE>* pProgramUniforms = NULL;
+
+		int issuedCalls = 0;
+		int skippedCalls = 0;
+	};
+
+	thread_local GL_STATE g_State;
+
+	/***********************************************************
+	 *  Changed()
+	 *
+	 *  This method is used for counting a state change as issued
+	 *  or skipped.  It returns true when the call must be made.
+	 ***********************************************************/
+	bool Changed(bool bChanged)
+	{
+		if (bChanged)
+		{
+			g_State.issuedCalls++;
+		}
+		else
+		{
+			g_State.skippedCalls++;
+		}
+		return(bChanged);
+	}
+
+	/***********************************************************
+	 *  UniformChanged()
+	 *
+	 *  This method is used for comparing a uniform value with the
+	 *  shadowed value of the program in use, and storing it when
+	 *  it differs.  It returns true when the upload must be made.
+	 ***********************************************************/
+	bool UniformChanged(GLint location, const void* value, GLsizei bytes)
+	{
+		// uploads to inactive uniforms are ignored by OpenGL anyway
+		if (location < 0)
+		{
+			return(Changed(false));
+		}
+		if (NULL == g_State.pProgramUniforms)
+		{
+			return(Changed(true));
+		}
+
+		std::vector<UNIFORM_VALUE>& values = *g_State.pProgramUniforms;
+		if (location >= (GLint)values.size())
+		{
+			values.resize(location + 1);
+		}
+
+		UNIFORM_VALUE& shadow = values[location];
+		if ((shadow.bytes == bytes) && (0 == memcmp(shadow.data, value, bytes)))
+		{
+			return(Changed(false));
+		}
+		shadow.bytes = bytes;
+		memcpy(shadow.data, value, bytes);
+		return(Changed(true));
+	}
+
+	/***********************************************************
+	 *  GetTextureBinding()
+	 *
+	 *  This method is used for finding the cached binding of a
+	 *  texture target on the active texture unit.  NULL is
+	 *  returned for targets and units that are not cached.
+	 ***********************************************************/
+	GLuint* GetTextureBinding(GLenum target)
+	{
+		if (UNKNOWN_ENUM == g_State.activeTexture)
+		{
+			return(NULL);
+		}
+		int unit = (int)(g_State.activeTexture - GL_TEXTURE0);
+		if ((unit < 0) || (unit >= MAX_TEXTURE_UNITS))
+		{
+			return(NULL);
+		}
+
+		if (GL_TEXTURE_2D == target)
+		{
+			return(&g_State.textureUnits[unit].texture2D);
+		}
+		if (GL_TEXTURE_2D_ARRAY == target)
+		{
+			return(&g_State.textureUnits[unit].textureArray);
+		}
+		return(NULL);
+	}
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used for binding a vertex array object.
+ ***********************************************************/
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (Changed(vertexArray != g_State.vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+		g_State.vertexArray = vertexArray;
+	}
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making a shader program current.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint program)
+{
+	if (Changed(program != g_State.program))
+	{
+		glUseProgram(program);
+		g_State.program = program;
+		g_State.pProgramUniforms = (0 == program) ? NULL : &g_State.uniforms[program];
+	}
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This method is used for selecting the active texture unit.
+ ***********************************************************/
+void GLStateCache::ActiveTexture(GLenum textureUnit)
+{
+	if (Changed(textureUnit != g_State.activeTexture))
+	{
+		glActiveTexture(textureUnit);
+		g_State.activeTexture = textureUnit;
+	}
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to the active
+ *  texture unit.
+ ***********************************************************/
+void GLStateCache::BindTexture(GLenum target, GLuint texture)
+{
+	GLuint* pBinding = GetTextureBinding(target);
+	if (NULL == pBinding)
+	{
+		Changed(true);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (Changed(texture != *pBinding))
+	{
+		glBindTexture(target, texture);
+		*pBinding = texture;
+	}
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used for enabling an OpenGL capability.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::const_iterator it = g_State.capabilities.find(capability);
+	if (Changed((it == g_State.capabilities.end()) || (false == it->second)))
+	{
+		glEnable(capability);
+		g_State.capabilities[capability] = true;
+	}
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for disabling an OpenGL capability.
+ ***********************************************************/
+void GLStateCache::Disable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::const_iterator it = g_State.capabilities.find(capability);
+	if (Changed((it == g_State.capabilities.end()) || (true == it->second)))
+	{
+		glDisable(capability);
+		g_State.capabilities[capability] = false;
+	}
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blend function.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (Changed((sourceFactor != g_State.blendSource) ||
+		(destinationFactor != g_State.blendDestination)))
+	{
+		glBlendFunc(sourceFactor, destinationFactor);
+		g_State.blendSource = sourceFactor;
+		g_State.blendDestination = destinationFactor;
+	}
+}
+
+/***********************************************************
+ *  Uniform*()
+ *
+ *  These methods are used for uploading a single uniform value
+ *  to the program in use.
+ ***********************************************************/
+void GLStateCache::Uniform1i(GLint location, GLint value)
+{
+	if (UniformChanged(location, &value, sizeof(GLint)))
+	{
+		glUniform1i(location, value);
+	}
+}
+
+void GLStateCache::Uniform1f(GLint location, GLfloat value)
+{
+	if (UniformChanged(location, &value, sizeof(GLfloat)))
+	{
+		glUniform1f(location, value);
+	}
+}
+
+void GLStateCache::Uniform2fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 2 * sizeof(GLfloat)))
+	{
+		glUniform2fv(location, 1, value);
+	}
+}
+
+void GLStateCache::Uniform3fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 3 * sizeof(GLfloat)))
+	{
+		glUniform3fv(location, 1, value);
+	}
+}
+
+void GLStateCache::Uniform4fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 4 * sizeof(GLfloat)))
+	{
+		glUniform4fv(location, 1, value);
+	}
+}
+
+void GLStateCache::UniformMatrix2fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 4 * sizeof(GLfloat)))
+	{
+		glUniformMatrix2fv(location, 1, GL_FALSE, value);
+	}
+}
+
+void GLStateCache::UniformMatrix3fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 9 * sizeof(GLfloat)))
+	{
+		glUniformMatrix3fv(location, 1, GL_FALSE, value);
+	}
+}
+
+void GLStateCache::UniformMatrix4fv(GLint location, const GLfloat* value)
+{
+	if (UniformChanged(location, value, 16 * sizeof(GLfloat)))
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, value);
+	}
+}
+
+/***********************************************************
+ *  DeleteVertexArrays()
+ *
+ *  This method is used for deleting vertex array objects.  A
+ *  deleted vertex array that is bound reverts to zero.
+ ***********************************************************/
+void GLStateCache::DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays)
+{
+	glDeleteVertexArrays(count, vertexArrays);
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if ((0 != vertexArrays[i]) && (vertexArrays[i] == g_State.vertexArray))
+		{
+			g_State.vertexArray = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  DeleteTextures()
+ *
+ *  This method is used for deleting textures.  Units that a
+ *  deleted texture is bound to revert to zero.
+ ***********************************************************/
+void GLStateCache::DeleteTextures(GLsizei count, const GLuint* textures)
+{
+	glDeleteTextures(count, textures);
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (0 == textures[i])
+		{
+			continue;
+		}
+		for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+		{
+			TEXTURE_UNIT& textureUnit = g_State.textureUnits[unit];
+			if (textures[i] == textureUnit.texture2D)
+			{
+				textureUnit.texture2D = 0;
+			}
+			if (textures[i] == textureUnit.textureArray)
+			{
+				textureUnit.textureArray = 0;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  DeleteProgram()
+ *
+ *  This method is used for deleting a shader program.  A
+ *  program in use stays current until another one is used,
+ *  so only its shadowed uniforms are dropped.
+ ***********************************************************/
+void GLStateCache::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+	ForgetProgram(program);
+}
+
+/***********************************************************
+ *  ForgetProgram()
+ *
+ *  This method is used for dropping the shadowed uniform
+ *  values of a program, so the next upload of each uniform
+ *  is issued.
+ ***********************************************************/
+void GLStateCache::ForgetProgram(GLuint program)
+{
+	// cleared rather than erased, the program in use points at it
+	std::unordered_map<GLuint, std::vector<UNIFORM_VALUE>>::iterator it = g_State.uniforms.find(program);
+	if (it != g_State.uniforms.end())
+	{
+		it->second.clear();
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all of the cached state
+ *  after OpenGL was called without going through the cache.
+ *  The counters are kept.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	int issuedCalls = g_State.issuedCalls;
+	int skippedCalls = g_State.skippedCalls;
+
+	g_State = GL_STATE();
+	g_State.issuedCalls = issuedCalls;
+	g_State.skippedCalls = skippedCalls;
+}
+
+/***********************************************************
+ *  GetIssuedCount()
+ *
+ *  This method is used for getting the number of calls that
+ *  were passed on to OpenGL since the last reset.
+ ***********************************************************/
+int GLStateCache::GetIssuedCount()
+{
+	return(g_State.issuedCalls);
+}
+
+/***********************************************************
+ *  GetSkippedCount()
+ *
+ *  This method is used for getting the number of calls that
+ *  were skipped since the last reset.
+ ***********************************************************/
+int GLStateCache::GetSkippedCount()
+{
+	return(g_State.skippedCalls);
+}
+
+/***********************************************************
+ *  ResetCounters()
+ *
+ *  This method is used for resetting the issued and skipped
+ *  counters, once per frame.
+ ***********************************************************/
+void GLStateCache::ResetCounters()
+{
+	g_State.issuedCalls = 0;
+	g_State.skippedCalls = 0;
+}
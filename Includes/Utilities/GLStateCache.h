@@ -0,0 +1,80 @@
+/******************************************************************************
+ * GLStateCache.h
+ * =================
+ * Filters redundant OpenGL state changes before they reach the driver.
+ *
+ * PURPOSE:
+ * - Remember the last value set for the commonly changed pieces of OpenGL
+ *   state, and skip any call that would set the value that is already there.
+ * - Count the calls that were passed on to OpenGL and the calls that were
+ *   skipped, so the effect can be reported with the frame statistics.
+ *
+ * FEATURES:
+ * - Bound vertex array object and shader program.
+ * - Active texture unit and the 2D / 2D array texture bound to each unit.
+ * - Enabled capabilities, such as depth testing and blending.
+ * - Blend function.
+ * - Shadowed uniform values, kept per shader program and per location.
+ *
+ * USAGE:
+ * - Make every state change through the static methods of `GLStateCache`
+ *   instead of calling OpenGL directly; a call made around the cache leaves
+ *   it out of date, so call `Invalidate()` after any such code.
+ * - Call `ForgetProgram()` after linking a program, since linking resets its
+ *   uniforms to their default values.
+ * - The state is kept per thread, one thread per OpenGL context.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+class GLStateCache
+{
+public:
+	// vertex arrays and programs
+	// ------------------------------------------------------------------------
+	static void BindVertexArray(GLuint vertexArray);
+	static void UseProgram(GLuint program);
+
+	// textures - BindTexture() binds to the active texture unit
+	// ------------------------------------------------------------------------
+	static void ActiveTexture(GLenum textureUnit);
+	static void BindTexture(GLenum target, GLuint texture);
+
+	// fixed function state
+	// ------------------------------------------------------------------------
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+	static void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+	// uniforms of the program in use - a single value each
+	// ------------------------------------------------------------------------
+	static void Uniform1i(GLint location, GLint value);
+	static void Uniform1f(GLint location, GLfloat value);
+	static void Uniform2fv(GLint location, const GLfloat* value);
+	static void Uniform3fv(GLint location, const GLfloat* value);
+	static void Uniform4fv(GLint location, const GLfloat* value);
+	static void UniformMatrix2fv(GLint location, const GLfloat* value);
+	static void UniformMatrix3fv(GLint location, const GLfloat* value);
+	static void UniformMatrix4fv(GLint location, const GLfloat* value);
+
+	// deleting objects also removes them from the cached bindings
+	// ------------------------------------------------------------------------
+	static void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+	static void DeleteTextures(GLsizei count, const GLuint* textures);
+	static void DeleteProgram(GLuint program);
+
+	// drop the shadowed uniform values of a program after it is (re)linked
+	static void ForgetProgram(GLuint program);
+	// forget all of the cached state, the next call of each kind is issued
+	static void Invalidate();
+
+	// number of calls passed on to OpenGL and skipped since the last reset
+	// ------------------------------------------------------------------------
+	static int GetIssuedCount();
+	static int GetSkippedCount();
+	static void ResetCounters();
+};
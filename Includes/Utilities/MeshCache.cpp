@@ -0,0 +1,391 @@
+/******************************************************************************
+ * MeshCache.cpp
+ * ==================
+ * Writes generated meshes to page aligned binary files and maps them back
+ * into memory.
+ *
+ * PURPOSE:
+ * - Replace the generation of a mesh with mapping its cache file.
+ *
+ * FEATURES:
+ * - A file is a header, then the vertices and the indices, each starting
+ *   on a page boundary, so the mapped data can be handed to OpenGL as is.
+ * - Files are written to a temporary name and renamed into place, so a
+ *   partly written file is never mapped.
+ * - Missing, stale or damaged files are treated as a cache miss.
+ *
+ ******************************************************************************/
+
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MeshCache.h"
+
+namespace
+{
+	// identifies a cached mesh file and the version of its layout
+	const char g_MeshMagic[4] = { 'C', 'M', 'S', 'H' };
+	const uint32_t g_MeshVersion = 2;
+	// the vertices and the indices start on a multiple of this
+	const uint64_t g_PageSize = 4096;
+	// floats in each vertex - position, normal and UV
+	const uint32_t g_FloatsPerVertex = 8;
+
+	// header at the start of every cached mesh file
+	struct MESH_FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t keyHash;          // the key and the generator version
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t partCount;
+		uint32_t partIndexCounts[MeshCache::MAX_PARTS];
+		int32_t numSlices;
+		float minimum[3];
+		float maximum[3];
+		float center[3];
+		float radius;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;      // 0 for a mesh without indices
+		uint64_t fileSize;
+	};
+
+	// 64-bit FNV-1a over a string, continuing from the passed in hash
+	uint64_t HashString(const std::string& text, uint64_t hash)
+	{
+		for (unsigned char character : text)
+		{
+			hash ^= character;
+			hash *= 1099511628211ULL;
+		}
+
+		return(hash);
+	}
+
+	// round a file offset up to the next page boundary
+	uint64_t AlignToPage(uint64_t offset)
+	{
+		return((offset + g_PageSize - 1) / g_PageSize * g_PageSize);
+	}
+
+	// map a whole file read only, NULL if it can not be opened
+	void* MapFile(const std::string& path, size_t& size)
+	{
+		void* pMapping = NULL;
+		size = 0;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return(NULL);
+		}
+		LARGE_INTEGER fileSize;
+		if ((GetFileSizeEx(file, &fileSize)) && (fileSize.QuadPart > 0))
+		{
+			// the view keeps the mapping alive once the handles are closed
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+			{
+				pMapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+			size = (size_t)fileSize.QuadPart;
+		}
+		CloseHandle(file);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return(NULL);
+		}
+		struct stat status;
+		if ((fstat(file, &status) == 0) && (status.st_size > 0))
+		{
+			size = (size_t)status.st_size;
+			pMapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (pMapping == MAP_FAILED)
+			{
+				pMapping = NULL;
+			}
+		}
+		close(file);
+#endif
+
+		if (NULL == pMapping)
+		{
+			size = 0;
+		}
+		return(pMapping);
+	}
+
+	// release a mapping made by MapFile()
+	void UnmapFile(void* pMapping, size_t size)
+	{
+		if (NULL == pMapping)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		(void)size;
+		UnmapViewOfFile(pMapping);
+#else
+		munmap(pMapping, size);
+#endif
+	}
+
+	// write zero bytes up to a file offset
+	void PadFile(std::ofstream& file, uint64_t offset)
+	{
+		static const char zeros[g_PageSize] = {};
+		uint64_t position = (uint64_t)file.tellp();
+		if (offset > position)
+		{
+			file.write(zeros, (std::streamsize)(offset - position));
+		}
+	}
+}
+
+/***********************************************************
+ *  MeshCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshCache::MeshCache(const char* cacheFolder, uint32_t generatorVersion)
+{
+	m_cacheFolder = cacheFolder;
+	m_generatorHash = HashString(std::to_string(generatorVersion), 14695981039346656037ULL);
+	m_mappedMeshes = 0;
+	m_storedMeshes = 0;
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the key of a mesh from
+ *  the name of its generator and its parameters, such as
+ *  "torus(1,0.06,24,8)".  The parameters are written with
+ *  enough digits to tell every float apart.
+ ***********************************************************/
+std::string MeshCache::MakeKey(const char* generator, const std::vector<float>& parameters)
+{
+	std::string key = generator;
+	key += "(";
+	for (size_t i = 0; i < parameters.size(); i++)
+	{
+		char value[32];
+		snprintf(value, sizeof(value), "%s%.9g", (i == 0) ? "" : ",", parameters[i]);
+		key += value;
+	}
+	key += ")";
+
+	return(key);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cache
+ *  file for a key.  The generator version is left out, so a
+ *  changed generator overwrites the file it replaces.
+ ***********************************************************/
+std::string MeshCache::GetCachePath(const std::string& key) const
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "%016llx.cmsh",
+		(unsigned long long)HashString(key, 14695981039346656037ULL));
+
+	return(m_cacheFolder + "/" + filename);
+}
+
+/***********************************************************
+ *  HashKey()
+ *
+ *  This method is used for hashing a key together with the
+ *  generator version, to find stale cache files.
+ ***********************************************************/
+uint64_t MeshCache::HashKey(const std::string& key) const
+{
+	return(HashString(key, m_generatorHash));
+}
+
+/***********************************************************
+ *  Map()
+ *
+ *  This method is used for mapping the cache file of a key
+ *  into memory.  The vertices and indices of the mesh point
+ *  into the mapping until Unmap() is called.
+ ***********************************************************/
+bool MeshCache::Map(const std::string& key, MESH_DATA& mesh)
+{
+	mesh = MESH_DATA();
+
+	size_t size = 0;
+	void* pMapping = MapFile(GetCachePath(key), size);
+	if (NULL == pMapping)
+	{
+		return(false);
+	}
+
+	if (size < sizeof(MESH_FILE_HEADER))
+	{
+		UnmapFile(pMapping, size);
+		return(false);
+	}
+
+	const MESH_FILE_HEADER* pHeader = (const MESH_FILE_HEADER*)pMapping;
+	uint64_t partIndices = 0;
+	for (uint32_t i = 0; (i < pHeader->partCount) && (i < (uint32_t)MAX_PARTS); i++)
+	{
+		partIndices += pHeader->partIndexCounts[i];
+	}
+	uint64_t vertexBytes = (uint64_t)pHeader->vertexCount * g_FloatsPerVertex * sizeof(float);
+	uint64_t indexBytes = (uint64_t)pHeader->indexCount * sizeof(uint32_t);
+	if ((memcmp(pHeader->magic, g_MeshMagic, sizeof(g_MeshMagic)) != 0) ||
+		(pHeader->version != g_MeshVersion) ||
+		(pHeader->keyHash != HashKey(key)) ||
+		(pHeader->fileSize != size) ||
+		(pHeader->vertexCount == 0) ||
+		(pHeader->partCount > (uint32_t)MAX_PARTS) ||
+		(partIndices != pHeader->indexCount) ||
+		(pHeader->vertexOffset % g_PageSize != 0) ||
+		(pHeader->vertexOffset + vertexBytes > size) ||
+		(pHeader->indexOffset % g_PageSize != 0) ||
+		((pHeader->indexCount > 0) && ((pHeader->indexOffset == 0) || (pHeader->indexOffset + indexBytes > size))))
+	{
+		UnmapFile(pMapping, size);
+		return(false);
+	}
+
+	const unsigned char* pBytes = (const unsigned char*)pMapping;
+	mesh.vertices = (const float*)(pBytes + pHeader->vertexOffset);
+	mesh.vertexCount = pHeader->vertexCount;
+	mesh.indices = (pHeader->indexCount > 0) ? (const uint32_t*)(pBytes + pHeader->indexOffset) : NULL;
+	mesh.indexCount = pHeader->indexCount;
+	mesh.partCount = pHeader->partCount;
+	memcpy(mesh.partIndexCounts, pHeader->partIndexCounts, sizeof(mesh.partIndexCounts));
+	mesh.numSlices = pHeader->numSlices;
+	mesh.minimum = glm::vec3(pHeader->minimum[0], pHeader->minimum[1], pHeader->minimum[2]);
+	mesh.maximum = glm::vec3(pHeader->maximum[0], pHeader->maximum[1], pHeader->maximum[2]);
+	mesh.center = glm::vec3(pHeader->center[0], pHeader->center[1], pHeader->center[2]);
+	mesh.radius = pHeader->radius;
+	mesh.pMapping = pMapping;
+	mesh.mappingSize = size;
+	m_mappedMeshes++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Unmap()
+ *
+ *  This method is used for releasing the mapping of a mesh
+ *  returned by Map().
+ ***********************************************************/
+void MeshCache::Unmap(MESH_DATA& mesh)
+{
+	UnmapFile(mesh.pMapping, mesh.mappingSize);
+	mesh.pMapping = NULL;
+	mesh.mappingSize = 0;
+	mesh.vertices = NULL;
+	mesh.indices = NULL;
+}
+
+/***********************************************************
+ *  Store()
+ *
+ *  This method is used for writing a generated mesh to the
+ *  cache file of its key, replacing a stale one.
+ ***********************************************************/
+bool MeshCache::Store(const std::string& key, const MESH_DATA& mesh)
+{
+	if ((NULL == mesh.vertices) || (mesh.vertexCount == 0) ||
+		((mesh.indexCount > 0) && (NULL == mesh.indices)) ||
+		(mesh.partCount > (uint32_t)MAX_PARTS))
+	{
+		return(false);
+	}
+
+	uint64_t vertexBytes = (uint64_t)mesh.vertexCount * g_FloatsPerVertex * sizeof(float);
+	uint64_t indexBytes = (uint64_t)mesh.indexCount * sizeof(uint32_t);
+
+	MESH_FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_MeshMagic, sizeof(g_MeshMagic));
+	header.version = g_MeshVersion;
+	header.keyHash = HashKey(key);
+	header.vertexCount = mesh.vertexCount;
+	header.indexCount = mesh.indexCount;
+	header.partCount = mesh.partCount;
+	memcpy(header.partIndexCounts, mesh.partIndexCounts, sizeof(header.partIndexCounts));
+	header.numSlices = mesh.numSlices;
+	for (int i = 0; i < 3; i++)
+	{
+		header.minimum[i] = mesh.minimum[i];
+		header.maximum[i] = mesh.maximum[i];
+		header.center[i] = mesh.center[i];
+	}
+	header.radius = mesh.radius;
+	header.vertexOffset = AlignToPage(sizeof(header));
+	header.indexOffset = (mesh.indexCount > 0) ? AlignToPage(header.vertexOffset + vertexBytes) : 0;
+	header.fileSize = (mesh.indexCount > 0) ? (header.indexOffset + indexBytes) : (header.vertexOffset + vertexBytes);
+
+	// write to a temporary file first so a partly written file
+	// is never mapped
+	std::error_code error;
+	std::filesystem::create_directories(m_cacheFolder, error);
+	std::string cachePath = GetCachePath(key);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Could not write cached mesh:" << cachePath << std::endl;
+			return(false);
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		PadFile(file, header.vertexOffset);
+		file.write((const char*)mesh.vertices, (std::streamsize)vertexBytes);
+		if (mesh.indexCount > 0)
+		{
+			PadFile(file, header.indexOffset);
+			file.write((const char*)mesh.indices, (std::streamsize)indexBytes);
+		}
+
+		if (!file)
+		{
+			std::cout << "Could not write cached mesh:" << cachePath << std::endl;
+			return(false);
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::cout << "Could not write cached mesh:" << cachePath << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return(false);
+	}
+
+	m_storedMeshes++;
+	return(true);
+}
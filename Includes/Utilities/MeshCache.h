@@ -0,0 +1,97 @@
+/******************************************************************************
+ * MeshCache.h
+ * =================
+ * Stores generated meshes in binary files that are mapped straight back into
+ * memory on the next run.
+ *
+ * PURPOSE:
+ * - Skip generating the parametric meshes on the CPU at every start.
+ * - Hand OpenGL the vertices and indices from the mapped file, with no
+ *   parsing and no copy of each vertex in between.
+ *
+ * FEATURES:
+ * - One file per generator and parameters, named after the key, so each
+ *   mesh is found without reading any other file.
+ * - The vertices and indices start on page boundaries of the file, and the
+ *   header records their counts, the index counts of the mesh's parts, the
+ *   bounds and the slices of the mesh.
+ * - Every file records the layout version and a hash of its key and of the
+ *   generator version - a number bumped by hand whenever the generators
+ *   change what they output - so changed generators or parameters rebuild
+ *   the mesh, while the files stay valid across rebuilds of the program.
+ *
+ * USAGE:
+ * - Call `Map()` with the key of a mesh before generating it, and upload the
+ *   mapped data before calling `Unmap()`.
+ * - On a miss, generate the mesh and pass it to `Store()`.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MeshCache
+{
+public:
+	// constructor - the version identifies the output of the generators
+	MeshCache(const char* cacheFolder, uint32_t generatorVersion);
+
+	// most parts a cached mesh's indices can be split into
+	static const int MAX_PARTS = 8;
+
+	// a mesh read from or written to the cache
+	struct MESH_DATA
+	{
+		const float* vertices;       // 8 floats each, position, normal, UV
+		uint32_t vertexCount;
+		const uint32_t* indices;     // NULL for a mesh drawn without indices
+		uint32_t indexCount;
+		// the indices are split into parts drawn on their own, one
+		// after the other
+		uint32_t partCount;
+		uint32_t partIndexCounts[MAX_PARTS];
+		int32_t numSlices;           // slices the draw methods split it by
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+		glm::vec3 center;
+		float radius;
+		// the mapping the vertices and indices point into, NULL for a
+		// mesh that was not mapped
+		void* pMapping;
+		size_t mappingSize;
+	};
+
+	// build the key of a mesh from its generator and its parameters
+	static std::string MakeKey(const char* generator, const std::vector<float>& parameters);
+
+	// map the cached mesh for a key into memory - false on a cache miss
+	bool Map(const std::string& key, MESH_DATA& mesh);
+	// release the mapping of a mesh returned by Map()
+	void Unmap(MESH_DATA& mesh);
+	// write a generated mesh to the cache
+	bool Store(const std::string& key, const MESH_DATA& mesh);
+
+	// meshes mapped and stored since the cache was created
+	int GetMappedCount() const { return(m_mappedMeshes); }
+	int GetStoredCount() const { return(m_storedMeshes); }
+
+private:
+	// folder the cached meshes are written to
+	std::string m_cacheFolder;
+	// hash of the generator version, mixed into the hash of every key
+	uint64_t m_generatorHash;
+	int m_mappedMeshes;
+	int m_storedMeshes;
+
+	// path of the cache file for a key
+	std::string GetCachePath(const std::string& key) const;
+	// hash of a key and the generator version, stored in the file
+	uint64_t HashKey(const std::string& key) const;
+};
@@ -0,0 +1,469 @@
+/******************************************************************************
+ * MeshOptimizer.cpp
+ * ==================
+ * Reorders the triangles of indexed triangle lists for the GPU's vertex
+ * caches and for less overdraw.
+ *
+ * PURPOSE:
+ * - Order triangles so their vertices are reused from the post-transform
+ *   cache, then order clusters of them so outward facing ones come first.
+ *
+ * FEATURES:
+ * - The vertex cache order scores vertices by their position in a
+ *   simulated LRU cache and by the triangles still using them, and always
+ *   draws the best scoring triangle touching the cache next.
+ * - The overdraw order only moves whole clusters, cut where the cache is
+ *   flushed anyway or where the cluster already reached its target ACMR,
+ *   so it costs little of the cache order.
+ *
+ ******************************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshOptimizer.h"
+
+namespace
+{
+	// the LRU cache the vertex cache order is scored against, and the
+	// weights of its scores from "Linear-Speed Vertex Cache Optimisation"
+	const int g_ScoreCacheSize = 32;
+	const float g_CacheDecayPower = 1.5f;
+	const float g_LastTriangleScore = 0.75f;
+	const float g_ValenceBoostScale = 2.0f;
+	const float g_ValenceBoostPower = 0.5f;
+	// the FIFO cache the statistics and clusters are measured against,
+	// about the size of the caches of current GPUs
+	const uint32_t g_FifoCacheSize = 16;
+
+	// score of a vertex at a position of the LRU cache, -1 if it is not
+	// in the cache, used by the passed in number of triangles still to
+	// be drawn
+	float ScoreVertex(int cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return(-1.0f);
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the vertices of the last triangle score the same, so the
+			// order it was drawn in makes no difference
+			if (cachePosition < 3)
+			{
+				score = g_LastTriangleScore;
+			}
+			else
+			{
+				float scale = 1.0f / (float)(g_ScoreCacheSize - 3);
+				score = powf(1.0f - (float)(cachePosition - 3) * scale, g_CacheDecayPower);
+			}
+		}
+
+		// vertices with few triangles left are finished off first
+		score += g_ValenceBoostScale * powf((float)remainingTriangles, -g_ValenceBoostPower);
+
+		return(score);
+	}
+
+	// run a triangle through the FIFO cache, a vertex is in the cache if
+	// it missed within the last g_FifoCacheSize misses - returns the
+	// number of misses
+	uint32_t UpdateFifoCache(const uint32_t* triangle, std::vector<uint32_t>& timestamps, uint32_t& timestamp)
+	{
+		uint32_t misses = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			if (timestamp - timestamps[triangle[i]] > g_FifoCacheSize)
+			{
+				timestamps[triangle[i]] = timestamp++;
+				misses++;
+			}
+		}
+
+		return(misses);
+	}
+
+	// position of a vertex
+	glm::vec3 GetPosition(const float* vertices, size_t floatsPerVertex, uint32_t index)
+	{
+		const float* vertex = vertices + (size_t)index * floatsPerVertex;
+		return(glm::vec3(vertex[0], vertex[1], vertex[2]));
+	}
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used for reordering the triangles so the
+ *  vertices of each one are likely to be in the cache when
+ *  it is drawn.  The next triangle is the best scoring one
+ *  using a cached vertex, or the best of all that are left
+ *  once no cached vertex has triangles left.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if ((NULL == indices) || (triangleCount < 2))
+	{
+		return;
+	}
+
+	// the triangles using each vertex, the ones still to be drawn kept
+	// at the start of the vertex's list
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return;
+		}
+		remainingTriangles[indices[i]]++;
+	}
+
+	std::vector<uint32_t> triangleOffsets(vertexCount, 0);
+	for (size_t vertex = 1; vertex < vertexCount; vertex++)
+	{
+		triangleOffsets[vertex] = triangleOffsets[vertex - 1] + remainingTriangles[vertex - 1];
+	}
+
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	std::vector<uint32_t> filled(vertexCount, 0);
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			uint32_t vertex = indices[triangle * 3 + i];
+			vertexTriangles[triangleOffsets[vertex] + filled[vertex]++] = (uint32_t)triangle;
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertexScores[vertex] = ScoreVertex(-1, remainingTriangles[vertex]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		triangleScores[triangle] = vertexScores[indices[triangle * 3]] +
+			vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+	}
+
+	std::vector<bool> drawn(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(g_ScoreCacheSize + 3);
+	newCache.reserve(g_ScoreCacheSize + 3);
+
+	int bestTriangle = -1;
+	size_t firstUndrawn = 0;
+	for (size_t drawnCount = 0; drawnCount < triangleCount; drawnCount++)
+	{
+		// nothing in the cache is left to draw, so start again from the
+		// best triangle anywhere
+		if (bestTriangle < 0)
+		{
+			float bestScore = -1.0f;
+			while (drawn[firstUndrawn])
+			{
+				firstUndrawn++;
+			}
+			for (size_t triangle = firstUndrawn; triangle < triangleCount; triangle++)
+			{
+				if ((!drawn[triangle]) && (triangleScores[triangle] > bestScore))
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = (int)triangle;
+				}
+			}
+		}
+
+		const uint32_t* triangleIndices = indices + (size_t)bestTriangle * 3;
+		output.insert(output.end(), triangleIndices, triangleIndices + 3);
+		drawn[bestTriangle] = true;
+
+		// take the triangle off the lists of its vertices
+		for (int i = 0; i < 3; i++)
+		{
+			uint32_t vertex = triangleIndices[i];
+			uint32_t* first = &vertexTriangles[triangleOffsets[vertex]];
+			uint32_t* last = first + remainingTriangles[vertex];
+			uint32_t* found = std::find(first, last, (uint32_t)bestTriangle);
+			if (found != last)
+			{
+				std::swap(*found, *(last - 1));
+				remainingTriangles[vertex]--;
+			}
+		}
+
+		// the triangle's vertices move to the front of the cache, and
+		// the rest keep their order behind them
+		newCache.assign(triangleIndices, triangleIndices + 3);
+		for (uint32_t vertex : cache)
+		{
+			if ((vertex != triangleIndices[0]) && (vertex != triangleIndices[1]) && (vertex != triangleIndices[2]))
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		// score the vertices again, including the ones that just fell
+		// out of the cache, and pass the change on to their triangles
+		for (size_t position = 0; position < newCache.size(); position++)
+		{
+			uint32_t vertex = newCache[position];
+			cachePositions[vertex] = (position < (size_t)g_ScoreCacheSize) ? (int)position : -1;
+			float score = ScoreVertex(cachePositions[vertex], remainingTriangles[vertex]);
+			float change = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const uint32_t* first = &vertexTriangles[triangleOffsets[vertex]];
+			for (uint32_t i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				triangleScores[first[i]] += change;
+			}
+		}
+
+		// the next triangle is the best one using a cached vertex
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		if (newCache.size() > (size_t)g_ScoreCacheSize)
+		{
+			newCache.resize(g_ScoreCacheSize);
+		}
+		for (uint32_t vertex : newCache)
+		{
+			const uint32_t* first = &vertexTriangles[triangleOffsets[vertex]];
+			for (uint32_t i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				if (triangleScores[first[i]] > bestScore)
+				{
+					bestScore = triangleScores[first[i]];
+					bestTriangle = (int)first[i];
+				}
+			}
+		}
+
+		cache.swap(newCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/***********************************************************
+ *  OptimizeOverdraw()
+ *
+ *  This method is used for reordering clusters of a cache
+ *  ordered triangle list.  Clusters start where a triangle
+ *  misses the cache on all three vertices, and are split
+ *  again once their ACMR is down to the threshold.  They
+ *  are drawn in order of how far their area weighted
+ *  center lies out from the center of the mesh along
+ *  their normal, most outward facing first.  Clusters
+ *  that tie keep their order.
+ ***********************************************************/
+void MeshOptimizer::OptimizeOverdraw(
+	uint32_t* indices,
+	size_t indexCount,
+	const float* vertices,
+	size_t vertexCount,
+	size_t floatsPerVertex,
+	float threshold)
+{
+	size_t triangleCount = indexCount / 3;
+	if ((NULL == indices) || (NULL == vertices) || (triangleCount < 2))
+	{
+		return;
+	}
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return;
+		}
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = g_FifoCacheSize + 1;
+
+	// the cache order starts a new patch of the mesh where all three
+	// vertices miss
+	std::vector<size_t> patches;
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		uint32_t misses = UpdateFifoCache(indices + triangle * 3, timestamps, timestamp);
+		if ((triangle == 0) || (misses == 3))
+		{
+			patches.push_back(triangle);
+		}
+	}
+	patches.push_back(triangleCount);
+
+	// split each patch where the ACMR from its last split is down to
+	// the threshold of the patch's ACMR, flushing the cache each time
+	std::vector<size_t> clusters;
+	for (size_t patch = 0; patch + 1 < patches.size(); patch++)
+	{
+		size_t start = patches[patch];
+		size_t end = patches[patch + 1];
+
+		timestamp += g_FifoCacheSize + 1;
+		uint32_t patchMisses = 0;
+		for (size_t triangle = start; triangle < end; triangle++)
+		{
+			patchMisses += UpdateFifoCache(indices + triangle * 3, timestamps, timestamp);
+		}
+		float targetACMR = threshold * (float)patchMisses / (float)(end - start);
+
+		clusters.push_back(start);
+		timestamp += g_FifoCacheSize + 1;
+		uint32_t runningMisses = 0;
+		uint32_t runningTriangles = 0;
+		for (size_t triangle = start; triangle < end; triangle++)
+		{
+			runningMisses += UpdateFifoCache(indices + triangle * 3, timestamps, timestamp);
+			runningTriangles++;
+			if ((float)runningMisses / (float)runningTriangles <= targetACMR)
+			{
+				clusters.push_back(triangle + 1);
+				timestamp += g_FifoCacheSize + 1;
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+
+		// a split after the last triangle leaves an empty cluster
+		if (clusters.back() == end)
+		{
+			clusters.pop_back();
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// the center of the mesh, from every vertex used
+	glm::vec3 meshCenter(0.0f);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		meshCenter += GetPosition(vertices, floatsPerVertex, indices[i]);
+	}
+	meshCenter /= (float)(triangleCount * 3);
+
+	// clusters that face out about as far, such as the pieces of a
+	// flat cap, differ only by rounding and keep their cache order
+	float meshRadius = 0.0f;
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		meshRadius = std::max(meshRadius, glm::length(GetPosition(vertices, floatsPerVertex, indices[i]) - meshCenter));
+	}
+	float keyStep = (meshRadius > 0.0f) ? meshRadius / 1024.0f : 1.0f;
+
+	// how far out each cluster faces
+	size_t clusterCount = clusters.size() - 1;
+	std::vector<float> clusterKeys(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++)
+		{
+			glm::vec3 p0 = GetPosition(vertices, floatsPerVertex, indices[triangle * 3]);
+			glm::vec3 p1 = GetPosition(vertices, floatsPerVertex, indices[triangle * 3 + 1]);
+			glm::vec3 p2 = GetPosition(vertices, floatsPerVertex, indices[triangle * 3 + 2]);
+			glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(cross);
+
+			center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		float normalLength = glm::length(normal);
+		if ((area > 0.0f) && (normalLength > 0.0f))
+		{
+			clusterKeys[cluster] = floorf(glm::dot(center / area - meshCenter, normal / normalLength) / keyStep);
+		}
+		else
+		{
+			clusterKeys[cluster] = 0.0f;
+		}
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		order[cluster] = cluster;
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&clusterKeys](size_t a, size_t b) { return(clusterKeys[a] > clusterKeys[b]); });
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	for (size_t cluster : order)
+	{
+		output.insert(output.end(), indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+/***********************************************************
+ *  AnalyzeVertexCache()
+ *
+ *  This method is used for counting the vertices a FIFO
+ *  cache would transform to draw the triangles, per
+ *  triangle and per vertex used.
+ ***********************************************************/
+MeshOptimizer::CACHE_STATISTICS MeshOptimizer::AnalyzeVertexCache(
+	const uint32_t* indices,
+	size_t indexCount,
+	size_t vertexCount)
+{
+	CACHE_STATISTICS statistics = { 0.0f, 0.0f };
+	size_t triangleCount = indexCount / 3;
+	if ((NULL == indices) || (triangleCount == 0))
+	{
+		return(statistics);
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	uint32_t timestamp = g_FifoCacheSize + 1;
+	size_t misses = 0;
+	size_t usedCount = 0;
+	for (size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		const uint32_t* triangleIndices = indices + triangle * 3;
+		if ((triangleIndices[0] >= vertexCount) || (triangleIndices[1] >= vertexCount) ||
+			(triangleIndices[2] >= vertexCount))
+		{
+			return(statistics);
+		}
+
+		misses += UpdateFifoCache(triangleIndices, timestamps, timestamp);
+		for (int i = 0; i < 3; i++)
+		{
+			if (!used[triangleIndices[i]])
+			{
+				used[triangleIndices[i]] = true;
+				usedCount++;
+			}
+		}
+	}
+
+	statistics.acmr = (float)misses / (float)triangleCount;
+	statistics.atvr = (float)misses / (float)usedCount;
+
+	return(statistics);
+}
@@ -16,6 +16,8 @@
  * - Compiles vertex and fragment shaders and checks for errors.
  * - Links shaders into an OpenGL shader program.
  * - Outputs detailed error messages for debugging shader compilation and linking.
+ * - Caches the locations of all active uniforms after a successful link.
+ * - Attaches registered uniform blocks to their buffer binding points.
  *
  * USAGE:
  * - Use `LoadShaders()` to load, compile, and link shaders from file paths.
@@ -45,6 +47,18 @@ using namespace std;
 
 #include "ShaderManager.h"
 
+/***********************************************************
+ *  ShaderManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderManager::ShaderManager()
+{
+	m_programID = 0;
+	m_uniformLookups = 0;
+	m_linkGeneration = 0;
+}
+
 /***********************************************************
  *  LoadShaders()
  *
@@ -144,7 +158,108 @@ GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fra
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	// linking resets the uniforms, so their shadowed values are stale
+	GLStateCache::ForgetProgram(ProgramID);
+
+	// any previously resolved uniform locations are now stale
+	CacheUniformLocations();
+	ApplyUniformBlockBindings();
+
 	return ProgramID;
 }
 
+/***********************************************************
+ *  CacheUniformLocations()
+ *
+ *  This method is called after the shader program has been
+ *  linked to query every active uniform once and store its
+ *  location, so that uniform setters never have to ask the
+ *  driver for a location by name.
+ ***********************************************************/
+void ShaderManager::CacheUniformLocations()
+{
+	m_uniformLocations.clear();
+	m_linkGeneration++;
+
+	GLint activeUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &activeUniforms);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	if ((activeUniforms <= 0) || (maxNameLength <= 0))
+	{
+		return;
+	}
+
+	std::vector<char> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < activeUniforms; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_programID, i, maxNameLength, &nameLength, &size, &type, &nameBuffer[0]);
+
+		std::string name(&nameBuffer[0], nameLength);
+		GLint location = glGetUniformLocation(m_programID, name.c_str());
+		// uniforms inside uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+		m_uniformLocations[name] = location;
 
+		// arrays of basic types are reported as "name[0]" - register the
+		// remaining elements and the bare name as well
+		if ((name.size() > 3) && (name.compare(name.size() - 3, 3, "[0]") == 0))
+		{
+			std::string baseName = name.substr(0, name.size() - 3);
+			m_uniformLocations[baseName] = location;
+			for (GLint element = 1; element < size; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				m_uniformLocations[elementName] = glGetUniformLocation(m_programID, elementName.c_str());
+			}
+		}
+	}
+}
+
+
+
+/***********************************************************
+ *  SetUniformBlockBinding()
+ *
+ *  This method is called to attach a uniform block of the
+ *  shader program to a uniform buffer binding point, so any
+ *  number of programs can read the same uniform buffer.
+ ***********************************************************/
+void ShaderManager::SetUniformBlockBinding(const std::string &blockName, GLuint bindingPoint)
+{
+	m_uniformBlockBindings[blockName] = bindingPoint;
+
+	if (m_programID != 0)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(m_programID, blockName.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_programID, blockIndex, bindingPoint);
+		}
+	}
+}
+
+/***********************************************************
+ *  ApplyUniformBlockBindings()
+ *
+ *  This method is called after the shader program has been
+ *  linked to attach every registered uniform block again.
+ ***********************************************************/
+void ShaderManager::ApplyUniformBlockBindings()
+{
+	std::unordered_map<std::string, GLuint>::const_iterator it;
+	for (it = m_uniformBlockBindings.begin(); it != m_uniformBlockBindings.end(); ++it)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(m_programID, it->first.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_programID, blockIndex, it->second);
+		}
+	}
+}
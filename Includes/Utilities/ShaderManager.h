@@ -17,12 +17,21 @@
  *    - Matrices (2x2, 3x3, 4x4)
  *    - Sampler2D for texture units.
  * - Inline functions for efficient and direct interaction with the OpenGL API.
+ * - Program and uniform calls go through `GLStateCache`, so uploading the
+ *   value a uniform already holds is skipped.
+ * - Uniform location cache filled from active-uniform reflection after each
+ *   link, with handle based setters for the per-frame render path.
  *
  * USAGE:
  * - Create an instance of `ShaderManager`.
  * - Use `LoadShaders` to initialize shader programs with file paths.
  * - Use `use()` to activate the shader program before rendering.
  * - Set shader uniform variables with the provided utility methods.
+ * - Resolve hot-path uniforms once with `getUniformLocation()` and pass the
+ *   returned handle to the setters; re-resolve when `GetLinkGeneration()`
+ *   changes after a relink.
+ * - Attach uniform blocks to shared buffer binding points with
+ *   `SetUniformBlockBinding()`; the bindings survive a relink.
  *
  * AUTHOR:
  * - Brian Battersby - SNHU Instructor / Computer Science
@@ -36,6 +45,8 @@
 
 #include <GL/glew.h>        // GLEW library
 
+#include "GLStateCache.h"
+
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
@@ -45,10 +56,13 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 class ShaderManager
 {
 public:
+	ShaderManager();
+
 	unsigned int m_programID;
 	
 	GLuint LoadShaders(
@@ -59,80 +73,168 @@ public:
 	// ------------------------------------------------------------------------
 	inline void use()
 	{
-		glUseProgram(m_programID);
+		GLStateCache::UseProgram(m_programID);
+	}
+
+	// uniform location cache
+	// ------------------------------------------------------------------------
+	// returns the cached location of an active uniform, or -1 if the linked
+	// program has no active uniform with that name. every call is counted as
+	// a name lookup, so resolve hot-path uniforms once and keep the handle.
+	inline GLint getUniformLocation(const std::string &name) const
+	{
+		m_uniformLookups++;
+		std::unordered_map<std::string, GLint>::const_iterator it = m_uniformLocations.find(name);
+		if (it == m_uniformLocations.end())
+		{
+			return(-1);
+		}
+		return(it->second);
+	}
+
+	// incremented every time the program is relinked - any uniform handles
+	// resolved against an older generation must be resolved again
+	inline unsigned int GetLinkGeneration() const
+	{
+		return(m_linkGeneration);
+	}
+
+	// attach the named uniform block to a uniform buffer binding point. the
+	// binding is remembered and applied again whenever the program is relinked
+	void SetUniformBlockBinding(const std::string &blockName, GLuint bindingPoint);
+
+	// number of uniform name lookups since the last reset (once per frame)
+	inline int GetUniformLookupCount() const
+	{
+		return(m_uniformLookups);
+	}
+	inline void ResetUniformLookupCount()
+	{
+		m_uniformLookups = 0;
 	}
 
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	inline void setBoolValue(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
+		setBoolValue(getUniformLocation(name), value);
+	}
+	inline void setBoolValue(GLint location, bool value) const
+	{
+		GLStateCache::Uniform1i(location, (int)value);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setIntValue(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		setIntValue(getUniformLocation(name), value);
+	}
+	inline void setIntValue(GLint location, int value) const
+	{
+		GLStateCache::Uniform1i(location, value);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setFloatValue(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
+		setFloatValue(getUniformLocation(name), value);
+	}
+	inline void setFloatValue(GLint location, float value) const
+	{
+		GLStateCache::Uniform1f(location, value);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec2Value(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		setVec2Value(getUniformLocation(name), value);
+	}
+	inline void setVec2Value(GLint location, const glm::vec2 &value) const
+	{
+		GLStateCache::Uniform2fv(location, &value[0]);
 	}
 
 	inline void setVec2Value(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_programID, name.c_str()), x, y);
+		setVec2Value(getUniformLocation(name), glm::vec2(x, y));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec3Value(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		setVec3Value(getUniformLocation(name), value);
+	}
+	inline void setVec3Value(GLint location, const glm::vec3 &value) const
+	{
+		GLStateCache::Uniform3fv(location, &value[0]);
 	}
 	inline void setVec3Value(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_programID, name.c_str()), x, y, z);
+		setVec3Value(getUniformLocation(name), glm::vec3(x, y, z));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec4Value(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		setVec4Value(getUniformLocation(name), value);
+	}
+	inline void setVec4Value(GLint location, const glm::vec4 &value) const
+	{
+		GLStateCache::Uniform4fv(location, &value[0]);
 	}
 	inline void setVec4Value(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(m_programID, name.c_str()), x, y, z, w);
+		setVec4Value(getUniformLocation(name), glm::vec4(x, y, z, w));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat2Value(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		GLStateCache::UniformMatrix2fv(getUniformLocation(name), &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat3Value(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		setMat3Value(getUniformLocation(name), mat);
+	}
+	inline void setMat3Value(GLint location, const glm::mat3 &mat) const
+	{
+		GLStateCache::UniformMatrix3fv(location, &mat[0][0]);
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat4Value(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+		setMat4Value(getUniformLocation(name), mat);
+	}
+	inline void setMat4Value(GLint location, const glm::mat4 &mat) const
+	{
+		GLStateCache::UniformMatrix4fv(location, glm::value_ptr(mat));
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setSampler2DValue(const std::string& name, const int &value) const
 	{
-		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		setSampler2DValue(getUniformLocation(name), value);
+	}
+	inline void setSampler2DValue(GLint location, const int &value) const
+	{
+		GLStateCache::Uniform1i(location, value);
 	}
+
+private:
+	// active uniform name -> location, rebuilt after every link
+	std::unordered_map<std::string, GLint> m_uniformLocations;
+	// number of name based lookups since the last reset
+	mutable int m_uniformLookups;
+	// incremented after every link so cached handles can be invalidated
+	unsigned int m_linkGeneration;
+	// uniform block name -> uniform buffer binding point
+	std::unordered_map<std::string, GLuint> m_uniformBlockBindings;
+
+	// fill the uniform location cache from the linked program
+	void CacheUniformLocations();
+	// attach the registered uniform blocks of the linked program
+	void ApplyUniformBlockBindings();
 };
\ No newline at end of file
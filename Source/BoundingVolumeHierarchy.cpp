@@ -0,0 +1,502 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// tree of bounding boxes over the scene's draws, for culling and queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	// bins the item centers are sorted into along each axis
+	const int SPLIT_BINS = 12;
+	// ranges this small are never split
+	const int LEAF_ITEMS = 2;
+	// nodes a query keeps to visit, a walk holds at most one per level
+	// so the tree is never built deeper than this - far more than a
+	// tree over millions of items with reasonable splits needs
+	const int STACK_SIZE = 64;
+	// the cost of testing a node relative to testing an item
+	const float NODE_COST = 1.0f;
+
+	void GrowBox(BoundingVolumeHierarchy::BOX& box, glm::vec3 minimum, glm::vec3 maximum)
+	{
+		box.minimum = glm::min(box.minimum, minimum);
+		box.maximum = glm::max(box.maximum, maximum);
+	}
+
+	BoundingVolumeHierarchy::BOX EmptyBox()
+	{
+		BoundingVolumeHierarchy::BOX box;
+		box.minimum = glm::vec3(FLT_MAX);
+		box.maximum = glm::vec3(-FLT_MAX);
+		return(box);
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the passed
+ *  in item boxes.  The old tree is thrown away.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const std::vector<BOX>& itemBounds)
+{
+	Clear();
+
+	int itemCount = (int)itemBounds.size();
+	if (itemCount == 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> centers(itemCount);
+	m_itemIndices.resize(itemCount);
+	for (int item = 0; item < itemCount; item++)
+	{
+		centers[item] = (itemBounds[item].minimum + itemBounds[item].maximum) * 0.5f;
+		m_itemIndices[item] = item;
+	}
+
+	// a binary tree with at least one item per leaf never has more
+	// than twice as many nodes as items
+	m_nodes.reserve(itemCount * 2);
+	BuildNode(itemBounds, centers, 0, itemCount, 0);
+
+	m_leafBounds.resize(itemCount);
+	for (int i = 0; i < itemCount; i++)
+	{
+		m_leafBounds[i] = itemBounds[m_itemIndices[i]];
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the node for a range of
+ *  the item indices and then the nodes below it.  The range
+ *  is split by the bin boundary with the lowest surface area
+ *  cost, or kept as a leaf when no split is cheaper than
+ *  testing every item in it.
+ ***********************************************************/
+int BoundingVolumeHierarchy::BuildNode(const std::vector<BOX>& itemBounds,
+	const std::vector<glm::vec3>& centers, int first, int count, int depth)
+{
+	int nodeIndex = (int)m_nodes.size();
+	m_nodes.push_back(NODE());
+
+	BOX bounds = EmptyBox();
+	BOX centerBounds = EmptyBox();
+	for (int i = first; i < first + count; i++)
+	{
+		int item = m_itemIndices[i];
+		GrowBox(bounds, itemBounds[item].minimum, itemBounds[item].maximum);
+		GrowBox(centerBounds, centers[item], centers[item]);
+	}
+
+	m_nodes[nodeIndex].minimum = bounds.minimum;
+	m_nodes[nodeIndex].maximum = bounds.maximum;
+	m_nodes[nodeIndex].index = first;
+	m_nodes[nodeIndex].itemCount = count;
+
+	if ((count <= LEAF_ITEMS) || (depth >= STACK_SIZE - 2))
+	{
+		return(nodeIndex);
+	}
+
+	// find the cheapest bin boundary on any axis
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centerBounds.maximum[axis] - centerBounds.minimum[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		BOX binBounds[SPLIT_BINS];
+		int binCounts[SPLIT_BINS] = { 0 };
+		for (int bin = 0; bin < SPLIT_BINS; bin++)
+		{
+			binBounds[bin] = EmptyBox();
+		}
+
+		float binScale = SPLIT_BINS / extent;
+		for (int i = first; i < first + count; i++)
+		{
+			int item = m_itemIndices[i];
+			int bin = std::min(SPLIT_BINS - 1,
+				(int)((centers[item][axis] - centerBounds.minimum[axis]) * binScale));
+			binCounts[bin]++;
+			GrowBox(binBounds[bin], itemBounds[item].minimum, itemBounds[item].maximum);
+		}
+
+		// sweep from the right to get the area and count of everything
+		// after each boundary, then from the left to price the splits
+		float rightAreas[SPLIT_BINS];
+		int rightCounts[SPLIT_BINS];
+		BOX sweep = EmptyBox();
+		int sweepCount = 0;
+		for (int bin = SPLIT_BINS - 1; bin > 0; bin--)
+		{
+			sweepCount += binCounts[bin];
+			if (binCounts[bin] > 0)
+			{
+				GrowBox(sweep, binBounds[bin].minimum, binBounds[bin].maximum);
+			}
+			rightAreas[bin] = SurfaceArea(sweep);
+			rightCounts[bin] = sweepCount;
+		}
+
+		sweep = EmptyBox();
+		sweepCount = 0;
+		for (int split = 1; split < SPLIT_BINS; split++)
+		{
+			sweepCount += binCounts[split - 1];
+			if (binCounts[split - 1] > 0)
+			{
+				GrowBox(sweep, binBounds[split - 1].minimum, binBounds[split - 1].maximum);
+			}
+			if ((sweepCount == 0) || (rightCounts[split] == 0))
+			{
+				continue;
+			}
+
+			float cost = SurfaceArea(sweep) * sweepCount + rightAreas[split] * rightCounts[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// the costs above leave out the division by the node's own area,
+	// so the cost of keeping the leaf is scaled the same way
+	float area = SurfaceArea(bounds);
+	float leafCost = area * count;
+	if ((bestAxis < 0) || (NODE_COST * area + bestCost >= leafCost))
+	{
+		return(nodeIndex);
+	}
+
+	float extent = centerBounds.maximum[bestAxis] - centerBounds.minimum[bestAxis];
+	float binScale = SPLIT_BINS / extent;
+	float splitMinimum = centerBounds.minimum[bestAxis];
+	int* middle = std::partition(m_itemIndices.data() + first, m_itemIndices.data() + first + count,
+		[&](int item)
+		{
+			int bin = std::min(SPLIT_BINS - 1, (int)((centers[item][bestAxis] - splitMinimum) * binScale));
+			return(bin < bestSplit);
+		});
+	int leftCount = (int)(middle - (m_itemIndices.data() + first));
+
+	// the first child follows the node, so only the second is stored
+	m_nodes[nodeIndex].itemCount = 0;
+	BuildNode(itemBounds, centers, first, leftCount, depth + 1);
+	int rightChild = BuildNode(itemBounds, centers, first + leftCount, count - leftCount, depth + 1);
+	m_nodes[nodeIndex].index = rightChild;
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for recomputing the node boxes after
+ *  items moved.  Every child comes after its parent in the
+ *  array, so one pass from the back has the children ready
+ *  before their parent is reached.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::Refit(const std::vector<BOX>& itemBounds)
+{
+	if (itemBounds.size() != m_itemIndices.size())
+	{
+		return(false);
+	}
+
+	for (int nodeIndex = (int)m_nodes.size() - 1; nodeIndex >= 0; nodeIndex--)
+	{
+		NODE& node = m_nodes[nodeIndex];
+		BOX bounds = EmptyBox();
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.index; i < node.index + node.itemCount; i++)
+			{
+				m_leafBounds[i] = itemBounds[m_itemIndices[i]];
+				GrowBox(bounds, m_leafBounds[i].minimum, m_leafBounds[i].maximum);
+			}
+		}
+		else
+		{
+			const NODE& left = m_nodes[nodeIndex + 1];
+			const NODE& right = m_nodes[node.index];
+			GrowBox(bounds, left.minimum, left.maximum);
+			GrowBox(bounds, right.minimum, right.maximum);
+		}
+
+		node.minimum = bounds.minimum;
+		node.maximum = bounds.maximum;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for throwing away the tree.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_itemIndices.clear();
+	m_leafBounds.clear();
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the items whose boxes
+ *  intersect the view volume.  A node outside the volume
+ *  skips everything below it.
+ ***********************************************************/
+int BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, std::vector<int>& items) const
+{
+	int nodesTested = 0;
+	if (m_nodes.empty())
+	{
+		return(nodesTested);
+	}
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const NODE& node = m_nodes[nodeIndex];
+		nodesTested++;
+
+		if (!frustum.IntersectsBox(node.minimum, node.maximum))
+		{
+			continue;
+		}
+
+		if (node.itemCount == 1)
+		{
+			items.push_back(m_itemIndices[node.index]);
+		}
+		else if (node.itemCount > 1)
+		{
+			for (int i = node.index; i < node.index + node.itemCount; i++)
+			{
+				if (frustum.IntersectsBox(m_leafBounds[i].minimum, m_leafBounds[i].maximum))
+				{
+					items.push_back(m_itemIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.index;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+
+	return(nodesTested);
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for finding the nearest item whose
+ *  box is hit by a ray, for picking and for keeping the
+ *  camera out of objects.  The nearer child is walked first
+ *  and nodes further away than the nearest hit so far are
+ *  skipped.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+	int& item, float& distance) const
+{
+	item = -1;
+	distance = maxDistance;
+	if (m_nodes.empty())
+	{
+		return(false);
+	}
+
+	// division by zero gives an infinity, which the slab test handles
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const NODE& node = m_nodes[nodeIndex];
+
+		float entry = 0.0f;
+		if (!IntersectRayBox(origin, inverseDirection, node.minimum, node.maximum, distance, entry))
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.index; i < node.index + node.itemCount; i++)
+			{
+				float itemEntry = 0.0f;
+				if (IntersectRayBox(origin, inverseDirection, m_leafBounds[i].minimum,
+					m_leafBounds[i].maximum, distance, itemEntry) && (itemEntry < distance))
+				{
+					distance = itemEntry;
+					item = m_itemIndices[i];
+				}
+			}
+		}
+		else
+		{
+			int leftChild = nodeIndex + 1;
+			int rightChild = node.index;
+			float leftEntry = 0.0f;
+			float rightEntry = 0.0f;
+			bool bLeft = IntersectRayBox(origin, inverseDirection, m_nodes[leftChild].minimum,
+				m_nodes[leftChild].maximum, distance, leftEntry);
+			bool bRight = IntersectRayBox(origin, inverseDirection, m_nodes[rightChild].minimum,
+				m_nodes[rightChild].maximum, distance, rightEntry);
+
+			// push the further child first so the nearer is popped first
+			if (bLeft && bRight)
+			{
+				if (leftEntry <= rightEntry)
+				{
+					stack[stackSize++] = rightChild;
+					stack[stackSize++] = leftChild;
+				}
+				else
+				{
+					stack[stackSize++] = leftChild;
+					stack[stackSize++] = rightChild;
+				}
+			}
+			else if (bLeft)
+			{
+				stack[stackSize++] = leftChild;
+			}
+			else if (bRight)
+			{
+				stack[stackSize++] = rightChild;
+			}
+		}
+	}
+
+	return(item >= 0);
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for collecting the items whose boxes
+ *  intersect a sphere, such as the objects a light reaches.
+ *  A box is outside when the point in it closest to the
+ *  center is further away than the radius.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QuerySphere(glm::vec3 center, float radius, std::vector<int>& items) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	float radiusSquared = radius * radius;
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const NODE& node = m_nodes[nodeIndex];
+
+		glm::vec3 offset = center - glm::clamp(center, node.minimum, node.maximum);
+		if (glm::dot(offset, offset) > radiusSquared)
+		{
+			continue;
+		}
+
+		if (node.itemCount > 0)
+		{
+			for (int i = node.index; i < node.index + node.itemCount; i++)
+			{
+				offset = center - glm::clamp(center, m_leafBounds[i].minimum, m_leafBounds[i].maximum);
+				if (glm::dot(offset, offset) <= radiusSquared)
+				{
+					items.push_back(m_itemIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.index;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  SurfaceArea()
+ *
+ *  This method is used for getting the surface area of a
+ *  box.  The chance of a random ray or view volume touching
+ *  a box grows with it, which is what the split costs are
+ *  built on.
+ ***********************************************************/
+float BoundingVolumeHierarchy::SurfaceArea(const BOX& box)
+{
+	glm::vec3 extent = glm::max(box.maximum - box.minimum, glm::vec3(0.0f));
+	return(2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x));
+}
+
+/***********************************************************
+ *  IntersectRayBox()
+ *
+ *  This method is used for the slab test of a ray against a
+ *  box.  The ray enters the box at the furthest of the near
+ *  planes and leaves it at the nearest of the far planes.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IntersectRayBox(glm::vec3 origin, glm::vec3 inverseDirection,
+	glm::vec3 minimum, glm::vec3 maximum, float maxDistance, float& distance)
+{
+	glm::vec3 t0 = (minimum - origin) * inverseDirection;
+	glm::vec3 t1 = (maximum - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+	distance = entry;
+	return(entry <= exit);
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// tree of bounding boxes over the scene's draws, for culling and queries
+//
+// The tree is built top down, splitting each node where the surface area
+// heuristic estimates the cheapest queries, with the item centers sorted
+// into a fixed number of bins along each axis. The nodes are stored in one
+// array in depth first order - the first child of a node follows it, and the
+// node stores where its second child is - so a query walks the array with a
+// small stack and no pointers. When items move, Refit() recomputes the boxes
+// from the leaves up without changing the shape of the tree.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// axis aligned box of an item, in world space
+	struct BOX
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// one node of the flattened tree
+	struct NODE
+	{
+		glm::vec3 minimum;
+		int index;           // first item of a leaf, second child of an inner node
+		glm::vec3 maximum;
+		int itemCount;       // 0 for an inner node
+	};
+
+	// build the tree over the passed in item boxes, the item index is
+	// the position of its box
+	void Build(const std::vector<BOX>& itemBounds);
+	// recompute the node boxes after the items moved, the number of
+	// items has to be the same as when the tree was built
+	bool Refit(const std::vector<BOX>& itemBounds);
+	void Clear();
+
+	// items whose boxes intersect the view volume, returns the number of
+	// nodes tested
+	int QueryFrustum(const Frustum& frustum, std::vector<int>& items) const;
+	// the nearest item whose box is hit by the ray within maxDistance,
+	// false if none is
+	bool QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+		int& item, float& distance) const;
+	// items whose boxes intersect the sphere
+	void QuerySphere(glm::vec3 center, float radius, std::vector<int>& items) const;
+
+	int GetNodeCount() const { return((int)m_nodes.size()); }
+	int GetItemCount() const { return((int)m_itemIndices.size()); }
+	const std::vector<NODE>& GetNodes() const { return(m_nodes); }
+
+private:
+	// flattened nodes, the root is the first
+	std::vector<NODE> m_nodes;
+	// item indices, each leaf holds a range of them
+	std::vector<int> m_itemIndices;
+	// item boxes in the same order as the indices, so a leaf tests
+	// its items without jumping around the caller's array
+	std::vector<BOX> m_leafBounds;
+
+	// build the node for a range of the item indices, returns its index
+	int BuildNode(const std::vector<BOX>& itemBounds, const std::vector<glm::vec3>& centers,
+		int first, int count, int depth);
+	// the surface area of a box, for the split costs
+	static float SurfaceArea(const BOX& box);
+	// distance along the ray to where it enters a box, false if it misses
+	static bool IntersectRayBox(glm::vec3 origin, glm::vec3 inverseDirection,
+		glm::vec3 minimum, glm::vec3 maximum, float maxDistance, float& distance);
+};
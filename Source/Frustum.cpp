@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// test bounding volumes against the planes of the view volume
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Frustum::Frustum()
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		m_planes[plane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for reading the planes of the view
+ *  volume out of a projection * view matrix.  A point is
+ *  inside when -w <= x, y, z <= w in clip space, which makes
+ *  each plane the fourth row plus or minus one of the others.
+ ***********************************************************/
+void Frustum::SetViewProjection(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row],
+			viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];
+	m_planes[1] = rows[3] - rows[0];
+	m_planes[2] = rows[3] + rows[1];
+	m_planes[3] = rows[3] - rows[1];
+	m_planes[4] = rows[3] + rows[2];
+	m_planes[5] = rows[3] - rows[2];
+
+	for (int plane = 0; plane < 6; plane++)
+	{
+		float length = glm::length(glm::vec3(m_planes[plane]));
+		if (length > 0.0f)
+		{
+			m_planes[plane] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IntersectsSphere()
+ *
+ *  This method is used for testing a sphere against the
+ *  planes.  It is outside when its center is further than its
+ *  radius behind any one of them.
+ ***********************************************************/
+bool Frustum::IntersectsSphere(glm::vec3 center, float radius) const
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if (glm::dot(glm::vec3(m_planes[plane]), center) + m_planes[plane].w < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IntersectsBox()
+ *
+ *  This method is used for testing an axis aligned box
+ *  against the planes.  Only the corner furthest along each
+ *  plane's normal has to be tested - if that one is behind
+ *  the plane, so is the whole box.
+ ***********************************************************/
+bool Frustum::IntersectsBox(glm::vec3 minimum, glm::vec3 maximum) const
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		glm::vec3 normal = glm::vec3(m_planes[plane]);
+		glm::vec3 corner;
+		corner.x = (normal.x >= 0.0f) ? maximum.x : minimum.x;
+		corner.y = (normal.y >= 0.0f) ? maximum.y : minimum.y;
+		corner.z = (normal.z >= 0.0f) ? maximum.z : minimum.z;
+
+		if (glm::dot(normal, corner) + m_planes[plane].w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  TransformBox()
+ *
+ *  This method is used for finding the box around a model
+ *  space box after it is transformed.  Each world axis adds
+ *  up the smaller and the larger product of every matrix
+ *  element with the box's extent along that axis.
+ ***********************************************************/
+void Frustum::TransformBox(const glm::mat4& model, glm::vec3 minimum, glm::vec3 maximum,
+	glm::vec3& transformedMinimum, glm::vec3& transformedMaximum)
+{
+	transformedMinimum = glm::vec3(model[3]);
+	transformedMaximum = glm::vec3(model[3]);
+
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float a = model[column][row] * minimum[column];
+			float b = model[column][row] * maximum[column];
+			transformedMinimum[row] += std::min(a, b);
+			transformedMaximum[row] += std::max(a, b);
+		}
+	}
+}
+
+/***********************************************************
+ *  TransformRadius()
+ *
+ *  This method is used for scaling a radius by the longest
+ *  axis of a matrix, so the sphere still holds everything it
+ *  held before the transform.
+ ***********************************************************/
+float Frustum::TransformRadius(const glm::mat4& model, float radius)
+{
+	float scale = std::max(glm::length(glm::vec3(model[0])),
+		std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+	return(radius * scale);
+}
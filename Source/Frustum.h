@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// test bounding volumes against the planes of the view volume
+//
+// The six planes are read from the rows of projection * view, so the same
+// code handles perspective and orthographic projections. Each plane points
+// into the view volume and is normalized, so the distance of a point from it
+// can be compared with a sphere's radius. Volumes that straddle a corner of
+// the view volume can pass even though they are outside, but nothing that
+// is inside is ever rejected.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+class Frustum
+{
+public:
+	// constructor - everything passes until the planes are set
+	Frustum();
+
+	// read the planes of the view volume of a projection * view matrix
+	void SetViewProjection(const glm::mat4& viewProjection);
+
+	// false if the volume is completely outside one of the planes
+	bool IntersectsSphere(glm::vec3 center, float radius) const;
+	bool IntersectsBox(glm::vec3 minimum, glm::vec3 maximum) const;
+
+	// the box around a model space box once it is transformed
+	static void TransformBox(const glm::mat4& model, glm::vec3 minimum, glm::vec3 maximum,
+		glm::vec3& transformedMinimum, glm::vec3& transformedMaximum);
+	// the radius of a model space sphere once it is transformed, scaled
+	// by the largest axis scale of the matrix
+	static float TransformRadius(const glm::mat4& model, float radius);
+
+private:
+	// left, right, bottom, top, near and far - xyz is the normal
+	// pointing inside, w the distance
+	glm::vec4 m_planes[6];
+};
@@ -9,6 +9,9 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <chrono>           // startup timing
+#include <cstring>          // command line options
+#include <algorithm>        // frame timing
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -23,6 +26,9 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "TextureLoader.h"
+#include "MeshCache.h"
 
 // Namespace for declaring global variables
 namespace
@@ -39,12 +45,24 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// texture loader object for decoding the scene textures in the background
+	TextureLoader* g_TextureLoader = nullptr;
+	// texture cache object holding the cooked, block compressed textures
+	TextureCache* g_TextureCache = nullptr;
+	// mesh cache object holding the generated meshes
+	MeshCache* g_MeshCache = nullptr;
+
+	// folder the cooked textures are stored in
+	const char* const TEXTURE_CACHE_FOLDER = "textures/cooked";
+	// folder the generated meshes are stored in
+	const char* const MESH_CACHE_FOLDER = "meshes/cooked";
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
+bool InitializeGLFW(bool bHeadless);
+bool InitializeGLEW(bool bHeadless);
+void ReportFrameStatistics();
 
 
 /***********************************************************
@@ -55,8 +73,122 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	bool bFirstFrame = true;
+
+	// the cooked texture cache is used unless --no-texture-cache is passed,
+	// the generated meshes are cached unless --no-mesh-cache is passed,
+	// and mipmaps are box filtered unless --mip-filter=kaiser is passed.
+	// --scene-copies=N renders N copies of the scene side by side, and
+	// --no-multi-draw issues a draw call per mesh instead of one per frame,
+	// --no-static-batches draws the objects that never move one by one, and
+	// --no-frustum-culling draws the objects outside the view as well,
+	// --no-occlusion-culling draws the objects hidden behind the walls, and
+	// --no-detail-levels draws the round meshes at full detail at any size,
+	// and --vertex-format=full or =half packs the shared geometry in full
+	// floats or half float positions instead of 16-bit positions.
+	// --headless renders into an offscreen framebuffer of a hidden window
+	// that needs no display, --frames=N exits after N frames and prints
+	// their timings, and --capture=FILE writes the last frame to a PPM file
+	bool bUseTextureCache = true;
+	bool bUseMeshCache = true;
+	bool bMultiDraw = true;
+	bool bStaticBatching = true;
+	bool bFrustumCulling = true;
+	bool bOcclusionCulling = true;
+	bool bDetailLevels = true;
+	MipGenerator::MIP_FILTER mipFilter = MipGenerator::MIP_FILTER_BOX;
+	ShapeMeshes::VERTEX_FORMAT vertexFormat = ShapeMeshes::VERTEX_FORMAT_SNORM16;
+	int sceneCopies = 1;
+	bool bHeadless = false;
+	int frameLimit = 0;
+	const char* capturePath = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-texture-cache") == 0)
+		{
+			bUseTextureCache = false;
+		}
+		else if (strcmp(argv[i], "--no-mesh-cache") == 0)
+		{
+			bUseMeshCache = false;
+		}
+		else if (strcmp(argv[i], "--mip-filter=kaiser") == 0)
+		{
+			mipFilter = MipGenerator::MIP_FILTER_KAISER;
+		}
+		else if (strcmp(argv[i], "--mip-filter=box") == 0)
+		{
+			mipFilter = MipGenerator::MIP_FILTER_BOX;
+		}
+		else if (strncmp(argv[i], "--scene-copies=", 15) == 0)
+		{
+			sceneCopies = atoi(argv[i] + 15);
+		}
+		else if (strcmp(argv[i], "--no-multi-draw") == 0)
+		{
+			bMultiDraw = false;
+		}
+		else if (strcmp(argv[i], "--no-static-batches") == 0)
+		{
+			bStaticBatching = false;
+		}
+		else if (strcmp(argv[i], "--no-frustum-culling") == 0)
+		{
+			bFrustumCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-occlusion-culling") == 0)
+		{
+			bOcclusionCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-detail-levels") == 0)
+		{
+			bDetailLevels = false;
+		}
+		else if (strcmp(argv[i], "--vertex-format=full") == 0)
+		{
+			vertexFormat = ShapeMeshes::VERTEX_FORMAT_FULL;
+		}
+		else if (strcmp(argv[i], "--vertex-format=half") == 0)
+		{
+			vertexFormat = ShapeMeshes::VERTEX_FORMAT_HALF;
+		}
+		else if (strcmp(argv[i], "--vertex-format=snorm16") == 0)
+		{
+			vertexFormat = ShapeMeshes::VERTEX_FORMAT_SNORM16;
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			bHeadless = true;
+		}
+		else if (strncmp(argv[i], "--frames=", 9) == 0)
+		{
+			frameLimit = atoi(argv[i] + 9);
+		}
+		else if (strncmp(argv[i], "--capture=", 10) == 0)
+		{
+			capturePath = argv[i] + 10;
+		}
+	}
+	// a headless or captured run renders a single frame unless told otherwise
+	if (((bHeadless) || (NULL != capturePath)) && (frameLimit <= 0))
+	{
+		frameLimit = 1;
+	}
+
+	// start decoding the scene textures on worker threads while
+	// the display window and the shaders are being set up
+	g_TextureLoader = new TextureLoader();
+	g_TextureLoader->SetMipFilter(mipFilter);
+	if (bUseTextureCache)
+	{
+		g_TextureCache = new TextureCache(TEXTURE_CACHE_FOLDER);
+		g_TextureLoader->SetTextureCache(g_TextureCache);
+	}
+	SceneManager::QueueSceneTextures(g_TextureLoader);
+
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	if (InitializeGLFW(bHeadless) == false)
 	{
 		return(EXIT_FAILURE);
 	}
@@ -68,10 +200,20 @@ int main(int argc, char* argv[])
 		g_ShaderManager);
 
 	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE, bHeadless);
+	if (NULL == g_Window)
+	{
+		return(EXIT_FAILURE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	if (InitializeGLEW(bHeadless) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// without a visible window the frames are rendered offscreen
+	if ((bHeadless) && (g_ViewManager->CreateOffscreenTarget() == false))
 	{
 		return(EXIT_FAILURE);
 	}
@@ -83,8 +225,33 @@ int main(int argc, char* argv[])
 	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	// the textures are uploaded on a loader thread through a shared
+	// context, so the scene is rendered while they are still loading -
+	// except when headless, where every frame is rendered fully textured
+	// so the captured images are the same from run to run
+	g_SceneManager = new SceneManager(g_ShaderManager, g_TextureLoader);
+	if (false == bHeadless)
+	{
+		g_SceneManager->SetLoaderContext(g_ViewManager->CreateLoaderContext());
+	}
+	g_SceneManager->SetSceneCopies(sceneCopies);
+	g_SceneManager->SetMultiDraw(bMultiDraw);
+	g_SceneManager->SetStaticBatching(bStaticBatching);
+	g_SceneManager->SetFrustumCulling(bFrustumCulling);
+	g_SceneManager->SetOcclusionCulling(bOcclusionCulling);
+	g_SceneManager->SetDetailLevels(bDetailLevels);
+	g_SceneManager->SetVertexFormat(vertexFormat);
+	if (bUseMeshCache)
+	{
+		g_MeshCache = new MeshCache(MESH_CACHE_FOLDER, ShapeMeshes::GetGeneratorVersion());
+		g_SceneManager->SetMeshCache(g_MeshCache);
+	}
 	g_SceneManager->PrepareScene();
+	if (NULL != g_MeshCache)
+	{
+		std::cout << "Mesh cache:" << g_MeshCache->GetMappedCount() << " meshes mapped, "
+			<< g_MeshCache->GetStoredCount() << " generated and stored" << std::endl;
+	}
 
 	// Output display message describing keyboard controls //
 	std::cout << "\n********** Keyboard Controls **********\n";
@@ -99,13 +266,27 @@ int main(int argc, char* argv[])
 	std::cout << "Right Mouse Button Toggle - Zoom in and out\n";
 	std::cout << "Left Mouse Button Toggle - Flashlight on and off\n";
 	std::cout << "Middle Mouse Button Scroll - Change Movement speed\n";
+	std::cout << "F - Print frame statistics\n";
+
+	// time of each rendered frame, when the frames are limited
+	int renderedFrames = 0;
+	double totalFrameMilliseconds = 0.0;
+	double minFrameMilliseconds = 0.0;
+	double maxFrameMilliseconds = 0.0;
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	while ((!glfwWindowShouldClose(g_Window)) &&
+		((0 == frameLimit) || (renderedFrames < frameLimit)))
 	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+		// start counting the per-frame statistics
+		g_ShaderManager->ResetUniformLookupCount();
+		GLStateCache::ResetCounters();
+
 		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		GLStateCache::Enable(GL_DEPTH_TEST);
 
 		// Clear the frame and z buffers
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -113,24 +294,84 @@ int main(int argc, char* argv[])
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewProjection(g_ViewManager->GetViewProjection());
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		// output the statistics for this frame if requested
+		if (g_ViewManager->IsFrameStatsRequested())
+		{
+			ReportFrameStatistics();
+		}
+
+		// write the last frame out before the buffers are swapped
+		renderedFrames++;
+		if ((NULL != capturePath) && (renderedFrames == frameLimit))
+		{
+			g_ViewManager->SaveFrameImage(capturePath);
+		}
+
+		if (g_ViewManager->IsHeadless())
+		{
+			// nothing is shown, so wait for the frame to be finished
+			// for the frame timings to include the rendering
+			glFinish();
+		}
+		else
+		{
+			// Flips the the back buffer with the front buffer every frame.
+			glfwSwapBuffers(g_Window);
+		}
+
+		if (0 != frameLimit)
+		{
+			double frameMilliseconds = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - frameStart).count();
+			totalFrameMilliseconds += frameMilliseconds;
+			minFrameMilliseconds = (renderedFrames == 1) ? frameMilliseconds : std::min(minFrameMilliseconds, frameMilliseconds);
+			maxFrameMilliseconds = std::max(maxFrameMilliseconds, frameMilliseconds);
+		}
+
+		// report how long the application took to show the scene
+		if (bFirstFrame)
+		{
+			bFirstFrame = false;
+			std::cout << "Time to first frame ms:" << std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - startTime).count() << std::endl;
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
 	}
 
+	if ((0 != frameLimit) && (renderedFrames > 0))
+	{
+		std::cout << "Frame timing:" << renderedFrames << " frames, average ms:" << (totalFrameMilliseconds / renderedFrames)
+			<< ", min ms:" << minFrameMilliseconds << ", max ms:" << maxFrameMilliseconds << std::endl;
+	}
+
 	// clear the allocated manager objects from memory
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
+	if (NULL != g_TextureLoader)
+	{
+		delete g_TextureLoader;
+		g_TextureLoader = NULL;
+	}
+	if (NULL != g_TextureCache)
+	{
+		delete g_TextureCache;
+		g_TextureCache = NULL;
+	}
+	if (NULL != g_MeshCache)
+	{
+		delete g_MeshCache;
+		g_MeshCache = NULL;
+	}
 	if (NULL != g_ViewManager)
 	{
 		delete g_ViewManager;
@@ -150,12 +391,25 @@ int main(int argc, char* argv[])
  *	InitializeGLFW()
  * 
  *  This function is used to initialize the GLFW library.   
+ *  When headless on Linux, GLFW's null platform is used with
+ *  an EGL context, so no X11 or Wayland display is needed and
+ *  Mesa can render with llvmpipe on machines without a GPU.
  ***********************************************************/
-bool InitializeGLFW()
+bool InitializeGLFW(bool bHeadless)
 {
 	// GLFW: initialize and configure library
 	// --------------------------------------
-	glfwInit();
+#if !defined(_WIN32) && !defined(__APPLE__)
+	if (bHeadless)
+	{
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
+#endif
+	if (GLFW_FALSE == glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW" << std::endl;
+		return(false);
+	}
 
 #ifdef __APPLE__
 	// set the version of OpenGL and profile to use
@@ -167,6 +421,12 @@ bool InitializeGLFW()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+#if !defined(_WIN32) && !defined(__APPLE__)
+	if (bHeadless)
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+	}
 #endif
 	// GLFW: end -------------------------------
 
@@ -177,8 +437,13 @@ bool InitializeGLFW()
  *	InitializeGLEW()
  *
  *  This function is used to initialize the GLEW library.
+ *  A Linux GLEW built for GLX loads the OpenGL entry points
+ *  first and then fails to find a GLX display, which the EGL
+ *  context of a headless run does not have - that error is
+ *  ignored when headless, as only the GLX extensions are
+ *  missing.
  ***********************************************************/
-bool InitializeGLEW()
+bool InitializeGLEW(bool bHeadless)
 {
 	// GLEW: initialize
 	// -----------------------------------------
@@ -186,6 +451,12 @@ bool InitializeGLEW()
 
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if ((bHeadless) && (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -198,4 +469,44 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	ReportFrameStatistics()
+ *
+ *  This function is used to output the statistics gathered
+ *  while rendering the current frame.
+ ***********************************************************/
+void ReportFrameStatistics()
+{
+	std::cout << "\n********** Frame Statistics **********\n";
+	std::cout << "Uniform name lookups: " << g_ShaderManager->GetUniformLookupCount() << "\n";
+
+	// state changes between the draws, in the order the objects
+	// submitted them and in the sorted order they were drawn in
+	RenderQueue::STATE_CHANGES unsorted;
+	RenderQueue::STATE_CHANGES sorted;
+	g_SceneManager->GetStateChanges(unsorted, sorted);
+	std::cout << "Draws: " << g_SceneManager->GetDrawCount() << "\n";
+	std::cout << "Frustum culling: " << g_SceneManager->GetVisibleDrawCount() << " visible, " << g_SceneManager->GetCulledDrawCount() << " culled, "
+		<< g_SceneManager->GetHierarchyNodesTested() << " tree nodes tested\n";
+	std::cout << "Occlusion culling: " << g_SceneManager->GetOccludedDrawCount() << " occluded, "
+		<< g_SceneManager->GetOccluderTriangleCount() << " occluder triangles (" << OcclusionBuffer::GetInstructionSetName() << ")\n";
+	std::cout << "Triangles: " << g_SceneManager->GetSubmittedTriangleCount() << " submitted, detail levels";
+	for (int level = 0; level < ShapeMeshes::DETAIL_LEVELS; level++)
+	{
+		std::cout << ((level == 0) ? " " : "/") << g_SceneManager->GetDetailLevelDrawCount(level);
+	}
+	std::cout << " draws\n";
+	std::cout << "Scene graph nodes: " << g_SceneManager->GetSceneNodeCount() << ", world matrices updated: " << g_SceneManager->GetWorldMatrixUpdateCount() << "\n";
+	std::cout << "Static batches: " << g_SceneManager->GetStaticBatchCount() << ", baked from " << g_SceneManager->GetStaticDrawCount() << " draws\n";
+	std::cout << "Draw calls: " << g_SceneManager->GetDrawCallCount() << ", instanced: " << g_SceneManager->GetInstancedDrawCallCount()
+		<< ", multi-draw commands: " << g_SceneManager->GetMultiDrawCommandCount() << "\n";
+	std::cout << "Draw submission ms: " << g_SceneManager->GetSubmitMilliseconds() << "\n";
+	std::cout << "Texture changes: " << unsorted.textures << " unsorted, " << sorted.textures << " sorted\n";
+	std::cout << "Material changes: " << unsorted.materials << " unsorted, " << sorted.materials << " sorted\n";
+	std::cout << "VAO changes: " << unsorted.vertexArrays << " unsorted, " << sorted.vertexArrays << " sorted\n";
+
+	// state changes and uniform uploads made through the state cache
+	std::cout << "GL state calls: " << GLStateCache::GetIssuedCount() << " issued, " << GLStateCache::GetSkippedCount() << " skipped\n";
+}
@@ -0,0 +1,591 @@
+///////////////////////////////////////////////////////////////////////////////
+// mipgenerator.cpp
+// ============
+// build texture mip chains on the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define MIP_GENERATOR_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MIP_SSE2_TARGET
+#define MIP_AVX2_TARGET
+#else
+#define MIP_SSE2_TARGET __attribute__((target("sse2")))
+#define MIP_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// the filter weights are in 1/4096ths and add up to 4096
+	const int g_WeightBits = 12;
+	// fraction bits kept between the vertical and the horizontal pass
+	const int g_IntermediateBits = 6;
+	const int g_VerticalShift = g_WeightBits - g_IntermediateBits;
+	const int g_VerticalRound = 1 << (g_VerticalShift - 1);
+	const int g_HorizontalShift = g_WeightBits + g_IntermediateBits;
+	const int g_HorizontalRound = 1 << (g_HorizontalShift - 1);
+
+	// pixels of edge repeated on each side of a filtered row
+	const int g_RowPadding = 8;
+
+	// separable filter for halving an image - output pixel x is made from
+	// source pixels 2x + firstTap through 2x + firstTap + taps - 1
+	struct MIP_KERNEL
+	{
+		int taps;   // always even, the SIMD kernels take them in pairs
+		int firstTap;
+		short weights[8];
+	};
+
+	// 2x2 average, the same result as (a + b + c + d + 2) / 4
+	const MIP_KERNEL g_BoxKernel = { 2, 0, { 2048, 2048 } };
+	// sinc with its cutoff at the new Nyquist frequency, under a Kaiser
+	// window with beta 4 that spans the 8 taps
+	const MIP_KERNEL g_KaiserKernel = { 8, -3, { -51, -176, 479, 1796, 1796, 479, -176, -51 } };
+
+	// vertical pass - filter count bytes of the passed in RGBA rows
+	// into an intermediate row with g_IntermediateBits of fraction
+	typedef void (*FILTER_ROWS)(const unsigned char* const* rows, const short* weights,
+		int taps, int count, short* output);
+	// horizontal pass - filter an intermediate row, padded with its
+	// edge pixels, into width RGBA pixels
+	typedef void (*FILTER_COLUMNS)(const short* row, const short* weights,
+		int taps, int firstTap, int width, unsigned char* output);
+
+	struct MIP_KERNEL_FUNCTIONS
+	{
+		FILTER_ROWS filterRows;
+		FILTER_COLUMNS filterColumns;
+	};
+
+	/***********************************************************
+	 *  scalar kernels - the reference for the SIMD kernels
+	 ***********************************************************/
+	void FilterRowsScalar(const unsigned char* const* rows, const short* weights,
+		int taps, int count, short* output)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			int sum = g_VerticalRound;
+			for (int k = 0; k < taps; k++)
+			{
+				sum += weights[k] * rows[k][i];
+			}
+			output[i] = (short)(sum >> g_VerticalShift);
+		}
+	}
+
+	void FilterPixelScalar(const short* row, const short* weights,
+		int taps, int firstTap, int x, unsigned char* output)
+	{
+		const short* source = row + (2 * x + firstTap) * 4;
+		for (int c = 0; c < 4; c++)
+		{
+			int sum = g_HorizontalRound;
+			for (int k = 0; k < taps; k++)
+			{
+				sum += weights[k] * source[k * 4 + c];
+			}
+			output[c] = (unsigned char)std::min(255, std::max(0, sum >> g_HorizontalShift));
+		}
+	}
+
+	void FilterColumnsScalar(const short* row, const short* weights,
+		int taps, int firstTap, int width, unsigned char* output)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			FilterPixelScalar(row, weights, taps, firstTap, x, output + x * 4);
+		}
+	}
+
+	// two 16-bit weights packed for _mm_madd_epi16
+	int PackWeightPair(short first, short second)
+	{
+		return((int)(((unsigned int)(unsigned short)second << 16) | (unsigned short)first));
+	}
+
+#ifdef MIP_GENERATOR_X86
+	/***********************************************************
+	 *  SSE2 kernels
+	 ***********************************************************/
+	MIP_SSE2_TARGET void FilterRowsSSE2(const unsigned char* const* rows, const short* weights,
+		int taps, int count, short* output)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi32(g_VerticalRound);
+
+		int i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i sum0 = round;
+			__m128i sum1 = round;
+			__m128i sum2 = round;
+			__m128i sum3 = round;
+			for (int k = 0; k < taps; k += 2)
+			{
+				// interleave the bytes of two rows so one multiply-add
+				// applies the weights of both
+				const __m128i weightPair = _mm_set1_epi32(PackWeightPair(weights[k], weights[k + 1]));
+				__m128i a = _mm_loadu_si128((const __m128i*)(rows[k] + i));
+				__m128i b = _mm_loadu_si128((const __m128i*)(rows[k + 1] + i));
+				__m128i aLow = _mm_unpacklo_epi8(a, zero);
+				__m128i aHigh = _mm_unpackhi_epi8(a, zero);
+				__m128i bLow = _mm_unpacklo_epi8(b, zero);
+				__m128i bHigh = _mm_unpackhi_epi8(b, zero);
+				sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(aLow, bLow), weightPair));
+				sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(aLow, bLow), weightPair));
+				sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi16(aHigh, bHigh), weightPair));
+				sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi16(aHigh, bHigh), weightPair));
+			}
+			sum0 = _mm_srai_epi32(sum0, g_VerticalShift);
+			sum1 = _mm_srai_epi32(sum1, g_VerticalShift);
+			sum2 = _mm_srai_epi32(sum2, g_VerticalShift);
+			sum3 = _mm_srai_epi32(sum3, g_VerticalShift);
+			_mm_storeu_si128((__m128i*)(output + i), _mm_packs_epi32(sum0, sum1));
+			_mm_storeu_si128((__m128i*)(output + i + 8), _mm_packs_epi32(sum2, sum3));
+		}
+
+		if (i < count)
+		{
+			const unsigned char* tailRows[8];
+			for (int k = 0; k < taps; k++)
+			{
+				tailRows[k] = rows[k] + i;
+			}
+			FilterRowsScalar(tailRows, weights, taps, count - i, output + i);
+		}
+	}
+
+	MIP_SSE2_TARGET void FilterColumnsSSE2(const short* row, const short* weights,
+		int taps, int firstTap, int width, unsigned char* output)
+	{
+		const __m128i round = _mm_set1_epi32(g_HorizontalRound);
+		__m128i weightPairs[4];
+		for (int k = 0; k < taps; k += 2)
+		{
+			weightPairs[k / 2] = _mm_set1_epi32(PackWeightPair(weights[k], weights[k + 1]));
+		}
+
+		for (int x = 0; x < width; x++)
+		{
+			const short* source = row + (2 * x + firstTap) * 4;
+			__m128i sum = round;
+			for (int k = 0; k < taps; k += 2)
+			{
+				// two neighbouring RGBA pixels, interleaved per channel
+				__m128i pixels = _mm_loadu_si128((const __m128i*)(source + k * 4));
+				__m128i pairs = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(pairs, weightPairs[k / 2]));
+			}
+			sum = _mm_srai_epi32(sum, g_HorizontalShift);
+			__m128i packed = _mm_packs_epi32(sum, sum);
+			int color = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+			memcpy(output + x * 4, &color, 4);
+		}
+	}
+
+	/***********************************************************
+	 *  AVX2 kernels
+	 ***********************************************************/
+	MIP_AVX2_TARGET void FilterRowsAVX2(const unsigned char* const* rows, const short* weights,
+		int taps, int count, short* output)
+	{
+		const __m256i round = _mm256_set1_epi32(g_VerticalRound);
+
+		int i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i sum0 = round;
+			__m256i sum1 = round;
+			for (int k = 0; k < taps; k += 2)
+			{
+				const __m256i weightPair = _mm256_set1_epi32(PackWeightPair(weights[k], weights[k + 1]));
+				__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(rows[k] + i)));
+				__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(rows[k + 1] + i)));
+				sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), weightPair));
+				sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), weightPair));
+			}
+			// the unpacks and the pack both work per 128-bit lane, so
+			// together they leave the values in their original order
+			sum0 = _mm256_srai_epi32(sum0, g_VerticalShift);
+			sum1 = _mm256_srai_epi32(sum1, g_VerticalShift);
+			_mm256_storeu_si256((__m256i*)(output + i), _mm256_packs_epi32(sum0, sum1));
+		}
+
+		if (i < count)
+		{
+			const unsigned char* tailRows[8];
+			for (int k = 0; k < taps; k++)
+			{
+				tailRows[k] = rows[k] + i;
+			}
+			FilterRowsScalar(tailRows, weights, taps, count - i, output + i);
+		}
+	}
+
+	MIP_AVX2_TARGET void FilterColumnsAVX2(const short* row, const short* weights,
+		int taps, int firstTap, int width, unsigned char* output)
+	{
+		const __m256i round = _mm256_set1_epi32(g_HorizontalRound);
+		__m256i weightPairs[4];
+		for (int k = 0; k < taps; k += 2)
+		{
+			weightPairs[k / 2] = _mm256_set1_epi32(PackWeightPair(weights[k], weights[k + 1]));
+		}
+
+		// two output pixels at a time, one per 128-bit lane
+		int x = 0;
+		for (; x + 2 <= width; x += 2)
+		{
+			const short* source = row + (2 * x + firstTap) * 4;
+			__m256i sum = round;
+			for (int k = 0; k < taps; k += 2)
+			{
+				__m256i pixels = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(source + k * 4))),
+					_mm_loadu_si128((const __m128i*)(source + (k + 2) * 4)), 1);
+				__m256i pairs = _mm256_unpacklo_epi16(pixels, _mm256_bsrli_epi128(pixels, 8));
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(pairs, weightPairs[k / 2]));
+			}
+			sum = _mm256_srai_epi32(sum, g_HorizontalShift);
+			__m256i packed = _mm256_packs_epi32(sum, sum);
+			packed = _mm256_packus_epi16(packed, packed);
+			int first = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+			int second = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+			memcpy(output + x * 4, &first, 4);
+			memcpy(output + x * 4 + 4, &second, 4);
+		}
+
+		if (x < width)
+		{
+			FilterPixelScalar(row, weights, taps, firstTap, x, output + x * 4);
+		}
+	}
+#endif
+
+	// fastest kernels the CPU and the operating system support
+	int DetectInstructionSet()
+	{
+#ifdef MIP_GENERATOR_X86
+#if defined(_MSC_VER)
+		int info[4] = { 0 };
+		__cpuid(info, 0);
+		int highestFunction = info[0];
+		__cpuid(info, 1);
+		bool bSSE2 = (info[3] & (1 << 26)) != 0;
+		bool bOSXSAVE = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		bool bAVX2 = false;
+		if ((bOSXSAVE) && (bAVX) && (highestFunction >= 7) &&
+			((_xgetbv(0) & 6) == 6))
+		{
+			__cpuidex(info, 7, 0);
+			bAVX2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		bool bSSE2 = __builtin_cpu_supports("sse2");
+		bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+		if (bAVX2)
+		{
+			return(MipGenerator::MIP_INSTRUCTIONS_AVX2);
+		}
+		if (bSSE2)
+		{
+			return(MipGenerator::MIP_INSTRUCTIONS_SSE2);
+		}
+#endif
+		return(MipGenerator::MIP_INSTRUCTIONS_SCALAR);
+	}
+
+	const int g_SupportedInstructionSet = DetectInstructionSet();
+	std::atomic<int> g_InstructionSet(g_SupportedInstructionSet);
+
+	MIP_KERNEL_FUNCTIONS GetKernelFunctions()
+	{
+		MIP_KERNEL_FUNCTIONS functions = { FilterRowsScalar, FilterColumnsScalar };
+#ifdef MIP_GENERATOR_X86
+		switch (g_InstructionSet.load())
+		{
+		case MipGenerator::MIP_INSTRUCTIONS_AVX2:
+			functions.filterRows = FilterRowsAVX2;
+			functions.filterColumns = FilterColumnsAVX2;
+			break;
+		case MipGenerator::MIP_INSTRUCTIONS_SSE2:
+			functions.filterRows = FilterRowsSSE2;
+			functions.filterColumns = FilterColumnsSSE2;
+			break;
+		default:
+			break;
+		}
+#endif
+		return(functions);
+	}
+
+	// halve an RGBA image with the passed in kernel
+	void DownsampleImage(const unsigned char* source, int sourceWidth, int sourceHeight,
+		unsigned char* destination, int width, int height,
+		const MIP_KERNEL& kernel, const MIP_KERNEL_FUNCTIONS& functions)
+	{
+		// intermediate row with room for the repeated edge pixels
+		std::vector<short> row((size_t)(sourceWidth + 2 * g_RowPadding) * 4);
+		short* rowStart = row.data() + g_RowPadding * 4;
+		const unsigned char* rows[8];
+
+		for (int y = 0; y < height; y++)
+		{
+			// rows past the top or bottom repeat the edge row
+			for (int k = 0; k < kernel.taps; k++)
+			{
+				int sourceY = std::min(std::max(2 * y + kernel.firstTap + k, 0), sourceHeight - 1);
+				rows[k] = source + (size_t)sourceY * sourceWidth * 4;
+			}
+			functions.filterRows(rows, kernel.weights, kernel.taps, sourceWidth * 4, rowStart);
+
+			for (int p = 1; p <= g_RowPadding; p++)
+			{
+				memcpy(rowStart - p * 4, rowStart, 4 * sizeof(short));
+				memcpy(rowStart + (sourceWidth - 1 + p) * 4, rowStart + (sourceWidth - 1) * 4, 4 * sizeof(short));
+			}
+			functions.filterColumns(rowStart, kernel.weights, kernel.taps, kernel.firstTap,
+				width, destination + (size_t)y * width * 4);
+		}
+	}
+
+	// first source pixel of the two each of count output pixels blends,
+	// and the weight of the second in 1/4096ths, for stretching size
+	// source pixels over count
+	void GetResizeTaps(int size, int count, std::vector<int>& first, std::vector<int>& weights)
+	{
+		const int weightOne = 1 << g_WeightBits;
+
+		first.resize(count);
+		weights.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			// center of the output pixel in the source, where the
+			// center of source pixel 0 is at 0
+			int64_t center = ((int64_t)(2 * i + 1) * size * weightOne) / (2 * count) - weightOne / 2;
+			center = std::max(center, (int64_t)0);
+			first[i] = (int)(center >> g_WeightBits);
+			weights[i] = (int)(center & (weightOne - 1));
+			if (first[i] >= size - 1)
+			{
+				first[i] = size - 1;
+				weights[i] = 0;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMipChain()
+ *
+ *  This method is used for building every mip level below the
+ *  passed in RGB or RGBA image.  Each level is made from the
+ *  one above it, and RGB images are filtered as RGBA with the
+ *  alpha dropped again from each finished level.
+ ***********************************************************/
+bool MipGenerator::BuildMipChain(const unsigned char* pixels, int width, int height,
+	int colorChannels, MIP_FILTER filter, std::vector<MIP_LEVEL>& levels)
+{
+	levels.clear();
+	if ((NULL == pixels) || (width <= 0) || (height <= 0) ||
+		((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return(false);
+	}
+
+	const MIP_KERNEL& kernel = (filter == MIP_FILTER_KAISER) ? g_KaiserKernel : g_BoxKernel;
+	MIP_KERNEL_FUNCTIONS functions = GetKernelFunctions();
+
+	std::vector<unsigned char> sourceRGBA;
+	std::vector<unsigned char> levelRGBA;
+	const unsigned char* source = pixels;
+	if (colorChannels == 3)
+	{
+		sourceRGBA.resize((size_t)width * height * 4);
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			sourceRGBA[i * 4 + 0] = pixels[i * 3 + 0];
+			sourceRGBA[i * 4 + 1] = pixels[i * 3 + 1];
+			sourceRGBA[i * 4 + 2] = pixels[i * 3 + 2];
+			sourceRGBA[i * 4 + 3] = 255;
+		}
+		source = sourceRGBA.data();
+	}
+
+	levels.reserve(GetLevelCount(width, height) - 1);
+	int sourceWidth = width;
+	int sourceHeight = height;
+	while ((sourceWidth > 1) || (sourceHeight > 1))
+	{
+		MIP_LEVEL level;
+		level.width = std::max(1, sourceWidth / 2);
+		level.height = std::max(1, sourceHeight / 2);
+		size_t pixelCount = (size_t)level.width * level.height;
+		levelRGBA.resize(pixelCount * 4);
+		DownsampleImage(source, sourceWidth, sourceHeight,
+			levelRGBA.data(), level.width, level.height, kernel, functions);
+
+		if (colorChannels == 4)
+		{
+			level.pixels = levelRGBA;
+		}
+		else
+		{
+			level.pixels.resize(pixelCount * 3);
+			for (size_t i = 0; i < pixelCount; i++)
+			{
+				level.pixels[i * 3 + 0] = levelRGBA[i * 4 + 0];
+				level.pixels[i * 3 + 1] = levelRGBA[i * 4 + 1];
+				level.pixels[i * 3 + 2] = levelRGBA[i * 4 + 2];
+			}
+		}
+		levels.push_back(std::move(level));
+
+		// the level just built is the source of the next one
+		sourceRGBA.swap(levelRGBA);
+		source = sourceRGBA.data();
+		sourceWidth = std::max(1, sourceWidth / 2);
+		sourceHeight = std::max(1, sourceHeight / 2);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ResizeImage()
+ *
+ *  This method is used for stretching an RGB or RGBA image to
+ *  another size with bilinear filtering.  Each output pixel
+ *  blends the four source pixels around its center, so the
+ *  source should be no more than twice the output size; a
+ *  larger image is resized from one of its mip levels.
+ ***********************************************************/
+bool MipGenerator::ResizeImage(const unsigned char* pixels, int width, int height,
+	int colorChannels, int resizedWidth, int resizedHeight, std::vector<unsigned char>& resized)
+{
+	resized.clear();
+	if ((NULL == pixels) || (width <= 0) || (height <= 0) ||
+		(resizedWidth <= 0) || (resizedHeight <= 0) ||
+		((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return(false);
+	}
+
+	std::vector<int> columns, columnWeights, rows, rowWeights;
+	GetResizeTaps(width, resizedWidth, columns, columnWeights);
+	GetResizeTaps(height, resizedHeight, rows, rowWeights);
+
+	// both passes are in 1/4096ths, so the sum of a pixel fits in
+	// 32 bits unsigned
+	const uint32_t weightOne = 1 << g_WeightBits;
+	const uint32_t round = 1u << (2 * g_WeightBits - 1);
+	resized.resize((size_t)resizedWidth * resizedHeight * colorChannels);
+	for (int y = 0; y < resizedHeight; y++)
+	{
+		const unsigned char* top = pixels + (size_t)rows[y] * width * colorChannels;
+		const unsigned char* bottom = pixels + (size_t)std::min(rows[y] + 1, height - 1) * width * colorChannels;
+		uint32_t bottomWeight = (uint32_t)rowWeights[y];
+		unsigned char* output = resized.data() + (size_t)y * resizedWidth * colorChannels;
+
+		for (int x = 0; x < resizedWidth; x++)
+		{
+			size_t left = (size_t)columns[x] * colorChannels;
+			size_t right = (size_t)std::min(columns[x] + 1, width - 1) * colorChannels;
+			uint32_t rightWeight = (uint32_t)columnWeights[x];
+
+			for (int channel = 0; channel < colorChannels; channel++)
+			{
+				uint32_t topSum = top[left + channel] * (weightOne - rightWeight) + top[right + channel] * rightWeight;
+				uint32_t bottomSum = bottom[left + channel] * (weightOne - rightWeight) + bottom[right + channel] * rightWeight;
+				output[x * colorChannels + channel] = (unsigned char)(
+					(topSum * (weightOne - bottomWeight) + bottomSum * bottomWeight + round) >> (2 * g_WeightBits));
+			}
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting the number of levels in a
+ *  full mip chain, including the base image.
+ ***********************************************************/
+int MipGenerator::GetLevelCount(int width, int height)
+{
+	int levelCount = 1;
+	while ((width > 1) || (height > 1))
+	{
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		levelCount++;
+	}
+
+	return(levelCount);
+}
+
+/***********************************************************
+ *  GetFilterName()
+ *
+ *  This method is used for getting the name of a filter.
+ ***********************************************************/
+const char* MipGenerator::GetFilterName(MIP_FILTER filter)
+{
+	return((filter == MIP_FILTER_KAISER) ? "kaiser" : "box");
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for getting the kernels in use.
+ ***********************************************************/
+MipGenerator::MIP_INSTRUCTION_SET MipGenerator::GetInstructionSet()
+{
+	return((MIP_INSTRUCTION_SET)g_InstructionSet.load());
+}
+
+/***********************************************************
+ *  GetInstructionSetName()
+ *
+ *  This method is used for getting the name of the kernels
+ *  in use.
+ ***********************************************************/
+const char* MipGenerator::GetInstructionSetName()
+{
+	switch (GetInstructionSet())
+	{
+	case MIP_INSTRUCTIONS_AVX2:
+		return("AVX2");
+	case MIP_INSTRUCTIONS_SSE2:
+		return("SSE2");
+	default:
+		return("scalar");
+	}
+}
+
+/***********************************************************
+ *  SetInstructionSet()
+ *
+ *  This method is used for switching to slower kernels than
+ *  the CPU supports.  Faster ones than supported are ignored.
+ ***********************************************************/
+void MipGenerator::SetInstructionSet(MIP_INSTRUCTION_SET instructionSet)
+{
+	g_InstructionSet = std::min((int)instructionSet, g_SupportedInstructionSet);
+}
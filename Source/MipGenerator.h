@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+// mipgenerator.h
+// ============
+// build texture mip chains on the CPU
+//
+// Each level is made by halving the previous one with a separable filter,
+// either a 2x2 box or an 8 tap Kaiser windowed sinc. All of the filtering is
+// done in fixed point integer math, so the scalar, SSE2 and AVX2 kernels
+// produce the same bytes and a chain is identical from run to run and from
+// machine to machine. A chain is built from the image bytes alone, so it can
+// be built on any thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+class MipGenerator
+{
+public:
+	// filter used to reduce one level to the next
+	enum MIP_FILTER
+	{
+		MIP_FILTER_BOX = 0,
+		MIP_FILTER_KAISER
+	};
+
+	// kernels used for the filtering, fastest supported one by default
+	enum MIP_INSTRUCTION_SET
+	{
+		MIP_INSTRUCTIONS_SCALAR = 0,
+		MIP_INSTRUCTIONS_SSE2,
+		MIP_INSTRUCTIONS_AVX2
+	};
+
+	// one reduced level of a mip chain
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;   // same channels as the source
+	};
+
+	// build every level below the passed in RGB or RGBA image, down to 1x1
+	static bool BuildMipChain(const unsigned char* pixels, int width, int height,
+		int colorChannels, MIP_FILTER filter, std::vector<MIP_LEVEL>& levels);
+
+	// stretch an RGB or RGBA image to another size with bilinear filtering,
+	// for images no more than twice the new size
+	static bool ResizeImage(const unsigned char* pixels, int width, int height,
+		int colorChannels, int resizedWidth, int resizedHeight, std::vector<unsigned char>& resized);
+
+	// number of levels in a full chain, including the base image
+	static int GetLevelCount(int width, int height);
+	// name of a filter, for logging
+	static const char* GetFilterName(MIP_FILTER filter);
+
+	// kernels in use, and their name for logging
+	static MIP_INSTRUCTION_SET GetInstructionSet();
+	static const char* GetInstructionSetName();
+	// use slower kernels than the CPU supports - for comparing the output
+	static void SetInstructionSet(MIP_INSTRUCTION_SET instructionSet);
+};
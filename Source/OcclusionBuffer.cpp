@@ -0,0 +1,408 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionbuffer.cpp
+// ============
+// low resolution depth buffer drawn on the CPU, for skipping hidden draws
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// pixels along each side of a tile, also what the width is rounded
+	// to so the rows can be filled four pixels at a time
+	const int TILE_SIZE = 8;
+	// how far behind the stored depth a box has to be to count as hidden,
+	// so a surface never hides its own box through rounding
+	const float DEPTH_BIAS = 1.0e-5f;
+	// triangles smaller than this in square pixels cover no pixel centers
+	const float MINIMUM_AREA = 1.0e-6f;
+
+	// the triangles of the six faces of a box, by corner - bit 0 of a
+	// corner picks the maximum x, bit 1 the maximum y and bit 2 the
+	// maximum z
+	const int g_BoxTriangles[36] = {
+		0, 2, 6,  0, 6, 4,     // -x
+		1, 3, 7,  1, 7, 5,     // +x
+		0, 1, 5,  0, 5, 4,     // -y
+		2, 3, 7,  2, 7, 6,     // +y
+		0, 1, 3,  0, 3, 2,     // -z
+		4, 5, 7,  4, 7, 6      // +z
+	};
+}
+
+/***********************************************************
+ *  OcclusionBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionBuffer::OcclusionBuffer()
+{
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_rasterizedTriangles = 0;
+
+	SetResolution(256, 144);
+}
+
+/***********************************************************
+ *  SetResolution()
+ *
+ *  This method is used for sizing the buffer.  The size is
+ *  rounded up to whole tiles, the view is stretched over all
+ *  of it so the aspect ratio comes from the projection.
+ ***********************************************************/
+void OcclusionBuffer::SetResolution(int width, int height)
+{
+	m_tilesX = (std::max(width, 1) + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (std::max(height, 1) + TILE_SIZE - 1) / TILE_SIZE;
+	m_width = m_tilesX * TILE_SIZE;
+	m_height = m_tilesY * TILE_SIZE;
+
+	m_depth.resize(m_width * m_height);
+	m_tileDepth.resize(m_tilesX * m_tilesY);
+	Clear();
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the matrix the occluders
+ *  and the tested boxes are drawn with.
+ ***********************************************************/
+void OcclusionBuffer::SetViewProjection(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for setting every pixel and tile to
+ *  the far plane, so nothing is hidden until occluders are
+ *  drawn.
+ ***********************************************************/
+void OcclusionBuffer::Clear()
+{
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+	std::fill(m_tileDepth.begin(), m_tileDepth.end(), 1.0f);
+	m_rasterizedTriangles = 0;
+}
+
+/***********************************************************
+ *  RasterizeBox()
+ *
+ *  This method is used for drawing the twelve triangles of a
+ *  box's faces.  Faces of a flat box, such as the box of a
+ *  plane, have no area on the screen and are skipped.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeBox(const glm::mat4& model, glm::vec3 minimum, glm::vec3 maximum)
+{
+	glm::mat4 modelViewProjection = m_viewProjection * model;
+
+	glm::vec4 corners[8];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 position(
+			(corner & 1) ? maximum.x : minimum.x,
+			(corner & 2) ? maximum.y : minimum.y,
+			(corner & 4) ? maximum.z : minimum.z,
+			1.0f);
+		corners[corner] = modelViewProjection * position;
+	}
+
+	for (int i = 0; i < 36; i += 3)
+	{
+		RasterizeClipTriangle(corners[g_BoxTriangles[i]], corners[g_BoxTriangles[i + 1]],
+			corners[g_BoxTriangles[i + 2]]);
+	}
+}
+
+/***********************************************************
+ *  RasterizeClipTriangle()
+ *
+ *  This method is used for cutting away the part of a clip
+ *  space triangle in front of the near plane, where z < -w,
+ *  and drawing what is left.  Cutting one corner off leaves
+ *  four corners, which are drawn as two triangles.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	const glm::vec4 triangle[3] = { a, b, c };
+	glm::vec4 polygon[4];
+	int count = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& from = triangle[i];
+		const glm::vec4& to = triangle[(i + 1) % 3];
+		float fromDistance = from.z + from.w;
+		float toDistance = to.z + to.w;
+
+		if (fromDistance >= 0.0f)
+		{
+			polygon[count++] = from;
+		}
+		if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+		{
+			float t = fromDistance / (fromDistance - toDistance);
+			polygon[count++] = from + (to - from) * t;
+		}
+	}
+	if (count < 3)
+	{
+		return;
+	}
+
+	glm::vec3 screen[4];
+	for (int i = 0; i < count; i++)
+	{
+		if (polygon[i].w <= 0.0f)
+		{
+			return;
+		}
+		glm::vec3 ndc = glm::vec3(polygon[i]) / polygon[i].w;
+		screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z);
+	}
+
+	RasterizeTriangle(screen[0], screen[1], screen[2]);
+	if (count == 4)
+	{
+		RasterizeTriangle(screen[0], screen[2], screen[3]);
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for drawing a triangle into the depth
+ *  buffer.  A pixel is covered when its center is on the
+ *  inner side of all three edges, and keeps the nearer of its
+ *  depth and the triangle's.  The edges and the depth are
+ *  planes in x and y, so each row only adds x terms to the
+ *  values at the start of the row.
+ ***********************************************************/
+void OcclusionBuffer::RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+{
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (std::fabs(area) < MINIMUM_AREA)
+	{
+		return;
+	}
+	// wind every triangle the same way so inside is always positive
+	if (area < 0.0f)
+	{
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	// pixels whose centers are inside the bounds of the triangle
+	int x0 = std::max(0, (int)std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f));
+	int x1 = std::min(m_width - 1, (int)std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f));
+	int y0 = std::max(0, (int)std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f));
+	int y1 = std::min(m_height - 1, (int)std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f));
+	if ((x0 > x1) || (y0 > y1))
+	{
+		return;
+	}
+	m_rasterizedTriangles++;
+
+	// each edge is a * x + b * y + c, positive on the inner side
+	const glm::vec3* vertices[3] = { &v0, &v1, &v2 };
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	for (int edge = 0; edge < 3; edge++)
+	{
+		const glm::vec3& from = *vertices[edge];
+		const glm::vec3& to = *vertices[(edge + 1) % 3];
+		edgeA[edge] = from.y - to.y;
+		edgeB[edge] = to.x - from.x;
+		edgeC[edge] = -(edgeA[edge] * from.x + edgeB[edge] * from.y);
+	}
+
+	float depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	float depthC = v0.z - depthX * v0.x - depthY * v0.y;
+
+	// the rows start on a multiple of four pixels, the width is one
+	int xStart = x0 & ~3;
+
+	for (int y = y0; y <= y1; y++)
+	{
+		float centerY = (float)y + 0.5f;
+		float rowEdge0 = edgeB[0] * centerY + edgeC[0];
+		float rowEdge1 = edgeB[1] * centerY + edgeC[1];
+		float rowEdge2 = edgeB[2] * centerY + edgeC[2];
+		float rowDepth = depthY * centerY + depthC;
+		float* pRow = &m_depth[y * m_width];
+
+#ifdef OCCLUSION_SSE2
+		const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (int x = xStart; x <= x1; x += 4)
+		{
+			__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), offsets);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), centerX), _mm_set1_ps(rowEdge0));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), centerX), _mm_set1_ps(rowEdge1));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), centerX), _mm_set1_ps(rowEdge2));
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+				_mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthX), centerX), _mm_set1_ps(rowDepth));
+			__m128 stored = _mm_loadu_ps(pRow + x);
+			__m128 nearer = _mm_min_ps(stored, depth);
+			_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+		}
+#else
+		for (int x = xStart; x <= x1; x++)
+		{
+			float centerX = (float)x + 0.5f;
+			if ((edgeA[0] * centerX + rowEdge0 >= 0.0f) &&
+				(edgeA[1] * centerX + rowEdge1 >= 0.0f) &&
+				(edgeA[2] * centerX + rowEdge2 >= 0.0f))
+			{
+				float depth = depthX * centerX + rowDepth;
+				pRow[x] = std::min(pRow[x], depth);
+			}
+		}
+#endif
+	}
+}
+
+/***********************************************************
+ *  BuildHierarchy()
+ *
+ *  This method is used for keeping the furthest depth of each
+ *  tile.  A box that is behind a tile's furthest depth is
+ *  hidden in all of the tile without reading its pixels.
+ ***********************************************************/
+void OcclusionBuffer::BuildHierarchy()
+{
+	for (int tileY = 0; tileY < m_tilesY; tileY++)
+	{
+		for (int tileX = 0; tileX < m_tilesX; tileX++)
+		{
+			float furthest = -1.0f;
+			for (int y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; y++)
+			{
+				const float* pRow = &m_depth[y * m_width + tileX * TILE_SIZE];
+				for (int x = 0; x < TILE_SIZE; x++)
+				{
+					furthest = std::max(furthest, pRow[x]);
+				}
+			}
+			m_tileDepth[tileY * m_tilesX + tileX] = furthest;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for testing a world space box against
+ *  the occluders.  The box is replaced by the screen
+ *  rectangle around its corners at the depth of its nearest
+ *  corner, and is visible when that depth is in front of any
+ *  pixel of the rectangle.  Tiles that are entirely in front
+ *  of the box are skipped without reading their pixels.
+ ***********************************************************/
+bool OcclusionBuffer::IsBoxVisible(glm::vec3 minimum, glm::vec3 maximum) const
+{
+	glm::vec2 screenMinimum(1.0f);
+	glm::vec2 screenMaximum(-1.0f);
+	float nearest = 1.0f;
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 clip = m_viewProjection * glm::vec4(
+			(corner & 1) ? maximum.x : minimum.x,
+			(corner & 2) ? maximum.y : minimum.y,
+			(corner & 4) ? maximum.z : minimum.z,
+			1.0f);
+
+		// the rectangle is not bounded once a corner is in front of
+		// the near plane
+		if ((clip.w <= 0.0f) || (clip.z < -clip.w))
+		{
+			return(true);
+		}
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		screenMinimum = glm::min(screenMinimum, glm::vec2(ndc));
+		screenMaximum = glm::max(screenMaximum, glm::vec2(ndc));
+		nearest = std::min(nearest, ndc.z);
+	}
+
+	// boxes off the screen are left to the frustum test
+	if ((screenMaximum.x < -1.0f) || (screenMinimum.x > 1.0f) ||
+		(screenMaximum.y < -1.0f) || (screenMinimum.y > 1.0f))
+	{
+		return(true);
+	}
+
+	int x0 = std::max(0, (int)std::floor((screenMinimum.x * 0.5f + 0.5f) * m_width));
+	int x1 = std::min(m_width - 1, (int)std::floor((screenMaximum.x * 0.5f + 0.5f) * m_width));
+	int y0 = std::max(0, (int)std::floor((screenMinimum.y * 0.5f + 0.5f) * m_height));
+	int y1 = std::min(m_height - 1, (int)std::floor((screenMaximum.y * 0.5f + 0.5f) * m_height));
+
+	float hiddenDepth = nearest - DEPTH_BIAS;
+
+	for (int tileY = y0 / TILE_SIZE; tileY <= y1 / TILE_SIZE; tileY++)
+	{
+		for (int tileX = x0 / TILE_SIZE; tileX <= x1 / TILE_SIZE; tileX++)
+		{
+			if (m_tileDepth[tileY * m_tilesX + tileX] < hiddenDepth)
+			{
+				continue;
+			}
+
+			int pixelX0 = std::max(x0, tileX * TILE_SIZE);
+			int pixelX1 = std::min(x1, (tileX + 1) * TILE_SIZE - 1);
+			int pixelY0 = std::max(y0, tileY * TILE_SIZE);
+			int pixelY1 = std::min(y1, (tileY + 1) * TILE_SIZE - 1);
+			for (int y = pixelY0; y <= pixelY1; y++)
+			{
+				const float* pRow = &m_depth[y * m_width];
+				for (int x = pixelX0; x <= pixelX1; x++)
+				{
+					if (pRow[x] >= hiddenDepth)
+					{
+						return(true);
+					}
+				}
+			}
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetInstructionSetName()
+ *
+ *  This method is used for getting the name of the
+ *  instructions the rows are filled with, for logging.
+ ***********************************************************/
+const char* OcclusionBuffer::GetInstructionSetName()
+{
+#ifdef OCCLUSION_SSE2
+	return("SSE2");
+#else
+	return("scalar");
+#endif
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionbuffer.h
+// ============
+// low resolution depth buffer drawn on the CPU, for skipping hidden draws
+//
+// A few large objects, the occluders, are drawn into a small depth buffer
+// every frame, and the box of every other draw is tested against it before
+// the draw is queued. A box is hidden when its nearest depth is behind the
+// depth stored at every pixel it covers. The buffer is split into tiles that
+// keep the furthest depth in them, so most tests only read the tiles. The
+// rows are filled four pixels at a time with SSE2 when the compiler targets
+// it. Only pixels whose centers an occluder covers are written, which keeps
+// draws seen through the gaps between occluders.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class OcclusionBuffer
+{
+public:
+	// constructor
+	OcclusionBuffer();
+
+	// size of the buffer, rounded up to whole tiles
+	void SetResolution(int width, int height);
+	// the projection * view matrix the occluders and boxes are drawn with
+	void SetViewProjection(const glm::mat4& viewProjection);
+
+	// set every pixel to the far plane
+	void Clear();
+	// draw the faces of a model space box placed by the model matrix -
+	// only for meshes that fill their box, such as boxes and planes
+	void RasterizeBox(const glm::mat4& model, glm::vec3 minimum, glm::vec3 maximum);
+	// keep the furthest depth of each tile, after the occluders are drawn
+	void BuildHierarchy();
+
+	// false if a world space box is behind the occluders everywhere it
+	// covers, boxes crossing the near plane are always visible
+	bool IsBoxVisible(glm::vec3 minimum, glm::vec3 maximum) const;
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	// depth at a pixel, -1 to 1 from the near to the far plane
+	float GetDepth(int x, int y) const { return(m_depth[y * m_width + x]); }
+	// occluder triangles drawn since the last Clear()
+	int GetRasterizedTriangleCount() const { return(m_rasterizedTriangles); }
+	// instructions used to fill the rows, for logging
+	static const char* GetInstructionSetName();
+
+private:
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	glm::mat4 m_viewProjection;
+	// depth of every pixel, row by row from the bottom of the view
+	std::vector<float> m_depth;
+	// furthest depth of every tile
+	std::vector<float> m_tileDepth;
+	int m_rasterizedTriangles;
+
+	// clip a clip space triangle against the near plane and draw it
+	void RasterizeClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+	// draw a triangle with pixel coordinates and depths
+	void RasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+};
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// collect the draws of a frame and sort them to minimise state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	// layout of a sort key, from the most significant bit down
+	//   63      translucent - drawn after every opaque packet
+	//   48-62   program
+	//   32-47   texture slot + 1, 0 for a solid color
+	//   24-31   material ID + 1
+	//   16-23   vertex array
+	//   10-15   mesh
+	//   8-9     detail level
+	//   0-7     mesh flags
+	// translucent packets use their submission order below bit 63
+	const uint64_t g_TranslucentBit = 1ULL << 63;
+
+	uint64_t KeyField(int value, int bits, int shift)
+	{
+		return(((uint64_t)value & ((1ULL << bits) - 1)) << shift);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for building the sort key of a draw
+ *  packet and adding it to the queue.
+ ***********************************************************/
+void RenderQueue::Submit(DRAW_PACKET& packet)
+{
+	if (packet.bTranslucent)
+	{
+		packet.key = g_TranslucentBit | (uint64_t)m_packets.size();
+	}
+	else
+	{
+		packet.key =
+			KeyField((int)packet.program, 15, 48) |
+			KeyField(packet.textureSlot + 1, 16, 32) |
+			KeyField(packet.materialID + 1, 8, 24) |
+			KeyField(packet.vertexArray, 8, 16) |
+			KeyField(packet.mesh, 6, 10) |
+			KeyField(packet.detailLevel, 2, 8) |
+			KeyField((int)packet.meshFlags, 8, 0);
+	}
+
+	m_packets.push_back(packet);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the packets by their keys.
+ *  Packets with equal keys stay in their submission order.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	std::stable_sort(m_packets.begin(), m_packets.end(),
+		[](const DRAW_PACKET& first, const DRAW_PACKET& second)
+		{
+			return(first.key < second.key);
+		});
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the packets.  The
+ *  memory is kept for the next frame.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_packets.clear();
+}
+
+/***********************************************************
+ *  CountStateChanges()
+ *
+ *  This method is used for counting how often the texture,
+ *  material and vertex array change when the packets are
+ *  drawn in their current order.  The first packet counts as
+ *  a change of each.
+ ***********************************************************/
+RenderQueue::STATE_CHANGES RenderQueue::CountStateChanges() const
+{
+	STATE_CHANGES changes = { 0, 0, 0 };
+
+	const DRAW_PACKET* pPrevious = NULL;
+	for (const DRAW_PACKET& packet : m_packets)
+	{
+		if ((NULL == pPrevious) || (packet.textureSlot != pPrevious->textureSlot))
+		{
+			changes.textures++;
+		}
+		if ((NULL == pPrevious) || (packet.materialID != pPrevious->materialID))
+		{
+			changes.materials++;
+		}
+		if ((NULL == pPrevious) || (packet.vertexArray != pPrevious->vertexArray))
+		{
+			changes.vertexArrays++;
+		}
+		pPrevious = &packet;
+	}
+
+	return(changes);
+}
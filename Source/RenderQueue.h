@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// collect the draws of a frame and sort them to minimise state changes
+//
+// Each draw is submitted as a packet holding everything it needs - mesh,
+// texture, material, UV scale and transform. The packets are sorted by a
+// 64-bit key built from the program, texture, material, mesh and detail
+// level, so draws that share state end up next to each other. Translucent
+// draws are kept after the opaque ones and in the order they were submitted,
+// since they blend with whatever was drawn before them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+
+	// everything needed to issue one draw
+	struct DRAW_PACKET
+	{
+		uint64_t key;              // filled in by Submit()
+		unsigned int program;
+		int mesh;                  // which draw call to make
+		int vertexArray;           // draws with the same value share a VAO
+		unsigned int meshFlags;    // parts of the mesh to draw
+		int detailLevel;           // tessellation to draw, 0 is the finest
+		int textureSlot;           // -1 to draw with color instead
+		glm::vec4 color;
+		int materialID;
+		glm::vec2 UVscale;
+		bool bMirrorTexture;
+		bool bTranslucent;
+		glm::mat4 model;
+	};
+
+	// number of times each kind of state changes over a list of packets
+	struct STATE_CHANGES
+	{
+		int textures;
+		int materials;
+		int vertexArrays;
+	};
+
+	// add a packet for this frame, its key is built here
+	void Submit(DRAW_PACKET& packet);
+	// sort the submitted packets by their keys
+	void Sort();
+	// remove all packets, ready for the next frame
+	void Clear();
+
+	// the packets in their current order
+	const std::vector<DRAW_PACKET>& GetPackets() const { return(m_packets); }
+	// state changes needed to draw the packets in their current order
+	STATE_CHANGES CountStateChanges() const;
+
+private:
+	std::vector<DRAW_PACKET> m_packets;
+};
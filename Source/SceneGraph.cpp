@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// retained hierarchy of scene nodes with cached world matrices
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node below the passed in
+ *  parent.  Its world matrix is computed by the next update.
+ *  A parent that does not exist yet is treated as no parent,
+ *  which keeps every parent ahead of its children.
+ ***********************************************************/
+int SceneGraph::AddNode(int parent, const NODE_TRANSFORM& transform)
+{
+	int node = (int)m_parents.size();
+
+	if ((parent < 0) || (parent >= node))
+	{
+		parent = NO_PARENT;
+	}
+
+	m_parents.push_back(parent);
+	m_transforms.Resize(node + 1);
+	m_transforms.Set(node, transform.scale, transform.rotationDegrees, transform.position);
+	m_localMatrices.Resize(node + 1);
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_dirty.push_back(true);
+	m_updated.push_back(false);
+
+	return(node);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_parents.clear();
+	m_transforms.Resize(0);
+	m_localMatrices.Resize(0);
+	m_worldMatrices.clear();
+	m_dirty.clear();
+	m_updated.clear();
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for changing the local transform of a
+ *  node and marking it dirty.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(int node, const NODE_TRANSFORM& transform)
+{
+	if ((node < 0) || (node >= (int)m_parents.size()))
+	{
+		return;
+	}
+
+	m_transforms.Set(node, transform.scale, transform.rotationDegrees, transform.position);
+	m_dirty[node] = true;
+}
+
+/***********************************************************
+ *  SetLocalPosition()
+ *
+ *  This method is used for moving a node relative to its
+ *  parent and marking it dirty.
+ ***********************************************************/
+void SceneGraph::SetLocalPosition(int node, glm::vec3 position)
+{
+	if ((node < 0) || (node >= (int)m_parents.size()))
+	{
+		return;
+	}
+
+	m_transforms.positionX[node] = position.x;
+	m_transforms.positionY[node] = position.y;
+	m_transforms.positionZ[node] = position.z;
+	m_dirty[node] = true;
+}
+
+/***********************************************************
+ *  GetLocalTransform()
+ *
+ *  This method is used for reading back the local transform
+ *  of a node.
+ ***********************************************************/
+SceneGraph::NODE_TRANSFORM SceneGraph::GetLocalTransform(int node) const
+{
+	NODE_TRANSFORM transform;
+	m_transforms.Get(node, transform.scale, transform.rotationDegrees, transform.position);
+
+	return(transform);
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for recomputing the world matrices of
+ *  the dirty nodes.  The local matrices of each run of dirty
+ *  nodes are built in one batch first.  The parents are ahead
+ *  of their children, so one pass over the nodes then sees
+ *  every parent's new matrix before its children, and a node
+ *  is recomputed when it or its parent changed.  Nothing is
+ *  recomputed when no node is dirty.
+ ***********************************************************/
+int SceneGraph::UpdateWorldMatrices()
+{
+	int updatedCount = 0;
+
+	size_t runStart = 0;
+	while (runStart < m_parents.size())
+	{
+		if (!m_dirty[runStart])
+		{
+			runStart++;
+			continue;
+		}
+
+		size_t runEnd = runStart + 1;
+		while ((runEnd < m_parents.size()) && (m_dirty[runEnd]))
+		{
+			runEnd++;
+		}
+		TransformKernel::ComposeTransforms(m_transforms, m_localMatrices, runStart, runEnd - runStart);
+		runStart = runEnd;
+	}
+
+	for (size_t node = 0; node < m_parents.size(); node++)
+	{
+		int parent = m_parents[node];
+		bool bParentUpdated = (parent != NO_PARENT) && (m_updated[parent]);
+
+		m_updated[node] = (m_dirty[node]) || (bParentUpdated);
+		if (!m_updated[node])
+		{
+			continue;
+		}
+
+		if (parent == NO_PARENT)
+		{
+			m_worldMatrices[node] = m_localMatrices.GetMatrix(node);
+		}
+		else
+		{
+			m_worldMatrices[node] = m_worldMatrices[parent] * m_localMatrices.GetMatrix(node);
+		}
+		m_dirty[node] = false;
+		updatedCount++;
+	}
+
+	return(updatedCount);
+}
+
+/***********************************************************
+ *  ComposeTransform()
+ *
+ *  This method is used for building the matrix that scales,
+ *  rotates around X, Y and then Z, and then translates, by
+ *  multiplying glm matrices.
+ ***********************************************************/
+glm::mat4 SceneGraph::ComposeTransform(const NODE_TRANSFORM& transform)
+{
+	glm::mat4 scale = glm::scale(transform.scale);
+	glm::mat4 rotationX = glm::rotate(glm::radians(transform.rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::mat4 rotationY = glm::rotate(glm::radians(transform.rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 rotationZ = glm::rotate(glm::radians(transform.rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 translation = glm::translate(transform.position);
+
+	return(translation * rotationZ * rotationY * rotationX * scale);
+}
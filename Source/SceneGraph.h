@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// retained hierarchy of scene nodes with cached world matrices
+//
+// Each node stores its local scale, rotation and position, relative to its
+// parent. The world matrices are cached, and only recomputed for nodes that
+// were changed since the last update and for everything below them. Nodes
+// are stored in one array with every parent ahead of its children, so the
+// update is a single pass from the front of the array to the back. The local
+// transforms are kept as structures of arrays, so the local matrices of runs
+// of changed nodes are built by the batched TransformKernel.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TransformKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+
+	// a node without a parent is placed in world space
+	static const int NO_PARENT = -1;
+
+	// local transform of a node, the rotations are in degrees
+	struct NODE_TRANSFORM
+	{
+		glm::vec3 scale;
+		glm::vec3 rotationDegrees;
+		glm::vec3 position;
+	};
+
+	// add a node below the passed in parent and return its index - the
+	// parent has to be added first
+	int AddNode(int parent, const NODE_TRANSFORM& transform);
+	// remove every node
+	void Clear();
+
+	// change the local transform of a node, its subtree is updated by
+	// the next UpdateWorldMatrices()
+	void SetLocalTransform(int node, const NODE_TRANSFORM& transform);
+	void SetLocalPosition(int node, glm::vec3 position);
+	NODE_TRANSFORM GetLocalTransform(int node) const;
+
+	// recompute the world matrices of the changed nodes and their
+	// subtrees, returns the number of matrices recomputed
+	int UpdateWorldMatrices();
+	// the world matrix of a node as of the last update
+	const glm::mat4& GetWorldMatrix(int node) const { return(m_worldMatrices[node]); }
+	int GetNodeCount() const { return((int)m_parents.size()); }
+
+	// the matrix for a scale, rotation and position, applied in that order,
+	// built with glm - the reference for the batched kernel
+	static glm::mat4 ComposeTransform(const NODE_TRANSFORM& transform);
+
+private:
+	// node data, indexed by node
+	std::vector<int> m_parents;
+	TransformKernel::TRANSFORM_ARRAYS m_transforms;
+	// local matrices, only rebuilt for dirty nodes
+	TransformKernel::MATRIX_ARRAYS m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+	// true if the node's own transform changed since the last update
+	std::vector<unsigned char> m_dirty;
+	// true if the node's world matrix was recomputed in the current update
+	std::vector<unsigned char> m_updated;
+};
@@ -23,6 +23,15 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -36,10 +45,194 @@
 namespace
 {
 	const char* g_ModelName = "model";
+	const char* g_NormalMatrixName = "normalMatrix";
 	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
+	const char* g_TextureArraysName = "textureArrays";
+	const char* g_TextureArrayName = "textureArray";
+	const char* g_TextureLayerName = "textureLayer";
+	const char* g_MirrorTextureName = "bMirrorTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UVScaleName = "UVscale";
+	const char* g_LightDataBlockName = "LightData";
+	const char* g_MaterialDataBlockName = "MaterialData";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_InstancedName = "bInstanced";
+	const char* g_DecodeOffsetName = "decodeOffset";
+	const char* g_DecodeScaleName = "decodeScale";
+	// distance between the copies of the scene, the width of the room
+	const float g_SceneCopySpacing = 40.0f;
+	// screen heights below which a round mesh is drawn at the next
+	// coarser detail level, and the margin around them a draw has to
+	// cross to change level, so a draw near a size does not flicker
+	const float g_DetailLevelSizes[ShapeMeshes::DETAIL_LEVELS - 1] = { 0.05f, 0.02f };
+	const float g_DetailLevelMargin = 0.15f;
+
+	// true if any pixel of a decoded or cooked image is not fully opaque
+	bool HasTranslucentPixels(const TextureLoader::TEXTURE_IMAGE& image)
+	{
+		if (image.colorChannels != 4)
+		{
+			return(false);
+		}
+
+		if (image.bCompressed)
+		{
+			// each BC3 block starts with its highest and lowest alpha,
+			// so a block is fully opaque only when both are 255
+			if (image.cooked.levels.empty())
+			{
+				return(false);
+			}
+			const std::vector<unsigned char>& blocks = image.cooked.levels[0].blocks;
+			for (size_t i = 0; i + 1 < blocks.size(); i += 16)
+			{
+				if ((blocks[i] != 255) || (blocks[i + 1] != 255))
+				{
+					return(true);
+				}
+			}
+			return(false);
+		}
+
+		size_t byteCount = (size_t)image.width * image.height * 4;
+		for (size_t i = 3; i < byteCount; i += 4)
+		{
+			if (image.pixels[i] != 255)
+			{
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	// true if a packet can be drawn as another instance of the first packet
+	// of a run - instances only differ in transform, UV scale and material
+	bool CanShareInstancedDraw(const RenderQueue::DRAW_PACKET& first, const RenderQueue::DRAW_PACKET& packet)
+	{
+		if ((packet.program != first.program) ||
+			(packet.mesh != first.mesh) ||
+			(packet.meshFlags != first.meshFlags) ||
+			(packet.textureSlot != first.textureSlot) ||
+			(packet.bMirrorTexture != first.bMirrorTexture) ||
+			(packet.bTranslucent != first.bTranslucent))
+		{
+			return(false);
+		}
+		// draws without a texture share the color uniform
+		return((first.textureSlot >= 0) || (packet.color == first.color));
+	}
+
+	// true if a static draw can be baked into the same batch as another,
+	// the UV scale is baked into the texture coordinates
+	bool CanShareStaticBatch(const SceneManager::STATIC_BATCH& batch, const RenderQueue::DRAW_PACKET& packet)
+	{
+		if ((packet.textureSlot != batch.textureSlot) ||
+			(packet.materialID != batch.materialID) ||
+			(packet.bMirrorTexture != batch.bMirrorTexture))
+		{
+			return(false);
+		}
+		// draws without a texture are drawn with the batch color
+		return((batch.textureSlot >= 0) || (packet.color == batch.color));
+	}
+
+	// parts of the shared geometry drawn for a mesh, in the order they
+	// are stored, returns the number of parts
+	int GetSharedMeshParts(int mesh, unsigned int meshFlags, ShapeMeshes::SHARED_MESH parts[3])
+	{
+		int count = 0;
+
+		switch (mesh)
+		{
+		case SceneManager::MESH_BOX:
+			parts[count++] = ShapeMeshes::SHARED_BOX;
+			break;
+		case SceneManager::MESH_CONE:
+			if (meshFlags & SceneManager::MESH_DRAW_BOTTOM)
+			{
+				parts[count++] = ShapeMeshes::SHARED_CONE_BOTTOM;
+			}
+			parts[count++] = ShapeMeshes::SHARED_CONE_SIDES;
+			break;
+		case SceneManager::MESH_CYLINDER:
+			if (meshFlags & SceneManager::MESH_DRAW_BOTTOM)
+			{
+				parts[count++] = ShapeMeshes::SHARED_CYLINDER_BOTTOM;
+			}
+			if (meshFlags & SceneManager::MESH_DRAW_TOP)
+			{
+				parts[count++] = ShapeMeshes::SHARED_CYLINDER_TOP;
+			}
+			if (meshFlags & SceneManager::MESH_DRAW_SIDES)
+			{
+				parts[count++] = ShapeMeshes::SHARED_CYLINDER_SIDES;
+			}
+			break;
+		case SceneManager::MESH_PLANE:
+			parts[count++] = ShapeMeshes::SHARED_PLANE;
+			break;
+		case SceneManager::MESH_PRISM:
+			parts[count++] = ShapeMeshes::SHARED_PRISM;
+			break;
+		case SceneManager::MESH_PYRAMID3:
+			parts[count++] = ShapeMeshes::SHARED_PYRAMID3;
+			break;
+		case SceneManager::MESH_PYRAMID4:
+			parts[count++] = ShapeMeshes::SHARED_PYRAMID4;
+			break;
+		case SceneManager::MESH_SPHERE:
+			parts[count++] = ShapeMeshes::SHARED_SPHERE;
+			break;
+		case SceneManager::MESH_HALF_SPHERE:
+			parts[count++] = ShapeMeshes::SHARED_HALF_SPHERE;
+			break;
+		case SceneManager::MESH_TAPERED_CYLINDER:
+			if (meshFlags & SceneManager::MESH_DRAW_BOTTOM)
+			{
+				parts[count++] = ShapeMeshes::SHARED_TAPERED_CYLINDER_BOTTOM;
+			}
+			if (meshFlags & SceneManager::MESH_DRAW_TOP)
+			{
+				parts[count++] = ShapeMeshes::SHARED_TAPERED_CYLINDER_TOP;
+			}
+			if (meshFlags & SceneManager::MESH_DRAW_SIDES)
+			{
+				parts[count++] = ShapeMeshes::SHARED_TAPERED_CYLINDER_SIDES;
+			}
+			break;
+		case SceneManager::MESH_TORUS:
+			parts[count++] = ShapeMeshes::SHARED_TORUS;
+			break;
+		case SceneManager::MESH_HALF_TORUS:
+			parts[count++] = ShapeMeshes::SHARED_HALF_TORUS;
+			break;
+		case SceneManager::MESH_EXTRA_TORUS1:
+			parts[count++] = ShapeMeshes::SHARED_EXTRA_TORUS1;
+			break;
+		case SceneManager::MESH_EXTRA_TORUS2:
+			parts[count++] = ShapeMeshes::SHARED_EXTRA_TORUS2;
+			break;
+		default:
+			break;
+		}
+
+		return(count);
+	}
+
+	// half meshes are drawn from the vertex array of the whole mesh
+	int GetMeshVertexArray(int mesh)
+	{
+		switch (mesh)
+		{
+		case SceneManager::MESH_HALF_SPHERE:
+			return(SceneManager::MESH_SPHERE);
+		case SceneManager::MESH_HALF_TORUS:
+			return(SceneManager::MESH_TORUS);
+		default:
+			return(mesh);
+		}
+	}
 }
 
 /***********************************************************
@@ -47,18 +240,54 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(ShaderManager *pShaderManager, TextureLoader *pTextureLoader)
 {
 	m_pShaderManager = pShaderManager;
+	m_pTextureLoader = pTextureLoader;
+	m_bOwnsTextureLoader = false;
+	m_textureUploadBytes = 0;
+	m_textureMemoryBytes = 0;
+	m_pLoaderWindow = NULL;
+	m_placeholderTexture = 0;
+	m_renderedFrames = 0;
 	m_basicMeshes = new ShapeMeshes();
 
-	// initialize the texture collection
-	for (auto& textureID : m_textureIDs)
+	m_lightDataUBO = 0;
+	m_materialDataUBO = 0;
+	m_uniformGeneration = 0;
+	ResolveUniformHandles();
+
+	m_unsortedStateChanges = { 0, 0, 0 };
+	m_sortedStateChanges = { 0, 0, 0 };
+	m_bMultiDraw = true;
+	m_drawCalls = 0;
+	m_instancedDrawCalls = 0;
+	m_multiDrawCommands = 0;
+	m_submitMilliseconds = 0.0;
+	m_sceneCopies = 1;
+	m_copyTransform = glm::mat4(1.0f);
+	m_bStaticBatching = true;
+	m_bBuildingScene = false;
+	m_objectNode = SceneGraph::NO_PARENT;
+	m_objectPivot = glm::vec3(0.0f);
+	m_bStaticObject = false;
+	m_bOccluderDraw = false;
+	m_drawNode = SceneGraph::NO_PARENT;
+	m_worldMatrixUpdates = 0;
+	m_bFrustumCulling = true;
+	m_visibleDraws = 0;
+	m_culledDraws = 0;
+	m_hierarchyNodesTested = 0;
+	m_drawItem = -1;
+	m_bOcclusionCulling = true;
+	m_occludedDraws = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_bDetailLevels = true;
+	m_submittedTriangles = 0;
+	for (int level = 0; level < ShapeMeshes::DETAIL_LEVELS; level++)
 	{
-		textureID.tag = "/0"; 
-		textureID.ID = -1;
+		m_detailLevelDraws[level] = 0;
 	}
-	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -72,74 +301,134 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	// wait for the loader thread before freeing what it loaded
+	if (m_loaderThread.joinable())
+	{
+		m_loaderThread.join();
+	}
+	if (m_bOwnsTextureLoader)
+	{
+		delete m_pTextureLoader;
+	}
+	m_pTextureLoader = NULL;
 	// destroy all loaded textures
 	DestroyGLTextures();
+	// free the light uniform buffer
+	if (0 != m_lightDataUBO)
+	{
+		glDeleteBuffers(1, &m_lightDataUBO);
+		m_lightDataUBO = 0;
+	}
+	// free the material uniform buffer
+	if (0 != m_materialDataUBO)
+	{
+		glDeleteBuffers(1, &m_materialDataUBO);
+		m_materialDataUBO = 0;
+	}
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for taking a decoded or cooked texture
+ *  image and assigning it a layer in the texture array that
+ *  matches its size and format.  The image is kept until
+ *  CreateGLTextureArrays() copies it into OpenGL.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(TextureLoader::TEXTURE_IMAGE& image, int textureSlot)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
+	const char* filename = image.filename.c_str();
+	int width = image.width;
+	int height = image.height;
+	int colorChannels = image.colorChannels;
 
-	// if the image was successfully read from the image file
-	if (image)
+	// if the image was successfully read from the image file or the cache
+	if ((image.pixels) || (image.bCompressed))
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels;
+		if (image.bCompressed)
+		{
+			std::cout << ", cooked:" << ((colorChannels == 4) ? "BC3" : "BC1") << ", mips:" << image.cooked.levels.size() << ", read ms:" << image.decodeMilliseconds << std::endl;
+		}
 		else
+		{
+			std::cout << ", decode ms:" << image.decodeMilliseconds << ", mips:" << (image.mipLevels.size() + 1) << ", mip ms:" << image.mipMilliseconds;
+			if (image.cookMilliseconds > 0.0)
+			{
+				std::cout << ", cooked for next launch ms:" << image.cookMilliseconds;
+			}
+			std::cout << std::endl;
+		}
+
+		// only RGB and RGBA (supports transparency) images are handled
+		if ((colorChannels != 3) && (colorChannels != 4))
 		{
 			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+			stbi_image_free(image.pixels);
+			image.pixels = NULL;
 			return false;
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// find the texture array for images of this size and format
+		int arrayIndex = 0;
+		while ((arrayIndex < (int)m_textureArrays.size()) &&
+			((m_textureArrays[arrayIndex].width != width) ||
+			(m_textureArrays[arrayIndex].height != height) ||
+			(m_textureArrays[arrayIndex].colorChannels != colorChannels) ||
+			(m_textureArrays[arrayIndex].bCompressed != image.bCompressed)))
+		{
+			arrayIndex++;
+		}
+
+		// the shader samples a fixed number of texture arrays, so once
+		// they are all in use an image of a new size is stretched into
+		// the array nearest its size
+		if ((arrayIndex == (int)m_textureArrays.size()) && (arrayIndex >= PLACEHOLDER_TEXTURE_ARRAY))
+		{
+			arrayIndex = FitImageToTextureArray(image);
+			if (arrayIndex < 0)
+			{
+				std::cout << "Could not load image:" << filename << ", it needs texture array " << (m_textureArrays.size() + 1)
+					<< " but the shader samples only " << PLACEHOLDER_TEXTURE_ARRAY << ", and none of them holds "
+					<< colorChannels << " channel images" << std::endl;
+				stbi_image_free(image.pixels);
+				image.pixels = NULL;
+				return false;
+			}
+
+			std::cout << "Resized image:" << filename << " from " << width << "x" << height << " to " << image.width << "x" << image.height
+				<< " to share texture array " << arrayIndex << ", all " << PLACEHOLDER_TEXTURE_ARRAY << " texture arrays are in use" << std::endl;
+		}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+		// start a new texture array if this is the first image of its kind
+		if (arrayIndex == (int)m_textureArrays.size())
+		{
+			TEXTURE_ARRAY textureArray;
+			textureArray.ID = 0;
+			textureArray.width = width;
+			textureArray.height = height;
+			textureArray.colorChannels = colorChannels;
+			textureArray.layers = 0;
+			textureArray.bCompressed = image.bCompressed;
+			textureArray.mipLevels = image.bCompressed ? (int)image.cooked.levels.size() : (int)image.mipLevels.size() + 1;
+			m_textureArrays.push_back(textureArray);
+		}
 
 		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+		TEXTURE_INFO& textureInfo = m_textureIDs[textureSlot];
+		textureInfo.tag = image.tag;
+		textureInfo.arrayIndex = arrayIndex;
+		textureInfo.layer = m_textureArrays[arrayIndex].layers++;
+		textureInfo.bTranslucent = HasTranslucentPixels(image);
+
+		// hold on to the image data until the texture arrays are created
+		PENDING_IMAGE pendingImage;
+		pendingImage.pixels = image.pixels;
+		pendingImage.mipLevels = std::move(image.mipLevels);
+		pendingImage.cooked = std::move(image.cooked);
+		pendingImage.textureSlot = textureSlot;
+		m_pendingImages.push_back(std::move(pendingImage));
+		image.pixels = NULL;
 
 		return true;
 	}
@@ -151,284 +440,1771 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 }
 
 /***********************************************************
- *  BindGLTextures()
+ *  FitImageToTextureArray()
+ *
+ *  This method is used for stretching an image of a size that
+ *  has no texture array to the size of the array with the same
+ *  channels that is nearest to it, once every array the shader
+ *  samples is in use.  A cooked image is decoded from its
+ *  source file again, and the stretched image is compressed
+ *  again when the array is block compressed.  The index of the
+ *  array is returned, or -1 if no array holds the image's
+ *  channels.
+ ***********************************************************/
+int SceneManager::FitImageToTextureArray(TextureLoader::TEXTURE_IMAGE& image)
+{
+	// nearest in halvings and doublings of the width and height
+	int arrayIndex = -1;
+	float nearestDistance = FLT_MAX;
+	for (int i = 0; i < (int)m_textureArrays.size(); i++)
+	{
+		const TEXTURE_ARRAY& textureArray = m_textureArrays[i];
+		if (textureArray.colorChannels != image.colorChannels)
+		{
+			continue;
+		}
+
+		float distance = std::fabs(std::log2((float)textureArray.width / (float)image.width)) +
+			std::fabs(std::log2((float)textureArray.height / (float)image.height));
+		if (distance < nearestDistance)
+		{
+			arrayIndex = i;
+			nearestDistance = distance;
+		}
+	}
+	if (arrayIndex < 0)
+	{
+		return(-1);
+	}
+	const TEXTURE_ARRAY& textureArray = m_textureArrays[arrayIndex];
+
+	// block compressed pixels can not be stretched
+	if (image.bCompressed)
+	{
+		image.bCompressed = false;
+		image.cooked.levels.clear();
+		if ((!m_pTextureLoader->DecodeSourceImage(image)) || (image.colorChannels != textureArray.colorChannels))
+		{
+			stbi_image_free(image.pixels);
+			image.pixels = NULL;
+			return(-1);
+		}
+	}
+
+	// a large image is stretched from its smallest mip level that is
+	// still at least the size of the array
+	const unsigned char* source = image.pixels;
+	int sourceWidth = image.width;
+	int sourceHeight = image.height;
+	for (const MipGenerator::MIP_LEVEL& mipLevel : image.mipLevels)
+	{
+		if ((mipLevel.width < textureArray.width) || (mipLevel.height < textureArray.height))
+		{
+			break;
+		}
+		source = mipLevel.pixels.data();
+		sourceWidth = mipLevel.width;
+		sourceHeight = mipLevel.height;
+	}
+
+	std::vector<unsigned char> resized;
+	MipGenerator::ResizeImage(source, sourceWidth, sourceHeight, image.colorChannels,
+		textureArray.width, textureArray.height, resized);
+
+	// the pixels are freed with stbi_image_free(), which calls free()
+	unsigned char* pixels = (unsigned char*)malloc(resized.size());
+	memcpy(pixels, resized.data(), resized.size());
+	stbi_image_free(image.pixels);
+	image.pixels = pixels;
+	image.width = textureArray.width;
+	image.height = textureArray.height;
+	MipGenerator::BuildMipChain(image.pixels, image.width, image.height, image.colorChannels,
+		m_pTextureLoader->GetMipFilter(), image.mipLevels);
+
+	if (textureArray.bCompressed)
+	{
+		TextureCache::CompressTexture(image.pixels, image.width, image.height, image.colorChannels,
+			image.mipLevels, image.cooked);
+		image.bCompressed = true;
+		image.mipLevels.clear();
+		stbi_image_free(image.pixels);
+		image.pixels = NULL;
+	}
+
+	return(arrayIndex);
+}
+
+/***********************************************************
+ *  CreateGLTextureArrays()
+ *
+ *  This method is used for creating an OpenGL texture array
+ *  for each size and format of loaded image and copying the
+ *  images into their layers.  Every mip level is uploaded
+ *  explicitly, built on the CPU for decoded images and read
+ *  from the cache for cooked images.
+ ***********************************************************/
+void SceneManager::CreateGLTextureArrays()
+{
+	for (int arrayIndex = 0; arrayIndex < (int)m_textureArrays.size(); arrayIndex++)
+	{
+		TEXTURE_ARRAY& textureArray = m_textureArrays[arrayIndex];
+		if ((0 != textureArray.ID) || (0 == textureArray.layers))
+		{
+			continue;
+		}
+
+		glGenTextures(1, &textureArray.ID);
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, textureArray.ID);
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		if (textureArray.bCompressed)
+		{
+			// BC1 for RGB images, BC3 for RGBA images
+			GLenum internalFormat = (textureArray.colorChannels == 4) ?
+				GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+			// allocate every layer of every mip level
+			int levelWidth = textureArray.width;
+			int levelHeight = textureArray.height;
+			for (int level = 0; level < textureArray.mipLevels; level++)
+			{
+				int levelSize = TextureCache::GetLevelSize(levelWidth, levelHeight, textureArray.colorChannels);
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat,
+					levelWidth, levelHeight, textureArray.layers,
+					0, levelSize * textureArray.layers, NULL);
+				m_textureMemoryBytes += (size_t)levelSize * textureArray.layers;
+
+				levelWidth = std::max(1, levelWidth / 2);
+				levelHeight = std::max(1, levelHeight / 2);
+			}
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, textureArray.mipLevels - 1);
+
+			// copy each cooked mip chain into its own layer
+			for (auto& pendingImage : m_pendingImages)
+			{
+				const TEXTURE_INFO& textureInfo = m_textureIDs[pendingImage.textureSlot];
+				if (textureInfo.arrayIndex == arrayIndex)
+				{
+					std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+					size_t uploadBytes = 0;
+					for (int level = 0; level < (int)pendingImage.cooked.levels.size(); level++)
+					{
+						const TextureCache::COOKED_LEVEL& cookedLevel = pendingImage.cooked.levels[level];
+						glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, textureInfo.layer,
+							cookedLevel.width, cookedLevel.height, 1,
+							internalFormat, (GLsizei)cookedLevel.blocks.size(), cookedLevel.blocks.data());
+						uploadBytes += cookedLevel.blocks.size();
+					}
+					double uploadMilliseconds = std::chrono::duration<double, std::milli>(
+						std::chrono::steady_clock::now() - uploadStart).count();
+					m_textureUploadBytes += uploadBytes;
+
+					std::cout << "Uploaded texture:" << textureInfo.tag << ", array:" << arrayIndex << ", layer:" << textureInfo.layer << ", bytes:" << uploadBytes << ", upload ms:" << uploadMilliseconds << std::endl;
+				}
+			}
+		}
+		else
+		{
+			GLenum internalFormat = (textureArray.colorChannels == 4) ? GL_RGBA8 : GL_RGB8;
+			GLenum pixelFormat = (textureArray.colorChannels == 4) ? GL_RGBA : GL_RGB;
+
+			// allocate every layer of every mip level
+			int levelWidth = textureArray.width;
+			int levelHeight = textureArray.height;
+			for (int level = 0; level < textureArray.mipLevels; level++)
+			{
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat,
+					levelWidth, levelHeight, textureArray.layers,
+					0, pixelFormat, GL_UNSIGNED_BYTE, NULL);
+				// RGB8 is stored with 4 bytes per texel by most drivers
+				m_textureMemoryBytes += (size_t)levelWidth * levelHeight * 4 * textureArray.layers;
+
+				levelWidth = std::max(1, levelWidth / 2);
+				levelHeight = std::max(1, levelHeight / 2);
+			}
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, textureArray.mipLevels - 1);
+
+			// rows of the small RGB levels are not 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			// copy each image and its mip chain into its own layer
+			for (auto& pendingImage : m_pendingImages)
+			{
+				const TEXTURE_INFO& textureInfo = m_textureIDs[pendingImage.textureSlot];
+				if (textureInfo.arrayIndex == arrayIndex)
+				{
+					std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, textureInfo.layer,
+						textureArray.width, textureArray.height, 1,
+						pixelFormat, GL_UNSIGNED_BYTE, pendingImage.pixels);
+					size_t uploadBytes = (size_t)textureArray.width * textureArray.height * textureArray.colorChannels;
+					for (int level = 1; level <= (int)pendingImage.mipLevels.size(); level++)
+					{
+						const MipGenerator::MIP_LEVEL& mipLevel = pendingImage.mipLevels[level - 1];
+						glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, textureInfo.layer,
+							mipLevel.width, mipLevel.height, 1,
+							pixelFormat, GL_UNSIGNED_BYTE, mipLevel.pixels.data());
+						uploadBytes += mipLevel.pixels.size();
+					}
+					double uploadMilliseconds = std::chrono::duration<double, std::milli>(
+						std::chrono::steady_clock::now() - uploadStart).count();
+					m_textureUploadBytes += uploadBytes;
+
+					std::cout << "Uploaded texture:" << textureInfo.tag << ", array:" << arrayIndex << ", layer:" << textureInfo.layer << ", bytes:" << uploadBytes << ", upload ms:" << uploadMilliseconds << std::endl;
+				}
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		// hand the array to the render thread with a fence that is
+		// signaled once the uploads above have completed
+		LOADED_TEXTURE_ARRAY loadedArray;
+		loadedArray.arrayIndex = arrayIndex;
+		loadedArray.ID = textureArray.ID;
+		for (int slot = 0; slot < (int)m_textureIDs.size(); slot++)
+		{
+			if (m_textureIDs[slot].arrayIndex == arrayIndex)
+			{
+				loadedArray.textureSlots.push_back(slot);
+				loadedArray.textures.push_back(m_textureIDs[slot]);
+			}
+		}
+		loadedArray.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+		{
+			std::lock_guard<std::mutex> lock(m_loadedArraysMutex);
+			m_loadedArrays.push_back(loadedArray);
+		}
+
+		std::cout << "Created texture array " << arrayIndex << ", width:" << textureArray.width << ", height:" << textureArray.height << ", channels:" << textureArray.colorChannels << ", layers:" << textureArray.layers << (textureArray.bCompressed ? ", compressed" : "") << std::endl;
+	}
+
+	// free the image data from local memory
+	for (auto& pendingImage : m_pendingImages)
+	{
+		if (NULL != pendingImage.pixels)
+		{
+			stbi_image_free(pendingImage.pixels);
+		}
+	}
+	m_pendingImages.clear();
+}
+
+/***********************************************************
+ *  CreatePlaceholderTexture()
+ *
+ *  This method is used for creating the small grey texture
+ *  that objects are drawn with until their own texture is
+ *  resident.  It is bound to its own texture unit.
+ ***********************************************************/
+void SceneManager::CreatePlaceholderTexture()
+{
+	if (0 != m_placeholderTexture)
+	{
+		return;
+	}
+
+	const unsigned char placeholderPixels[2 * 2 * 4] = {
+		160, 160, 160, 255,   144, 144, 144, 255,
+		144, 144, 144, 255,   160, 160, 160, 255 };
+
+	glGenTextures(1, &m_placeholderTexture);
+	GLStateCache::ActiveTexture(GL_TEXTURE0 + PLACEHOLDER_TEXTURE_ARRAY);
+	GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, m_placeholderTexture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 2, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderPixels);
+	GLStateCache::ActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  PollLoadedTextures()
+ *
+ *  This method is used for checking the fences of the texture
+ *  arrays handed over by the loader.  Each array that has
+ *  finished uploading is bound to its texture unit and its
+ *  textures replace the placeholder from then on.
+ ***********************************************************/
+void SceneManager::PollLoadedTextures()
+{
+	std::lock_guard<std::mutex> lock(m_loadedArraysMutex);
+	if (m_loadedArrays.empty())
+	{
+		return;
+	}
+
+	auto loadedArray = m_loadedArrays.begin();
+	while (loadedArray != m_loadedArrays.end())
+	{
+		// poll the fence without waiting
+		GLenum status = glClientWaitSync(loadedArray->fence, 0, 0);
+		if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED))
+		{
+			loadedArray++;
+			continue;
+		}
+		glDeleteSync(loadedArray->fence);
+
+		// bind texture arrays on corresponding texture units
+		GLStateCache::ActiveTexture(GL_TEXTURE0 + loadedArray->arrayIndex);
+		GLStateCache::BindTexture(GL_TEXTURE_2D_ARRAY, loadedArray->ID);
+		for (int i = 0; i < (int)loadedArray->textureSlots.size(); i++)
+		{
+			m_residentTextures[loadedArray->textureSlots[i]] = loadedArray->textures[i];
+		}
+
+		std::cout << "Texture array " << loadedArray->arrayIndex << " resident after " << m_renderedFrames << " frames" << std::endl;
+		loadedArray = m_loadedArrays.erase(loadedArray);
+	}
+	GLStateCache::ActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture arrays.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	// fences of arrays that were never polled
+	for (auto& loadedArray : m_loadedArrays)
+	{
+		glDeleteSync(loadedArray.fence);
+	}
+	m_loadedArrays.clear();
+	if (0 != m_placeholderTexture)
+	{
+		GLStateCache::DeleteTextures(1, &m_placeholderTexture);
+		m_placeholderTexture = 0;
+	}
+	for (auto& textureArray : m_textureArrays)
+	{
+		GLStateCache::DeleteTextures(1, &textureArray.ID);
+	}
+	for (auto& pendingImage : m_pendingImages)
+	{
+		if (NULL != pendingImage.pixels)
+		{
+			stbi_image_free(pendingImage.pixels);
+		}
+	}
+	m_textureArrays.clear();
+	m_pendingImages.clear();
+	m_textureIDs.clear();
+	m_residentTextures.clear();
+}
+
+/***********************************************************
+ *  FindTextureSlot()
+ *
+ *  This method is used for getting a slot index for the previously
+ *  loaded texture bitmap associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindTextureSlot(std::string tag)
+{
+	for (int index = 0; index < (int)m_residentTextures.size(); index++)
+	{
+		if (m_residentTextures[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  FindMaterialID()
+ *
+ *  This method is used for getting the ID of a material from
+ *  the previously defined materials list that is associated
+ *  with the passed in tag.  -1 is returned if no material
+ *  with that tag has been defined.
+ ***********************************************************/
+int SceneManager::FindMaterialID(std::string tag)
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  ResolveUniformHandles()
+ *
+ *  This method is used for looking up the locations of the
+ *  uniforms that are set for every draw, so the render path
+ *  never has to look up a uniform by name.
+ ***********************************************************/
+void SceneManager::ResolveUniformHandles()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_uniforms.model = m_pShaderManager->getUniformLocation(g_ModelName);
+	m_uniforms.normalMatrix = m_pShaderManager->getUniformLocation(g_NormalMatrixName);
+	m_uniforms.objectColor = m_pShaderManager->getUniformLocation(g_ColorValueName);
+	m_uniforms.textureArray = m_pShaderManager->getUniformLocation(g_TextureArrayName);
+	m_uniforms.textureLayer = m_pShaderManager->getUniformLocation(g_TextureLayerName);
+	m_uniforms.mirrorTexture = m_pShaderManager->getUniformLocation(g_MirrorTextureName);
+	m_uniforms.useTexture = m_pShaderManager->getUniformLocation(g_UseTextureName);
+	m_uniforms.UVscale = m_pShaderManager->getUniformLocation(g_UVScaleName);
+	m_uniforms.materialIndex = m_pShaderManager->getUniformLocation(g_MaterialIndexName);
+	m_uniforms.instanced = m_pShaderManager->getUniformLocation(g_InstancedName);
+	m_uniforms.decodeOffset = m_pShaderManager->getUniformLocation(g_DecodeOffsetName);
+	m_uniforms.decodeScale = m_pShaderManager->getUniformLocation(g_DecodeScaleName);
+	m_uniformGeneration = m_pShaderManager->GetLinkGeneration();
+
+	// texture array i is always bound to texture unit i
+	for (int i = 0; i < TOTAL_TEXTURE_ARRAYS; i++)
+	{
+		std::string samplerName = std::string(g_TextureArraysName) + "[" + std::to_string(i) + "]";
+		m_pShaderManager->setSampler2DValue(samplerName, i);
+	}
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform of the
+ *  next submitted draw using the passed in values.  While the
+ *  scene is built the transform is stored in a new node below
+ *  the object being recorded, with the position made relative
+ *  to the object's pivot, and the matrix is only computed when
+ *  the node's world matrix is updated.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	SceneGraph::NODE_TRANSFORM transform;
+	transform.scale = scaleXYZ;
+	transform.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	transform.position = positionXYZ;
+
+	if (m_bBuildingScene)
+	{
+		transform.position -= m_objectPivot;
+		m_drawNode = m_sceneGraph.AddNode(m_objectNode, transform);
+	}
+	else
+	{
+		m_drawState.model = m_copyTransform * SceneGraph::ComposeTransform(transform);
+	}
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for drawing the next submitted draw
+ *  with the passed in color instead of a texture.
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	m_drawState.textureSlot = -1;
+	m_drawState.color = currentColor;
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for texturing the next submitted draw
+ *  with the passed in texture slot.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	int textureSlot)
+{
+	if ((textureSlot >= 0) && (textureSlot < (int)m_residentTextures.size()))
+	{
+		m_drawState.textureSlot = textureSlot;
+	}
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture associated
+ *  with the passed in tag into the shader.  The tag is
+ *  searched for on every call, so the render path should
+ *  pass the texture slot directly instead.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	std::string textureTag)
+{
+	SetShaderTexture(FindTextureSlot(textureTag));
+}
+
+/***********************************************************
+ *  SetTextureMirrorRepeat()
+ *
+ *  This method is used for switching the texture sampling
+ *  between repeat and mirrored repeat wrapping.  The texture
+ *  arrays are shared, so the mirroring is done in the shader
+ *  instead of changing the wrap mode of the texture.
+ ***********************************************************/
+void SceneManager::SetTextureMirrorRepeat(
+	bool bMirror)
+{
+	m_drawState.bMirrorTexture = bMirror;
+}
+
+/***********************************************************
+ *  SetOccluder()
+ *
+ *  This method is used for marking the parts recorded next as
+ *  occluders, until it is cleared or the object ends.  Their
+ *  bounding boxes are drawn into the occlusion buffer, so only
+ *  meshes that fill their box, such as walls and boxes, should
+ *  be marked.
+ ***********************************************************/
+void SceneManager::SetOccluder(
+	bool bOccluder)
+{
+	m_bOccluderDraw = bOccluder;
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values of the next submitted draw.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	m_drawState.UVscale = glm::vec2(u, v);
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting the material that the
+ *  shader reads from the material table for the next draw.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	int materialID)
+{
+	if ((materialID >= 0) && (materialID < (int)m_objectMaterials.size()))
+	{
+		m_drawState.materialID = materialID;
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting a material by its tag.
+ *  The tag is resolved to a material ID on every call, so the
+ *  render path should pass the ID directly instead.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	std::string materialTag)
+{
+	SetShaderMaterial(FindMaterialID(materialTag));
+}
+
+/***********************************************************
+ *  SubmitMesh()
+ *
+ *  This method is used for adding a draw of the passed in
+ *  mesh to the render queue, with the state recorded by the
+ *  Set methods.  Nothing is drawn until DrawRenderQueue().
+ *  While the scene is built the draw is retained instead, and
+ *  placed by the node of the last SetTransformations().
+ ***********************************************************/
+void SceneManager::SubmitMesh(int mesh, unsigned int meshParts)
+{
+	RenderQueue::DRAW_PACKET packet = m_drawState;
+	packet.program = m_pShaderManager->m_programID;
+	packet.mesh = mesh;
+	packet.vertexArray = GetMeshVertexArray(mesh);
+	packet.meshFlags = meshParts;
+
+	if (m_bBuildingScene)
+	{
+		RETAINED_DRAW draw;
+		draw.node = m_drawNode;
+		draw.bStatic = m_bStaticObject;
+		draw.bOccluder = m_bOccluderDraw;
+		draw.packet = packet;
+		m_retainedDraws.push_back(draw);
+		return;
+	}
+
+	SubmitPacket(packet);
+}
+
+/***********************************************************
+ *  SubmitPacket()
+ *
+ *  This method is used for adding a packet to the render
+ *  queue.  Whether it is translucent is decided here, since
+ *  that changes when its texture finishes loading.  Draws of
+ *  the scene take their visibility from the frustum query of
+ *  the draw tree, in the order their boxes were gathered.
+ *  The detail level of the packet is picked here as well.
+ ***********************************************************/
+void SceneManager::SubmitPacket(RenderQueue::DRAW_PACKET& packet)
+{
+	// the draws of the scene are numbered in submission order
+	int item = m_drawItem;
+	if (m_drawItem >= 0)
+	{
+		m_drawItem++;
+	}
+
+	if (m_bFrustumCulling)
+	{
+		bool bVisible;
+		if ((item >= 0) && (item < (int)m_drawVisible.size()))
+		{
+			bVisible = (m_drawVisible[item] != 0);
+		}
+		else
+		{
+			bVisible = IsPacketVisible(packet);
+		}
+		if (!bVisible)
+		{
+			m_culledDraws++;
+			return;
+		}
+	}
+	m_visibleDraws++;
+
+	packet.detailLevel = SelectDetailLevel(packet, item);
+	m_detailLevelDraws[packet.detailLevel]++;
+	m_submittedTriangles += GetPacketTriangleCount(packet);
+
+	packet.program = m_pShaderManager->m_programID;
+	if (packet.textureSlot >= 0)
+	{
+		packet.bTranslucent = m_residentTextures[packet.textureSlot].bTranslucent;
+	}
+	else
+	{
+		packet.bTranslucent = (packet.color.a < 1.0f);
+	}
+
+	m_renderQueue.Submit(packet);
+}
+
+/***********************************************************
+ *  IsPacketVisible()
+ *
+ *  This method is used for testing the bounds of a packet's
+ *  mesh, placed by its model matrix, against the view volume.
+ *  The bounding sphere is tested first since it is cheaper,
+ *  and the box is only tested when the sphere passes.  A mesh
+ *  without bounds is always visible.
+ ***********************************************************/
+bool SceneManager::IsPacketVisible(const RenderQueue::DRAW_PACKET& packet) const
+{
+	ShapeMeshes::MESH_BOUNDS bounds;
+	if (!GetPacketMeshBounds(packet.mesh, packet.meshFlags, bounds))
+	{
+		return(true);
+	}
+
+	glm::vec3 center = glm::vec3(packet.model * glm::vec4(bounds.center, 1.0f));
+	if (!m_frustum.IntersectsSphere(center, Frustum::TransformRadius(packet.model, bounds.radius)))
+	{
+		return(false);
+	}
+
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+	Frustum::TransformBox(packet.model, bounds.minimum, bounds.maximum, minimum, maximum);
+	return(m_frustum.IntersectsBox(minimum, maximum));
+}
+
+/***********************************************************
+ *  GetPacketMeshBounds()
+ *
+ *  This method is used for getting the model space bounds of
+ *  the mesh a packet draws.  It returns false when the mesh
+ *  has no bounds, such as a mesh that is not loaded.
+ ***********************************************************/
+bool SceneManager::GetPacketMeshBounds(int mesh, unsigned int meshParts, ShapeMeshes::MESH_BOUNDS& bounds) const
+{
+	if (mesh == MESH_STATIC_BATCH)
+	{
+		bounds = m_basicMeshes->GetStaticBatchBounds((int)meshParts);
+	}
+	else
+	{
+		// every part of a mesh has the bounds of the whole mesh
+		ShapeMeshes::SHARED_MESH parts[3];
+		if (GetSharedMeshParts(mesh, meshParts, parts) == 0)
+		{
+			return(false);
+		}
+		bounds = m_basicMeshes->GetMeshBounds(parts[0]);
+	}
+
+	return(bounds.radius >= 0.0f);
+}
+
+/***********************************************************
+ *  SelectDetailLevel()
+ *
+ *  This method is used for picking the tessellation a packet
+ *  is drawn at from the height of its bounding sphere on the
+ *  screen.  A draw only moves to another level once its size
+ *  is past the margin around the size between the levels, so
+ *  a draw near that size keeps its level instead of popping
+ *  between them.  Only the shared geometry holds the coarser
+ *  levels, so the finest is used without multi-draw calls.
+ ***********************************************************/
+int SceneManager::SelectDetailLevel(const RenderQueue::DRAW_PACKET& packet, int item)
+{
+	if ((!m_bDetailLevels) || (!m_bMultiDraw))
+	{
+		return(0);
+	}
+
+	switch (packet.mesh)
+	{
+	case MESH_CONE:
+	case MESH_CYLINDER:
+	case MESH_SPHERE:
+	case MESH_HALF_SPHERE:
+	case MESH_TORUS:
+	case MESH_HALF_TORUS:
+		break;
+	default:
+		return(0);
+	}
+
+	ShapeMeshes::MESH_BOUNDS bounds;
+	if (!GetPacketMeshBounds(packet.mesh, packet.meshFlags, bounds))
+	{
+		return(0);
+	}
+
+	// the second row of projection * view scales a world length to a
+	// clip space height, and the screen is 2 units high after dividing
+	// by w - so the sphere's diameter over the screen height is this
+	glm::vec3 center = glm::vec3(packet.model * glm::vec4(bounds.center, 1.0f));
+	float radius = Frustum::TransformRadius(packet.model, bounds.radius);
+	glm::vec4 clip = m_viewProjection * glm::vec4(center, 1.0f);
+	if (clip.w <= 0.0f)
+	{
+		return(0);
+	}
+	glm::vec3 heightRow = glm::vec3(m_viewProjection[0][1], m_viewProjection[1][1], m_viewProjection[2][1]);
+	float size = radius * glm::length(heightRow) / clip.w;
+
+	int previous = -1;
+	if (item >= 0)
+	{
+		if (item >= (int)m_drawLevels.size())
+		{
+			m_drawLevels.resize(item + 1, -1);
+		}
+		previous = m_drawLevels[item];
+	}
+
+	// a draw that was coarser than a boundary has to grow past the margin
+	// above it to come back, and a finer one shrink past the margin below
+	int level = 0;
+	for (int boundary = 0; boundary < ShapeMeshes::DETAIL_LEVELS - 1; boundary++)
+	{
+		float limit = g_DetailLevelSizes[boundary];
+		if (previous > boundary)
+		{
+			limit *= 1.0f + g_DetailLevelMargin;
+		}
+		else if (previous >= 0)
+		{
+			limit *= 1.0f - g_DetailLevelMargin;
+		}
+		if (size < limit)
+		{
+			level = boundary + 1;
+		}
+	}
+
+	if (item >= 0)
+	{
+		m_drawLevels[item] = (signed char)level;
+	}
+
+	return(level);
+}
+
+/***********************************************************
+ *  GetPacketTriangleCount()
+ *
+ *  This method is used for counting the triangles a packet
+ *  draws from the shared geometry at its detail level.
+ ***********************************************************/
+int SceneManager::GetPacketTriangleCount(const RenderQueue::DRAW_PACKET& packet) const
+{
+	GLuint indexCount = 0;
+
+	if (packet.mesh == MESH_STATIC_BATCH)
+	{
+		indexCount = m_basicMeshes->GetStaticBatchRange((int)packet.meshFlags).indexCount;
+	}
+	else
+	{
+		ShapeMeshes::SHARED_MESH parts[3];
+		int partCount = GetSharedMeshParts(packet.mesh, packet.meshFlags, parts);
+		for (int part = 0; part < partCount; part++)
+		{
+			indexCount += m_basicMeshes->GetSharedRange(parts[part], packet.detailLevel).indexCount;
+		}
+	}
+
+	return((int)(indexCount / 3));
+}
+
+/***********************************************************
+ *  AddDrawBounds()
+ *
+ *  This method is used for adding the world box of a draw to
+ *  the draw boxes.  A draw without bounds gets a box that no
+ *  plane can be in front of, so it is never culled.
+ ***********************************************************/
+void SceneManager::AddDrawBounds(int mesh, unsigned int meshParts, const glm::mat4& model)
+{
+	BoundingVolumeHierarchy::BOX box;
+	ShapeMeshes::MESH_BOUNDS bounds;
+	if (GetPacketMeshBounds(mesh, meshParts, bounds))
+	{
+		Frustum::TransformBox(model, bounds.minimum, bounds.maximum, box.minimum, box.maximum);
+	}
+	else
+	{
+		box.minimum = glm::vec3(-FLT_MAX);
+		box.maximum = glm::vec3(FLT_MAX);
+	}
+
+	m_drawBounds.push_back(box);
+}
+
+/***********************************************************
+ *  UpdateDrawHierarchy()
+ *
+ *  This method is used for finding which draws of the frame
+ *  are inside the view volume.  The boxes are gathered in the
+ *  order RenderScene() submits the draws.  The tree is only
+ *  rebuilt when the number of draws changes, and only refit
+ *  when nodes of the scene graph moved.
+ ***********************************************************/
+void SceneManager::UpdateDrawHierarchy()
+{
+	bool bBaked = !m_staticBatches.empty();
+
+	size_t movingDraws = 0;
+	for (const RETAINED_DRAW& draw : m_retainedDraws)
+	{
+		if ((!draw.bStatic) || (!bBaked))
+		{
+			movingDraws++;
+		}
+	}
+	size_t drawCount = m_sceneCopies * (m_staticBatches.size() + movingDraws);
+	bool bRebuild = ((int)drawCount != m_drawHierarchy.GetItemCount());
+
+	if ((bRebuild) || (m_worldMatrixUpdates > 0))
+	{
+		m_drawBounds.clear();
+		for (int copy = 0; copy < m_sceneCopies; copy++)
+		{
+			glm::mat4 copyTransform = glm::translate(glm::vec3(g_SceneCopySpacing * copy, 0.0f, 0.0f));
+
+			for (const STATIC_BATCH& batch : m_staticBatches)
+			{
+				AddDrawBounds(MESH_STATIC_BATCH, (unsigned int)batch.batch, copyTransform);
+			}
+			for (const RETAINED_DRAW& draw : m_retainedDraws)
+			{
+				if ((draw.bStatic) && (bBaked))
+				{
+					continue;
+				}
+				AddDrawBounds(draw.packet.mesh, draw.packet.meshFlags,
+					copyTransform * m_sceneGraph.GetWorldMatrix(draw.node));
+			}
+		}
+
+		if (bRebuild)
+		{
+			m_drawHierarchy.Build(m_drawBounds);
+			std::cout << "Draw hierarchy:" << m_drawHierarchy.GetNodeCount() << " nodes over "
+				<< m_drawBounds.size() << " draws" << std::endl;
+		}
+		else
+		{
+			m_drawHierarchy.Refit(m_drawBounds);
+		}
+	}
+
+	m_hierarchyItems.clear();
+	m_hierarchyNodesTested = m_drawHierarchy.QueryFrustum(m_frustum, m_hierarchyItems);
+
+	m_drawVisible.assign(drawCount, 0);
+	for (int item : m_hierarchyItems)
+	{
+		m_drawVisible[item] = 1;
+	}
+
+	if (m_bOcclusionCulling)
+	{
+		CullOccludedDraws();
+	}
+}
+
+/***********************************************************
+ *  CullOccludedDraws()
+ *
+ *  This method is used for drawing the occluders inside the
+ *  view volume into the occlusion buffer, and then testing the
+ *  box of each draw the frustum query found against it.  An
+ *  occluder is tested as well, but never hides itself.  The
+ *  occluders are baked into the static batches, so each is
+ *  tested against the view volume on its own box rather than
+ *  by the item of its batch.
+ ***********************************************************/
+void SceneManager::CullOccludedDraws()
+{
+	m_occlusionBuffer.Clear();
+
+	for (int copy = 0; copy < m_sceneCopies; copy++)
+	{
+		glm::mat4 copyTransform = glm::translate(glm::vec3(g_SceneCopySpacing * copy, 0.0f, 0.0f));
+
+		for (const RETAINED_DRAW& draw : m_retainedDraws)
+		{
+			ShapeMeshes::MESH_BOUNDS bounds;
+			if ((!draw.bOccluder) || (!GetPacketMeshBounds(draw.packet.mesh, draw.packet.meshFlags, bounds)))
+			{
+				continue;
+			}
+
+			// an occluder outside the view volume covers nothing on
+			// the screen, so it is not worth rasterizing
+			glm::mat4 model = copyTransform * m_sceneGraph.GetWorldMatrix(draw.node);
+			glm::vec3 minimum, maximum;
+			Frustum::TransformBox(model, bounds.minimum, bounds.maximum, minimum, maximum);
+			if (m_frustum.IntersectsBox(minimum, maximum))
+			{
+				m_occlusionBuffer.RasterizeBox(model, bounds.minimum, bounds.maximum);
+			}
+		}
+	}
+	m_occlusionBuffer.BuildHierarchy();
+
+	for (int item : m_hierarchyItems)
+	{
+		if (!m_occlusionBuffer.IsBoxVisible(m_drawBounds[item].minimum, m_drawBounds[item].maximum))
+		{
+			m_drawVisible[item] = 0;
+			m_occludedDraws++;
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawRenderQueue()
+ *
+ *  This method is used for sorting the draws submitted this
+ *  frame, so draws sharing a texture, material and mesh are
+ *  next to each other, and then issuing them.  When the shared
+ *  geometry is built the whole frame is one multi-draw call,
+ *  otherwise a run of draws that only differ in transform, UV
+ *  scale and material is issued as one instanced draw.
+ ***********************************************************/
+void SceneManager::DrawRenderQueue()
+{
+	std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+
+	m_unsortedStateChanges = m_renderQueue.CountStateChanges();
+	m_renderQueue.Sort();
+	m_sortedStateChanges = m_renderQueue.CountStateChanges();
+
+	m_drawCalls = 0;
+	m_instancedDrawCalls = 0;
+	m_multiDrawCommands = 0;
+
+	if ((m_bMultiDraw) && (m_basicMeshes->HasSharedGeometry()))
+	{
+		DrawRenderQueueIndirect();
+	}
+	else
+	{
+		const std::vector<RenderQueue::DRAW_PACKET>& packets = m_renderQueue.GetPackets();
+		const RenderQueue::DRAW_PACKET* pPrevious = NULL;
+		size_t first = 0;
+		while (first < packets.size())
+		{
+			size_t last = first + 1;
+			while ((last < packets.size()) && (CanShareInstancedDraw(packets[first], packets[last])))
+			{
+				last++;
+			}
+			int instanceCount = (int)(last - first);
+
+			// the shared state is set from the first packet of the run
+			ApplyDrawPacket(packets[first], pPrevious);
+			m_pShaderManager->setBoolValue(m_uniforms.instanced, instanceCount > 1);
+			if (instanceCount > 1)
+			{
+				m_instances.resize(instanceCount);
+				for (int i = 0; i < instanceCount; i++)
+				{
+					FillInstance(packets[first + i], m_instances[i]);
+				}
+				DrawMeshInstanced(packets[first], &m_instances[0], instanceCount);
+				m_instancedDrawCalls++;
+			}
+			else
+			{
+				DrawMesh(packets[first]);
+			}
+			m_drawCalls++;
+
+			pPrevious = &packets[first];
+			first = last;
+		}
+	}
+
+	m_submitMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - submitStart).count();
+}
+
+/***********************************************************
+ *  DrawRenderQueueIndirect()
+ *
+ *  This method is used for issuing the sorted packets from the
+ *  shared geometry.  Every packet becomes an instance, and each
+ *  run of packets drawing the same mesh parts becomes one
+ *  command reading its instances from its base instance on, so
+ *  the whole frame is drawn with one multi-draw call.  The
+ *  commands are kept in the sorted order, so the translucent
+ *  packets are still drawn last and in submission order.
+ ***********************************************************/
+void SceneManager::DrawRenderQueueIndirect()
+{
+	const std::vector<RenderQueue::DRAW_PACKET>& packets = m_renderQueue.GetPackets();
+
+	m_instances.resize(packets.size());
+	for (size_t i = 0; i < packets.size(); i++)
+	{
+		FillInstance(packets[i], m_instances[i]);
+	}
+
+	m_drawCommands.clear();
+	size_t first = 0;
+	while (first < packets.size())
+	{
+		size_t last = first + 1;
+		while ((last < packets.size()) &&
+			(packets[last].program == packets[first].program) &&
+			(packets[last].mesh == packets[first].mesh) &&
+			(packets[last].meshFlags == packets[first].meshFlags) &&
+			(packets[last].detailLevel == packets[first].detailLevel))
+		{
+			last++;
+		}
+		GLuint instanceCount = (GLuint)(last - first);
+
+		// a static batch is one range, a mesh up to three parts
+		ShapeMeshes::SHARED_RANGE ranges[3];
+		int rangeCount = 0;
+		if (packets[first].mesh == MESH_STATIC_BATCH)
+		{
+			ranges[rangeCount++] = m_basicMeshes->GetStaticBatchRange((int)packets[first].meshFlags);
+		}
+		else
+		{
+			ShapeMeshes::SHARED_MESH parts[3];
+			int partCount = GetSharedMeshParts(packets[first].mesh, packets[first].meshFlags, parts);
+			for (int part = 0; part < partCount; part++)
+			{
+				ranges[rangeCount++] = m_basicMeshes->GetSharedRange(parts[part], packets[first].detailLevel);
+			}
+		}
+
+		size_t runCommands = m_drawCommands.size();
+		for (int index = 0; index < rangeCount; index++)
+		{
+			const ShapeMeshes::SHARED_RANGE& range = ranges[index];
+			if (range.indexCount == 0)
+			{
+				continue;
+			}
+
+			// parts stored next to each other are drawn as one range
+			if (m_drawCommands.size() > runCommands)
+			{
+				ShapeMeshes::DRAW_ELEMENTS_COMMAND& previous = m_drawCommands.back();
+				if ((previous.firstIndex + previous.count == range.firstIndex) &&
+					(previous.baseVertex == range.baseVertex))
+				{
+					previous.count += range.indexCount;
+					continue;
+				}
+			}
+
+			ShapeMeshes::DRAW_ELEMENTS_COMMAND command;
+			command.count = range.indexCount;
+			command.instanceCount = instanceCount;
+			command.firstIndex = range.firstIndex;
+			command.baseVertex = range.baseVertex;
+			command.baseInstance = (GLuint)first;
+			m_drawCommands.push_back(command);
+
+			if (instanceCount > 1)
+			{
+				m_instancedDrawCalls++;
+			}
+		}
+
+		first = last;
+	}
+
+	if (m_drawCommands.empty())
+	{
+		return;
+	}
+
+	m_pShaderManager->setBoolValue(m_uniforms.instanced, true);
+	m_basicMeshes->DrawSharedMeshesIndirect(
+		&m_instances[0], (int)m_instances.size(),
+		&m_drawCommands[0], (int)m_drawCommands.size());
+	m_drawCalls = 1;
+	m_multiDrawCommands = (int)m_drawCommands.size();
+}
+
+/***********************************************************
+ *  FillInstance()
+ *
+ *  This method is used for filling the per-instance data of
+ *  a draw packet.  The placeholder is used while the texture
+ *  is still loading.
+ ***********************************************************/
+void SceneManager::FillInstance(
+	const RenderQueue::DRAW_PACKET& packet,
+	ShapeMeshes::INSTANCE_DATA& instance) const
+{
+	instance.model = packet.model;
+	instance.color = packet.color;
+	instance.UVscale = packet.UVscale;
+	instance.materialIndex = packet.materialID;
+	instance.textureArray = -1;
+	instance.textureLayer = 0;
+	instance.bMirrorTexture = packet.bMirrorTexture ? 1 : 0;
+	instance.decode = GetPacketVertexDecode(packet);
+	instance.normalMatrix = glm::transpose(glm::inverse(glm::mat3(packet.model)));
+
+	if (packet.textureSlot >= 0)
+	{
+		const TEXTURE_INFO& textureInfo = m_residentTextures[packet.textureSlot];
+		bool bResident = (textureInfo.arrayIndex >= 0);
+
+		instance.textureArray = bResident ? textureInfo.arrayIndex : PLACEHOLDER_TEXTURE_ARRAY;
+		instance.textureLayer = bResident ? textureInfo.layer : 0;
+	}
+}
+
+/***********************************************************
+ *  GetPacketVertexDecode()
+ *
+ *  This method is used for getting how the vertices a packet
+ *  is drawn from are decoded.  Static batches and every draw
+ *  of a multi-draw call read the shared geometry, the other
+ *  draws read the full floats of the meshes' own buffers.
+ ***********************************************************/
+ShapeMeshes::VERTEX_DECODE SceneManager::GetPacketVertexDecode(const RenderQueue::DRAW_PACKET& packet) const
+{
+	if (packet.mesh == MESH_STATIC_BATCH)
+	{
+		return(m_basicMeshes->GetSharedVertexDecode(
+			m_basicMeshes->GetStaticBatchRange((int)packet.meshFlags).baseVertex));
+	}
+
+	if ((m_bMultiDraw) && (m_basicMeshes->HasSharedGeometry()))
+	{
+		// the parts of a mesh share its vertices
+		ShapeMeshes::SHARED_MESH parts[3];
+		if (GetSharedMeshParts(packet.mesh, packet.meshFlags, parts) > 0)
+		{
+			return(m_basicMeshes->GetSharedVertexDecode(
+				m_basicMeshes->GetSharedRange(parts[0], packet.detailLevel).baseVertex));
+		}
+	}
+
+	return(ShapeMeshes::GetFullVertexDecode());
+}
+
+/***********************************************************
+ *  ApplyDrawPacket()
+ *
+ *  This method is used for setting the shader uniforms of a
+ *  draw packet.  Only the values that differ from the packet
+ *  drawn before it are sent.  The placeholder is used while
+ *  the texture is still loading.
+ ***********************************************************/
+void SceneManager::ApplyDrawPacket(
+	const RenderQueue::DRAW_PACKET& packet,
+	const RenderQueue::DRAW_PACKET* pPrevious)
+{
+	bool bFirst = (NULL == pPrevious);
+
+	if (packet.textureSlot < 0)
+	{
+		if ((bFirst) || (pPrevious->textureSlot >= 0) || (packet.color != pPrevious->color))
+		{
+			m_pShaderManager->setIntValue(m_uniforms.useTexture, false);
+			m_pShaderManager->setVec4Value(m_uniforms.objectColor, packet.color);
+		}
+	}
+	else if ((bFirst) || (packet.textureSlot != pPrevious->textureSlot))
+	{
+		const TEXTURE_INFO& textureInfo = m_residentTextures[packet.textureSlot];
+		bool bResident = (textureInfo.arrayIndex >= 0);
+
+		m_pShaderManager->setIntValue(m_uniforms.useTexture, true);
+		m_pShaderManager->setIntValue(m_uniforms.textureArray, bResident ? textureInfo.arrayIndex : PLACEHOLDER_TEXTURE_ARRAY);
+		m_pShaderManager->setIntValue(m_uniforms.textureLayer, bResident ? textureInfo.layer : 0);
+	}
+
+	if ((bFirst) || (packet.materialID != pPrevious->materialID))
+	{
+		m_pShaderManager->setIntValue(m_uniforms.materialIndex, packet.materialID);
+	}
+	if ((bFirst) || (packet.UVscale != pPrevious->UVscale))
+	{
+		m_pShaderManager->setVec2Value(m_uniforms.UVscale, packet.UVscale);
+	}
+	if ((bFirst) || (packet.bMirrorTexture != pPrevious->bMirrorTexture))
+	{
+		m_pShaderManager->setBoolValue(m_uniforms.mirrorTexture, packet.bMirrorTexture);
+	}
+	// only the static batches are drawn from the packed shared
+	// geometry here
+	if ((bFirst) || (packet.mesh == MESH_STATIC_BATCH) || (pPrevious->mesh == MESH_STATIC_BATCH))
+	{
+		ShapeMeshes::VERTEX_DECODE decode = GetPacketVertexDecode(packet);
+		m_pShaderManager->setVec4Value(m_uniforms.decodeOffset, decode.offset);
+		m_pShaderManager->setVec4Value(m_uniforms.decodeScale, decode.scale);
+	}
+
+	m_pShaderManager->setMat4Value(m_uniforms.model, packet.model);
+	// the normal matrix is inverted here once per draw, rather than for
+	// every vertex in the shader
+	if ((bFirst) || (packet.model != pPrevious->model))
+	{
+		m_pShaderManager->setMat3Value(m_uniforms.normalMatrix,
+			glm::transpose(glm::inverse(glm::mat3(packet.model))));
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for issuing the draw call of a packet.
+ ***********************************************************/
+void SceneManager::DrawMesh(const RenderQueue::DRAW_PACKET& packet)
+{
+	bool bDrawTop = (packet.meshFlags & MESH_DRAW_TOP) != 0;
+	bool bDrawBottom = (packet.meshFlags & MESH_DRAW_BOTTOM) != 0;
+	bool bDrawSides = (packet.meshFlags & MESH_DRAW_SIDES) != 0;
+
+	switch (packet.mesh)
+	{
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMesh(bDrawBottom);
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_PRISM:
+		m_basicMeshes->DrawPrismMesh();
+		break;
+	case MESH_PYRAMID3:
+		m_basicMeshes->DrawPyramid3Mesh();
+		break;
+	case MESH_PYRAMID4:
+		m_basicMeshes->DrawPyramid4Mesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_HALF_SPHERE:
+		m_basicMeshes->DrawHalfSphereMesh();
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	case MESH_HALF_TORUS:
+		m_basicMeshes->DrawHalfTorusMesh();
+		break;
+	case MESH_EXTRA_TORUS1:
+		m_basicMeshes->DrawExtraTorusMesh1();
+		break;
+	case MESH_EXTRA_TORUS2:
+		m_basicMeshes->DrawExtraTorusMesh2();
+		break;
+	case MESH_STATIC_BATCH:
+		m_basicMeshes->DrawStaticBatch((int)packet.meshFlags);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for issuing one instanced draw call
+ *  for a run of packets with the same mesh and texture.
+ ***********************************************************/
+void SceneManager::DrawMeshInstanced(
+	const RenderQueue::DRAW_PACKET& packet,
+	const ShapeMeshes::INSTANCE_DATA* instances,
+	int instanceCount)
+{
+	bool bDrawTop = (packet.meshFlags & MESH_DRAW_TOP) != 0;
+	bool bDrawBottom = (packet.meshFlags & MESH_DRAW_BOTTOM) != 0;
+	bool bDrawSides = (packet.meshFlags & MESH_DRAW_SIDES) != 0;
+
+	switch (packet.mesh)
+	{
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_CONE:
+		m_basicMeshes->DrawConeMeshInstanced(instances, instanceCount, bDrawBottom);
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMeshInstanced(instances, instanceCount, bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_PRISM:
+		m_basicMeshes->DrawPrismMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_PYRAMID3:
+		m_basicMeshes->DrawPyramid3MeshInstanced(instances, instanceCount);
+		break;
+	case MESH_PYRAMID4:
+		m_basicMeshes->DrawPyramid4MeshInstanced(instances, instanceCount);
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_HALF_SPHERE:
+		m_basicMeshes->DrawHalfSphereMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMeshInstanced(instances, instanceCount, bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_HALF_TORUS:
+		m_basicMeshes->DrawHalfTorusMeshInstanced(instances, instanceCount);
+		break;
+	case MESH_EXTRA_TORUS1:
+		m_basicMeshes->DrawExtraTorusMesh1Instanced(instances, instanceCount);
+		break;
+	case MESH_EXTRA_TORUS2:
+		m_basicMeshes->DrawExtraTorusMesh2Instanced(instances, instanceCount);
+		break;
+	case MESH_STATIC_BATCH:
+		m_basicMeshes->DrawStaticBatchInstanced((int)packet.meshFlags, instances, instanceCount);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetStateChanges()
+ *
+ *  This method is used for getting the texture, material and
+ *  VAO changes of the last frame, in the order the draws were
+ *  submitted and in the sorted order they were drawn in.
+ ***********************************************************/
+void SceneManager::GetStateChanges(
+	RenderQueue::STATE_CHANGES& unsorted,
+	RenderQueue::STATE_CHANGES& sorted) const
+{
+	unsorted = m_unsortedStateChanges;
+	sorted = m_sortedStateChanges;
+}
+
+/***********************************************************
+ *  UploadMaterialTable()
+ *
+ *  This method is used for copying the defined materials into
+ *  the MaterialData uniform buffer, indexed by material ID.
+ ***********************************************************/
+void SceneManager::UploadMaterialTable()
+{
+	MATERIAL_DATA_BLOCK materialTable = {};
+
+	for (int index = 0; (index < (int)m_objectMaterials.size()) && (index < TOTAL_MATERIALS); index++)
+	{
+		materialTable.materials[index].diffuseColor = m_objectMaterials[index].diffuseColor;
+		materialTable.materials[index].specularColor = m_objectMaterials[index].specularColor;
+		materialTable.materials[index].shininess = m_objectMaterials[index].shininess;
+	}
+
+	// create the material uniform buffer the first time through
+	if (0 == m_materialDataUBO)
+	{
+		glGenBuffers(1, &m_materialDataUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_materialDataUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(MATERIAL_DATA_BLOCK), NULL, GL_STATIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_MATERIALS, m_materialDataUBO);
+		m_pShaderManager->SetUniformBlockBinding(g_MaterialDataBlockName, UNIFORM_BLOCK_MATERIALS);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_materialDataUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MATERIAL_DATA_BLOCK), &materialTable);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+/***********************************************************
+ *  QueueSceneTextures()
+ *
+ *  This method is used for listing the texture image files of
+ *  the 3D scene and starting to decode them.  It makes no
+ *  OpenGL calls, so it can be called before the OpenGL
+ *  context exists.  The textures must be queued in the order
+ *  of TEXTURE_ID.
+ ***********************************************************/
+void SceneManager::QueueSceneTextures(TextureLoader* pTextureLoader)
+{
+	if (NULL == pTextureLoader)
+	{
+		return;
+	}
+
+	// walls, trim, floor, and ceiling textures
+	pTextureLoader->QueueImage("textures/floor.png", "floor");
+	pTextureLoader->QueueImage("textures/wallpaper.jpg", "wallpaper");
+	pTextureLoader->QueueImage("textures/ceiling.jpg", "ceiling");
+	// soda textures
+	pTextureLoader->QueueImage("textures/soda1.png", "soda1");
+	pTextureLoader->QueueImage("textures/soda2.png", "soda2"); // red
+	pTextureLoader->QueueImage("textures/sodatop.png", "soda_top");
+	// arcade
+	pTextureLoader->QueueImage("textures/tekken.jpg", "tekken");
+	pTextureLoader->QueueImage("textures/arcade2.png", "arcade2");
+	pTextureLoader->QueueImage("textures/coinslot.png", "coin_slot");
+	pTextureLoader->QueueImage("textures/test2.png", "test"); 
+	pTextureLoader->QueueImage("textures/testt.jpg", "testt");
+	pTextureLoader->QueueImage("textures/yellow.png", "yellow");
+	// lamp
+	pTextureLoader->QueueImage("textures/linen.jpg", "linen");
+	// everything
+	pTextureLoader->QueueImage("textures/leather.jpg", "leather");
+	pTextureLoader->QueueImage("textures/metal2.jpg", "metal2");
+	pTextureLoader->QueueImage("textures/aluminum.png", "aluminum");
+
+	// start decoding in the background
+	pTextureLoader->Start();
+}
+
+/***********************************************************
+ *  SetLoaderContext()
+ *
+ *  This method is used for passing in a hidden window whose
+ *  OpenGL context is shared with the display window.  When
+ *  set, the textures are uploaded on a loader thread through
+ *  that context while the scene is already being rendered.
+ ***********************************************************/
+void SceneManager::SetLoaderContext(GLFWwindow* pLoaderWindow)
+{
+	m_pLoaderWindow = pLoaderWindow;
+}
+
+/***********************************************************
+ *  SetSceneCopies()
+ *
+ *  This method is used for rendering several copies of the
+ *  scene side by side, to measure how the rendering scales
+ *  with the number of objects.
+ ***********************************************************/
+void SceneManager::SetSceneCopies(int copies)
+{
+	m_sceneCopies = (copies < 1) ? 1 : copies;
+}
+
+/***********************************************************
+ *  SetMultiDraw()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for choosing whether the frame is
+ *  drawn from the shared geometry with multi-draw calls.
+ *  The shared geometry is built in PrepareScene(), so this
+ *  has to be set before it is called.
  ***********************************************************/
-void SceneManager::BindGLTextures()
+void SceneManager::SetMultiDraw(bool bMultiDraw)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
+	m_bMultiDraw = bMultiDraw;
 }
 
 /***********************************************************
- *  DestroyGLTextures()
+ *  SetStaticBatching()
  *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  This method is used for choosing whether the objects that
+ *  never move are baked into static batches.  The batches are
+ *  baked in PrepareScene(), so this has to be set before it
+ *  is called.
  ***********************************************************/
-void SceneManager::DestroyGLTextures()
+void SceneManager::SetStaticBatching(bool bStaticBatching)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glDeleteTextures(1, &m_textureIDs[i].ID);
-	}
-	m_loadedTextures = 0; // reset counter if utilized in future changes.
+	m_bStaticBatching = bStaticBatching;
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  SetMeshCache()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for passing the cache the generated
+ *  meshes are mapped from to the basic meshes.  The meshes
+ *  are loaded in PrepareScene(), so this has to be set
+ *  before it is called.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+void SceneManager::SetMeshCache(MeshCache* pMeshCache)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureID);
+	m_basicMeshes->SetMeshCache(pMeshCache);
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  SetVertexFormat()
  *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for choosing the format the shared
+ *  geometry is packed in.  It is built in PrepareScene(), so
+ *  this has to be set before it is called.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+void SceneManager::SetVertexFormat(ShapeMeshes::VERTEX_FORMAT format)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
+	m_basicMeshes->SetSharedVertexFormat(format);
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  SetViewProjection()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for setting the view volume that the
+ *  draws of the next frame are tested against.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+void SceneManager::SetViewProjection(const glm::mat4& viewProjection)
 {
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return(true);
+	m_viewProjection = viewProjection;
+	m_frustum.SetViewProjection(viewProjection);
+	m_occlusionBuffer.SetViewProjection(viewProjection);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  SetFrustumCulling()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for choosing whether the draws outside
+ *  the view volume are skipped.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+void SceneManager::SetFrustumCulling(bool bFrustumCulling)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	m_bFrustumCulling = bFrustumCulling;
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  SetOcclusionCulling()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for choosing whether the draws hidden
+ *  behind the occluders are skipped.  The occluders are only
+ *  drawn for the draws that pass the frustum test, so this
+ *  does nothing while frustum culling is off.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::SetOcclusionCulling(bool bOcclusionCulling)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	m_bOcclusionCulling = bOcclusionCulling;
+}
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+/***********************************************************
+ *  SetDetailLevels()
+ *
+ *  This method is used for choosing whether the round meshes
+ *  are drawn with fewer triangles when they are small on the
+ *  screen.  The levels are kept in the shared geometry, so
+ *  the finest is always drawn without multi-draw calls.
+ ***********************************************************/
+void SceneManager::SetDetailLevels(bool bDetailLevels)
+{
+	m_bDetailLevels = bDetailLevels;
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  LoadSceneTextures()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for preparing the 3D scene by starting
+ *  to load the textures.  Objects are drawn with the placeholder
+ *  texture until their own texture is resident.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+void SceneManager::LoadSceneTextures()
 {
-	if (NULL != m_pShaderManager)
+	// decode the textures now if they were not queued at startup
+	if (NULL == m_pTextureLoader)
+	{
+		m_pTextureLoader = new TextureLoader();
+		m_bOwnsTextureLoader = true;
+		QueueSceneTextures(m_pTextureLoader);
+	}
+
+	CreatePlaceholderTexture();
+
+	// every texture slot exists up front so tags can be found
+	// before the textures are resident
+	m_residentTextures.resize(m_pTextureLoader->GetImageCount());
+	for (int i = 0; i < (int)m_residentTextures.size(); i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		m_residentTextures[i].tag = m_pTextureLoader->GetImageTag(i);
+		m_residentTextures[i].arrayIndex = -1;
+		m_residentTextures[i].layer = 0;
+		m_residentTextures[i].bTranslucent = false;
+	}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+	if (NULL != m_pLoaderWindow)
+	{
+		m_loaderThread = std::thread(&SceneManager::LoadTexturesOnLoaderThread, this);
+	}
+	else
+	{
+		UploadSceneTextures();
+		PollLoadedTextures();
 	}
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  LoadTexturesOnLoaderThread()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is run by the loader thread.  It makes the
+ *  shared context current and uploads the scene textures.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+void SceneManager::LoadTexturesOnLoaderThread()
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	glfwMakeContextCurrent(m_pLoaderWindow);
+	UploadSceneTextures();
+	glfwMakeContextCurrent(NULL);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  UploadSceneTextures()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for collecting the decoded texture
+ *  images, in the order they were queued, and uploading them
+ *  to the texture arrays.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::UploadSceneTextures()
 {
-	if (m_objectMaterials.size() > 0)
+	TextureLoader* pTextureLoader = m_pTextureLoader;
+	m_textureIDs.resize(pTextureLoader->GetImageCount());
+	for (auto& textureInfo : m_textureIDs)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		textureInfo.arrayIndex = -1;
+		textureInfo.layer = 0;
+		textureInfo.bTranslucent = false;
+	}
+
+	// cooked textures are block compressed with S3TC
+	bool bCompressionSupported = (GLEW_EXT_texture_compression_s3tc != 0);
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	double decodeMilliseconds = 0.0;
+	double mipMilliseconds = 0.0;
+	for (int i = 0; i < pTextureLoader->GetImageCount(); i++)
+	{
+		TextureLoader::TEXTURE_IMAGE image;
+		if (pTextureLoader->WaitForImage(i, image))
+		{
+			// fall back to decoding the source file if the cooked
+			// texture can not be used by this OpenGL driver
+			if ((image.bCompressed) && (false == bCompressionSupported))
+			{
+				image.bCompressed = false;
+				image.cooked.levels.clear();
+				pTextureLoader->DecodeSourceImage(image);
+			}
+
+			decodeMilliseconds += image.decodeMilliseconds;
+			mipMilliseconds += image.mipMilliseconds;
+			CreateGLTexture(image, i);
+		}
+		else
 		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			std::cout << "Could not load image:" << image.filename << std::endl;
 		}
 	}
-}
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
 
-/***********************************************************
- *  LoadSceneTextures()
- *
-*  This method is used for preparing the 3D scene by loading
-*  the textures in memory to be used for mapping to objects.
-*  Up to 16 textures can be loaded per scene.
- ***********************************************************/
-void SceneManager::LoadSceneTextures()
-{
-	bool bReturn = false;
-	// load the textures from image files
-	// walls, trim, floor, and ceiling textures
-	bReturn = CreateGLTexture("textures/floor.png", "floor");
-	bReturn = CreateGLTexture("textures/wallpaper.jpg", "wallpaper");
-	bReturn = CreateGLTexture("textures/ceiling.jpg", "ceiling");
-	// soda textures
-	bReturn = CreateGLTexture("textures/soda1.png", "soda1");
-	bReturn = CreateGLTexture("textures/soda2.png", "soda2"); // red
-	bReturn = CreateGLTexture("textures/sodatop.png", "soda_top");
-	// arcade
-	bReturn = CreateGLTexture("textures/tekken.jpg", "tekken");
-	bReturn = CreateGLTexture("textures/arcade2.png", "arcade2");
-	bReturn = CreateGLTexture("textures/coinslot.png", "coin_slot");
-	bReturn = CreateGLTexture("textures/test2.png", "test"); 
-	bReturn = CreateGLTexture("textures/testt.jpg", "testt");
-	bReturn = CreateGLTexture("textures/yellow.png", "yellow");
-	// lamp
-	bReturn = CreateGLTexture("textures/linen.jpg", "linen");
-	// everything
-	bReturn = CreateGLTexture("textures/leather.jpg", "leather");
-	bReturn = CreateGLTexture("textures/metal2.jpg", "metal2");
-	bReturn = CreateGLTexture("textures/aluminum.png", "aluminum");
-	// after texture image data is loaded, they need to be bound to texture slots.
-	BindGLTextures();
+	// after texture image data is loaded, it is copied into the texture
+	// arrays, which are bound to texture units once they are resident
+	std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+	CreateGLTextureArrays();
+	double uploadMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - uploadStart).count();
+
+	std::cout << "Texture decode ms:" << decodeMilliseconds
+		<< " (wall ms:" << pTextureLoader->GetDecodeWallMilliseconds()
+		<< " on " << pTextureLoader->GetThreadCount() << " threads)"
+		<< ", waited ms:" << pTextureLoader->GetWaitMilliseconds()
+		<< ", mip ms:" << mipMilliseconds
+		<< " (" << MipGenerator::GetFilterName(pTextureLoader->GetMipFilter())
+		<< ", " << MipGenerator::GetInstructionSetName() << ")"
+		<< ", upload ms:" << uploadMilliseconds
+		<< ", upload bytes:" << m_textureUploadBytes
+		<< ", texture memory bytes:" << m_textureMemoryBytes << std::endl;
 }
 
 /***********************************************************
@@ -448,126 +2224,134 @@ void SceneManager::DefineObjectMaterials()
 	 * High is a small/tight highlight area, like glass.
 	 */
 
+	// every material is stored at the index of its MATERIAL_ID so
+	// the render code can select it without a lookup
+	m_objectMaterials.clear();
+	m_objectMaterials.resize(MATERIAL_COUNT);
+
 	// floor
 	OBJECT_MATERIAL floorMaterial;
 	floorMaterial.diffuseColor = glm::vec3(0.13f, 0.13f, 0.13f); //.23 before
 	floorMaterial.specularColor = glm::vec3(0.06f, 0.06f, 0.06f); //0.06
 	floorMaterial.shininess = 8.0;
 	floorMaterial.tag = "floor";
-	m_objectMaterials.push_back(floorMaterial);
+	m_objectMaterials[MATERIAL_FLOOR] = floorMaterial;
 	// wallpaper
 	OBJECT_MATERIAL wallMaterial;
 	wallMaterial.diffuseColor = glm::vec3(0.45f, 0.45f, 0.45f);
 	wallMaterial.specularColor = glm::vec3(0.15f, 0.15f, 0.15f);
 	wallMaterial.shininess = 32.0;
 	wallMaterial.tag = "wallpaper";
-	m_objectMaterials.push_back(wallMaterial);
+	m_objectMaterials[MATERIAL_WALLPAPER] = wallMaterial;
 	// ceiling
 	OBJECT_MATERIAL ceilingMaterial;
 	ceilingMaterial.diffuseColor = glm::vec3(0.45f, 0.45f, 0.45f);
 	ceilingMaterial.specularColor = glm::vec3(0.12f, 0.12f, 0.12f);
 	ceilingMaterial.shininess = 8.0;
 	ceilingMaterial.tag = "ceiling";
-	m_objectMaterials.push_back(ceilingMaterial);
+	m_objectMaterials[MATERIAL_CEILING] = ceilingMaterial;
 	// soda1 (body)
 	OBJECT_MATERIAL soda1Material;
 	soda1Material.diffuseColor = glm::vec3(0.75f, 0.75f, 0.75f);
 	soda1Material.specularColor = glm::vec3(0.72f, 0.72f, 0.72f);
 	soda1Material.shininess = 64.0;
 	soda1Material.tag = "soda1";
-	m_objectMaterials.push_back(soda1Material);
+	m_objectMaterials[MATERIAL_SODA1] = soda1Material;
 	// soda2 (red body extended)
 	OBJECT_MATERIAL soda2Material;
 	soda2Material.diffuseColor = glm::vec3(0.75f, 0.75f, 0.75f);
 	soda2Material.specularColor = glm::vec3(0.72f, 0.72f, 0.72f);
 	soda2Material.shininess = 64.0;
 	soda2Material.tag = "soda2";
-	m_objectMaterials.push_back(soda2Material);
+	m_objectMaterials[MATERIAL_SODA2] = soda2Material;
 	// soda top (aluminum)
 	OBJECT_MATERIAL sodaTopMaterial;
 	sodaTopMaterial.diffuseColor = glm::vec3(0.25f, 0.25f, 0.25f);
 	sodaTopMaterial.specularColor = glm::vec3(0.15f, 0.15f, 0.15f);
 	sodaTopMaterial.shininess = 90.0;
 	sodaTopMaterial.tag = "soda_top";
-	m_objectMaterials.push_back(sodaTopMaterial);
+	m_objectMaterials[MATERIAL_SODA_TOP] = sodaTopMaterial;
 	// tekken arcade screen
 	OBJECT_MATERIAL tekkenMaterial;
 	tekkenMaterial.diffuseColor = glm::vec3(0.8f, 0.8f, 0.8f);
 	tekkenMaterial.specularColor = glm::vec3(0.8f, 0.8f, 0.8f);
 	tekkenMaterial.shininess = 256.0;
 	tekkenMaterial.tag = "tekken";
-	m_objectMaterials.push_back(tekkenMaterial);
+	m_objectMaterials[MATERIAL_TEKKEN] = tekkenMaterial;
 	// arcade2 is the dark plain body color for arcade
 	OBJECT_MATERIAL arcade2Material;
 	arcade2Material.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
 	arcade2Material.specularColor = glm::vec3(0.4f, 0.4f, 0.4f);
 	arcade2Material.shininess = 32.0;
 	arcade2Material.tag = "arcade2";
-	m_objectMaterials.push_back(arcade2Material);
+	m_objectMaterials[MATERIAL_ARCADE2] = arcade2Material;
 	//coin_slot on arcade machine front
 	OBJECT_MATERIAL coinslotMaterial;
 	coinslotMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
 	coinslotMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
 	coinslotMaterial.shininess = 32.0;
 	coinslotMaterial.tag = "coin_slot";
-	m_objectMaterials.push_back(coinslotMaterial);
+	m_objectMaterials[MATERIAL_COIN_SLOT] = coinslotMaterial;
 	// tekken logo 'test'
 	OBJECT_MATERIAL testMaterial;
 	testMaterial.diffuseColor = glm::vec3(0.6f, 0.6f, 0.6f);
 	testMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
 	testMaterial.shininess = 64.0;
 	testMaterial.tag = "test";
-	m_objectMaterials.push_back(testMaterial);
+	m_objectMaterials[MATERIAL_TEST] = testMaterial;
 	// tekken fighter logo 'testt'
 	OBJECT_MATERIAL testtMaterial;
 	testtMaterial.diffuseColor = glm::vec3(0.6f, 0.6f, 0.6f);
 	testtMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
 	testtMaterial.shininess = 64.0;
 	testtMaterial.tag = "testt";
-	m_objectMaterials.push_back(testtMaterial);
+	m_objectMaterials[MATERIAL_TESTT] = testtMaterial;
 	// arcade yellow buttons
 	OBJECT_MATERIAL yellowMaterial;
 	yellowMaterial.diffuseColor = glm::vec3(0.75f, 0.75f, 0.75f);
 	yellowMaterial.specularColor = glm::vec3(0.72f, 0.72f, 0.72f);
 	yellowMaterial.shininess = 64.0;
 	yellowMaterial.tag = "yellow";
-	m_objectMaterials.push_back(yellowMaterial);
+	m_objectMaterials[MATERIAL_YELLOW] = yellowMaterial;
 	// linen lamp shade
 	OBJECT_MATERIAL linenMaterial;
 	linenMaterial.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);
 	linenMaterial.specularColor = glm::vec3(0.10f, 0.10f, 0.10f);
 	linenMaterial.shininess = 8.0;
 	linenMaterial.tag = "linen";
-	m_objectMaterials.push_back(linenMaterial);
+	m_objectMaterials[MATERIAL_LINEN] = linenMaterial;
 	// leather seat + lamp body (some reflection)
 	OBJECT_MATERIAL leatherMaterial;
 	leatherMaterial.diffuseColor = glm::vec3(0.8f, 0.8f, 0.8f);
 	leatherMaterial.specularColor = glm::vec3(0.25f, 0.25f, 0.25f);
 	leatherMaterial.shininess = 16.0;
 	leatherMaterial.tag = "leather";
-	m_objectMaterials.push_back(leatherMaterial);
+	m_objectMaterials[MATERIAL_LEATHER] = leatherMaterial;
 	// metal 2 (part of lamp body + stool legs
 	OBJECT_MATERIAL metal2Material;
 	metal2Material.diffuseColor = glm::vec3(0.8f, 0.8f, 0.8f);
 	metal2Material.specularColor = glm::vec3(0.25f, 0.25f, 0.25f);
 	metal2Material.shininess = 32.0;
 	metal2Material.tag = "metal2";
-	m_objectMaterials.push_back(metal2Material);
+	m_objectMaterials[MATERIAL_METAL2] = metal2Material;
 	// aluminum for can + lamp
 	OBJECT_MATERIAL aluminumMaterial;
 	aluminumMaterial.diffuseColor = glm::vec3(0.25f, 0.25f, 0.25f);
 	aluminumMaterial.specularColor = glm::vec3(0.15f, 0.15f,0.15f);
 	aluminumMaterial.shininess = 90.0;
 	aluminumMaterial.tag = "aluminum";
-	m_objectMaterials.push_back(aluminumMaterial);
+	m_objectMaterials[MATERIAL_ALUMINUM] = aluminumMaterial;
 
+	// copy the materials into the shader material table
+	UploadMaterialTable();
 }
 
 /***********************************************************
  *  SetupSceneLights()
  *
  *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  sources for the 3D scene.  There are up to 5 point lights,
+ *  one directional light and the flashlight spot light.
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
@@ -577,35 +2361,39 @@ void SceneManager::SetupSceneLights()
 	// default OpenGL lighting then comment out the following line
 	m_pShaderManager->setBoolValue(g_UseLightingName, true);
 
+	// all of the light sources are collected into the LightData
+	// block and uploaded to the uniform buffer in one update
+	LIGHT_DATA_BLOCK lights = {};
+
 	// Directional light setup (global ambient light, can add a tiny bit of diffuse to brighten scene)
-	/*m_pShaderManager->setVec3Value("directionalLight.direction", -0.05f, -0.3f, -0.1f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.30f, 0.30f, 0.30f); 
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);*/
+	/*lights.directionalLight.position = glm::vec3(-0.05f, -0.3f, -0.1f);
+	lights.directionalLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.directionalLight.diffuse = glm::vec3(0.30f, 0.30f, 0.30f); 
+	lights.directionalLight.specular = glm::vec3(0.0f, 0.0f, 0.0f);
+	lights.directionalLight.bActive = true;*/
 	// I think the shadows look better without it.
 
 	// Point light 1 for light bulb (white/yellow) -- Left side of bulb
-	m_pShaderManager->setVec3Value("pointLights[0].position", 14.0f, 17.0f, -5.5f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.25f, 0.25f, 0.25f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 3.0f,3.0f,2.7f); //warm yellow/white
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 1.0f, 1.0f, 1.0f); // white highlights
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
+	lights.pointLights[0].position = glm::vec3(14.0f, 17.0f, -5.5f);
+	lights.pointLights[0].ambient = glm::vec3(0.25f, 0.25f, 0.25f);
+	lights.pointLights[0].diffuse = glm::vec3(3.0f,3.0f,2.7f); //warm yellow/white
+	lights.pointLights[0].specular = glm::vec3(1.0f, 1.0f, 1.0f); // white highlights
+	lights.pointLights[0].bActive = true;
 
 	// Point light 2 for light bulb -- right side of bulb 
-	m_pShaderManager->setVec3Value("pointLights[1].position", 16.0f, 17.0f, -5.5f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.25f, 0.25f, 0.25f); //0.25
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 3.0f, 3.0f, 2.7f); // 1.5 (test out: 1.5 to 2.0,2.0,1.9
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 1.0f, 1.0f, 1.0f); // white
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
+	lights.pointLights[1].position = glm::vec3(16.0f, 17.0f, -5.5f);
+	lights.pointLights[1].ambient = glm::vec3(0.25f, 0.25f, 0.25f); //0.25
+	lights.pointLights[1].diffuse = glm::vec3(3.0f, 3.0f, 2.7f); // 1.5 (test out: 1.5 to 2.0,2.0,1.9
+	lights.pointLights[1].specular = glm::vec3(1.0f, 1.0f, 1.0f); // white
+	lights.pointLights[1].bActive = true;
 
 
 	// Point Light for arcade screen (blue/purple)
-	m_pShaderManager->setVec3Value("pointLights[2].position", 0.0f, 20.0f, -4.3f);
-	m_pShaderManager->setVec3Value("pointLights[2].ambient", 0.15f, 0.15f, 0.15f);
-	m_pShaderManager->setVec3Value("pointLights[2].diffuse", 0.90f, 0.50f, 2.0f);
-	m_pShaderManager->setVec3Value("pointLights[2].specular", 0.80f, 0.65f, 1.0f);
-	m_pShaderManager->setBoolValue("pointLights[2].bActive", true);
+	lights.pointLights[2].position = glm::vec3(0.0f, 20.0f, -4.3f);
+	lights.pointLights[2].ambient = glm::vec3(0.15f, 0.15f, 0.15f);
+	lights.pointLights[2].diffuse = glm::vec3(0.90f, 0.50f, 2.0f);
+	lights.pointLights[2].specular = glm::vec3(0.80f, 0.65f, 1.0f);
+	lights.pointLights[2].bActive = true;
 
 
 	// Could change the spotlight to an overhead light on a ceiling fan - toggle with lmb or a key.
@@ -614,14 +2402,29 @@ void SceneManager::SetupSceneLights()
 	 * Position, direction, and bActive are all updated in ViewManager
 	 * Controlled by LMB (left mouse button) to toggle on/off
 	 */
-	m_pShaderManager->setVec3Value("spotLight.ambient", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setVec3Value("spotLight.diffuse", 2.3f, 2.3f, 2.0f);
-	m_pShaderManager->setVec3Value("spotLight.specular", 1.6f, 1.6f, 1.6f);
-	m_pShaderManager->setFloatValue("spotLight.constant", 1.0f);
-	m_pShaderManager->setFloatValue("spotLight.linear", 0.007f); // distance of 600
-	m_pShaderManager->setFloatValue("spotLight.quadratic", 0.0002f); // ^
-	m_pShaderManager->setFloatValue("spotLight.cutOff", glm::cos(glm::radians(25.0f)));
-	m_pShaderManager->setFloatValue("spotLight.outerCutOff", glm::cos(glm::radians(35.0f)));
+	lights.spotLight.ambient = glm::vec3(0.8f, 0.8f, 0.8f);
+	lights.spotLight.diffuse = glm::vec3(2.3f, 2.3f, 2.0f);
+	lights.spotLight.specular = glm::vec3(1.6f, 1.6f, 1.6f);
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.linear = 0.007f; // distance of 600
+	lights.spotLight.quadratic = 0.0002f; // ^
+	lights.spotLight.cutOff = glm::cos(glm::radians(25.0f));
+	lights.spotLight.outerCutOff = glm::cos(glm::radians(35.0f));
+
+	// create the light uniform buffer the first time through
+	if (0 == m_lightDataUBO)
+	{
+		glGenBuffers(1, &m_lightDataUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_lightDataUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LIGHT_DATA_BLOCK), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_LIGHTS, m_lightDataUBO);
+		m_pShaderManager->SetUniformBlockBinding(g_LightDataBlockName, UNIFORM_BLOCK_LIGHTS);
+	}
+
+	// upload all of the light sources with a single buffer update
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightDataUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LIGHT_DATA_BLOCK), &lights);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 /***********************************************************
@@ -633,7 +2436,7 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	// load the textures for the scene
+	// start loading the textures for the scene
 	LoadSceneTextures();
 	// define the materials for objects in the scene
 	DefineObjectMaterials();
@@ -642,7 +2445,9 @@ void SceneManager::PrepareScene()
 
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	// in the rendered 3D scene - the meshes are generated
+	// together on worker threads, and only uploaded here
+	m_basicMeshes->BeginMeshLoading();
 
 	m_basicMeshes->LoadPlaneMesh();
 	m_basicMeshes->LoadTaperedCylinderMesh();
@@ -653,22 +2458,360 @@ void SceneManager::PrepareScene()
 	//customized Torus, I lowered the radius to make it thinner
 	//and lowered segments as well since it's such a small part repeated
 	m_basicMeshes->LoadTorusMesh(1, 0.06f, 24, 8);
+
+	// the round meshes again with half the segments at each coarser
+	// level, drawn in their place when they are small on the screen
+	for (int level = 1; level < ShapeMeshes::DETAIL_LEVELS; level++)
+	{
+		int divisor = 1 << level;
+		m_basicMeshes->LoadCylinderMesh(1.0f, 1.0f, 36 / divisor, level);
+		m_basicMeshes->LoadSphereMesh(std::max(4, 16 / divisor), std::max(4, 16 / divisor), 1.0f, level);
+		m_basicMeshes->LoadTorusMesh(1, 0.06f, std::max(6, 24 / divisor), std::max(3, 8 / divisor), level);
+	}
+	m_basicMeshes->FinishMeshLoading();
+
+	// record the objects of the scene once, their transforms are kept
+	// in the scene graph and only recomputed when a node moves
+	BuildScene();
+
+	// the objects that never move are transformed into world space
+	// once, and merged into batches sharing their texture and material
+	if (m_bStaticBatching)
+	{
+		BakeStaticGeometry();
+	}
+
+	// pack the meshes and batches into one buffer, so each frame can be
+	// drawn with a single multi-draw call where OpenGL 4.3 is available
+	m_bMultiDraw = (m_bMultiDraw) && (GLEW_VERSION_4_3);
+	if (!m_basicMeshes->BuildSharedGeometry())
+	{
+		m_bMultiDraw = false;
+		m_staticBatches.clear();
+	}
 }
 
 /***********************************************************
- *  RenderScene()
+ *  BakeStaticGeometry()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for baking the retained draws of the
+ *  objects that never move into static batches.  The
+ *  vertices of each draw are transformed into world space,
+ *  with the normals transformed by the inverse transpose of
+ *  the model matrix, and the UV scale is applied to the
+ *  texture coordinates.  Draws with the same texture, material
+ *  and color are merged into one batch.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::BakeStaticGeometry()
+{
+	std::vector<std::vector<GLfloat>> batchVertices;
+	std::vector<std::vector<GLuint>> batchIndices;
+	std::vector<GLfloat> partVertices;
+	std::vector<GLuint> partIndices;
+
+	m_staticBatches.clear();
+	m_staticPackets.clear();
+
+	// the static draws are placed by their world matrices
+	for (const RETAINED_DRAW& draw : m_retainedDraws)
+	{
+		if (draw.bStatic)
+		{
+			m_staticPackets.push_back(draw.packet);
+			m_staticPackets.back().model = m_sceneGraph.GetWorldMatrix(draw.node);
+		}
+	}
+
+	for (const RenderQueue::DRAW_PACKET& packet : m_staticPackets)
+	{
+		// find the batch sharing the surface of this draw
+		size_t batchIndex = 0;
+		while ((batchIndex < m_staticBatches.size()) && (!CanShareStaticBatch(m_staticBatches[batchIndex], packet)))
+		{
+			batchIndex++;
+		}
+		if (batchIndex == m_staticBatches.size())
+		{
+			STATIC_BATCH batch;
+			batch.batch = -1;
+			batch.textureSlot = packet.textureSlot;
+			batch.color = packet.color;
+			batch.materialID = packet.materialID;
+			batch.bMirrorTexture = packet.bMirrorTexture;
+			m_staticBatches.push_back(batch);
+			batchVertices.emplace_back();
+			batchIndices.emplace_back();
+		}
+		std::vector<GLfloat>& vertices = batchVertices[batchIndex];
+		std::vector<GLuint>& indices = batchIndices[batchIndex];
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(packet.model)));
+
+		ShapeMeshes::SHARED_MESH parts[3];
+		int partCount = GetSharedMeshParts(packet.mesh, packet.meshFlags, parts);
+		for (int part = 0; part < partCount; part++)
+		{
+			if (!m_basicMeshes->GetSharedTriangles(parts[part], partVertices, partIndices))
+			{
+				continue;
+			}
+
+			GLuint firstVertex = (GLuint)(vertices.size() / 8);
+			for (size_t i = 0; i < partVertices.size(); i += 8)
+			{
+				glm::vec3 position = glm::vec3(packet.model * glm::vec4(partVertices[i], partVertices[i + 1], partVertices[i + 2], 1.0f));
+				glm::vec3 normal = normalMatrix * glm::vec3(partVertices[i + 3], partVertices[i + 4], partVertices[i + 5]);
+				if (glm::length(normal) > 0.0f)
+				{
+					normal = glm::normalize(normal);
+				}
+				glm::vec2 uv = glm::vec2(partVertices[i + 6], partVertices[i + 7]) * packet.UVscale;
+
+				vertices.insert(vertices.end(), {
+					position.x, position.y, position.z,
+					normal.x, normal.y, normal.z,
+					uv.x, uv.y });
+			}
+			for (GLuint index : partIndices)
+			{
+				indices.push_back(firstVertex + index);
+			}
+		}
+	}
+
+	// batches left empty by meshes that are not loaded are dropped
+	size_t kept = 0;
+	for (size_t i = 0; i < m_staticBatches.size(); i++)
+	{
+		m_staticBatches[i].batch = m_basicMeshes->AddStaticBatch(batchVertices[i], batchIndices[i]);
+		if (m_staticBatches[i].batch >= 0)
+		{
+			m_staticBatches[kept++] = m_staticBatches[i];
+		}
+	}
+	m_staticBatches.resize(kept);
+
+	std::cout << "Static geometry:" << m_staticPackets.size() << " draws baked into "
+		<< m_staticBatches.size() << " batches" << std::endl;
+}
+
+/***********************************************************
+ *  BuildScene()
+ *
+ *  This method is used for recording the scene once.  The
+ *  Render methods add a node for every part and retain its
+ *  draw, and each object gets a node of its own that its parts
+ *  are placed under.
+ ***********************************************************/
+void SceneManager::BuildScene()
 {
-	// render objects in the scene
+	SceneGraph::NODE_TRANSFORM rootTransform;
+	rootTransform.scale = glm::vec3(1.0f);
+	rootTransform.rotationDegrees = glm::vec3(0.0f);
+	rootTransform.position = glm::vec3(0.0f);
+
+	m_sceneGraph.Clear();
+	m_retainedDraws.clear();
+	ResetDrawState();
+
+	m_bBuildingScene = true;
+	m_objectNode = m_sceneGraph.AddNode(SceneGraph::NO_PARENT, rootTransform);
+	m_objectPivot = glm::vec3(0.0f);
+	m_drawNode = m_objectNode;
+
 	RenderWalls();
 	RenderSoda();
 	RenderLamp();
 	RenderChair();
 	RenderArcade();
+
+	m_bBuildingScene = false;
+	m_sceneGraph.UpdateWorldMatrices();
+
+	std::cout << "Scene graph:" << m_sceneGraph.GetNodeCount() << " nodes, "
+		<< m_retainedDraws.size() << " draws" << std::endl;
+}
+
+/***********************************************************
+ *  BeginSceneObject()
+ *
+ *  This method is used for adding the node of an object below
+ *  the scene root.  The parts recorded until EndSceneObject()
+ *  are added below it, relative to the passed in pivot.
+ ***********************************************************/
+void SceneManager::BeginSceneObject(glm::vec3 pivot, bool bStatic)
+{
+	if (!m_bBuildingScene)
+	{
+		return;
+	}
+
+	SceneGraph::NODE_TRANSFORM transform;
+	transform.scale = glm::vec3(1.0f);
+	transform.rotationDegrees = glm::vec3(0.0f);
+	transform.position = pivot;
+
+	// the root is always the first node
+	m_objectNode = m_sceneGraph.AddNode(0, transform);
+	m_objectPivot = pivot;
+	m_bStaticObject = bStatic;
+	m_drawNode = m_objectNode;
+}
+
+/***********************************************************
+ *  EndSceneObject()
+ *
+ *  This method is used for returning to the scene root after
+ *  an object is recorded.
+ ***********************************************************/
+void SceneManager::EndSceneObject()
+{
+	m_objectNode = 0;
+	m_objectPivot = glm::vec3(0.0f);
+	m_bStaticObject = false;
+	m_bOccluderDraw = false;
+	m_drawNode = m_objectNode;
+}
+
+/***********************************************************
+ *  SubmitRetainedDraws()
+ *
+ *  This method is used for submitting the retained draws with
+ *  the cached world matrices of their nodes.  The static draws
+ *  are left out when they are baked.  Only the copies of the
+ *  scene after the first need their matrices moved.
+ ***********************************************************/
+void SceneManager::SubmitRetainedDraws(int copy)
+{
+	bool bBaked = !m_staticBatches.empty();
+
+	for (const RETAINED_DRAW& draw : m_retainedDraws)
+	{
+		if ((draw.bStatic) && (bBaked))
+		{
+			continue;
+		}
+
+		RenderQueue::DRAW_PACKET packet = draw.packet;
+		if (copy == 0)
+		{
+			packet.model = m_sceneGraph.GetWorldMatrix(draw.node);
+		}
+		else
+		{
+			packet.model = m_copyTransform * m_sceneGraph.GetWorldMatrix(draw.node);
+		}
+		SubmitPacket(packet);
+	}
+}
+
+/***********************************************************
+ *  SubmitStaticBatches()
+ *
+ *  This method is used for submitting a draw of every static
+ *  batch.  The batches are already in world space, so they
+ *  are only placed by the transform of the scene copy.  The
+ *  recorded draw state is left as it was.
+ ***********************************************************/
+void SceneManager::SubmitStaticBatches()
+{
+	RenderQueue::DRAW_PACKET drawState = m_drawState;
+
+	for (const STATIC_BATCH& batch : m_staticBatches)
+	{
+		m_drawState.textureSlot = batch.textureSlot;
+		m_drawState.color = batch.color;
+		m_drawState.materialID = batch.materialID;
+		m_drawState.UVscale = glm::vec2(1.0f, 1.0f);
+		m_drawState.bMirrorTexture = batch.bMirrorTexture;
+		m_drawState.model = m_copyTransform;
+		SubmitMesh(MESH_STATIC_BATCH, (unsigned int)batch.batch);
+	}
+
+	m_drawState = drawState;
+}
+
+/***********************************************************
+ *  ResetDrawState()
+ *
+ *  This method is used for setting the state recorded for the
+ *  next submitted draw back to its defaults.
+ ***********************************************************/
+void SceneManager::ResetDrawState()
+{
+	m_drawState.key = 0;
+	m_drawState.program = m_pShaderManager->m_programID;
+	m_drawState.mesh = MESH_BOX;
+	m_drawState.vertexArray = MESH_BOX;
+	m_drawState.meshFlags = MESH_DRAW_ALL;
+	m_drawState.detailLevel = 0;
+	m_drawState.textureSlot = -1;
+	m_drawState.color = glm::vec4(1.0f);
+	m_drawState.materialID = 0;
+	m_drawState.UVscale = glm::vec2(1.0f, 1.0f);
+	m_drawState.bMirrorTexture = false;
+	m_drawState.bTranslucent = false;
+	m_drawState.model = glm::mat4(1.0f);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  transforming and drawing the basic 3D shapes
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// the uniform handles are stale if the shaders were relinked
+	if (m_uniformGeneration != m_pShaderManager->GetLinkGeneration())
+	{
+		ResolveUniformHandles();
+	}
+
+	// switch to the textures that have finished loading
+	PollLoadedTextures();
+	m_renderedFrames++;
+
+	// only the nodes that moved since the last frame are recomputed
+	m_worldMatrixUpdates = m_sceneGraph.UpdateWorldMatrices();
+
+	// record the draws of this frame starting from the default state
+	m_renderQueue.Clear();
+	ResetDrawState();
+	m_visibleDraws = 0;
+	m_culledDraws = 0;
+	m_hierarchyNodesTested = 0;
+	m_occludedDraws = 0;
+	m_submittedTriangles = 0;
+	for (int level = 0; level < ShapeMeshes::DETAIL_LEVELS; level++)
+	{
+		m_detailLevelDraws[level] = 0;
+	}
+
+	// the draws are submitted in the order their boxes were gathered
+	if (m_bFrustumCulling)
+	{
+		UpdateDrawHierarchy();
+	}
+	m_drawItem = 0;
+
+	// render objects in the scene, once for every copy of the scene -
+	// the baked static batches stand in for the objects that never move
+	for (int copy = 0; copy < m_sceneCopies; copy++)
+	{
+		m_copyTransform = glm::translate(glm::vec3(g_SceneCopySpacing * copy, 0.0f, 0.0f));
+
+		if (!m_staticBatches.empty())
+		{
+			SubmitStaticBatches();
+		}
+		SubmitRetainedDraws(copy);
+	}
+	m_copyTransform = glm::mat4(1.0f);
+	m_drawItem = -1;
+
+	// draw the submitted objects grouped by their state
+	DrawRenderQueue();
 }
 
 /***********************************************************
@@ -685,6 +2828,11 @@ void SceneManager::RenderWalls()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
+
+	// the parts are placed relative to the node of the walls, which
+	// hide everything outside the room
+	BeginSceneObject(glm::vec3(0.0f, 0.0f, 0.0f), true);
+	SetOccluder(true);
 	/******************************************************************/
 	// Floor
 	// set the XYZ scale for the mesh
@@ -698,11 +2846,11 @@ void SceneManager::RenderWalls()
 	// set the transformations into memory to be used on the drawn meshes
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	// draw the shader texture for floor
-	SetShaderTexture("floor");
-	SetShaderMaterial("floor");
+	SetShaderTexture(TEXTURE_FLOOR);
+	SetShaderMaterial(MATERIAL_FLOOR);
 	//SetShaderColor(0.51f,0.28f,0.086f,1);
 	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	SubmitMesh(MESH_PLANE);
 	/****************************************************************/
 	// Ceiling
 	scaleXYZ = glm::vec3(20.0f, 1.0f, 16.0f);
@@ -711,9 +2859,9 @@ void SceneManager::RenderWalls()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(0.0f, 28.0f, 6.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("ceiling");
-	SetShaderMaterial("ceiling");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderTexture(TEXTURE_CEILING);
+	SetShaderMaterial(MATERIAL_CEILING);
+	SubmitMesh(MESH_PLANE);
 	
 	/****************************************************************/
 	// Center Wall
@@ -724,9 +2872,9 @@ void SceneManager::RenderWalls()
 	positionXYZ = glm::vec3(0.0f, 14.0f, -10.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.62f, 0.455f, 0.278f, 1);
-	SetShaderTexture("wallpaper");
-	SetShaderMaterial("wallpaper");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderTexture(TEXTURE_WALLPAPER);
+	SetShaderMaterial(MATERIAL_WALLPAPER);
+	SubmitMesh(MESH_PLANE);
 	/****************************************************************/
 	// Right side Wall
 	scaleXYZ = glm::vec3(16.0f, 1.0f, 14.0f);
@@ -736,7 +2884,7 @@ void SceneManager::RenderWalls()
 	positionXYZ = glm::vec3(20.0f, 14.0f, 6.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.62f, 0.455f, 0.278f, 1);
-	m_basicMeshes->DrawPlaneMesh();
+	SubmitMesh(MESH_PLANE);
 	/****************************************************************/
 	// Left side Wall
 	scaleXYZ = glm::vec3(16.0f, 1.0f, 14.0f);
@@ -746,7 +2894,9 @@ void SceneManager::RenderWalls()
 	positionXYZ = glm::vec3(-20.0f, 14.0f, 6.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.62f, 0.455f, 0.278f, 1);
-	m_basicMeshes->DrawPlaneMesh();
+	SubmitMesh(MESH_PLANE);
+
+	EndSceneObject();
 }
 
 /**************************************************
@@ -763,6 +2913,9 @@ void SceneManager::RenderSoda()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
+
+	// the parts are placed relative to the node of the soda can
+	BeginSceneObject(glm::vec3(-8.0f, 0.4f, 4.0f), false);
 	/****************************************************************/
 	// Base of soda can
 	scaleXYZ = glm::vec3(0.8f, 0.4f, 0.8f); //using .8 as the scaling radius
@@ -773,9 +2926,9 @@ void SceneManager::RenderSoda()
 	positionXYZ = glm::vec3(-8.0f, 0.4f, 4.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.396f, 0.341f, 0.275f, 1); //silver base
-	SetShaderTexture("aluminum");
-	SetShaderMaterial("aluminum");
-	m_basicMeshes->DrawTaperedCylinderMesh(true, false, true); //no bottom
+	SetShaderTexture(TEXTURE_ALUMINUM);
+	SetShaderMaterial(MATERIAL_ALUMINUM);
+	SubmitMesh(MESH_TAPERED_CYLINDER, MESH_DRAW_TOP | MESH_DRAW_SIDES); //no bottom
 	/****************************************************************/
 	// Body of soda can
 	scaleXYZ = glm::vec3(0.8f, 2.0f, 0.8f);
@@ -784,11 +2937,11 @@ void SceneManager::RenderSoda()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(-8.0f, 0.4f, 4.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("soda1");
-	SetShaderMaterial("soda1");
+	SetShaderTexture(TEXTURE_SODA1);
+	SetShaderMaterial(MATERIAL_SODA1);
 	SetTextureUVScale(-1.0f, 1.0f); // flip the texture
 	//SetShaderColor(0.427f, 0.039f, 0.0f, 1.0); //red body
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	SetTextureUVScale(1.0f, 1.0f); // reset the texture UV scale to default
 	/****************************************************************/
 	// Body top - half sphere
@@ -798,11 +2951,11 @@ void SceneManager::RenderSoda()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(-8.0f, 2.4f, 4.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("soda2");
-	SetShaderMaterial("soda2");
+	SetShaderTexture(TEXTURE_SODA2);
+	SetShaderMaterial(MATERIAL_SODA2);
 	//SetShaderColor(0.427f, 0.039f, 0.0f, 1); //red body
 	//SetShaderMaterial("red_body");
-	m_basicMeshes->DrawHalfSphereMesh();
+	SubmitMesh(MESH_HALF_SPHERE);
 	/****************************************************************/
 	// Flat cylinder for top of lid - texture contains the tab
 	scaleXYZ = glm::vec3(0.6f, 0.03f, 0.6f); //scaled x & z smaller to fit
@@ -811,10 +2964,10 @@ void SceneManager::RenderSoda()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(-8.0f, 2.67f, 4.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("soda_top");
-	SetShaderMaterial("soda_top");
+	SetShaderTexture(TEXTURE_SODA_TOP);
+	SetShaderMaterial(MATERIAL_SODA_TOP);
 	//SetShaderColor(0.396f, 0.341f, 0.275f, 1); //silver
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// Torus for lid rim
 	scaleXYZ = glm::vec3(0.6f, 0.6f, 1.0f); //scaled x & y smaller to fit -- z adjusts thickness
@@ -823,10 +2976,12 @@ void SceneManager::RenderSoda()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(-8.0f, 2.71f, 4.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("aluminum");
-	SetShaderMaterial("aluminum");
+	SetShaderTexture(TEXTURE_ALUMINUM);
+	SetShaderMaterial(MATERIAL_ALUMINUM);
 	//SetShaderColor(0.500f, 0.410f, 0.350f, 1); //bright silver
-	m_basicMeshes->DrawTorusMesh();
+	SubmitMesh(MESH_TORUS);
+
+	EndSceneObject();
 }
 
 /***********************************************************
@@ -842,6 +2997,9 @@ void SceneManager::RenderLamp()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
+
+	// the parts are placed relative to the node of the lamp base
+	BeginSceneObject(glm::vec3(15.0f, 0.0f, -5.5f), true);
 	/****************************************************************/
 	// flat cylinder base
 	scaleXYZ = glm::vec3(2.7f, 0.3f, 2.7f);
@@ -851,9 +3009,9 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 0.0f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.300f, 0.082f, 0.039f, 1);
-	SetShaderTexture("leather");
-	SetShaderMaterial("leather");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_LEATHER);
+	SetShaderMaterial(MATERIAL_LEATHER);
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// tapered cylinder base piece
 	scaleXYZ = glm::vec3(0.7f, 0.5f, 0.7f);
@@ -863,9 +3021,9 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 0.3f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.252f, 0.082f, 0.039f, 1);
-	//SetShaderTexture("metal2");
-	//SetShaderMaterial("metal2");
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	//SetShaderTexture(TEXTURE_METAL2);
+	//SetShaderMaterial(MATERIAL_METAL2);
+	SubmitMesh(MESH_TAPERED_CYLINDER);
 	/****************************************************************/
 	// elongated cylinder pole
 	scaleXYZ = glm::vec3(0.3f, 15.0f, 0.3f);
@@ -875,9 +3033,9 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 0.8f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.302f, 0.082f, 0.039f, 1);
-	//SetShaderTexture("leather");
-	//SetShaderMaterial("leather");
-	m_basicMeshes->DrawCylinderMesh();
+	//SetShaderTexture(TEXTURE_LEATHER);
+	//SetShaderMaterial(MATERIAL_LEATHER);
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// socket for bulb
 	scaleXYZ = glm::vec3(0.3f, 0.7f, 0.3f);
@@ -887,9 +3045,9 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 15.8f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.396f, 0.341f, 0.275f, 1); //silver
-	SetShaderTexture("metal2");
-	SetShaderMaterial("metal2");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_METAL2);
+	SetShaderMaterial(MATERIAL_METAL2);
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// metal switch on side of socket
 	scaleXYZ = glm::vec3(0.05f, 0.3f, 0.05f);
@@ -899,7 +3057,7 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(14.8f, 16.2f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.141f, 0.102f, 0.039f, 1); //brown/black
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// bulb
 	scaleXYZ = glm::vec3(0.5f, 1.2f, 0.5f);
@@ -910,9 +3068,9 @@ void SceneManager::RenderLamp()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	SetShaderColor(3.0f, 2.7f, 2.0f, 1.0f);
 	// switched back to a bright shader color to simulate a turned on light bulb.
-	//SetShaderTexture("aluminum");
-	//SetShaderMaterial("aluminum");
-	m_basicMeshes->DrawCylinderMesh();
+	//SetShaderTexture(TEXTURE_ALUMINUM);
+	//SetShaderMaterial(MATERIAL_ALUMINUM);
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// torus metal hoop (meant to support shade)
 	scaleXYZ = glm::vec3(1.0f, 1.4f, 1.0f);
@@ -922,9 +3080,9 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 17.7f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.141f, 0.102f, 0.039f, 1); //brown/black
-	SetShaderTexture("metal2");
-	SetShaderMaterial("metal2");
-	m_basicMeshes->DrawTorusMesh();
+	SetShaderTexture(TEXTURE_METAL2);
+	SetShaderMaterial(MATERIAL_METAL2);
+	SubmitMesh(MESH_TORUS);
 	/****************************************************************/
 	// top emblem on hoop (sphere)
 	scaleXYZ = glm::vec3(0.15f, 0.25f, 0.15f);
@@ -934,7 +3092,7 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 19.4f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.141f, 0.102f, 0.039f, 1); //brown/black
-	m_basicMeshes->DrawSphereMesh();
+	SubmitMesh(MESH_SPHERE);
 	/****************************************************************/
 	// lamp shade outside
 	scaleXYZ = glm::vec3(2.7f, 3.7f, 2.5f);
@@ -943,9 +3101,9 @@ void SceneManager::RenderLamp()
 	YrotationDegrees = 0.0f;
 	ZrotationDegrees = 0.0f;
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("linen");
-	SetShaderMaterial("linen");
-	m_basicMeshes->DrawTaperedCylinderMesh(false, false, true);
+	SetShaderTexture(TEXTURE_LINEN);
+	SetShaderMaterial(MATERIAL_LINEN);
+	SubmitMesh(MESH_TAPERED_CYLINDER, MESH_DRAW_SIDES);
 	/****************************************************************/
 	// Torus connecting hoop to shade
 	scaleXYZ = glm::vec3(1.4f, 0.4f, 0.8f);
@@ -955,9 +3113,11 @@ void SceneManager::RenderLamp()
 	positionXYZ = glm::vec3(15.0f, 19.0f, -5.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.141f, 0.102f, 0.039f, 1); //brown/black
-	SetShaderTexture("metal2");
-	SetShaderMaterial("metal2");
-	m_basicMeshes->DrawTorusMesh();
+	SetShaderTexture(TEXTURE_METAL2);
+	SetShaderMaterial(MATERIAL_METAL2);
+	SubmitMesh(MESH_TORUS);
+
+	EndSceneObject();
 }
 /***********************************************************
  * RenderChair()
@@ -972,6 +3132,9 @@ void SceneManager::RenderChair()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
+
+	// the parts are placed relative to the node of the stool
+	BeginSceneObject(glm::vec3(0.0f, 0.0f, 3.0f), true);
 	/****************************************************************/
 	// Four Cylinder legs (front leg)
 	scaleXYZ = glm::vec3(0.2f, 6.0f, 0.2f);
@@ -981,9 +3144,9 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(0.0f, 0.0f, 6.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1); //black for legs
-	SetShaderTexture("metal2");
-	SetShaderMaterial("metal2");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_METAL2);
+	SetShaderMaterial(MATERIAL_METAL2);
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// right leg
 	scaleXYZ = glm::vec3(0.2f, 6.0f, 0.2f); //scaled to fit within pop tab
@@ -993,7 +3156,7 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(3.0f, 0.0f, 3.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1); //black for legs
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// back leg
 	scaleXYZ = glm::vec3(0.2f, 6.0f, 0.2f);
@@ -1003,7 +3166,7 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1);
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	///****************************************************************/
 	// left leg
 	scaleXYZ = glm::vec3(0.2f, 6.0f, 0.2f);
@@ -1013,7 +3176,7 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(-3.0f, 0.0f, 3.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1);
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	/****************************************************************/
 	// Torus Foot Ring
 	/****************************************************************/
@@ -1024,7 +3187,7 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(0.0f, 3.0f, 3.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1);
-	m_basicMeshes->DrawTorusMesh();
+	SubmitMesh(MESH_TORUS);
 	/****************************************************************/
 	// Cylinder Seat Cushion
 	/****************************************************************/
@@ -1036,9 +3199,11 @@ void SceneManager::RenderChair()
 	positionXYZ = glm::vec3(0.0f, 5.95f, 3.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.102f, 0.082f, 0.039f, 1);
-	SetShaderTexture("leather");
-	SetShaderMaterial("leather");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_LEATHER);
+	SetShaderMaterial(MATERIAL_LEATHER);
+	SubmitMesh(MESH_CYLINDER);
+
+	EndSceneObject();
 }
 /***********************************************************
  * RenderArcade()
@@ -1053,6 +3218,9 @@ void SceneManager::RenderArcade()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
+
+	// the parts are placed relative to the node of the arcade cabinet
+	BeginSceneObject(glm::vec3(0.0f, 0.0f, -4.5f), true);
 	/****************************************************************/
 	// Box base
 	scaleXYZ = glm::vec3(9.0f, 9.1f, 7.0f);
@@ -1062,10 +3230,13 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 4.6f, -6.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.245f, 0.063f, 0.012f, 1);  //change back to black
-	SetShaderTexture("test");
-	SetShaderMaterial("test");
+	SetShaderTexture(TEXTURE_TEST);
+	SetShaderMaterial(MATERIAL_TEST);
 	//SetShaderTexture("arcade");
-	m_basicMeshes->DrawBoxMesh();
+	// the base hides what is behind the cabinet
+	SetOccluder(true);
+	SubmitMesh(MESH_BOX);
+	SetOccluder(false);
 	/****************************************************************/
 	// coin slot decal overlay for box base
 	scaleXYZ = glm::vec3(3.0f, 1.0f, 3.0f);
@@ -1074,9 +3245,9 @@ void SceneManager::RenderArcade()
 	ZrotationDegrees = 0.0f;
 	positionXYZ = glm::vec3(0.0f, 5.0f, -2.495f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("coin_slot");
-	SetShaderMaterial("coin_slot");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderTexture(TEXTURE_COIN_SLOT);
+	SetShaderMaterial(MATERIAL_COIN_SLOT);
+	SubmitMesh(MESH_PLANE);
 	/****************************************************************/
 	// thin box plane for console control prism
 	scaleXYZ = glm::vec3(9.0f, 1.7f, 10.0f);
@@ -1086,9 +3257,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 10.0f, -4.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	SetShaderTexture("testt");
-	SetShaderMaterial("testt");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderTexture(TEXTURE_TESTT);
+	SetShaderMaterial(MATERIAL_TESTT);
+	SubmitMesh(MESH_BOX);
 	/****************************************************************/
 	// Prism for controls
 	scaleXYZ = glm::vec3(10.0f, 9.0f, 1.5f);
@@ -1098,20 +3269,14 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 11.6f, -4.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.245f, 0.063f, 0.012f, 1);
-	SetShaderTexture("test");
-	SetShaderMaterial("test");
+	SetShaderTexture(TEXTURE_TEST);
+	SetShaderMaterial(MATERIAL_TEST);
 	// wrapping test
-	int textureSlot = FindTextureSlot("test"); // get texture slot
-	GLuint textureID = FindTextureID("test"); // get ID
-	glActiveTexture(GL_TEXTURE0 + textureSlot); // 0 + active slot = active slot.
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+	SetTextureMirrorRepeat(true);
 	SetTextureUVScale(2.0f, 2.0f);
-	m_basicMeshes->DrawPrismMesh();
+	SubmitMesh(MESH_PRISM);
 	// reset parameters for next texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	SetTextureMirrorRepeat(false);
 	SetTextureUVScale(1.0f, 1.0f);
 	/****************************************************************/
 	// Prisms for screen box
@@ -1122,9 +3287,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 12.35f, -7.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	SetShaderTexture("arcade2");
-	SetShaderMaterial("arcade2");
-	m_basicMeshes->DrawPrismMesh();
+	SetShaderTexture(TEXTURE_ARCADE2);
+	SetShaderMaterial(MATERIAL_ARCADE2);
+	SubmitMesh(MESH_PRISM);
 	/****************************************************************/
 	// Prisms for screen box
 	scaleXYZ = glm::vec3(1.6f, 9.0f, 5.0f);
@@ -1134,7 +3299,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 13.495f, -7.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	m_basicMeshes->DrawPrismMesh();
+	SubmitMesh(MESH_PRISM);
 	/****************************************************************/
 	// Screen Box
 	scaleXYZ = glm::vec3(9.0f, 5.5f, 5.1f);
@@ -1144,9 +3309,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 16.635f, -7.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.245f, 0.063f, 0.012f, 1);
-	SetShaderTexture("test");
-	SetShaderMaterial("test");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderTexture(TEXTURE_TEST);
+	SetShaderMaterial(MATERIAL_TEST);
+	SubmitMesh(MESH_BOX);
 	/****************************************************************/
 	// Plane for screen -- emit light & add texture later
 	scaleXYZ = glm::vec3(3.95f, 1.0f, 2.8f); //old 3.1,1.0,2.4 || 3.95
@@ -1156,9 +3321,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 16.67f, -4.4f); //old 0.0,16.67,-4.4
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.094f, 0.267f, 0.369f, 1); //blue
-	SetShaderTexture("tekken");
-	SetShaderMaterial("tekken");
-	m_basicMeshes->DrawPlaneMesh();
+	SetShaderTexture(TEXTURE_TEKKEN);
+	SetShaderMaterial(MATERIAL_TEKKEN);
+	SubmitMesh(MESH_PLANE);
 	/****************************************************************/
 	// Top of Arcade Machine
 	scaleXYZ = glm::vec3(9.0f, 2.5f, 7.0f);
@@ -1168,9 +3333,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(0.0f, 20.65f, -6.1f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	SetShaderTexture("testt");
-	SetShaderMaterial("testt");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderTexture(TEXTURE_TESTT);
+	SetShaderMaterial(MATERIAL_TESTT);
+	SubmitMesh(MESH_BOX);
 	/****************************************************************/
 	// Trim/Decal for Arcade Machine
 	/****************************************************************/
@@ -1182,9 +3347,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(4.20f, 16.68f, -4.25f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	SetShaderTexture("arcade2");
-	SetShaderMaterial("arcade2");
-	m_basicMeshes->DrawBoxMesh();
+	SetShaderTexture(TEXTURE_ARCADE2);
+	SetShaderMaterial(MATERIAL_ARCADE2);
+	SubmitMesh(MESH_BOX);
 	// left side top trim
 	scaleXYZ = glm::vec3(0.5f, 0.6f, 5.5f);
 	XrotationDegrees = 89.0f;
@@ -1193,7 +3358,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(-4.20f, 16.68f, -4.25f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	m_basicMeshes->DrawBoxMesh();
+	SubmitMesh(MESH_BOX);
 	// control panel trim left side
 	scaleXYZ = glm::vec3(0.5f, 0.6f, 5.4f);
 	XrotationDegrees = 17.0f;
@@ -1202,7 +3367,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(-4.20f, 11.88f, -2.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1); //dark red
-	m_basicMeshes->DrawBoxMesh();
+	SubmitMesh(MESH_BOX);
 	// control panel trim right side
 	scaleXYZ = glm::vec3(0.5f, 0.6f, 5.4f);
 	XrotationDegrees = 17.0f;
@@ -1211,7 +3376,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(4.20f, 11.88f, -2.0f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1);
-	m_basicMeshes->DrawBoxMesh();
+	SubmitMesh(MESH_BOX);
 	/****************************************************************/
 	// Control Panel
 	/****************************************************************/
@@ -1223,7 +3388,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(-2.20f, 11.45f, -1.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.012f, 1); //dark red
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	// Joystick rod
 	scaleXYZ = glm::vec3(0.1f, 0.8f, 0.1f);
 	XrotationDegrees = 17.0f;
@@ -1232,9 +3397,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(-2.20f, 11.60f, -1.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.396f, 0.341f, 0.275f, 1); //silver
-	SetShaderTexture("aluminum");
-	SetShaderMaterial("aluminum");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_ALUMINUM);
+	SetShaderMaterial(MATERIAL_ALUMINUM);
+	SubmitMesh(MESH_CYLINDER);
 	// Joystick sphere
 	scaleXYZ = glm::vec3(0.4f, 0.4f, 0.4f);
 	XrotationDegrees = 17.0f;
@@ -1243,9 +3408,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(-2.20f, 12.7f, -1.2f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.427f, 0.039f, 0.0f, 1); //red
-	SetShaderTexture("soda2");
-	SetShaderMaterial("soda2");
-	m_basicMeshes->DrawSphereMesh();
+	SetShaderTexture(TEXTURE_SODA2);
+	SetShaderMaterial(MATERIAL_SODA2);
+	SubmitMesh(MESH_SPHERE);
 	/****************************************************************/
 	// Button base left
 	scaleXYZ = glm::vec3(0.5f, 0.1f, 0.5f);
@@ -1255,9 +3420,9 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(1.3f, 11.35f, -1.2f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.445f, 0.063f, 0.012f, 1);
-	SetShaderTexture("yellow"); // yellow for all button bases & buttons
-	SetShaderMaterial("yellow");
-	m_basicMeshes->DrawCylinderMesh();
+	SetShaderTexture(TEXTURE_YELLOW); // yellow for all button bases & buttons
+	SetShaderMaterial(MATERIAL_YELLOW);
+	SubmitMesh(MESH_CYLINDER);
 	// button base right
 	scaleXYZ = glm::vec3(0.5f, 0.1f, 0.5f);
 	XrotationDegrees = 17.0f;
@@ -1266,7 +3431,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(3.0f, 11.35f, -1.2f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.463f, 0.012f, 1);
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	// button base center
 	scaleXYZ = glm::vec3(0.5f, 0.1f, 0.5f);
 	XrotationDegrees = 17.0f;
@@ -1275,7 +3440,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(2.2f, 11.75f, -2.5f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.412f, 1);
-	m_basicMeshes->DrawCylinderMesh();
+	SubmitMesh(MESH_CYLINDER);
 	/* button tops */
 	// buttton top left
 	scaleXYZ = glm::vec3(0.3f, 0.2f, 0.3f);
@@ -1285,7 +3450,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(1.30f, 11.43f, -1.15f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.627f, 0.039f, 0.0f, 1);
-	m_basicMeshes->DrawHalfSphereMesh();
+	SubmitMesh(MESH_HALF_SPHERE);
 	// button top right
 	scaleXYZ = glm::vec3(0.3f, 0.2f, 0.3f);
 	XrotationDegrees = 17.0f;
@@ -1294,7 +3459,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(3.0f, 11.43f, -1.15f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.663f, 0.012f, 1);
-	m_basicMeshes->DrawHalfSphereMesh();
+	SubmitMesh(MESH_HALF_SPHERE);
 	// button top center
 	scaleXYZ = glm::vec3(0.3f, 0.2f, 0.3f);
 	XrotationDegrees = 17.0f;
@@ -1303,5 +3468,7 @@ void SceneManager::RenderArcade()
 	positionXYZ = glm::vec3(2.2f, 11.83f, -2.45f);
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
 	//SetShaderColor(0.145f, 0.063f, 0.612f, 1);
-	m_basicMeshes->DrawHalfSphereMesh();
+	SubmitMesh(MESH_HALF_SPHERE);
+
+	EndSceneObject();
 }
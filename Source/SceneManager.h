@@ -9,10 +9,21 @@
 
 #pragma once
 
+#include "BoundingVolumeHierarchy.h"
+#include "Frustum.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+#include "SceneGraph.h"
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "TextureLoader.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
 
 //#include <string> // this is already included right?
+#include <mutex>
+#include <thread>
 #include <vector>
 
 /***********************************************************
@@ -25,14 +36,122 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(ShaderManager *pShaderManager, TextureLoader *pTextureLoader = NULL);
 	// destructor
 	~SceneManager();
 
+	// loaded textures, in the order of TEXTURE_ID
+	enum TEXTURE_ID
+	{
+		TEXTURE_FLOOR = 0,
+		TEXTURE_WALLPAPER,
+		TEXTURE_CEILING,
+		TEXTURE_SODA1,
+		TEXTURE_SODA2,
+		TEXTURE_SODA_TOP,
+		TEXTURE_TEKKEN,
+		TEXTURE_ARCADE2,
+		TEXTURE_COIN_SLOT,
+		TEXTURE_TEST,
+		TEXTURE_TESTT,
+		TEXTURE_YELLOW,
+		TEXTURE_LINEN,
+		TEXTURE_LEATHER,
+		TEXTURE_METAL2,
+		TEXTURE_ALUMINUM,
+		TEXTURE_COUNT
+	};
+
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		int arrayIndex;   // texture array holding the image
+		int layer;        // layer of the image in that array
+		bool bTranslucent;   // has pixels that are not fully opaque
+	};
+
+	// meshes that draw packets can be submitted with
+	enum MESH_ID
+	{
+		MESH_BOX = 0,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_PLANE,
+		MESH_PRISM,
+		MESH_PYRAMID3,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS,
+		MESH_HALF_TORUS,
+		MESH_EXTRA_TORUS1,
+		MESH_EXTRA_TORUS2,
+		// baked static geometry, the mesh flags hold the batch index
+		MESH_STATIC_BATCH
+	};
+
+	// parts of a cylinder, tapered cylinder or cone to draw
+	enum MESH_PARTS
+	{
+		MESH_DRAW_TOP = 1,
+		MESH_DRAW_BOTTOM = 2,
+		MESH_DRAW_SIDES = 4,
+		MESH_DRAW_ALL = MESH_DRAW_TOP | MESH_DRAW_BOTTOM | MESH_DRAW_SIDES
+	};
+
+	// one texture array holds every image of the same size and format
+	struct TEXTURE_ARRAY
+	{
+		GLuint ID;
+		int width;
+		int height;
+		int colorChannels;
+		int layers;
+		// block compressed arrays are uploaded with their cooked mip chain
+		bool bCompressed;
+		int mipLevels;
+	};
+
+	// texture array uploaded by the loader, waiting for its fence
+	struct LOADED_TEXTURE_ARRAY
+	{
+		int arrayIndex;
+		GLuint ID;
+		GLsync fence;
+		std::vector<int> textureSlots;           // textures stored in the array
+		std::vector<TEXTURE_INFO> textures;      // info of each of those textures
+	};
+
+	// decoded image waiting to be copied into its texture array
+	struct PENDING_IMAGE
+	{
+		unsigned char* pixels;
+		std::vector<MipGenerator::MIP_LEVEL> mipLevels;
+		TextureCache::COOKED_TEXTURE cooked;
+		int textureSlot;
+	};
+
+	// indices of the defined materials in the material table
+	enum MATERIAL_ID
+	{
+		MATERIAL_FLOOR = 0,
+		MATERIAL_WALLPAPER,
+		MATERIAL_CEILING,
+		MATERIAL_SODA1,
+		MATERIAL_SODA2,
+		MATERIAL_SODA_TOP,
+		MATERIAL_TEKKEN,
+		MATERIAL_ARCADE2,
+		MATERIAL_COIN_SLOT,
+		MATERIAL_TEST,
+		MATERIAL_TESTT,
+		MATERIAL_YELLOW,
+		MATERIAL_LINEN,
+		MATERIAL_LEATHER,
+		MATERIAL_METAL2,
+		MATERIAL_ALUMINUM,
+		MATERIAL_COUNT
 	};
 
 	struct OBJECT_MATERIAL
@@ -43,29 +162,259 @@ public:
 		std::string tag;
 	};
 
+	// static draws sharing their surface, baked into one batch
+	struct STATIC_BATCH
+	{
+		int batch;              // index of the batch in the shared geometry
+		int textureSlot;        // -1 to draw with color instead
+		glm::vec4 color;
+		int materialID;
+		bool bMirrorTexture;
+	};
+
+	// draw recorded once when the scene is built, placed by its node
+	struct RETAINED_DRAW
+	{
+		int node;               // scene graph node holding the transform
+		bool bStatic;           // part of an object that never moves
+		bool bOccluder;         // drawn into the occlusion buffer
+		RenderQueue::DRAW_PACKET packet;
+	};
+
+	// shader uniform locations resolved once per program link
+	struct UNIFORM_HANDLES
+	{
+		GLint model;
+		GLint normalMatrix;
+		GLint objectColor;
+		GLint textureArray;
+		GLint textureLayer;
+		GLint mirrorTexture;
+		GLint useTexture;
+		GLint UVscale;
+		GLint materialIndex;
+		GLint instanced;
+		GLint decodeOffset;
+		GLint decodeScale;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
+	// textures as seen by the render thread, indexed by texture slot -
+	// arrayIndex is -1 until the texture is resident
+	std::vector<TEXTURE_INFO> m_residentTextures;
+	// placeholder texture array drawn until a texture is resident
+	GLuint m_placeholderTexture;
+	// number of frames rendered, for reporting when textures arrive
+	int m_renderedFrames;
+
+	// the following texture members are owned by the loader thread
+	// while the textures are loading
+	// loaded textures info, indexed by texture slot
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture arrays the loaded textures are stored in
+	std::vector<TEXTURE_ARRAY> m_textureArrays;
+	// decoded images not yet copied into the texture arrays
+	std::vector<PENDING_IMAGE> m_pendingImages;
+	// loader decoding the scene textures
+	TextureLoader* m_pTextureLoader;
+	// true if the texture loader was created by this object
+	bool m_bOwnsTextureLoader;
+	// bytes of texture data passed to OpenGL
+	size_t m_textureUploadBytes;
+	// estimated bytes of texture memory including the mip chains
+	size_t m_textureMemoryBytes;
+
+	// hidden window with a shared OpenGL context for the loader thread,
+	// NULL to upload the textures on the render thread
+	GLFWwindow* m_pLoaderWindow;
+	// thread uploading the textures through the shared context
+	std::thread m_loaderThread;
+	// texture arrays handed from the loader thread to the render thread
+	std::vector<LOADED_TEXTURE_ARRAY> m_loadedArrays;
+	std::mutex m_loadedArraysMutex;
+	// defined object materials, indexed by MATERIAL_ID
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// pre-resolved uniform locations for the render path
+	UNIFORM_HANDLES m_uniforms;
+	// uniform buffer holding the LightData block
+	GLuint m_lightDataUBO;
+	// uniform buffer holding the MaterialData table
+	GLuint m_materialDataUBO;
+	// shader link generation the uniform handles were resolved against
+	unsigned int m_uniformGeneration;
 
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
+	// draws of the current frame, sorted before they are issued
+	RenderQueue m_renderQueue;
+	// state the Set methods record for the next submitted draw
+	RenderQueue::DRAW_PACKET m_drawState;
+	// state changes of the last frame in submission and sorted order
+	RenderQueue::STATE_CHANGES m_unsortedStateChanges;
+	RenderQueue::STATE_CHANGES m_sortedStateChanges;
+	// per-instance data of the instanced draw being issued
+	std::vector<ShapeMeshes::INSTANCE_DATA> m_instances;
+	// draws of the multi-draw call being issued
+	std::vector<ShapeMeshes::DRAW_ELEMENTS_COMMAND> m_drawCommands;
+	// true to draw from the shared geometry with multi-draw calls
+	// when OpenGL 4.3 is available
+	bool m_bMultiDraw;
+	// draw calls issued in the last frame, how many were instanced, and
+	// how many draws the multi-draw calls held
+	int m_drawCalls;
+	int m_instancedDrawCalls;
+	int m_multiDrawCommands;
+	// CPU time spent issuing the render queue in the last frame
+	double m_submitMilliseconds;
+	// number of copies of the scene rendered side by side
+	int m_sceneCopies;
+	// true to bake the objects that never move into static batches
+	bool m_bStaticBatching;
+	// nodes of the scene objects and their parts, with cached world matrices
+	SceneGraph m_sceneGraph;
+	// draws of the scene, recorded once by BuildScene()
+	std::vector<RETAINED_DRAW> m_retainedDraws;
+	// true while the Render methods are recording the scene
+	bool m_bBuildingScene;
+	// node and pivot of the object being recorded, and whether it moves
+	int m_objectNode;
+	glm::vec3 m_objectPivot;
+	bool m_bStaticObject;
+	// true while the parts being recorded hide what is behind them
+	bool m_bOccluderDraw;
+	// node added by the last SetTransformations() call
+	int m_drawNode;
+	// world matrices recomputed in the last frame
+	int m_worldMatrixUpdates;
+	// draws recorded for baking, in world space
+	std::vector<RenderQueue::DRAW_PACKET> m_staticPackets;
+	// baked batches submitted in place of the static objects
+	std::vector<STATIC_BATCH> m_staticBatches;
+	// placement of the scene copy being rendered
+	glm::mat4 m_copyTransform;
+	// view volume of the current frame, and whether draws outside it
+	// are skipped
+	Frustum m_frustum;
+	bool m_bFrustumCulling;
+	// draws submitted and skipped by the frustum test in the last frame
+	int m_visibleDraws;
+	int m_culledDraws;
+	// world boxes of the draws of a frame in the order they are
+	// submitted, every static batch and moving draw of every copy
+	std::vector<BoundingVolumeHierarchy::BOX> m_drawBounds;
+	// tree over the draw boxes, and which of them the last frustum
+	// query found
+	BoundingVolumeHierarchy m_drawHierarchy;
+	std::vector<int> m_hierarchyItems;
+	std::vector<unsigned char> m_drawVisible;
+	// tree nodes tested by the frustum query of the last frame
+	int m_hierarchyNodesTested;
+	// draw box and detail level of the next submitted packet, -1 when
+	// it is submitted on its own
+	int m_drawItem;
+	// depth of the occluders drawn on the CPU, and whether draws
+	// hidden behind them are skipped
+	OcclusionBuffer m_occlusionBuffer;
+	bool m_bOcclusionCulling;
+	// draws inside the view volume that the occluders hid last frame
+	int m_occludedDraws;
+	// projection * view of the current frame, for the size of the draws
+	// on the screen
+	glm::mat4 m_viewProjection;
+	// true to draw the round meshes with fewer triangles when they are
+	// small on the screen
+	bool m_bDetailLevels;
+	// detail level each draw of the scene was given last frame, -1 before
+	// it was first drawn
+	std::vector<signed char> m_drawLevels;
+	// triangles submitted and draws given each detail level last frame
+	int m_submittedTriangles;
+	int m_detailLevelDraws[ShapeMeshes::DETAIL_LEVELS];
+
+	// resolve the uniform handles used while rendering
+	void ResolveUniformHandles();
+
+	// add a decoded texture image to the matching texture array
+	bool CreateGLTexture(TextureLoader::TEXTURE_IMAGE& image, int textureSlot);
+	// stretch an image into the texture array nearest its size, when
+	// every array is in use - the array index, or -1 if none fits
+	int FitImageToTextureArray(TextureLoader::TEXTURE_IMAGE& image);
+	// copy the decoded images into the OpenGL texture arrays
+	void CreateGLTextureArrays();
+	// create the placeholder texture shown until textures are loaded
+	void CreatePlaceholderTexture();
+	// collect the decoded images and upload them to the texture arrays
+	void UploadSceneTextures();
+	// upload the textures through the shared context on the loader thread
+	void LoadTexturesOnLoaderThread();
+	// bind the texture arrays whose uploads have finished
+	void PollLoadedTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
 	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// find the ID of a defined material by tag
+	int FindMaterialID(std::string tag);
+	// copy the defined materials into the material uniform buffer
+	void UploadMaterialTable();
+
+	// submit a draw of a mesh with the recorded state
+	void SubmitMesh(int mesh, unsigned int meshParts = MESH_DRAW_ALL);
+	// sort the submitted draws and issue them
+	void DrawRenderQueue();
+	// set the shader state of a packet that differs from the previous one
+	void ApplyDrawPacket(const RenderQueue::DRAW_PACKET& packet, const RenderQueue::DRAW_PACKET* pPrevious);
+	// issue the draw call of a packet
+	void DrawMesh(const RenderQueue::DRAW_PACKET& packet);
+	// issue one instanced draw call for a run of packets sharing their state
+	void DrawMeshInstanced(const RenderQueue::DRAW_PACKET& packet, const ShapeMeshes::INSTANCE_DATA* instances, int instanceCount);
+	// issue the sorted packets from the shared geometry with one multi-draw call
+	void DrawRenderQueueIndirect();
+	// fill the per-instance data of a packet, the texture is resolved here
+	void FillInstance(const RenderQueue::DRAW_PACKET& packet, ShapeMeshes::INSTANCE_DATA& instance) const;
+	// how the vertices a packet is drawn from are decoded
+	ShapeMeshes::VERTEX_DECODE GetPacketVertexDecode(const RenderQueue::DRAW_PACKET& packet) const;
+
+	// set the recorded draw state back to its defaults
+	void ResetDrawState();
+	// record the scene objects into the scene graph and retained draws
+	void BuildScene();
+	// start and end recording an object, its parts are placed relative
+	// to its pivot so moving its node moves all of them
+	void BeginSceneObject(glm::vec3 pivot, bool bStatic);
+	void EndSceneObject();
+	// submit the retained draws placed by their world matrices
+	void SubmitRetainedDraws(int copy);
+	// add a packet to the render queue, its translucency is set here -
+	// packets outside the view volume are skipped
+	void SubmitPacket(RenderQueue::DRAW_PACKET& packet);
+	// true if the bounds of a packet are inside the view volume
+	bool IsPacketVisible(const RenderQueue::DRAW_PACKET& packet) const;
+	// model space bounds of a mesh, false if it has none
+	bool GetPacketMeshBounds(int mesh, unsigned int meshParts, ShapeMeshes::MESH_BOUNDS& bounds) const;
+	// gather the world boxes of this frame's draws, rebuild or refit the
+	// tree over them, and find the draws inside the view volume
+	void UpdateDrawHierarchy();
+	// add the world box of a draw to the draw boxes
+	void AddDrawBounds(int mesh, unsigned int meshParts, const glm::mat4& model);
+	// draw the occluders into the occlusion buffer and take the draws
+	// hidden behind them out of the visible draws
+	void CullOccludedDraws();
+	// the detail level a packet is drawn at, from its size on the screen
+	// and the level the same draw had last frame
+	int SelectDetailLevel(const RenderQueue::DRAW_PACKET& packet, int item);
+	// triangles drawn for a packet at its detail level
+	int GetPacketTriangleCount(const RenderQueue::DRAW_PACKET& packet) const;
+	// record the draws of the static objects and bake them into batches
+	void BakeStaticGeometry();
+	// submit a draw of every static batch with the recorded transform
+	void SubmitStaticBatches();
+
+	// the following Set methods record state for the next
+	// submitted draw, it is sent to the shader when the
+	// render queue is drawn
 
 	// set the transformation values 
 	// into the transform buffer
@@ -84,14 +433,27 @@ private:
 		float alphaValue);
 
 	// set the texture data into the shader
+	void SetShaderTexture(
+		int textureSlot);
 	void SetShaderTexture(
 		std::string textureTag);
 
+	// sample the texture with mirrored repeat wrapping
+	void SetTextureMirrorRepeat(
+		bool bMirror);
+
+	// draw the parts recorded next into the occlusion buffer, for
+	// meshes that fill their bounds such as walls and boxes
+	void SetOccluder(
+		bool bOccluder);
+
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
+	// select the object material in the shader
+	void SetShaderMaterial(
+		int materialID);
 	void SetShaderMaterial(
 		std::string materialTag);
 
@@ -102,6 +464,66 @@ public:
 	void PrepareScene();
 	void RenderScene();
 
+	// texture, material and VAO changes of the last frame, as
+	// submitted and after sorting
+	void GetStateChanges(RenderQueue::STATE_CHANGES& unsorted, RenderQueue::STATE_CHANGES& sorted) const;
+	// number of draws in the last frame
+	int GetDrawCount() const { return((int)m_renderQueue.GetPackets().size()); }
+	// draw calls issued in the last frame, and how many of them were instanced
+	int GetDrawCallCount() const { return(m_drawCalls); }
+	int GetInstancedDrawCallCount() const { return(m_instancedDrawCalls); }
+	// draws held by the multi-draw calls of the last frame
+	int GetMultiDrawCommandCount() const { return(m_multiDrawCommands); }
+	// CPU time spent issuing the draws of the last frame
+	double GetSubmitMilliseconds() const { return(m_submitMilliseconds); }
+	// render this many copies of the scene side by side, for load testing
+	void SetSceneCopies(int copies);
+	// draw with multi-draw calls when supported, set before PrepareScene()
+	void SetMultiDraw(bool bMultiDraw);
+	// bake the static objects into batches, set before PrepareScene()
+	void SetStaticBatching(bool bStaticBatching);
+	// map the generated meshes from this cache, set before PrepareScene()
+	void SetMeshCache(MeshCache* pMeshCache);
+	// format the shared geometry is packed in, set before PrepareScene()
+	void SetVertexFormat(ShapeMeshes::VERTEX_FORMAT format);
+	// number of static batches and the draws that were baked into them
+	int GetStaticBatchCount() const { return((int)m_staticBatches.size()); }
+	int GetStaticDrawCount() const { return((int)m_staticPackets.size()); }
+	// skip the draws outside the view volume of projection * view, set
+	// before each RenderScene()
+	void SetViewProjection(const glm::mat4& viewProjection);
+	void SetFrustumCulling(bool bFrustumCulling);
+	// skip the draws hidden behind the occluders, needs frustum culling
+	void SetOcclusionCulling(bool bOcclusionCulling);
+	// draws in the view volume hidden by the occluders in the last frame,
+	// they are counted in the culled draws as well
+	int GetOccludedDrawCount() const { return(m_occludedDraws); }
+	// occluder triangles drawn on the CPU in the last frame
+	int GetOccluderTriangleCount() const { return(m_occlusionBuffer.GetRasterizedTriangleCount()); }
+	// draw the cone, cylinder, sphere and torus with fewer triangles
+	// when they are small on the screen, only with multi-draw calls
+	void SetDetailLevels(bool bDetailLevels);
+	// triangles in the draws of the last frame, and how many draws were
+	// given a detail level
+	int GetSubmittedTriangleCount() const { return(m_submittedTriangles); }
+	int GetDetailLevelDrawCount(int level) const { return(m_detailLevelDraws[level]); }
+	// draws inside the view volume and draws skipped in the last frame
+	int GetVisibleDrawCount() const { return(m_visibleDraws); }
+	int GetCulledDrawCount() const { return(m_culledDraws); }
+	// tree over the world boxes of the draws, the items are the static
+	// batches and then the moving draws of each scene copy - for ray and
+	// sphere queries against the scene
+	const BoundingVolumeHierarchy& GetDrawHierarchy() const { return(m_drawHierarchy); }
+	// tree nodes tested to cull the draws of the last frame
+	int GetHierarchyNodesTested() const { return(m_hierarchyNodesTested); }
+	// nodes in the scene graph and the world matrices recomputed last frame
+	int GetSceneNodeCount() const { return(m_sceneGraph.GetNodeCount()); }
+	int GetWorldMatrixUpdateCount() const { return(m_worldMatrixUpdates); }
+
+	// queue the scene texture image files for decoding
+	static void QueueSceneTextures(TextureLoader* pTextureLoader);
+	// upload scene textures on this loader context instead of the render thread
+	void SetLoaderContext(GLFWwindow* pLoaderWindow);
 	// load scence textures from image files
 	void LoadSceneTextures();
 	// define light sources for the 3D scene
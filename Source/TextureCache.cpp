@@ -0,0 +1,483 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// cook texture images into block compressed files with full mip chains
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// identifies a cooked texture file and the version of its layout
+	const char g_CookedMagic[4] = { 'C', 'T', 'E', 'X' };
+	const uint32_t g_CookedVersion = 2;
+
+	// header at the start of every cooked texture file, followed by
+	// levelCount COOKED_LEVEL_HEADER + compressed block pairs
+	struct COOKED_FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t width;
+		uint32_t height;
+		uint32_t colorChannels;
+		uint32_t mipFilter;
+		uint32_t levelCount;
+	};
+
+	struct COOKED_LEVEL_HEADER
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t byteCount;
+	};
+
+	// RGBA image used while building the mip chain
+	struct RGBA_IMAGE
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	// pack an 8-bit per channel color into 5:6:5
+	uint16_t PackColor565(const unsigned char* color)
+	{
+		int r = (color[0] * 31 + 127) / 255;
+		int g = (color[1] * 63 + 127) / 255;
+		int b = (color[2] * 31 + 127) / 255;
+		return((uint16_t)((r << 11) | (g << 5) | b));
+	}
+
+	// expand a 5:6:5 color back to 8 bits per channel
+	void UnpackColor565(uint16_t packed, int* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// copy an RGB or RGBA image into an RGBA image for compressing
+	RGBA_IMAGE WidenImage(const unsigned char* pixels, int width, int height, int colorChannels)
+	{
+		RGBA_IMAGE image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize((size_t)width * height * 4);
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			image.pixels[i * 4 + 0] = pixels[i * colorChannels + 0];
+			image.pixels[i * 4 + 1] = pixels[i * colorChannels + 1];
+			image.pixels[i * 4 + 2] = pixels[i * colorChannels + 2];
+			image.pixels[i * 4 + 3] = (colorChannels == 4) ? pixels[i * colorChannels + 3] : 255;
+		}
+
+		return(image);
+	}
+
+	// read the 4x4 block at (blockX, blockY), repeating the edge
+	// pixels for blocks that hang over the edge of the image
+	void FetchBlock(const RGBA_IMAGE& image, int blockX, int blockY, unsigned char block[16][4])
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			int sourceY = std::min(blockY * 4 + y, image.height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				int sourceX = std::min(blockX * 4 + x, image.width - 1);
+				memcpy(block[y * 4 + x], &image.pixels[((size_t)sourceY * image.width + sourceX) * 4], 4);
+			}
+		}
+	}
+
+	// compress the colors of a block to 8 bytes of BC1 data using
+	// the inset bounding box of the block colors as the endpoints
+	void CompressColorBlock(unsigned char block[16][4], unsigned char* output)
+	{
+		unsigned char minColor[3] = { 255, 255, 255 };
+		unsigned char maxColor[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				minColor[c] = std::min(minColor[c], block[i][c]);
+				maxColor[c] = std::max(maxColor[c], block[i][c]);
+			}
+		}
+
+		// pull the endpoints in slightly to reduce the error of the
+		// colors in the middle of the range
+		for (int c = 0; c < 3; c++)
+		{
+			int inset = (maxColor[c] - minColor[c]) / 16;
+			minColor[c] = (unsigned char)(minColor[c] + inset);
+			maxColor[c] = (unsigned char)(maxColor[c] - inset);
+		}
+
+		uint16_t color0 = PackColor565(maxColor);
+		uint16_t color1 = PackColor565(minColor);
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		// four color mode palette - the endpoints and two blends
+		int palette[4][3];
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int dr = block[i][0] - palette[p][0];
+					int dg = block[i][1] - palette[p][1];
+					int db = block[i][2] - palette[p][2];
+					int error = dr * dr + dg * dg + db * db;
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (i * 2);
+			}
+		}
+
+		output[0] = (unsigned char)(color0 & 0xFF);
+		output[1] = (unsigned char)(color0 >> 8);
+		output[2] = (unsigned char)(color1 & 0xFF);
+		output[3] = (unsigned char)(color1 >> 8);
+		output[4] = (unsigned char)(indices & 0xFF);
+		output[5] = (unsigned char)((indices >> 8) & 0xFF);
+		output[6] = (unsigned char)((indices >> 16) & 0xFF);
+		output[7] = (unsigned char)(indices >> 24);
+	}
+
+	// compress the alpha of a block to 8 bytes of BC3 alpha data
+	void CompressAlphaBlock(unsigned char block[16][4], unsigned char* output)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, (int)block[i][3]);
+			alpha1 = std::min(alpha1, (int)block[i][3]);
+		}
+
+		// eight alpha mode palette - the endpoints and six blends
+		int palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (int p = 1; p < 7; p++)
+		{
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 8; p++)
+				{
+					int error = std::abs(block[i][3] - palette[p]);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint64_t)bestIndex << (i * 3);
+			}
+		}
+
+		output[0] = (unsigned char)alpha0;
+		output[1] = (unsigned char)alpha1;
+		for (int b = 0; b < 6; b++)
+		{
+			output[2 + b] = (unsigned char)((indices >> (b * 8)) & 0xFF);
+		}
+	}
+
+	// compress a whole RGBA image to BC1 or BC3 blocks
+	void CompressImage(const RGBA_IMAGE& image, int colorChannels, std::vector<unsigned char>& blocks)
+	{
+		int blocksWide = (image.width + 3) / 4;
+		int blocksHigh = (image.height + 3) / 4;
+		int blockSize = (colorChannels == 4) ? 16 : 8;
+		blocks.resize((size_t)blocksWide * blocksHigh * blockSize);
+
+		unsigned char block[16][4];
+		unsigned char* output = blocks.data();
+		for (int blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				FetchBlock(image, blockX, blockY, block);
+				if (colorChannels == 4)
+				{
+					CompressAlphaBlock(block, output);
+					output += 8;
+				}
+				CompressColorBlock(block, output);
+				output += 8;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache(const char* cacheFolder)
+{
+	m_cacheFolder = cacheFolder;
+}
+
+/***********************************************************
+ *  HashSource()
+ *
+ *  This method is used for hashing the contents of a source
+ *  image file with 64-bit FNV-1a.
+ ***********************************************************/
+uint64_t TextureCache::HashSource(const std::vector<unsigned char>& sourceBytes)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char byte : sourceBytes)
+	{
+		hash ^= byte;
+		hash *= 1099511628211ULL;
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  GetLevelSize()
+ *
+ *  This method is used for getting the number of bytes of
+ *  BC1 (RGB) or BC3 (RGBA) blocks in a level of this size.
+ ***********************************************************/
+int TextureCache::GetLevelSize(int width, int height, int colorChannels)
+{
+	int blockSize = (colorChannels == 4) ? 16 : 8;
+	return(((width + 3) / 4) * ((height + 3) / 4) * blockSize);
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cooked
+ *  texture file for a source hash.
+ ***********************************************************/
+std::string TextureCache::GetCachePath(uint64_t sourceHash) const
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "%016llx.ctex", (unsigned long long)sourceHash);
+
+	return(m_cacheFolder + "/" + filename);
+}
+
+/***********************************************************
+ *  LoadCookedTexture()
+ *
+ *  This method is used for reading the cooked texture for a
+ *  source hash.  Missing, stale or damaged files are treated
+ *  as a cache miss.
+ ***********************************************************/
+bool TextureCache::LoadCookedTexture(uint64_t sourceHash, MipGenerator::MIP_FILTER mipFilter,
+	COOKED_TEXTURE& cooked) const
+{
+	std::ifstream file(GetCachePath(sourceHash), std::ios::binary);
+	if (!file)
+	{
+		return(false);
+	}
+
+	COOKED_FILE_HEADER header;
+	if (!file.read((char*)&header, sizeof(header)) ||
+		(memcmp(header.magic, g_CookedMagic, sizeof(g_CookedMagic)) != 0) ||
+		(header.version != g_CookedVersion) ||
+		(header.sourceHash != sourceHash) ||
+		(header.mipFilter != (uint32_t)mipFilter) ||
+		((header.colorChannels != 3) && (header.colorChannels != 4)) ||
+		(header.levelCount == 0) || (header.levelCount > 32))
+	{
+		return(false);
+	}
+
+	cooked.width = (int)header.width;
+	cooked.height = (int)header.height;
+	cooked.colorChannels = (int)header.colorChannels;
+	cooked.levels.resize(header.levelCount);
+
+	int levelWidth = cooked.width;
+	int levelHeight = cooked.height;
+	for (auto& level : cooked.levels)
+	{
+		COOKED_LEVEL_HEADER levelHeader;
+		if (!file.read((char*)&levelHeader, sizeof(levelHeader)) ||
+			((int)levelHeader.width != levelWidth) ||
+			((int)levelHeader.height != levelHeight) ||
+			((int)levelHeader.byteCount != GetLevelSize(levelWidth, levelHeight, cooked.colorChannels)))
+		{
+			cooked.levels.clear();
+			return(false);
+		}
+
+		level.width = levelWidth;
+		level.height = levelHeight;
+		level.blocks.resize(levelHeader.byteCount);
+		if (!file.read((char*)level.blocks.data(), levelHeader.byteCount))
+		{
+			cooked.levels.clear();
+			return(false);
+		}
+
+		levelWidth = std::max(1, levelWidth / 2);
+		levelHeight = std::max(1, levelHeight / 2);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CompressTexture()
+ *
+ *  This method is used for compressing a decoded image and
+ *  every level of its mip chain, without writing it to the
+ *  cache folder.
+ ***********************************************************/
+bool TextureCache::CompressTexture(const unsigned char* pixels,
+	int width, int height, int colorChannels,
+	const std::vector<MipGenerator::MIP_LEVEL>& mipLevels, COOKED_TEXTURE& cooked)
+{
+	if ((NULL == pixels) || (width <= 0) || (height <= 0) ||
+		((colorChannels != 3) && (colorChannels != 4)) ||
+		((int)mipLevels.size() != MipGenerator::GetLevelCount(width, height) - 1))
+	{
+		return(false);
+	}
+
+	cooked.width = width;
+	cooked.height = height;
+	cooked.colorChannels = colorChannels;
+	cooked.levels.resize(mipLevels.size() + 1);
+	for (int level = 0; level < (int)cooked.levels.size(); level++)
+	{
+		COOKED_LEVEL& cookedLevel = cooked.levels[level];
+		if (level == 0)
+		{
+			cookedLevel.width = width;
+			cookedLevel.height = height;
+			CompressImage(WidenImage(pixels, width, height, colorChannels), colorChannels, cookedLevel.blocks);
+		}
+		else
+		{
+			const MipGenerator::MIP_LEVEL& mipLevel = mipLevels[level - 1];
+			cookedLevel.width = mipLevel.width;
+			cookedLevel.height = mipLevel.height;
+			CompressImage(WidenImage(mipLevel.pixels.data(), mipLevel.width, mipLevel.height, colorChannels),
+				colorChannels, cookedLevel.blocks);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CookTexture()
+ *
+ *  This method is used for compressing a decoded image and
+ *  every level of its mip chain, and writing the result to
+ *  the cache folder.
+ ***********************************************************/
+bool TextureCache::CookTexture(uint64_t sourceHash, const unsigned char* pixels,
+	int width, int height, int colorChannels,
+	const std::vector<MipGenerator::MIP_LEVEL>& mipLevels, MipGenerator::MIP_FILTER mipFilter,
+	COOKED_TEXTURE& cooked) const
+{
+	if (!CompressTexture(pixels, width, height, colorChannels, mipLevels, cooked))
+	{
+		return(false);
+	}
+
+	// write to a temporary file first so a partly written file
+	// is never picked up as a cooked texture
+	std::error_code error;
+	std::filesystem::create_directories(m_cacheFolder, error);
+	std::string cachePath = GetCachePath(sourceHash);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Could not write cooked texture:" << cachePath << std::endl;
+			return(false);
+		}
+
+		COOKED_FILE_HEADER header;
+		memcpy(header.magic, g_CookedMagic, sizeof(g_CookedMagic));
+		header.version = g_CookedVersion;
+		header.sourceHash = sourceHash;
+		header.width = (uint32_t)width;
+		header.height = (uint32_t)height;
+		header.colorChannels = (uint32_t)colorChannels;
+		header.mipFilter = (uint32_t)mipFilter;
+		header.levelCount = (uint32_t)cooked.levels.size();
+		file.write((const char*)&header, sizeof(header));
+
+		for (auto& level : cooked.levels)
+		{
+			COOKED_LEVEL_HEADER levelHeader;
+			levelHeader.width = (uint32_t)level.width;
+			levelHeader.height = (uint32_t)level.height;
+			levelHeader.byteCount = (uint32_t)level.blocks.size();
+			file.write((const char*)&levelHeader, sizeof(levelHeader));
+			file.write((const char*)level.blocks.data(), level.blocks.size());
+		}
+
+		if (!file)
+		{
+			std::cout << "Could not write cooked texture:" << cachePath << std::endl;
+			return(false);
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::cout << "Could not write cooked texture:" << cachePath << std::endl;
+		std::filesystem::remove(tempPath, error);
+		return(false);
+	}
+
+	return(true);
+}
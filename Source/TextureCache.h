@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// cook texture images into block compressed files with full mip chains
+//
+// A cooked texture is stored in the cache folder under the hash of its
+// source image file, so editing a source image invalidates its cooked copy.
+// RGB images are compressed to BC1 (DXT1) and RGBA images to BC3 (DXT5),
+// along with the mip chain built by MipGenerator. The mip filter is stored in
+// the file, so switching filters cooks the textures again. Cooking and
+// reading back need no OpenGL context, so they can run on any thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MipGenerator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TextureCache
+{
+public:
+	// constructor
+	TextureCache(const char* cacheFolder);
+
+	// one block compressed mip level
+	struct COOKED_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> blocks;
+	};
+
+	// block compressed texture with its full mip chain
+	struct COOKED_TEXTURE
+	{
+		int width;
+		int height;
+		int colorChannels;   // 3 for BC1, 4 for BC3
+		std::vector<COOKED_LEVEL> levels;
+	};
+
+	// hash of the source image file contents, used as the cache key
+	static uint64_t HashSource(const std::vector<unsigned char>& sourceBytes);
+
+	// read the cooked texture for a source hash, with its mip chain built
+	// by the passed in filter - false on a cache miss
+	bool LoadCookedTexture(uint64_t sourceHash, MipGenerator::MIP_FILTER mipFilter,
+		COOKED_TEXTURE& cooked) const;
+	// compress decoded RGB or RGBA pixels and the levels of their mip
+	// chain, and write the result to the cache
+	bool CookTexture(uint64_t sourceHash, const unsigned char* pixels,
+		int width, int height, int colorChannels,
+		const std::vector<MipGenerator::MIP_LEVEL>& mipLevels, MipGenerator::MIP_FILTER mipFilter,
+		COOKED_TEXTURE& cooked) const;
+
+	// compress decoded RGB or RGBA pixels and the levels of their mip
+	// chain without writing them to the cache
+	static bool CompressTexture(const unsigned char* pixels,
+		int width, int height, int colorChannels,
+		const std::vector<MipGenerator::MIP_LEVEL>& mipLevels, COOKED_TEXTURE& cooked);
+
+	// number of bytes in a compressed level of the passed in size
+	static int GetLevelSize(int width, int height, int colorChannels);
+
+private:
+	// folder the cooked textures are written to
+	std::string m_cacheFolder;
+
+	// path of the cooked texture file for a source hash
+	std::string GetCachePath(uint64_t sourceHash) const;
+};
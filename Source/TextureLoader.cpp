@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture image files on a pool of worker threads
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+	// read the whole contents of a file - false if it can not be read
+	bool ReadFileBytes(const std::string& filename, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file)
+		{
+			return(false);
+		}
+
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return(true);
+	}
+
+	// milliseconds elapsed since the passed in time
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_pTextureCache = NULL;
+	m_mipFilter = MipGenerator::MIP_FILTER_BOX;
+	m_nextImage = 0;
+	m_decodedImages = 0;
+	m_decodeWallMilliseconds = 0.0;
+	m_waitMilliseconds = 0.0;
+	m_startTime = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	StopWorkers();
+
+	// free any decoded images that were never collected
+	for (auto& queuedImage : m_images)
+	{
+		if (NULL != queuedImage.image.pixels)
+		{
+			stbi_image_free(queuedImage.image.pixels);
+			queuedImage.image.pixels = NULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueueImage()
+ *
+ *  This method is used for adding an image file to the list
+ *  of images to decode.  Images must be queued before Start().
+ ***********************************************************/
+void TextureLoader::QueueImage(const char* filename, std::string tag)
+{
+	if (false == m_workers.empty())
+	{
+		std::cout << "Could not queue image:" << filename << ", the texture loader is already started" << std::endl;
+		return;
+	}
+
+	QUEUED_IMAGE queuedImage;
+	queuedImage.image.filename = filename;
+	queuedImage.image.tag = tag;
+	queuedImage.image.pixels = NULL;
+	queuedImage.image.width = 0;
+	queuedImage.image.height = 0;
+	queuedImage.image.colorChannels = 0;
+	queuedImage.image.decodeMilliseconds = 0.0;
+	queuedImage.image.bCompressed = false;
+	queuedImage.image.cookMilliseconds = 0.0;
+	queuedImage.image.mipMilliseconds = 0.0;
+	queuedImage.bDecoded = false;
+	queuedImage.bTaken = false;
+	m_images.push_back(queuedImage);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting a worker thread per CPU
+ *  core, up to one per queued image, to decode the images.
+ ***********************************************************/
+void TextureLoader::Start()
+{
+	if ((false == m_workers.empty()) || (true == m_images.empty()))
+	{
+		return;
+	}
+
+	int threadCount = (int)std::thread::hardware_concurrency();
+	if (threadCount < 1)
+	{
+		threadCount = 1;
+	}
+	if (threadCount > (int)m_images.size())
+	{
+		threadCount = (int)m_images.size();
+	}
+
+	m_startTime = std::chrono::steady_clock::now();
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::DecodeImages, this));
+	}
+}
+
+/***********************************************************
+ *  DecodeImages()
+ *
+ *  This method is run by each worker thread.  It keeps taking
+ *  the next queued image and decoding it until none are left.
+ ***********************************************************/
+void TextureLoader::DecodeImages()
+{
+	// the flip setting is kept per thread by stb_image
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	while (true)
+	{
+		int index = 0;
+		TEXTURE_IMAGE image;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_nextImage >= (int)m_images.size())
+			{
+				return;
+			}
+			index = m_nextImage++;
+			image = m_images[index].image;
+		}
+
+		LoadQueuedImage(image);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_images[index].image = std::move(image);
+			m_images[index].bDecoded = true;
+			if (++m_decodedImages == (int)m_images.size())
+			{
+				m_decodeWallMilliseconds = MillisecondsSince(m_startTime);
+			}
+		}
+		m_imageDecoded.notify_all();
+	}
+}
+
+/***********************************************************
+ *  LoadQueuedImage()
+ *
+ *  This method is used for reading an image from the texture
+ *  cache when it holds an up to date cooked copy, otherwise
+ *  the source file is decoded and then cooked for next time.
+ ***********************************************************/
+void TextureLoader::LoadQueuedImage(TEXTURE_IMAGE& image)
+{
+	std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+
+	if (NULL == m_pTextureCache)
+	{
+		DecodeSourceImage(image);
+		image.decodeMilliseconds = MillisecondsSince(decodeStart) - image.mipMilliseconds;
+		return;
+	}
+
+	std::vector<unsigned char> sourceBytes;
+	if (!ReadFileBytes(image.filename, sourceBytes))
+	{
+		return;
+	}
+
+	uint64_t sourceHash = TextureCache::HashSource(sourceBytes);
+	if (m_pTextureCache->LoadCookedTexture(sourceHash, m_mipFilter, image.cooked))
+	{
+		image.bCompressed = true;
+		image.width = image.cooked.width;
+		image.height = image.cooked.height;
+		image.colorChannels = image.cooked.colorChannels;
+		image.decodeMilliseconds = MillisecondsSince(decodeStart);
+		return;
+	}
+
+	// cache miss - decode the source file that was already read
+	image.pixels = stbi_load_from_memory(
+		sourceBytes.data(),
+		(int)sourceBytes.size(),
+		&image.width,
+		&image.height,
+		&image.colorChannels,
+		0);
+	image.decodeMilliseconds = MillisecondsSince(decodeStart);
+	BuildMipLevels(image);
+
+	// cook the image so the next launch can skip the decoding, the
+	// decoded pixels are still used for this launch
+	if (NULL != image.pixels)
+	{
+		std::chrono::steady_clock::time_point cookStart = std::chrono::steady_clock::now();
+		TextureCache::COOKED_TEXTURE cooked;
+		if (m_pTextureCache->CookTexture(sourceHash, image.pixels,
+			image.width, image.height, image.colorChannels,
+			image.mipLevels, m_mipFilter, cooked))
+		{
+			image.cookMilliseconds = MillisecondsSince(cookStart);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMipLevels()
+ *
+ *  This method is used for building the mip chain of a decoded
+ *  RGB or RGBA image with the selected filter.
+ ***********************************************************/
+void TextureLoader::BuildMipLevels(TEXTURE_IMAGE& image)
+{
+	if (NULL == image.pixels)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point mipStart = std::chrono::steady_clock::now();
+	MipGenerator::BuildMipChain(image.pixels, image.width, image.height,
+		image.colorChannels, m_mipFilter, image.mipLevels);
+	image.mipMilliseconds = MillisecondsSince(mipStart);
+}
+
+/***********************************************************
+ *  DecodeSourceImage()
+ *
+ *  This method is used for decoding the source file of an
+ *  image on the calling thread, flipped vertically for OpenGL,
+ *  and building its mip chain.
+ ***********************************************************/
+bool TextureLoader::DecodeSourceImage(TEXTURE_IMAGE& image)
+{
+	// the flip setting is kept per thread by stb_image
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	image.pixels = stbi_load(
+		image.filename.c_str(),
+		&image.width,
+		&image.height,
+		&image.colorChannels,
+		0);
+	BuildMipLevels(image);
+
+	return(NULL != image.pixels);
+}
+
+/***********************************************************
+ *  WaitForImage()
+ *
+ *  This method is used for collecting a decoded image.  It
+ *  blocks until the image at the passed in index is decoded,
+ *  then hands the pixels over to the caller.
+ ***********************************************************/
+bool TextureLoader::WaitForImage(int index, TEXTURE_IMAGE& image)
+{
+	if ((index < 0) || (index >= (int)m_images.size()))
+	{
+		return(false);
+	}
+
+	// start decoding now if Start() was never called
+	Start();
+
+	std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_imageDecoded.wait(lock, [this, index]() { return(m_images[index].bDecoded); });
+	m_waitMilliseconds += MillisecondsSince(waitStart);
+
+	if (true == m_images[index].bTaken)
+	{
+		return(false);
+	}
+
+	image = std::move(m_images[index].image);
+	m_images[index].image.pixels = NULL;
+	m_images[index].bTaken = true;
+
+	return((NULL != image.pixels) || (true == image.bCompressed));
+}
+
+/***********************************************************
+ *  GetImageTag()
+ *
+ *  This method is used for getting the tag of a queued image
+ *  while the images may still be decoding.
+ ***********************************************************/
+std::string TextureLoader::GetImageTag(int index)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if ((index < 0) || (index >= (int)m_images.size()))
+	{
+		return("");
+	}
+
+	return(m_images[index].image.tag);
+}
+
+/***********************************************************
+ *  GetDecodeWallMilliseconds()
+ *
+ *  This method is used for getting the time it took the
+ *  worker threads to decode every queued image.
+ ***********************************************************/
+double TextureLoader::GetDecodeWallMilliseconds()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_decodeWallMilliseconds);
+}
+
+/***********************************************************
+ *  StopWorkers()
+ *
+ *  This method is used for waiting for the worker threads
+ *  to finish and joining them.
+ ***********************************************************/
+void TextureLoader::StopWorkers()
+{
+	{
+		// no more images are handed out once the workers are stopping
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_nextImage = (int)m_images.size();
+	}
+
+	for (auto& worker : m_workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture image files on a pool of worker threads
+//
+// Images are queued by file name and decoded in the background as soon as
+// Start() is called, so the decoding can overlap the creation of the OpenGL
+// context and the compiling of the shaders. The decoded images are then
+// collected in the order they were queued.
+//
+// When a texture cache is set, an image with an up to date cooked copy is
+// read from the cache instead of being decoded, and an image without one is
+// decoded as usual and then cooked for the next launch.
+//
+// Decoded images get their mip chain built on the same worker thread, so the
+// chains of different images are built in parallel.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MipGenerator.h"
+#include "TextureCache.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// decoded image handed back to the caller
+	struct TEXTURE_IMAGE
+	{
+		std::string filename;
+		std::string tag;
+		unsigned char* pixels;   // freed with stbi_image_free()
+		int width;
+		int height;
+		int colorChannels;
+		double decodeMilliseconds;
+		// true when the image was read from the texture cache, in which
+		// case cooked holds the compressed mip chain and pixels is NULL
+		bool bCompressed;
+		TextureCache::COOKED_TEXTURE cooked;
+		// time spent cooking the image for the cache, 0 if not cooked
+		double cookMilliseconds;
+		// levels below the decoded pixels, empty for cooked images
+		std::vector<MipGenerator::MIP_LEVEL> mipLevels;
+		double mipMilliseconds;
+	};
+
+	// read and write cooked textures through this cache - call before Start()
+	void SetTextureCache(TextureCache* pTextureCache) { m_pTextureCache = pTextureCache; }
+	// filter the mip chains are built with - call before Start()
+	void SetMipFilter(MipGenerator::MIP_FILTER mipFilter) { m_mipFilter = mipFilter; }
+	MipGenerator::MIP_FILTER GetMipFilter() const { return(m_mipFilter); }
+	// add an image file to the list of images to decode
+	void QueueImage(const char* filename, std::string tag);
+	// start decoding the queued images on the worker threads
+	void Start();
+	// wait for the queued image at index to be decoded and take
+	// ownership of its pixels - false if the file could not be read
+	bool WaitForImage(int index, TEXTURE_IMAGE& image);
+
+	// decode the source file of an image and build its mip chain on
+	// the calling thread
+	bool DecodeSourceImage(TEXTURE_IMAGE& image);
+
+	// number of queued images
+	int GetImageCount() const { return((int)m_images.size()); }
+	// tag of the queued image at index
+	std::string GetImageTag(int index);
+	// number of worker threads decoding the images
+	int GetThreadCount() const { return((int)m_workers.size()); }
+	// time from Start() until the last image finished decoding
+	double GetDecodeWallMilliseconds();
+	// total time the caller spent blocked in WaitForImage()
+	double GetWaitMilliseconds() const { return(m_waitMilliseconds); }
+
+private:
+	// decoding state of each queued image
+	struct QUEUED_IMAGE
+	{
+		TEXTURE_IMAGE image;
+		bool bDecoded;
+		bool bTaken;
+	};
+
+	std::vector<QUEUED_IMAGE> m_images;
+	// cache of cooked textures, NULL to always decode the source files
+	TextureCache* m_pTextureCache;
+	MipGenerator::MIP_FILTER m_mipFilter;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_imageDecoded;
+	// index of the next image for a worker to pick up
+	int m_nextImage;
+	// number of images that have finished decoding
+	int m_decodedImages;
+	double m_decodeWallMilliseconds;
+	double m_waitMilliseconds;
+	// time Start() was called
+	std::chrono::steady_clock::time_point m_startTime;
+
+	// decode images until the queue is empty
+	void DecodeImages();
+	// read an image from the cache or decode and cook it
+	void LoadQueuedImage(TEXTURE_IMAGE& image);
+	// build the mip chain of a decoded image
+	void BuildMipLevels(TEXTURE_IMAGE& image);
+	// join the worker threads
+	void StopWorkers();
+};
@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.cpp
+// ============
+// build model matrices for many transforms at once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformKernel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TRANSFORM_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TRANSFORM_SSE2_TARGET
+#define TRANSFORM_AVX2_TARGET
+#else
+#define TRANSFORM_SSE2_TARGET __attribute__((target("sse2")))
+#define TRANSFORM_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	const float g_RadiansPerDegree = 0.017453292519943295f;
+	const float g_TwoOverPi = 0.63661977236758134f;
+	// pi / 2 split in three, the first two parts have few enough bits
+	// that multiplying them by a quadrant number is exact
+	const float g_HalfPi1 = 1.5703125f;
+	const float g_HalfPi2 = 4.837512969970703125e-4f;
+	const float g_HalfPi3 = 7.54978995489188216e-8f;
+	// minimax polynomials for sine and cosine over [-pi / 4, pi / 4]
+	const float g_Sine0 = -1.6666654611e-1f;
+	const float g_Sine1 = 8.3321608736e-3f;
+	const float g_Sine2 = -1.9515295891e-4f;
+	const float g_Cosine0 = 4.166664568298827e-2f;
+	const float g_Cosine1 = -1.388731625493765e-3f;
+	const float g_Cosine2 = 2.443315711809948e-5f;
+
+	// build count matrices starting at first - every kernel does the
+	// same operations in the same order, so they produce the same floats
+	typedef void (*COMPOSE_TRANSFORMS)(const TransformKernel::TRANSFORM_ARRAYS& transforms,
+		TransformKernel::MATRIX_ARRAYS& matrices, size_t first, size_t count);
+
+	/***********************************************************
+	 *  scalar kernel - the reference for the SIMD kernels
+	 ***********************************************************/
+	void SinCosScalar(float degrees, float& sine, float& cosine)
+	{
+		// reduce to [-pi / 4, pi / 4] around the nearest multiple of
+		// pi / 2, the quadrant picks the polynomial and the signs
+		float x = degrees * g_RadiansPerDegree;
+		int quadrant = (int)std::lrint(x * g_TwoOverPi);
+		float q = (float)quadrant;
+		float r = x - q * g_HalfPi1;
+		r = r - q * g_HalfPi2;
+		r = r - q * g_HalfPi3;
+		float z = r * r;
+
+		float s = ((g_Sine2 * z + g_Sine1) * z + g_Sine0) * z * r + r;
+		float c = ((g_Cosine2 * z + g_Cosine1) * z + g_Cosine0) * z * z - 0.5f * z + 1.0f;
+
+		sine = (quadrant & 1) ? c : s;
+		cosine = (quadrant & 1) ? s : c;
+		if (quadrant & 2)
+		{
+			sine = -sine;
+		}
+		if ((quadrant + 1) & 2)
+		{
+			cosine = -cosine;
+		}
+	}
+
+	void ComposeTransformScalar(const TransformKernel::TRANSFORM_ARRAYS& transforms,
+		TransformKernel::MATRIX_ARRAYS& matrices, size_t i)
+	{
+		float sinX, cosX, sinY, cosY, sinZ, cosZ;
+		SinCosScalar(transforms.rotationX[i], sinX, cosX);
+		SinCosScalar(transforms.rotationY[i], sinY, cosY);
+		SinCosScalar(transforms.rotationZ[i], sinZ, cosZ);
+
+		// rotationZ * rotationY * rotationX, each column then scaled
+		float cosZsinY = cosZ * sinY;
+		float sinZsinY = sinZ * sinY;
+		float scaleX = transforms.scaleX[i];
+		float scaleY = transforms.scaleY[i];
+		float scaleZ = transforms.scaleZ[i];
+
+		matrices.elements[0][i] = (cosZ * cosY) * scaleX;
+		matrices.elements[1][i] = (sinZ * cosY) * scaleX;
+		matrices.elements[2][i] = -sinY * scaleX;
+		matrices.elements[3][i] = 0.0f;
+		matrices.elements[4][i] = (cosZsinY * sinX - sinZ * cosX) * scaleY;
+		matrices.elements[5][i] = (sinZsinY * sinX + cosZ * cosX) * scaleY;
+		matrices.elements[6][i] = (cosY * sinX) * scaleY;
+		matrices.elements[7][i] = 0.0f;
+		matrices.elements[8][i] = (cosZsinY * cosX + sinZ * sinX) * scaleZ;
+		matrices.elements[9][i] = (sinZsinY * cosX - cosZ * sinX) * scaleZ;
+		matrices.elements[10][i] = (cosY * cosX) * scaleZ;
+		matrices.elements[11][i] = 0.0f;
+		matrices.elements[12][i] = transforms.positionX[i];
+		matrices.elements[13][i] = transforms.positionY[i];
+		matrices.elements[14][i] = transforms.positionZ[i];
+		matrices.elements[15][i] = 1.0f;
+	}
+
+	void ComposeTransformsScalar(const TransformKernel::TRANSFORM_ARRAYS& transforms,
+		TransformKernel::MATRIX_ARRAYS& matrices, size_t first, size_t count)
+	{
+		for (size_t i = first; i < first + count; i++)
+		{
+			ComposeTransformScalar(transforms, matrices, i);
+		}
+	}
+
+#ifdef TRANSFORM_KERNEL_X86
+	/***********************************************************
+	 *  SSE2 kernel
+	 ***********************************************************/
+	TRANSFORM_SSE2_TARGET void SinCosSSE2(__m128 degrees, __m128& sine, __m128& cosine)
+	{
+		__m128 x = _mm_mul_ps(degrees, _mm_set1_ps(g_RadiansPerDegree));
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(g_TwoOverPi)));
+		__m128 q = _mm_cvtepi32_ps(quadrant);
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(g_HalfPi1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(g_HalfPi2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(g_HalfPi3)));
+		__m128 z = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_Sine2), z), _mm_set1_ps(g_Sine1));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(g_Sine0));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_Cosine2), z), _mm_set1_ps(g_Cosine1));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(g_Cosine0));
+		c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+		c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+		// odd quadrants swap sine and cosine, bit 1 of the quadrant
+		// flips the sign of the sine and of the next quadrant's cosine
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		__m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+		sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+		sine = _mm_xor_ps(sine, sineSign);
+		cosine = _mm_xor_ps(cosine, cosineSign);
+	}
+
+	TRANSFORM_SSE2_TARGET void ComposeTransformsSSE2(const TransformKernel::TRANSFORM_ARRAYS& transforms,
+		TransformKernel::MATRIX_ARRAYS& matrices, size_t first, size_t count)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		float* elements[16];
+		for (int e = 0; e < 16; e++)
+		{
+			elements[e] = matrices.elements[e].data();
+		}
+
+		size_t i = first;
+		for (; i + 4 <= first + count; i += 4)
+		{
+			__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+			SinCosSSE2(_mm_loadu_ps(transforms.rotationX.data() + i), sinX, cosX);
+			SinCosSSE2(_mm_loadu_ps(transforms.rotationY.data() + i), sinY, cosY);
+			SinCosSSE2(_mm_loadu_ps(transforms.rotationZ.data() + i), sinZ, cosZ);
+
+			__m128 cosZsinY = _mm_mul_ps(cosZ, sinY);
+			__m128 sinZsinY = _mm_mul_ps(sinZ, sinY);
+			__m128 scaleX = _mm_loadu_ps(transforms.scaleX.data() + i);
+			__m128 scaleY = _mm_loadu_ps(transforms.scaleY.data() + i);
+			__m128 scaleZ = _mm_loadu_ps(transforms.scaleZ.data() + i);
+
+			_mm_storeu_ps(elements[0] + i, _mm_mul_ps(_mm_mul_ps(cosZ, cosY), scaleX));
+			_mm_storeu_ps(elements[1] + i, _mm_mul_ps(_mm_mul_ps(sinZ, cosY), scaleX));
+			_mm_storeu_ps(elements[2] + i, _mm_mul_ps(_mm_xor_ps(sinY, signBit), scaleX));
+			_mm_storeu_ps(elements[3] + i, zero);
+			_mm_storeu_ps(elements[4] + i, _mm_mul_ps(_mm_sub_ps(
+				_mm_mul_ps(cosZsinY, sinX), _mm_mul_ps(sinZ, cosX)), scaleY));
+			_mm_storeu_ps(elements[5] + i, _mm_mul_ps(_mm_add_ps(
+				_mm_mul_ps(sinZsinY, sinX), _mm_mul_ps(cosZ, cosX)), scaleY));
+			_mm_storeu_ps(elements[6] + i, _mm_mul_ps(_mm_mul_ps(cosY, sinX), scaleY));
+			_mm_storeu_ps(elements[7] + i, zero);
+			_mm_storeu_ps(elements[8] + i, _mm_mul_ps(_mm_add_ps(
+				_mm_mul_ps(cosZsinY, cosX), _mm_mul_ps(sinZ, sinX)), scaleZ));
+			_mm_storeu_ps(elements[9] + i, _mm_mul_ps(_mm_sub_ps(
+				_mm_mul_ps(sinZsinY, cosX), _mm_mul_ps(cosZ, sinX)), scaleZ));
+			_mm_storeu_ps(elements[10] + i, _mm_mul_ps(_mm_mul_ps(cosY, cosX), scaleZ));
+			_mm_storeu_ps(elements[11] + i, zero);
+			_mm_storeu_ps(elements[12] + i, _mm_loadu_ps(transforms.positionX.data() + i));
+			_mm_storeu_ps(elements[13] + i, _mm_loadu_ps(transforms.positionY.data() + i));
+			_mm_storeu_ps(elements[14] + i, _mm_loadu_ps(transforms.positionZ.data() + i));
+			_mm_storeu_ps(elements[15] + i, one);
+		}
+		for (; i < first + count; i++)
+		{
+			ComposeTransformScalar(transforms, matrices, i);
+		}
+	}
+
+	/***********************************************************
+	 *  AVX2 kernel
+	 ***********************************************************/
+	TRANSFORM_AVX2_TARGET void SinCosAVX2(__m256 degrees, __m256& sine, __m256& cosine)
+	{
+		__m256 x = _mm256_mul_ps(degrees, _mm256_set1_ps(g_RadiansPerDegree));
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(g_TwoOverPi)));
+		__m256 q = _mm256_cvtepi32_ps(quadrant);
+		__m256 r = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(g_HalfPi1)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(g_HalfPi2)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(g_HalfPi3)));
+		__m256 z = _mm256_mul_ps(r, r);
+
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(g_Sine2), z), _mm256_set1_ps(g_Sine1));
+		s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(g_Sine0));
+		s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), r), r);
+
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(g_Cosine2), z), _mm256_set1_ps(g_Cosine1));
+		c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(g_Cosine0));
+		c = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+		c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i two = _mm256_set1_epi32(2);
+		__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+		__m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+		__m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+			_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+
+		sine = _mm256_blendv_ps(s, c, swap);
+		cosine = _mm256_blendv_ps(c, s, swap);
+		sine = _mm256_xor_ps(sine, sineSign);
+		cosine = _mm256_xor_ps(cosine, cosineSign);
+	}
+
+	TRANSFORM_AVX2_TARGET void ComposeTransformsAVX2(const TransformKernel::TRANSFORM_ARRAYS& transforms,
+		TransformKernel::MATRIX_ARRAYS& matrices, size_t first, size_t count)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		float* elements[16];
+		for (int e = 0; e < 16; e++)
+		{
+			elements[e] = matrices.elements[e].data();
+		}
+
+		size_t i = first;
+		for (; i + 8 <= first + count; i += 8)
+		{
+			__m256 sinX, cosX, sinY, cosY, sinZ, cosZ;
+			SinCosAVX2(_mm256_loadu_ps(transforms.rotationX.data() + i), sinX, cosX);
+			SinCosAVX2(_mm256_loadu_ps(transforms.rotationY.data() + i), sinY, cosY);
+			SinCosAVX2(_mm256_loadu_ps(transforms.rotationZ.data() + i), sinZ, cosZ);
+
+			__m256 cosZsinY = _mm256_mul_ps(cosZ, sinY);
+			__m256 sinZsinY = _mm256_mul_ps(sinZ, sinY);
+			__m256 scaleX = _mm256_loadu_ps(transforms.scaleX.data() + i);
+			__m256 scaleY = _mm256_loadu_ps(transforms.scaleY.data() + i);
+			__m256 scaleZ = _mm256_loadu_ps(transforms.scaleZ.data() + i);
+
+			_mm256_storeu_ps(elements[0] + i, _mm256_mul_ps(_mm256_mul_ps(cosZ, cosY), scaleX));
+			_mm256_storeu_ps(elements[1] + i, _mm256_mul_ps(_mm256_mul_ps(sinZ, cosY), scaleX));
+			_mm256_storeu_ps(elements[2] + i, _mm256_mul_ps(_mm256_xor_ps(sinY, signBit), scaleX));
+			_mm256_storeu_ps(elements[3] + i, zero);
+			_mm256_storeu_ps(elements[4] + i, _mm256_mul_ps(_mm256_sub_ps(
+				_mm256_mul_ps(cosZsinY, sinX), _mm256_mul_ps(sinZ, cosX)), scaleY));
+			_mm256_storeu_ps(elements[5] + i, _mm256_mul_ps(_mm256_add_ps(
+				_mm256_mul_ps(sinZsinY, sinX), _mm256_mul_ps(cosZ, cosX)), scaleY));
+			_mm256_storeu_ps(elements[6] + i, _mm256_mul_ps(_mm256_mul_ps(cosY, sinX), scaleY));
+			_mm256_storeu_ps(elements[7] + i, zero);
+			_mm256_storeu_ps(elements[8] + i, _mm256_mul_ps(_mm256_add_ps(
+				_mm256_mul_ps(cosZsinY, cosX), _mm256_mul_ps(sinZ, sinX)), scaleZ));
+			_mm256_storeu_ps(elements[9] + i, _mm256_mul_ps(_mm256_sub_ps(
+				_mm256_mul_ps(sinZsinY, cosX), _mm256_mul_ps(cosZ, sinX)), scaleZ));
+			_mm256_storeu_ps(elements[10] + i, _mm256_mul_ps(_mm256_mul_ps(cosY, cosX), scaleZ));
+			_mm256_storeu_ps(elements[11] + i, zero);
+			_mm256_storeu_ps(elements[12] + i, _mm256_loadu_ps(transforms.positionX.data() + i));
+			_mm256_storeu_ps(elements[13] + i, _mm256_loadu_ps(transforms.positionY.data() + i));
+			_mm256_storeu_ps(elements[14] + i, _mm256_loadu_ps(transforms.positionZ.data() + i));
+			_mm256_storeu_ps(elements[15] + i, one);
+		}
+		for (; i < first + count; i++)
+		{
+			ComposeTransformScalar(transforms, matrices, i);
+		}
+	}
+#endif
+
+	int DetectInstructionSet()
+	{
+#ifdef TRANSFORM_KERNEL_X86
+#if defined(_MSC_VER)
+		int info[4] = { 0 };
+		__cpuid(info, 0);
+		int highestFunction = info[0];
+		__cpuid(info, 1);
+		bool bSSE2 = (info[3] & (1 << 26)) != 0;
+		bool bOSXSAVE = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		bool bAVX2 = false;
+		if ((bOSXSAVE) && (bAVX) && (highestFunction >= 7) &&
+			((_xgetbv(0) & 6) == 6))
+		{
+			__cpuidex(info, 7, 0);
+			bAVX2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		bool bSSE2 = __builtin_cpu_supports("sse2");
+		bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+		if (bAVX2)
+		{
+			return(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2);
+		}
+		if (bSSE2)
+		{
+			return(TransformKernel::TRANSFORM_INSTRUCTIONS_SSE2);
+		}
+#endif
+		return(TransformKernel::TRANSFORM_INSTRUCTIONS_SCALAR);
+	}
+
+	const int g_SupportedInstructionSet = DetectInstructionSet();
+	std::atomic<int> g_InstructionSet(g_SupportedInstructionSet);
+
+	COMPOSE_TRANSFORMS GetKernelFunction()
+	{
+#ifdef TRANSFORM_KERNEL_X86
+		switch (g_InstructionSet.load())
+		{
+		case TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2:
+			return(ComposeTransformsAVX2);
+		case TransformKernel::TRANSFORM_INSTRUCTIONS_SSE2:
+			return(ComposeTransformsSSE2);
+		default:
+			break;
+		}
+#endif
+		return(ComposeTransformsScalar);
+	}
+}
+
+/***********************************************************
+ *  TRANSFORM_ARRAYS::Resize()
+ *
+ *  This method is used for resizing every array to hold the
+ *  passed in number of transforms.
+ ***********************************************************/
+void TransformKernel::TRANSFORM_ARRAYS::Resize(size_t count)
+{
+	scaleX.resize(count);
+	scaleY.resize(count);
+	scaleZ.resize(count);
+	rotationX.resize(count);
+	rotationY.resize(count);
+	rotationZ.resize(count);
+	positionX.resize(count);
+	positionY.resize(count);
+	positionZ.resize(count);
+}
+
+/***********************************************************
+ *  TRANSFORM_ARRAYS::Set()
+ *
+ *  This method is used for storing one transform.
+ ***********************************************************/
+void TransformKernel::TRANSFORM_ARRAYS::Set(size_t index, glm::vec3 scale,
+	glm::vec3 rotationDegrees, glm::vec3 position)
+{
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+	rotationX[index] = rotationDegrees.x;
+	rotationY[index] = rotationDegrees.y;
+	rotationZ[index] = rotationDegrees.z;
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+}
+
+/***********************************************************
+ *  TRANSFORM_ARRAYS::Get()
+ *
+ *  This method is used for reading back one transform.
+ ***********************************************************/
+void TransformKernel::TRANSFORM_ARRAYS::Get(size_t index, glm::vec3& scale,
+	glm::vec3& rotationDegrees, glm::vec3& position) const
+{
+	scale = glm::vec3(scaleX[index], scaleY[index], scaleZ[index]);
+	rotationDegrees = glm::vec3(rotationX[index], rotationY[index], rotationZ[index]);
+	position = glm::vec3(positionX[index], positionY[index], positionZ[index]);
+}
+
+/***********************************************************
+ *  MATRIX_ARRAYS::Resize()
+ *
+ *  This method is used for resizing every array to hold the
+ *  passed in number of matrices.
+ ***********************************************************/
+void TransformKernel::MATRIX_ARRAYS::Resize(size_t count)
+{
+	for (int e = 0; e < 16; e++)
+	{
+		elements[e].resize(count);
+	}
+}
+
+/***********************************************************
+ *  MATRIX_ARRAYS::GetMatrix()
+ *
+ *  This method is used for gathering one matrix out of the
+ *  element arrays.
+ ***********************************************************/
+glm::mat4 TransformKernel::MATRIX_ARRAYS::GetMatrix(size_t index) const
+{
+	glm::mat4 matrix;
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			matrix[column][row] = elements[column * 4 + row][index];
+		}
+	}
+
+	return(matrix);
+}
+
+/***********************************************************
+ *  ComposeTransforms()
+ *
+ *  This method is used for building the matrices of a range
+ *  of transforms with the fastest kernel in use.  A range
+ *  that runs past the end of either set of arrays is ignored.
+ ***********************************************************/
+void TransformKernel::ComposeTransforms(const TRANSFORM_ARRAYS& transforms, MATRIX_ARRAYS& matrices,
+	size_t first, size_t count)
+{
+	if ((count == 0) ||
+		(first + count > transforms.Size()) ||
+		(first + count > matrices.Size()))
+	{
+		return;
+	}
+
+	GetKernelFunction()(transforms, matrices, first, count);
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used for getting the kernels in use.
+ ***********************************************************/
+TransformKernel::TRANSFORM_INSTRUCTION_SET TransformKernel::GetInstructionSet()
+{
+	return((TRANSFORM_INSTRUCTION_SET)g_InstructionSet.load());
+}
+
+/***********************************************************
+ *  GetInstructionSetName()
+ *
+ *  This method is used for getting the name of the kernels
+ *  in use.
+ ***********************************************************/
+const char* TransformKernel::GetInstructionSetName()
+{
+	switch (GetInstructionSet())
+	{
+	case TRANSFORM_INSTRUCTIONS_AVX2:
+		return("AVX2");
+	case TRANSFORM_INSTRUCTIONS_SSE2:
+		return("SSE2");
+	default:
+		return("scalar");
+	}
+}
+
+/***********************************************************
+ *  SetInstructionSet()
+ *
+ *  This method is used for switching to slower kernels than
+ *  the CPU supports.  Faster ones than supported are ignored.
+ ***********************************************************/
+void TransformKernel::SetInstructionSet(TRANSFORM_INSTRUCTION_SET instructionSet)
+{
+	g_InstructionSet = std::min((int)instructionSet, g_SupportedInstructionSet);
+}
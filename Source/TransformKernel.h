@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.h
+// ============
+// build model matrices for many transforms at once
+//
+// Each transform is a scale, a rotation around X, Y and then Z in degrees,
+// and a position, and is turned into the same matrix as
+// translation * rotationZ * rotationY * rotationX * scale. Instead of
+// multiplying four matrices, every element of the result is written out
+// directly from the sines and cosines of the three angles. The transforms
+// and the matrices are kept as structures of arrays, one array per value, so
+// the SSE2 and AVX2 kernels work on 4 or 8 transforms per instruction, and
+// the sines and cosines are evaluated with the same polynomial in every
+// kernel so they all produce the same matrices.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class TransformKernel
+{
+public:
+	// kernels used for the matrices, fastest supported one by default
+	enum TRANSFORM_INSTRUCTION_SET
+	{
+		TRANSFORM_INSTRUCTIONS_SCALAR = 0,
+		TRANSFORM_INSTRUCTIONS_SSE2,
+		TRANSFORM_INSTRUCTIONS_AVX2
+	};
+
+	// transforms, one array per value and one element per transform
+	struct TRANSFORM_ARRAYS
+	{
+		std::vector<float> scaleX;
+		std::vector<float> scaleY;
+		std::vector<float> scaleZ;
+		std::vector<float> rotationX;   // degrees
+		std::vector<float> rotationY;
+		std::vector<float> rotationZ;
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+
+		void Resize(size_t count);
+		size_t Size() const { return(scaleX.size()); }
+		// copy one transform in or out
+		void Set(size_t index, glm::vec3 scale, glm::vec3 rotationDegrees, glm::vec3 position);
+		void Get(size_t index, glm::vec3& scale, glm::vec3& rotationDegrees, glm::vec3& position) const;
+	};
+
+	// matrices, one array per element - elements[column * 4 + row], the
+	// same order as the floats of a glm::mat4
+	struct MATRIX_ARRAYS
+	{
+		std::vector<float> elements[16];
+
+		void Resize(size_t count);
+		size_t Size() const { return(elements[0].size()); }
+		glm::mat4 GetMatrix(size_t index) const;
+	};
+
+	// build the matrices of count transforms, starting at first in both
+	// arrays - the matrices have to be sized to hold them
+	static void ComposeTransforms(const TRANSFORM_ARRAYS& transforms, MATRIX_ARRAYS& matrices,
+		size_t first, size_t count);
+
+	// kernels in use, and their name for logging
+	static TRANSFORM_INSTRUCTION_SET GetInstructionSet();
+	static const char* GetInstructionSetName();
+	// use slower kernels than the CPU supports - for comparing the output
+	static void SetInstructionSet(TRANSFORM_INSTRUCTION_SET instructionSet);
+};
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ============
+// C++ mirrors of the std140 uniform blocks declared in the GLSL shaders, and
+// the binding points they are attached to. The layouts here must match the
+// block declarations in shaders/vertexShader.glsl and fragmentShader.glsl
+// byte for byte - vec3 members are padded out to 16 bytes as std140 requires.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+// number of point lights declared in the fragment shader
+#define TOTAL_POINT_LIGHTS 5
+// number of entries in the shader material table
+#define TOTAL_MATERIALS 32
+// number of texture arrays (one per image size and format) the shader samples
+#define TOTAL_TEXTURE_ARRAYS 8
+// the last texture array holds the placeholder shown until a texture is loaded
+#define PLACEHOLDER_TEXTURE_ARRAY (TOTAL_TEXTURE_ARRAYS - 1)
+
+// uniform buffer binding points shared by every shader program
+enum UNIFORM_BLOCK_BINDING
+{
+	UNIFORM_BLOCK_FRAME = 0,   // FrameData - camera and flashlight, every frame
+	UNIFORM_BLOCK_LIGHTS = 1,  // LightData - scene light sources
+	UNIFORM_BLOCK_MATERIALS = 2 // MaterialData - table indexed by materialIndex
+};
+
+// std140 layout of a DirectionalLight / PointLight struct (64 bytes)
+struct LIGHT_STD140
+{
+	glm::vec3 position;  // direction for the directional light
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// std140 layout of the SpotLight struct (96 bytes)
+struct SPOT_LIGHT_STD140
+{
+	glm::vec3 position;
+	float padding0;
+	glm::vec3 direction;
+	float cutOff;
+	float outerCutOff;
+	float constant;
+	float linear;
+	float quadratic;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	int bActive;
+};
+
+// std140 layout of the Material struct (32 bytes) - shininess
+// packs into the padding after specularColor
+struct MATERIAL_STD140
+{
+	glm::vec3 diffuseColor;
+	float padding0;
+	glm::vec3 specularColor;
+	float shininess;
+};
+
+// layout(std140) uniform FrameData (176 bytes)
+struct FRAME_DATA_BLOCK
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 viewPosition;
+	float padding0;
+	glm::vec3 flashlightPosition;
+	float padding1;
+	glm::vec3 flashlightDirection;
+	int bFlashlightActive;
+};
+
+// layout(std140) uniform LightData (480 bytes)
+struct LIGHT_DATA_BLOCK
+{
+	LIGHT_STD140 directionalLight;
+	LIGHT_STD140 pointLights[TOTAL_POINT_LIGHTS];
+	SPOT_LIGHT_STD140 spotLight;
+};
+
+// layout(std140) uniform MaterialData (1024 bytes)
+struct MATERIAL_DATA_BLOCK
+{
+	MATERIAL_STD140 materials[TOTAL_MATERIALS];
+};
+
+static_assert(sizeof(LIGHT_STD140) == 64, "LIGHT_STD140 must match the std140 layout");
+static_assert(sizeof(SPOT_LIGHT_STD140) == 96, "SPOT_LIGHT_STD140 must match the std140 layout");
+static_assert(sizeof(FRAME_DATA_BLOCK) == 176, "FRAME_DATA_BLOCK must match the std140 layout");
+static_assert(sizeof(LIGHT_DATA_BLOCK) == 480, "LIGHT_DATA_BLOCK must match the std140 layout");
+static_assert(sizeof(MATERIAL_STD140) == 32, "MATERIAL_STD140 must match the std140 layout");
+static_assert(sizeof(MATERIAL_DATA_BLOCK) == 1024, "MATERIAL_DATA_BLOCK must match the std140 layout");
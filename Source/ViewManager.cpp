@@ -8,6 +8,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "UniformBlocks.h"
+#include "GLStateCache.h"
 
 // GLM Math Header inclusions
 #define GLM_ENABLE_EXPERIMENTAL
@@ -15,14 +17,16 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <fstream>
+#include <vector>
+
 // declaration of the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000; //1000
 	const int WINDOW_HEIGHT = 800; //800
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+	const char* g_FrameDataBlockName = "FrameData";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -44,6 +48,10 @@ namespace
 	// flashlight
 	bool g_FlashlightOn = false;
 
+	// frame statistics key state, used to react once per key press
+	bool g_FrameStatsKeyDown = false;
+	bool g_FrameStatsRequested = false;
+
 }
 
 /***********************************************************
@@ -57,6 +65,14 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pLoaderWindow = NULL;
+	m_bHeadless = false;
+	m_offscreenFBO = 0;
+	m_offscreenColor = 0;
+	m_offscreenDepth = 0;
+	m_bTopRowFirst = false;
+	m_frameDataUBO = 0;
+	m_viewProjection = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 10.0f, 12.0f);
@@ -76,6 +92,32 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	if (NULL != m_pLoaderWindow)
+	{
+		glfwDestroyWindow(m_pLoaderWindow);
+		m_pLoaderWindow = NULL;
+	}
+	if (0 != m_frameDataUBO)
+	{
+		glDeleteBuffers(1, &m_frameDataUBO);
+		m_frameDataUBO = 0;
+	}
+	if (0 != m_offscreenFBO)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &m_offscreenFBO);
+		m_offscreenFBO = 0;
+	}
+	if (0 != m_offscreenColor)
+	{
+		glDeleteRenderbuffers(1, &m_offscreenColor);
+		m_offscreenColor = 0;
+	}
+	if (0 != m_offscreenDepth)
+	{
+		glDeleteRenderbuffers(1, &m_offscreenDepth);
+		m_offscreenDepth = 0;
+	}
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -87,17 +129,25 @@ ViewManager::~ViewManager()
  *  CreateDisplayWindow()
  *
  *  This method is used to create the main display window.
+ *  When headless, the window is never shown and takes no
+ *  input - the scene is rendered into the offscreen target
+ *  instead, see CreateOffscreenTarget().
  ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle, bool bHeadless)
 {
 	GLFWwindow* window = nullptr;
 
 	// try to create the displayed OpenGL window
+	if (bHeadless)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 	window = glfwCreateWindow(
 		WINDOW_WIDTH,
 		WINDOW_HEIGHT,
 		windowTitle,
 		NULL, NULL);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
 	if (window == NULL)
 	{
 		std::cout << "Failed to create GLFW window" << std::endl;
@@ -106,27 +156,161 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
-	// tell GLFW to capture all mouse events
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// this callback is used to receive window resize events
-	glfwSetFramebufferSizeCallback(window, &ViewManager::Window_Resize_Callback);
-	// this callback is used to receive scroll wheel events
-	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
-	// this callback is used to receive mouse moving events
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
-	// this callback is used to receive mouse button press events
-	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
-
+	if (false == bHeadless)
+	{
+		// tell GLFW to capture all mouse events
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+		// this callback is used to receive window resize events
+		glfwSetFramebufferSizeCallback(window, &ViewManager::Window_Resize_Callback);
+		// this callback is used to receive scroll wheel events
+		glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
+		// this callback is used to receive mouse moving events
+		glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+		// this callback is used to receive mouse button press events
+		glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+	}
 
 	// enable blending for supporting transparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLStateCache::Enable(GL_BLEND);
+	GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	m_pWindow = window;
+	m_bHeadless = bHeadless;
 
 	return(window);
 }
+
+/***********************************************************
+ *  CreateOffscreenTarget()
+ *
+ *  This method is used to create a framebuffer the size of
+ *  the display window, with 8-bit color and a 24-bit depth
+ *  buffer, and to leave it bound so every frame is rendered
+ *  into it.  The hidden window's own buffers are not used,
+ *  as drivers are free to leave them undefined.
+ *
+ *  Mesa stores window buffers top row first and renders
+ *  into them upside down, which breaks the ties of triangle
+ *  edges through pixel centers the other way.  The offscreen
+ *  frame is rendered with an upper left origin as well, so
+ *  it matches what the window shows pixel for pixel.
+ ***********************************************************/
+bool ViewManager::CreateOffscreenTarget()
+{
+	if (0 != m_offscreenFBO)
+	{
+		return(true);
+	}
+
+	glGenRenderbuffers(1, &m_offscreenColor);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WINDOW_WIDTH, WINDOW_HEIGHT);
+	glGenRenderbuffers(1, &m_offscreenDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, WINDOW_WIDTH, WINDOW_HEIGHT);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_offscreenFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreenColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_offscreenDepth);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		std::cout << "Failed to create the offscreen framebuffer, status:0x" << std::hex << status << std::dec << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return(false);
+	}
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	if (GLEW_VERSION_4_5)
+	{
+		glClipControl(GL_UPPER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+		m_bTopRowFirst = true;
+	}
+
+	std::cout << "Offscreen target:" << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SaveFrameImage()
+ *
+ *  This method is used to read back the frame rendered last,
+ *  from the offscreen target when there is one, and to write
+ *  it to a binary PPM file.  OpenGL returns the rows bottom
+ *  up unless the frame was rendered top row first, so they
+ *  are written in reverse.
+ ***********************************************************/
+bool ViewManager::SaveFrameImage(const char* filePath)
+{
+	if ((NULL == m_pWindow) || (NULL == filePath))
+	{
+		return(false);
+	}
+
+	const int rowBytes = WINDOW_WIDTH * 3;
+	std::vector<unsigned char> pixels((size_t)rowBytes * WINDOW_HEIGHT);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_offscreenFBO);
+	glReadBuffer((0 != m_offscreenFBO) ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write the frame image:" << filePath << std::endl;
+		return(false);
+	}
+	file << "P6\n" << WINDOW_WIDTH << " " << WINDOW_HEIGHT << "\n255\n";
+	for (int i = 0; i < WINDOW_HEIGHT; i++)
+	{
+		int row = (m_bTopRowFirst) ? i : (WINDOW_HEIGHT - 1 - i);
+		file.write((const char*)&pixels[(size_t)row * rowBytes], rowBytes);
+	}
+	if (!file)
+	{
+		std::cout << "Could not write the frame image:" << filePath << std::endl;
+		return(false);
+	}
+
+	std::cout << "Frame image:" << filePath << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CreateLoaderContext()
+ *
+ *  This method is used to create a hidden window whose OpenGL
+ *  context shares textures, buffers and sync objects with the
+ *  display window.  The context can then be made current on a
+ *  loader thread to upload resources while the display window
+ *  keeps rendering.
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateLoaderContext()
+{
+	if (NULL == m_pWindow)
+	{
+		return(NULL);
+	}
+
+	if (NULL == m_pLoaderWindow)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		m_pLoaderWindow = glfwCreateWindow(1, 1, "Resource Loader", NULL, m_pWindow);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+		if (NULL == m_pLoaderWindow)
+		{
+			std::cout << "Failed to create the resource loader context, resources will be loaded on the render thread" << std::endl;
+		}
+	}
+
+	return(m_pLoaderWindow);
+}
 /***********************************************************
  *  MouseButtonCallback()
  *
@@ -291,6 +475,45 @@ void ViewManager::ProcessKeyboardEvents()
 		g_pCamera->Zoom = 80;
 		
 	}
+
+	// print the frame statistics once per key press
+	bool bFrameStatsKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_F) == GLFW_PRESS);
+	if (bFrameStatsKeyDown && !g_FrameStatsKeyDown)
+	{
+		g_FrameStatsRequested = true;
+	}
+	g_FrameStatsKeyDown = bFrameStatsKeyDown;
+}
+
+/***********************************************************
+ *  IsFrameStatsRequested()
+ *
+ *  This method returns true once after the frame statistics
+ *  key has been pressed.
+ ***********************************************************/
+bool ViewManager::IsFrameStatsRequested()
+{
+	bool bRequested = g_FrameStatsRequested;
+	g_FrameStatsRequested = false;
+	return(bRequested);
+}
+
+/***********************************************************
+ *  CreateFrameDataBuffer()
+ *
+ *  This method is used for creating the uniform buffer that
+ *  holds the per-frame camera and flashlight settings and
+ *  attaching it to the FrameData block of the shaders.
+ ***********************************************************/
+void ViewManager::CreateFrameDataBuffer()
+{
+	glGenBuffers(1, &m_frameDataUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameDataUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FRAME_DATA_BLOCK), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_FRAME, m_frameDataUBO);
+
+	m_pShaderManager->SetUniformBlockBinding(g_FrameDataBlockName, UNIFORM_BLOCK_FRAME);
 }
 
 /***********************************************************
@@ -332,20 +555,33 @@ void ViewManager::PrepareSceneView()
 			-(GLfloat)WINDOW_HEIGHT / (2.0f * g_pCamera->Zoom), (GLfloat)WINDOW_HEIGHT / (2.0f * g_pCamera->Zoom),
 			0.1f, 100.0f);
 	}
+
+	// kept so the draws outside the view can be skipped
+	m_viewProjection = projection * view;
 	
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		if (0 == m_frameDataUBO)
+		{
+			CreateFrameDataBuffer();
+		}
+
+		FRAME_DATA_BLOCK frameData = {};
+		// the view and projection matrices for proper rendering
+		frameData.view = view;
+		frameData.projection = projection;
+		// the view position of the camera for proper rendering
+		frameData.viewPosition = g_pCamera->Position;
 
 		// This is for the flashlight
-		m_pShaderManager->setVec3Value("spotLight.position", g_pCamera->Position);
-		m_pShaderManager->setVec3Value("spotLight.direction", g_pCamera->Front);
-		m_pShaderManager->setBoolValue("spotLight.bActive", g_FlashlightOn); //change bool state depending on mouse press
+		frameData.flashlightPosition = g_pCamera->Position;
+		frameData.flashlightDirection = g_pCamera->Front;
+		frameData.bFlashlightActive = g_FlashlightOn; //change bool state depending on mouse press
+
+		// upload the whole block with a single buffer update
+		glBindBuffer(GL_UNIFORM_BUFFER, m_frameDataUBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FRAME_DATA_BLOCK), &frameData);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	}
 }
\ No newline at end of file
@@ -39,14 +39,50 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// hidden window owning the resource loader's shared OpenGL context
+	GLFWwindow* m_pLoaderWindow;
+	// true when the window is hidden and the scene is rendered offscreen
+	bool m_bHeadless;
+	// framebuffer the scene is rendered into in headless mode, with its
+	// color and depth renderbuffers
+	GLuint m_offscreenFBO;
+	GLuint m_offscreenColor;
+	GLuint m_offscreenDepth;
+	// true when the offscreen frame is rendered with its first row at
+	// the top, see CreateOffscreenTarget()
+	bool m_bTopRowFirst;
+
+	// uniform buffer holding the FrameData block
+	GLuint m_frameDataUBO;
+	// projection * view of the last prepared frame
+	glm::mat4 m_viewProjection;
+
+	// create the uniform buffer for the per-frame view settings
+	void CreateFrameDataBuffer();
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
 
 public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// create the initial OpenGL display window, hidden and without
+	// input when headless
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle, bool bHeadless = false);
+	// create and bind the framebuffer the scene is rendered into when
+	// headless, once GLEW is initialized
+	bool CreateOffscreenTarget();
+	// true when the scene is rendered without a visible window
+	bool IsHeadless() const { return(m_bHeadless); }
+	// read back the rendered frame and write it to a binary PPM file
+	bool SaveFrameImage(const char* filePath);
+	// create a hidden window whose OpenGL context shares its
+	// objects with the display window, for loading on another thread
+	GLFWwindow* CreateLoaderContext();
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// true once after the frame statistics key has been pressed
+	bool IsFrameStatsRequested();
+	// projection * view of the last prepared frame, for culling
+	const glm::mat4& GetViewProjection() const { return(m_viewProjection); }
 };
\ No newline at end of file
@@ -0,0 +1,533 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchytests.cpp
+// ============
+// unit tests and benchmarks of the bounding volume hierarchy
+//
+// Every query is compared with testing each item box on its own, over random
+// boxes, both after the tree is built and after the boxes move and it is
+// refit. The benchmarks time building, refitting and each query over 10^3 to
+// 10^6 boxes, next to the brute force loop the tree replaces.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "BoundingVolumeHierarchy.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	typedef BoundingVolumeHierarchy::BOX BOX;
+
+	// a ray or sphere query, in world space
+	struct QUERY
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		float radius;
+	};
+
+	/***********************************************************
+	 *  RandomBoxes()
+	 *
+	 *  This function is used for making boxes of up to four
+	 *  units on a side scattered through a cube, the size of
+	 *  the cube growing with the count so the density stays
+	 *  about the same.
+	 ***********************************************************/
+	std::vector<BOX> RandomBoxes(int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		float extent = 10.0f * std::cbrt((float)count);
+
+		std::vector<BOX> boxes(count);
+		for (BOX& box : boxes)
+		{
+			glm::vec3 center(RandomFloat(random, -extent, extent),
+				RandomFloat(random, -extent, extent), RandomFloat(random, -extent, extent));
+			glm::vec3 halfSize(RandomFloat(random, 0.05f, 2.0f),
+				RandomFloat(random, 0.05f, 2.0f), RandomFloat(random, 0.05f, 2.0f));
+			box.minimum = center - halfSize;
+			box.maximum = center + halfSize;
+		}
+
+		return(boxes);
+	}
+
+	/***********************************************************
+	 *  MoveBoxes()
+	 *
+	 *  This function is used for moving every box a random
+	 *  distance, the way the draws move between frames.
+	 ***********************************************************/
+	void MoveBoxes(std::vector<BOX>& boxes, float distance, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		for (BOX& box : boxes)
+		{
+			glm::vec3 offset(RandomFloat(random, -distance, distance),
+				RandomFloat(random, -distance, distance), RandomFloat(random, -distance, distance));
+			box.minimum += offset;
+			box.maximum += offset;
+		}
+	}
+
+	/***********************************************************
+	 *  RandomQueries()
+	 *
+	 *  This function is used for making rays and spheres that
+	 *  start inside the cube the boxes are scattered through.
+	 ***********************************************************/
+	std::vector<QUERY> RandomQueries(int count, float extent, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+
+		std::vector<QUERY> queries(count);
+		for (QUERY& query : queries)
+		{
+			query.origin = glm::vec3(RandomFloat(random, -extent, extent),
+				RandomFloat(random, -extent, extent), RandomFloat(random, -extent, extent));
+			query.direction = glm::vec3(RandomFloat(random, -1.0f, 1.0f),
+				RandomFloat(random, -1.0f, 1.0f), RandomFloat(random, -1.0f, 1.0f));
+			if (glm::dot(query.direction, query.direction) < 0.0001f)
+			{
+				query.direction = glm::vec3(0.0f, 0.0f, -1.0f);
+			}
+			query.direction = glm::normalize(query.direction);
+			query.radius = RandomFloat(random, 0.5f, 10.0f);
+		}
+
+		// rays along the axes, which divide by zero in the slab test
+		queries[0].direction = glm::vec3(1.0f, 0.0f, 0.0f);
+		queries[1 % count].direction = glm::vec3(0.0f, -1.0f, 0.0f);
+		queries[2 % count].direction = glm::vec3(0.0f, 0.0f, 1.0f);
+
+		return(queries);
+	}
+
+	/***********************************************************
+	 *  MakeFrustums()
+	 *
+	 *  This function is used for making view volumes looking
+	 *  from several places in several directions, with both a
+	 *  perspective and an orthographic projection.
+	 ***********************************************************/
+	std::vector<Frustum> MakeFrustums(float extent)
+	{
+		std::vector<Frustum> frustums;
+		glm::mat4 perspective = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, extent);
+		glm::mat4 orthographic = glm::ortho(-extent * 0.25f, extent * 0.25f,
+			-extent * 0.2f, extent * 0.2f, 0.1f, extent);
+
+		const glm::vec3 eyes[] =
+		{
+			glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(extent, extent * 0.5f, extent),
+			glm::vec3(-extent * 0.3f, -extent * 0.8f, extent * 0.1f),
+			glm::vec3(extent * 2.0f, 0.0f, 0.0f)
+		};
+		for (const glm::vec3& eye : eyes)
+		{
+			glm::mat4 view = glm::lookAt(eye, glm::vec3(extent * 0.1f, 0.0f, -extent * 0.2f),
+				glm::vec3(0.0f, 1.0f, 0.0f));
+
+			Frustum frustum;
+			frustum.SetViewProjection(perspective * view);
+			frustums.push_back(frustum);
+			frustum.SetViewProjection(orthographic * view);
+			frustums.push_back(frustum);
+		}
+
+		return(frustums);
+	}
+
+	/***********************************************************
+	 *  BruteForceFrustum()
+	 *
+	 *  This function returns the items whose boxes intersect
+	 *  the view volume, testing every box.
+	 ***********************************************************/
+	std::vector<int> BruteForceFrustum(const std::vector<BOX>& boxes, const Frustum& frustum)
+	{
+		std::vector<int> items;
+		for (int item = 0; item < (int)boxes.size(); item++)
+		{
+			if (frustum.IntersectsBox(boxes[item].minimum, boxes[item].maximum))
+			{
+				items.push_back(item);
+			}
+		}
+
+		return(items);
+	}
+
+	/***********************************************************
+	 *  BruteForceRay()
+	 *
+	 *  This function returns the distance to the nearest box
+	 *  the ray enters before maxDistance, or maxDistance if it
+	 *  enters none.  A ray starting inside a box enters it at
+	 *  zero.
+	 ***********************************************************/
+	float BruteForceRay(const std::vector<BOX>& boxes, glm::vec3 origin, glm::vec3 direction,
+		float maxDistance)
+	{
+		glm::vec3 inverseDirection = 1.0f / direction;
+
+		float nearest = maxDistance;
+		for (const BOX& box : boxes)
+		{
+			glm::vec3 t0 = (box.minimum - origin) * inverseDirection;
+			glm::vec3 t1 = (box.maximum - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+			float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+			if ((entry <= exit) && (entry < nearest))
+			{
+				nearest = entry;
+			}
+		}
+
+		return(nearest);
+	}
+
+	/***********************************************************
+	 *  BoxDistanceSquared()
+	 *
+	 *  This function returns the squared distance from a point
+	 *  to the nearest point of a box, zero inside it.
+	 ***********************************************************/
+	float BoxDistanceSquared(const BOX& box, glm::vec3 point)
+	{
+		glm::vec3 offset = glm::clamp(point, box.minimum, box.maximum) - point;
+		return(glm::dot(offset, offset));
+	}
+
+	/***********************************************************
+	 *  BruteForceSphere()
+	 *
+	 *  This function returns the items whose boxes intersect
+	 *  the sphere, testing every box.
+	 ***********************************************************/
+	std::vector<int> BruteForceSphere(const std::vector<BOX>& boxes, glm::vec3 center, float radius)
+	{
+		std::vector<int> items;
+		for (int item = 0; item < (int)boxes.size(); item++)
+		{
+			if (BoxDistanceSquared(boxes[item], center) <= radius * radius)
+			{
+				items.push_back(item);
+			}
+		}
+
+		return(items);
+	}
+
+	/***********************************************************
+	 *  CheckNodes()
+	 *
+	 *  This function is used for checking that every node box
+	 *  holds the boxes of its children or its items, and that
+	 *  the leaves hold each item once.
+	 ***********************************************************/
+	void CheckNodes(const BoundingVolumeHierarchy& tree, const std::vector<BOX>& boxes)
+	{
+		const std::vector<BoundingVolumeHierarchy::NODE>& nodes = tree.GetNodes();
+		CHECK(tree.GetItemCount() == (int)boxes.size());
+
+		int leafItems = 0;
+		for (int nodeIndex = 0; nodeIndex < (int)nodes.size(); nodeIndex++)
+		{
+			const BoundingVolumeHierarchy::NODE& node = nodes[nodeIndex];
+			if (node.itemCount > 0)
+			{
+				leafItems += node.itemCount;
+				CHECK(node.index >= 0);
+				CHECK(node.index + node.itemCount <= (int)boxes.size());
+				continue;
+			}
+
+			CHECK(node.index > nodeIndex + 1);
+			CHECK(node.index < (int)nodes.size());
+			const BoundingVolumeHierarchy::NODE& left = nodes[nodeIndex + 1];
+			const BoundingVolumeHierarchy::NODE& right = nodes[node.index];
+			CHECK(glm::all(glm::lessThanEqual(node.minimum, glm::min(left.minimum, right.minimum))));
+			CHECK(glm::all(glm::greaterThanEqual(node.maximum, glm::max(left.maximum, right.maximum))));
+		}
+		CHECK(leafItems == (int)boxes.size());
+
+		// the root holds every item
+		if (!nodes.empty())
+		{
+			for (const BOX& box : boxes)
+			{
+				CHECK(glm::all(glm::lessThanEqual(nodes[0].minimum, box.minimum)));
+				CHECK(glm::all(glm::greaterThanEqual(nodes[0].maximum, box.maximum)));
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  CheckQueries()
+	 *
+	 *  This function is used for comparing every query of the
+	 *  tree with the brute force answer over the same boxes.
+	 ***********************************************************/
+	void CheckQueries(const BoundingVolumeHierarchy& tree, const std::vector<BOX>& boxes, float extent)
+	{
+		std::vector<int> items;
+		for (const Frustum& frustum : MakeFrustums(extent))
+		{
+			items.clear();
+			tree.QueryFrustum(frustum, items);
+			std::sort(items.begin(), items.end());
+			CHECK(items == BruteForceFrustum(boxes, frustum));
+		}
+
+		for (const QUERY& query : RandomQueries(200, extent, 7))
+		{
+			float maxDistance = extent;
+			int item = -1;
+			float distance = 0.0f;
+			bool bHit = tree.QueryRay(query.origin, query.direction, maxDistance, item, distance);
+
+			// several boxes can be entered at the same distance, so
+			// the nearest distance is compared rather than the item
+			float expected = BruteForceRay(boxes, query.origin, query.direction, maxDistance);
+			CHECK(bHit == (expected < maxDistance));
+			CHECK(distance == expected);
+			if (bHit)
+			{
+				CHECK((item >= 0) && (item < (int)boxes.size()));
+				CHECK(BruteForceRay(std::vector<BOX>(1, boxes[item]), query.origin,
+					query.direction, maxDistance) == distance);
+			}
+
+			items.clear();
+			tree.QuerySphere(query.origin, query.radius, items);
+			std::sort(items.begin(), items.end());
+			CHECK(items == BruteForceSphere(boxes, query.origin, query.radius));
+		}
+	}
+
+	/***********************************************************
+	 *  PrintTime()
+	 *
+	 *  This function is used for printing one benchmark time.
+	 ***********************************************************/
+	void PrintTime(const char* label, int boxCount, double milliseconds)
+	{
+		std::cout << "  " << std::left << std::setw(22) << label << std::right
+			<< std::setw(8) << boxCount << " boxes: "
+			<< std::fixed << std::setprecision(4) << std::setw(12) << milliseconds << " ms"
+			<< std::endl;
+	}
+}
+
+TEST_CASE(HierarchyEmptyTree)
+{
+	BoundingVolumeHierarchy tree;
+	tree.Build(std::vector<BOX>());
+	CHECK(tree.GetNodeCount() == 0);
+	CHECK(tree.GetItemCount() == 0);
+
+	std::vector<int> items;
+	Frustum frustum;
+	CHECK(tree.QueryFrustum(frustum, items) == 0);
+	CHECK(items.empty());
+
+	int item = 5;
+	float distance = 0.0f;
+	CHECK(!tree.QueryRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 100.0f, item, distance));
+	CHECK(item == -1);
+
+	tree.QuerySphere(glm::vec3(0.0f), 100.0f, items);
+	CHECK(items.empty());
+}
+
+TEST_CASE(HierarchyClear)
+{
+	BoundingVolumeHierarchy tree;
+	tree.Build(RandomBoxes(100, 1));
+	CHECK(tree.GetItemCount() == 100);
+	CHECK(tree.GetNodeCount() > 0);
+
+	tree.Clear();
+	CHECK(tree.GetNodeCount() == 0);
+	CHECK(tree.GetItemCount() == 0);
+}
+
+TEST_CASE(HierarchySingleItem)
+{
+	std::vector<BOX> boxes(1);
+	boxes[0].minimum = glm::vec3(-1.0f, -1.0f, -6.0f);
+	boxes[0].maximum = glm::vec3(1.0f, 1.0f, -4.0f);
+
+	BoundingVolumeHierarchy tree;
+	tree.Build(boxes);
+	CHECK(tree.GetNodeCount() == 1);
+	CheckNodes(tree, boxes);
+
+	int item = -1;
+	float distance = 0.0f;
+	CHECK(tree.QueryRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 100.0f, item, distance));
+	CHECK(item == 0);
+	CHECK_NEAR(distance, 4.0f, 1e-6);
+	CHECK(!tree.QueryRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 3.0f, item, distance));
+	CHECK(!tree.QueryRay(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 100.0f, item, distance));
+
+	std::vector<int> items;
+	tree.QuerySphere(glm::vec3(0.0f), 4.0f, items);
+	CHECK(items.size() == 1);
+	items.clear();
+	tree.QuerySphere(glm::vec3(0.0f), 3.9f, items);
+	CHECK(items.empty());
+}
+
+TEST_CASE(HierarchyQueriesMatchBruteForce)
+{
+	const int counts[] = { 2, 3, 17, 1000, 20000 };
+	for (int count : counts)
+	{
+		std::vector<BOX> boxes = RandomBoxes(count, 100 + count);
+		BoundingVolumeHierarchy tree;
+		tree.Build(boxes);
+
+		CheckNodes(tree, boxes);
+		CheckQueries(tree, boxes, 10.0f * std::cbrt((float)count));
+	}
+}
+
+TEST_CASE(HierarchyCoincidentBoxes)
+{
+	// every center in the same place leaves nothing to split on
+	std::vector<BOX> boxes(300);
+	for (int i = 0; i < (int)boxes.size(); i++)
+	{
+		float size = 0.5f + 0.01f * i;
+		boxes[i].minimum = glm::vec3(-size);
+		boxes[i].maximum = glm::vec3(size);
+	}
+
+	BoundingVolumeHierarchy tree;
+	tree.Build(boxes);
+	CheckNodes(tree, boxes);
+	CheckQueries(tree, boxes, 10.0f);
+}
+
+TEST_CASE(HierarchyRefitMatchesBruteForce)
+{
+	std::vector<BOX> boxes = RandomBoxes(5000, 11);
+	float extent = 10.0f * std::cbrt(5000.0f);
+
+	BoundingVolumeHierarchy tree;
+	tree.Build(boxes);
+	int nodeCount = tree.GetNodeCount();
+
+	// small moves, like a frame of animation, then large ones
+	// that scatter the items far from where the tree put them
+	MoveBoxes(boxes, 1.0f, 12);
+	CHECK(tree.Refit(boxes));
+	CHECK(tree.GetNodeCount() == nodeCount);
+	CheckNodes(tree, boxes);
+	CheckQueries(tree, boxes, extent);
+
+	MoveBoxes(boxes, extent, 13);
+	CHECK(tree.Refit(boxes));
+	CheckNodes(tree, boxes);
+	CheckQueries(tree, boxes, extent);
+
+	// refitting with a different number of items is refused
+	boxes.pop_back();
+	CHECK(!tree.Refit(boxes));
+}
+
+BENCHMARK(HierarchyBuildRefitQuery)
+{
+	const int counts[] = { 1000, 10000, 100000, 1000000 };
+	for (int count : counts)
+	{
+		std::vector<BOX> boxes = RandomBoxes(count, 1);
+		float extent = 10.0f * std::cbrt((float)count);
+		std::vector<Frustum> frustums = MakeFrustums(extent);
+		std::vector<QUERY> queries = RandomQueries(1000, extent, 2);
+		int runs = (count >= 100000) ? 1 : 5;
+
+		BoundingVolumeHierarchy tree;
+		PrintTime("Build", count, TimeMilliseconds([&]() { tree.Build(boxes); }, runs));
+
+		std::vector<BOX> moved = boxes;
+		MoveBoxes(moved, 1.0f, 3);
+		PrintTime("Refit", count, TimeMilliseconds([&]() { tree.Refit(moved); }, runs));
+		tree.Build(boxes);
+
+		// per query times, the tree next to testing every box
+		std::vector<int> items;
+		size_t found = 0;
+		double milliseconds = TimeMilliseconds([&]()
+		{
+			for (const Frustum& frustum : frustums)
+			{
+				items.clear();
+				tree.QueryFrustum(frustum, items);
+				found += items.size();
+			}
+		}, runs);
+		PrintTime("QueryFrustum", count, milliseconds / frustums.size());
+		milliseconds = TimeMilliseconds([&]()
+		{
+			for (const Frustum& frustum : frustums)
+			{
+				found += BruteForceFrustum(boxes, frustum).size();
+			}
+		}, runs);
+		PrintTime("BruteForceFrustum", count, milliseconds / frustums.size());
+
+		milliseconds = TimeMilliseconds([&]()
+		{
+			for (const QUERY& query : queries)
+			{
+				int item = -1;
+				float distance = 0.0f;
+				found += tree.QueryRay(query.origin, query.direction, extent, item, distance) ? 1 : 0;
+			}
+		}, runs);
+		PrintTime("QueryRay", count, milliseconds / queries.size());
+		milliseconds = TimeMilliseconds([&]()
+		{
+			for (int i = 0; i < 10; i++)
+			{
+				found += (BruteForceRay(boxes, queries[i].origin, queries[i].direction, extent) < extent) ? 1 : 0;
+			}
+		}, runs);
+		PrintTime("BruteForceRay", count, milliseconds / 10);
+
+		milliseconds = TimeMilliseconds([&]()
+		{
+			for (const QUERY& query : queries)
+			{
+				items.clear();
+				tree.QuerySphere(query.origin, query.radius, items);
+				found += items.size();
+			}
+		}, runs);
+		PrintTime("QuerySphere", count, milliseconds / queries.size());
+		milliseconds = TimeMilliseconds([&]()
+		{
+			for (int i = 0; i < 10; i++)
+			{
+				found += BruteForceSphere(boxes, queries[i].origin, queries[i].radius).size();
+			}
+		}, runs);
+		PrintTime("BruteForceSphere", count, milliseconds / 10);
+
+		// keeps the queries from being optimized away
+		CHECK(found > 0);
+	}
+}
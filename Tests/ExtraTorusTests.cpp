@@ -0,0 +1,419 @@
+///////////////////////////////////////////////////////////////////////////////
+// extratorustests.cpp
+// ============
+// compare the extra torus grid with the generator it replaced
+//
+// GenerateOldExtraTorus() is a copy of the loop LoadExtraTorusMesh1 and
+// LoadExtraTorusMesh2 ran before the extra tori were built as an indexed
+// grid, with the segment counts made parameters and the OpenGL upload left
+// out. The tests check that the grid's vertices are the old generator's bit
+// for bit, and that its triangles are the old triangles less the slivers the
+// old 7-vertex stride drew. The benchmark times both generators and prints
+// the size of their buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "MeshBuilder.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+
+namespace
+{
+	const int g_FloatsPerVertex = MeshBuilder::FLOATS_PER_VERTEX;
+
+	// the old generator's output, before and after welding
+	struct OLD_EXTRA_TORUS
+	{
+		std::vector<float> triangleVertices;   // 7 vertices per quad
+		std::vector<float> vertices;           // welded
+		std::vector<uint32_t> indices;
+	};
+
+	/***********************************************************
+	 *  WeldVertices()
+	 *
+	 *  This function is a copy of the old ShapeMeshes method,
+	 *  merging the vertices with the same position, normal and
+	 *  texture coordinates.
+	 ***********************************************************/
+	void WeldVertices(std::vector<float>& vertices, std::vector<uint32_t>& indices)
+	{
+		typedef std::array<float, MeshBuilder::FLOATS_PER_VERTEX> VERTEX;
+
+		std::map<VERTEX, uint32_t> welded;
+		std::vector<uint32_t> remap(vertices.size() / g_FloatsPerVertex);
+		std::vector<float> weldedVertices;
+		weldedVertices.reserve(vertices.size());
+		for (size_t i = 0; i < remap.size(); i++)
+		{
+			VERTEX vertex;
+			std::copy(vertices.begin() + i * g_FloatsPerVertex, vertices.begin() + (i + 1) * g_FloatsPerVertex,
+				vertex.begin());
+
+			std::map<VERTEX, uint32_t>::const_iterator found = welded.find(vertex);
+			if (found == welded.end())
+			{
+				uint32_t index = (uint32_t)(weldedVertices.size() / g_FloatsPerVertex);
+				welded[vertex] = index;
+				weldedVertices.insert(weldedVertices.end(), vertex.begin(), vertex.end());
+				remap[i] = index;
+			}
+			else
+			{
+				remap[i] = found->second;
+			}
+		}
+
+		for (uint32_t& index : indices)
+		{
+			index = remap[index];
+		}
+		vertices.swap(weldedVertices);
+	}
+
+	/***********************************************************
+	 *  GenerateOldExtraTorus()
+	 *
+	 *  This function is a copy of the old extra torus loop.
+	 ***********************************************************/
+	void GenerateOldExtraTorus(float thickness, int _mainSegments, int _tubeSegments, OLD_EXTRA_TORUS& torus)
+	{
+		float _mainRadius = 1.0f;
+		float _tubeRadius = .1f;
+
+		if (thickness <= 1.0)
+		{
+			_tubeRadius = thickness;
+		}
+
+		auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
+		auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+
+		std::vector<glm::vec3> vertex_list;
+		std::vector<std::vector<glm::vec3>> segments_list;
+		std::vector<glm::vec2> texture_coords;
+		glm::vec3 normal;
+		glm::vec3 vertex;
+		glm::vec2 text_coord;
+
+		// generate the torus vertices
+		auto currentMainSegmentAngle = 0.0f;
+		for (auto i = 0; i < _mainSegments; i++)
+		{
+			auto sinMainSegment = sin(currentMainSegmentAngle);
+			auto cosMainSegment = cos(currentMainSegmentAngle);
+			auto currentTubeSegmentAngle = 0.0f;
+			std::vector<glm::vec3> segment_points;
+			for (auto j = 0; j < _tubeSegments; j++)
+			{
+				auto sinTubeSegment = sin(currentTubeSegmentAngle);
+				auto cosTubeSegment = cos(currentTubeSegmentAngle);
+
+				auto surfacePosition = glm::vec3(
+					(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
+					(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
+					_tubeRadius * sinTubeSegment);
+
+				segment_points.push_back(surfacePosition);
+
+				currentTubeSegmentAngle += tubeSegmentAngleStep;
+			}
+			segments_list.push_back(segment_points);
+			segment_points.clear();
+
+			currentMainSegmentAngle += mainSegmentAngleStep;
+		}
+
+		float horizontalStep = 1.0 / _mainSegments;
+		float verticalStep = 1.0 / _tubeSegments;
+		float u = 0.0;
+		float v = 0.0;
+
+		// connect the various segments together, forming triangles
+		for (int i = 0; i < _mainSegments; i++)
+		{
+			for (int j = 0; j < _tubeSegments; j++)
+			{
+				if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
+				{
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+					vertex_list.push_back(segments_list[i][j + 1]);
+					texture_coords.push_back(glm::vec2(u, v + verticalStep));
+					vertex_list.push_back(segments_list[i + 1][j + 1]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+					vertex_list.push_back(segments_list[i + 1][j]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
+					vertex_list.push_back(segments_list[i + 1][j + 1]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+				}
+				else
+				{
+					if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][0]);
+						texture_coords.push_back(glm::vec2(u, 0));
+						vertex_list.push_back(segments_list[0][0]);
+						texture_coords.push_back(glm::vec2(0, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[0][j]);
+						texture_coords.push_back(glm::vec2(0, v));
+						vertex_list.push_back(segments_list[0][0]);
+						texture_coords.push_back(glm::vec2(0, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+					else if ((i + 1) == _mainSegments)
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][j + 1]);
+						texture_coords.push_back(glm::vec2(u, v + verticalStep));
+						vertex_list.push_back(segments_list[0][j + 1]);
+						texture_coords.push_back(glm::vec2(0, v + verticalStep));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[0][j]);
+						texture_coords.push_back(glm::vec2(0, v));
+						vertex_list.push_back(segments_list[0][j + 1]);
+						texture_coords.push_back(glm::vec2(0, v + verticalStep));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+					else if ((j + 1) == _tubeSegments)
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][0]);
+						texture_coords.push_back(glm::vec2(u, 0));
+						vertex_list.push_back(segments_list[i + 1][0]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i + 1][j]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, v));
+						vertex_list.push_back(segments_list[i + 1][0]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+
+				}
+				v += verticalStep;
+			}
+			v = 0.0;
+			u += horizontalStep;
+		}
+
+		std::vector<float>& combined_values = torus.triangleVertices;
+		combined_values.clear();
+
+		// combine interleaved vertices, normals, and texture coords
+		for (size_t i = 0; i < vertex_list.size(); i++)
+		{
+			vertex = vertex_list[i];
+			normal = normalize(vertex);
+
+			text_coord = texture_coords[i];
+			combined_values.push_back(vertex.x);
+			combined_values.push_back(vertex.y);
+			combined_values.push_back(vertex.z);
+			combined_values.push_back(normal.x);
+			combined_values.push_back(normal.y);
+			combined_values.push_back(normal.z);
+			combined_values.push_back(text_coord.x);
+			combined_values.push_back(text_coord.y);
+		}
+
+		// the triangles repeat their shared corners, so merge them into
+		// one indexed triangle list
+		torus.vertices = combined_values;
+		torus.indices.clear();
+		MeshBuilder::AppendTriangles(MeshBuilder::PRIMITIVE_TRIANGLES, 0, (uint32_t)vertex_list.size(), torus.indices);
+		WeldVertices(torus.vertices, torus.indices);
+	}
+
+	/***********************************************************
+	 *  FinishOldExtraTorus()
+	 *
+	 *  This function is used for running the old generator's
+	 *  welded triangles through the same optimizer and bounds
+	 *  as the loaded meshes, which MeshBuilder::BuildExtraTorus
+	 *  does as part of building the grid.
+	 ***********************************************************/
+	void FinishOldExtraTorus(OLD_EXTRA_TORUS& torus)
+	{
+		size_t vertexCount = torus.vertices.size() / g_FloatsPerVertex;
+		MeshOptimizer::AnalyzeVertexCache(torus.indices.data(), torus.indices.size(), vertexCount);
+		MeshOptimizer::OptimizeVertexCache(torus.indices.data(), torus.indices.size(), vertexCount);
+		MeshOptimizer::OptimizeOverdraw(torus.indices.data(), torus.indices.size(), torus.vertices.data(),
+			vertexCount, g_FloatsPerVertex, 1.05f);
+		MeshBuilder::ComputeBounds(torus.vertices.data(), vertexCount);
+	}
+
+	/***********************************************************
+	 *  FindGridVertex()
+	 *
+	 *  This function returns the grid vertex with the same
+	 *  position bits as the passed in vertex, -1 if none has.
+	 ***********************************************************/
+	int FindGridVertex(const MeshBuilder::MESH_DATA& grid, const float* vertex)
+	{
+		for (size_t index = 0; index < grid.vertices.size() / g_FloatsPerVertex; index++)
+		{
+			if (memcmp(&grid.vertices[index * g_FloatsPerVertex], vertex, 3 * sizeof(float)) == 0)
+			{
+				return((int)index);
+			}
+		}
+
+		return(-1);
+	}
+}
+
+TEST_CASE(ExtraTorusGridMatchesOldVertices)
+{
+	// the thicknesses of both extra tori, and the fallback over 1
+	const float thicknesses[] = { 0.4f, 0.6f, 2.0f };
+	const int segments[][2] = { { 30, 30 }, { 24, 8 } };
+	for (float thickness : thicknesses)
+	{
+		for (const int* mainTube : segments)
+		{
+			int mainSegments = mainTube[0];
+			int tubeSegments = mainTube[1];
+			OLD_EXTRA_TORUS old;
+			GenerateOldExtraTorus(thickness, mainSegments, tubeSegments, old);
+			MeshBuilder::MESH_DATA grid;
+			MeshBuilder::BuildExtraTorus(thickness, mainSegments, tubeSegments, grid);
+
+			// the old loop started every quad's 7 vertices with the
+			// quad's own grid vertex, the same bits as the new grid's
+			CHECK(old.triangleVertices.size() ==
+				(size_t)mainSegments * tubeSegments * 7 * g_FloatsPerVertex);
+			bool bSame = true;
+			for (int quad = 0; quad < mainSegments * tubeSegments; quad++)
+			{
+				bSame = bSame && (memcmp(&old.triangleVertices[quad * 7 * g_FloatsPerVertex],
+					&grid.vertices[quad * g_FloatsPerVertex], g_FloatsPerVertex * sizeof(float)) == 0);
+			}
+			CHECK(bSame);
+
+			// every welded old vertex has the position and normal of
+			// a grid vertex - only texture coordinates were added
+			for (size_t index = 0; index < old.vertices.size() / g_FloatsPerVertex; index++)
+			{
+				const float* vertex = &old.vertices[index * g_FloatsPerVertex];
+				int gridIndex = FindGridVertex(grid, vertex);
+				CHECK(gridIndex >= 0);
+				if (gridIndex >= 0)
+				{
+					CHECK(memcmp(&grid.vertices[gridIndex * g_FloatsPerVertex], vertex, 6 * sizeof(float)) == 0);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE(ExtraTorusGridDropsOldSlivers)
+{
+	const int mainSegments = 30;
+	const int tubeSegments = 30;
+	OLD_EXTRA_TORUS old;
+	GenerateOldExtraTorus(0.4f, mainSegments, tubeSegments, old);
+	MeshBuilder::MESH_DATA grid;
+	MeshBuilder::BuildExtraTorus(0.4f, mainSegments, tubeSegments, grid);
+
+	// the old triangles as sorted grid vertex triples
+	std::set<std::array<int, 3>> oldTriangles;
+	int sliverCount = 0;
+	for (size_t i = 0; i < old.indices.size(); i += 3)
+	{
+		std::array<int, 3> triangle;
+		std::array<int, 3> rings;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			triangle[corner] = FindGridVertex(grid, &old.vertices[old.indices[i + corner] * g_FloatsPerVertex]);
+			rings[corner] = triangle[corner] / tubeSegments;
+		}
+
+		// slivers have all three corners on one ring, in its plane
+		if ((rings[0] == rings[1]) && (rings[1] == rings[2]))
+		{
+			sliverCount++;
+			continue;
+		}
+		std::sort(triangle.begin(), triangle.end());
+		oldTriangles.insert(triangle);
+	}
+
+	std::set<std::array<int, 3>> gridTriangles;
+	for (size_t i = 0; i < grid.indices.size(); i += 3)
+	{
+		std::array<int, 3> triangle = { (int)grid.indices[i], (int)grid.indices[i + 1], (int)grid.indices[i + 2] };
+		std::sort(triangle.begin(), triangle.end());
+		gridTriangles.insert(triangle);
+	}
+
+	// 7 vertices a quad made 2 triangles and a third of a third, so
+	// every third quad's vertices made a triangle along one ring
+	CHECK(old.indices.size() == (size_t)mainSegments * tubeSegments * 7);
+	CHECK(sliverCount == mainSegments * tubeSegments / 3);
+	CHECK(gridTriangles.size() == grid.indices.size() / 3);
+	CHECK(oldTriangles == gridTriangles);
+}
+
+BENCHMARK(ExtraTorusGridAgainstOld)
+{
+	const int segments[][2] = { { 30, 30 }, { 100, 100 }, { 300, 300 } };
+	for (const int* mainTube : segments)
+	{
+		int mainSegments = mainTube[0];
+		int tubeSegments = mainTube[1];
+		int runs = (mainSegments >= 300) ? 3 : 20;
+
+		// the grid is optimized as it is built, so the old
+		// generator is timed both on its own and optimized
+		OLD_EXTRA_TORUS old;
+		double oldMilliseconds = TimeMilliseconds([&]()
+		{
+			GenerateOldExtraTorus(0.4f, mainSegments, tubeSegments, old);
+		}, runs);
+		double oldFinishedMilliseconds = TimeMilliseconds([&]()
+		{
+			GenerateOldExtraTorus(0.4f, mainSegments, tubeSegments, old);
+			FinishOldExtraTorus(old);
+		}, runs);
+		MeshBuilder::MESH_DATA grid;
+		double gridMilliseconds = TimeMilliseconds([&]()
+		{
+			grid = MeshBuilder::MESH_DATA();
+			MeshBuilder::BuildExtraTorus(0.4f, mainSegments, tubeSegments, grid);
+		}, runs);
+
+		std::cout << "extra torus " << mainSegments << "x" << tubeSegments << ":" << std::endl;
+		std::cout << "- old:  " << (int)(oldMilliseconds * 1000.0) << " us, "
+			<< (int)(oldFinishedMilliseconds * 1000.0) << " us optimized, "
+			<< old.triangleVertices.size() * sizeof(float) << " bytes of vertices before welding, "
+			<< old.vertices.size() * sizeof(float) << " after, "
+			<< old.indices.size() * sizeof(uint32_t) << " bytes of indices" << std::endl;
+		std::cout << "- grid: " << (int)(gridMilliseconds * 1000.0) << " us optimized, "
+			<< grid.vertices.size() * sizeof(float) << " bytes of vertices, "
+			<< grid.indices.size() * sizeof(uint32_t) << " bytes of indices" << std::endl;
+
+		CHECK(grid.vertices.size() < old.vertices.size());
+	}
+}
@@ -0,0 +1,478 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialpathtests.cpp
+// ============
+// compare selecting materials by tag with selecting them from the material
+// table
+//
+// The old path copied the tag into a std::string, searched the materials for
+// it and set three uniforms for every draw. The new path uploads every
+// material once into the MaterialData uniform block and sets one integer
+// uniform per draw. Both are run here against small shaders in an OpenGL
+// context made with EGL, so no window or display is needed, over thousands
+// of draws. The test checks that both paths give every draw the same color,
+// and is skipped when no EGL context can be made. This file is only built
+// when CMake finds OpenGL and EGL.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "UniformBlocks.h"
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// the framebuffer the draws are rendered into, one pixel per draw
+	const int g_TargetSize = 64;
+
+	// a material as the scene defined it before the material table
+	struct OBJECT_MATERIAL
+	{
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// each draw is one point, placed at a pixel of the framebuffer by its
+	// vertex number
+	const std::string g_VertexShader =
+		"#version 330 core\n"
+		"const int targetSize = " + std::to_string(g_TargetSize) + ";\n"
+		"void main()\n"
+		"{\n"
+		"	int pixel = gl_VertexID % (targetSize * targetSize);\n"
+		"	vec2 position = (vec2(pixel % targetSize, pixel / targetSize) + 0.5) * 2.0 / float(targetSize) - 1.0;\n"
+		"	gl_Position = vec4(position, 0.0, 1.0);\n"
+		"}\n";
+	const char* g_FragmentShaderOld =
+		"#version 330 core\n"
+		"struct Material { vec3 diffuseColor; vec3 specularColor; float shininess; };\n"
+		"uniform Material material;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentColor = vec4(material.diffuseColor.r, material.specularColor.g,\n"
+		"		material.shininess / 256.0, 1.0);\n"
+		"}\n";
+	const char* g_FragmentShaderNew =
+		"#version 330 core\n"
+		"struct Material { vec3 diffuseColor; vec3 specularColor; float shininess; };\n"
+		"layout(std140) uniform MaterialData { Material materials[32]; };\n"
+		"uniform int materialIndex;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	Material material = materials[materialIndex];\n"
+		"	fragmentColor = vec4(material.diffuseColor.r, material.specularColor.g,\n"
+		"		material.shininess / 256.0, 1.0);\n"
+		"}\n";
+
+	// the OpenGL objects both paths draw with
+	struct MATERIAL_BENCHMARK_CONTEXT
+	{
+		bool bReady;
+		GLuint oldProgram;
+		GLuint newProgram;
+		GLint diffuseColorLocation;
+		GLint specularColorLocation;
+		GLint shininessLocation;
+		GLint materialIndexLocation;
+		GLuint materialDataUBO;
+		GLuint framebuffer;
+		GLuint colorBuffer;
+		GLuint vertexArray;
+	};
+
+	/***********************************************************
+	 *  DefineMaterials()
+	 *
+	 *  This function returns the scene's materials with their
+	 *  tags, in the order the scene defined them.
+	 ***********************************************************/
+	std::vector<OBJECT_MATERIAL> DefineMaterials()
+	{
+		const char* tags[] =
+		{
+			"floor", "wallpaper", "ceiling", "soda1", "soda2", "soda_top", "tekken", "arcade2",
+			"coin_slot", "test", "testt", "yellow", "linen", "leather", "metal2", "aluminum"
+		};
+
+		std::vector<OBJECT_MATERIAL> materials;
+		for (int index = 0; index < 16; index++)
+		{
+			OBJECT_MATERIAL material;
+			material.diffuseColor = glm::vec3(0.05f * index + 0.1f);
+			material.specularColor = glm::vec3(0.9f - 0.05f * index);
+			material.shininess = (float)(8 << (index % 6));
+			material.tag = tags[index];
+			materials.push_back(material);
+		}
+
+		return(materials);
+	}
+
+	/***********************************************************
+	 *  FindMaterial()
+	 *
+	 *  This function is a copy of the old tag lookup, which took
+	 *  the tag by value and searched every material for it.
+	 ***********************************************************/
+	bool FindMaterial(const std::vector<OBJECT_MATERIAL>& materials, std::string tag,
+		OBJECT_MATERIAL& material)
+	{
+		for (const OBJECT_MATERIAL& candidate : materials)
+		{
+			if (candidate.tag.compare(tag) == 0)
+			{
+				material.diffuseColor = candidate.diffuseColor;
+				material.specularColor = candidate.specularColor;
+				material.shininess = candidate.shininess;
+				return(true);
+			}
+		}
+
+		return(false);
+	}
+
+	/***********************************************************
+	 *  SetMaterialOld()
+	 *
+	 *  This function selects a material the old way - the tag
+	 *  is copied into a std::string for every call, looked up,
+	 *  and the material is set as three uniforms.
+	 ***********************************************************/
+	void SetMaterialOld(const MATERIAL_BENCHMARK_CONTEXT& context,
+		const std::vector<OBJECT_MATERIAL>& materials, std::string materialTag)
+	{
+		OBJECT_MATERIAL material;
+		if (FindMaterial(materials, materialTag, material))
+		{
+			glUniform3fv(context.diffuseColorLocation, 1, &material.diffuseColor[0]);
+			glUniform3fv(context.specularColorLocation, 1, &material.specularColor[0]);
+			glUniform1f(context.shininessLocation, material.shininess);
+		}
+	}
+
+	/***********************************************************
+	 *  SetMaterialNew()
+	 *
+	 *  This function selects a material from the table with one
+	 *  integer uniform.
+	 ***********************************************************/
+	void SetMaterialNew(const MATERIAL_BENCHMARK_CONTEXT& context, int materialID)
+	{
+		glUniform1i(context.materialIndexLocation, materialID);
+	}
+
+	/***********************************************************
+	 *  CompileProgram()
+	 *
+	 *  This function is used for compiling and linking a vertex
+	 *  and fragment shader, 0 if either fails.
+	 ***********************************************************/
+	GLuint CompileProgram(const char* vertexSource, const char* fragmentSource)
+	{
+		GLuint program = glCreateProgram();
+		const char* sources[] = { vertexSource, fragmentSource };
+		const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+		for (int i = 0; i < 2; i++)
+		{
+			GLuint shader = glCreateShader(types[i]);
+			glShaderSource(shader, 1, &sources[i], NULL);
+			glCompileShader(shader);
+			GLint bCompiled = GL_FALSE;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+			if (bCompiled != GL_TRUE)
+			{
+				char log[1024] = { 0 };
+				glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+				std::cout << "Shader compile failed:" << log << std::endl;
+				glDeleteShader(shader);
+				glDeleteProgram(program);
+				return(0);
+			}
+			glAttachShader(program, shader);
+			glDeleteShader(shader);
+		}
+
+		glLinkProgram(program);
+		GLint bLinked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &bLinked);
+		if (bLinked != GL_TRUE)
+		{
+			glDeleteProgram(program);
+			return(0);
+		}
+
+		return(program);
+	}
+
+	/***********************************************************
+	 *  CreateEGLContext()
+	 *
+	 *  This function is used for making an OpenGL 3.3 core
+	 *  context current with no surface, on Mesa's surfaceless
+	 *  platform when it has one.
+	 ***********************************************************/
+	bool CreateEGLContext()
+	{
+		EGLDisplay display = EGL_NO_DISPLAY;
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL)
+		{
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+		if (display == EGL_NO_DISPLAY)
+		{
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+		if ((display == EGL_NO_DISPLAY) || (!eglInitialize(display, NULL, NULL)))
+		{
+			return(false);
+		}
+
+		const EGLint configAttributes[] =
+		{
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configCount = 0;
+		if ((!eglBindAPI(EGL_OPENGL_API)) ||
+			(!eglChooseConfig(display, configAttributes, &config, 1, &configCount)) ||
+			(configCount == 0))
+		{
+			return(false);
+		}
+
+		const EGLint contextAttributes[] =
+		{
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		if (context == EGL_NO_CONTEXT)
+		{
+			return(false);
+		}
+
+		return(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE);
+	}
+
+	/***********************************************************
+	 *  GetContext()
+	 *
+	 *  This function returns the OpenGL objects both paths draw
+	 *  with, made the first time it is called.  bReady is false
+	 *  when no context could be made.
+	 ***********************************************************/
+	const MATERIAL_BENCHMARK_CONTEXT& GetContext()
+	{
+		static MATERIAL_BENCHMARK_CONTEXT context = {};
+		static bool bCreated = false;
+		if (bCreated)
+		{
+			return(context);
+		}
+		bCreated = true;
+
+		if (!CreateEGLContext())
+		{
+			std::cout << "Material paths:no EGL context, skipped" << std::endl;
+			return(context);
+		}
+		std::cout << "Renderer:" << (const char*)glGetString(GL_RENDERER) << std::endl;
+
+		context.oldProgram = CompileProgram(g_VertexShader.c_str(), g_FragmentShaderOld);
+		context.newProgram = CompileProgram(g_VertexShader.c_str(), g_FragmentShaderNew);
+		if ((context.oldProgram == 0) || (context.newProgram == 0))
+		{
+			return(context);
+		}
+		context.diffuseColorLocation = glGetUniformLocation(context.oldProgram, "material.diffuseColor");
+		context.specularColorLocation = glGetUniformLocation(context.oldProgram, "material.specularColor");
+		context.shininessLocation = glGetUniformLocation(context.oldProgram, "material.shininess");
+		context.materialIndexLocation = glGetUniformLocation(context.newProgram, "materialIndex");
+
+		// the material table, uploaded once
+		std::vector<OBJECT_MATERIAL> materials = DefineMaterials();
+		MATERIAL_DATA_BLOCK materialTable = {};
+		for (int index = 0; index < (int)materials.size(); index++)
+		{
+			materialTable.materials[index].diffuseColor = materials[index].diffuseColor;
+			materialTable.materials[index].specularColor = materials[index].specularColor;
+			materialTable.materials[index].shininess = materials[index].shininess;
+		}
+		glGenBuffers(1, &context.materialDataUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, context.materialDataUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(MATERIAL_DATA_BLOCK), &materialTable, GL_STATIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_MATERIALS, context.materialDataUBO);
+		glUniformBlockBinding(context.newProgram,
+			glGetUniformBlockIndex(context.newProgram, "MaterialData"), UNIFORM_BLOCK_MATERIALS);
+
+		glGenRenderbuffers(1, &context.colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, context.colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, g_TargetSize, g_TargetSize);
+		glGenFramebuffers(1, &context.framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, context.colorBuffer);
+		glViewport(0, 0, g_TargetSize, g_TargetSize);
+
+		// a core context draws nothing without a vertex array bound
+		glGenVertexArrays(1, &context.vertexArray);
+		glBindVertexArray(context.vertexArray);
+
+		context.bReady = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) &&
+			(glGetError() == GL_NO_ERROR);
+		return(context);
+	}
+
+	/***********************************************************
+	 *  MakeDrawList()
+	 *
+	 *  This function returns the material of each draw, in the
+	 *  scrambled order a scene's draws use them.
+	 ***********************************************************/
+	std::vector<int> MakeDrawList(int drawCount)
+	{
+		std::vector<int> drawMaterials(drawCount);
+		for (int draw = 0; draw < drawCount; draw++)
+		{
+			drawMaterials[draw] = (draw * 7 + draw / 16) % 16;
+		}
+
+		return(drawMaterials);
+	}
+
+	/***********************************************************
+	 *  DrawOld() / DrawNew()
+	 *
+	 *  These functions draw one point per draw, selecting its
+	 *  material with the old or the new path.  bDraw false only
+	 *  selects the materials, to time the selection on its own.
+	 ***********************************************************/
+	void DrawOld(const MATERIAL_BENCHMARK_CONTEXT& context, const std::vector<OBJECT_MATERIAL>& materials,
+		const std::vector<int>& drawMaterials, bool bDraw)
+	{
+		glUseProgram(context.oldProgram);
+		for (int draw = 0; draw < (int)drawMaterials.size(); draw++)
+		{
+			// the render code passed string literals
+			SetMaterialOld(context, materials, materials[drawMaterials[draw]].tag.c_str());
+			if (bDraw)
+			{
+				glDrawArrays(GL_POINTS, draw, 1);
+			}
+		}
+		glFinish();
+	}
+
+	void DrawNew(const MATERIAL_BENCHMARK_CONTEXT& context, const std::vector<int>& drawMaterials, bool bDraw)
+	{
+		glUseProgram(context.newProgram);
+		for (int draw = 0; draw < (int)drawMaterials.size(); draw++)
+		{
+			SetMaterialNew(context, drawMaterials[draw]);
+			if (bDraw)
+			{
+				glDrawArrays(GL_POINTS, draw, 1);
+			}
+		}
+		glFinish();
+	}
+
+	/***********************************************************
+	 *  ReadPixels()
+	 *
+	 *  This function returns the colors the draws left in the
+	 *  framebuffer.
+	 ***********************************************************/
+	std::vector<unsigned char> ReadPixels()
+	{
+		std::vector<unsigned char> pixels(g_TargetSize * g_TargetSize * 4);
+		glReadPixels(0, 0, g_TargetSize, g_TargetSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		return(pixels);
+	}
+}
+
+TEST_CASE(MaterialPathsRenderTheSame)
+{
+	const MATERIAL_BENCHMARK_CONTEXT& context = GetContext();
+	if (!context.bReady)
+	{
+		return;
+	}
+
+	std::vector<OBJECT_MATERIAL> materials = DefineMaterials();
+	std::vector<int> drawMaterials = MakeDrawList(g_TargetSize * g_TargetSize);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	DrawOld(context, materials, drawMaterials, true);
+	std::vector<unsigned char> oldPixels = ReadPixels();
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	DrawNew(context, drawMaterials, true);
+	std::vector<unsigned char> newPixels = ReadPixels();
+
+	CHECK(glGetError() == GL_NO_ERROR);
+	CHECK(oldPixels == newPixels);
+	// every pixel was drawn, with the material its draw chose
+	for (int draw = 0; draw < (int)drawMaterials.size(); draw++)
+	{
+		CHECK(oldPixels[draw * 4 + 3] == 255);
+		CHECK(oldPixels[draw * 4 + 2] ==
+			(unsigned char)(materials[drawMaterials[draw]].shininess / 256.0f * 255.0f + 0.5f));
+	}
+}
+
+BENCHMARK(MaterialPathOldAgainstNew)
+{
+	const MATERIAL_BENCHMARK_CONTEXT& context = GetContext();
+	if (!context.bReady)
+	{
+		return;
+	}
+
+	std::vector<OBJECT_MATERIAL> materials = DefineMaterials();
+	const int drawCounts[] = { 1000, 4000, 16000 };
+	for (int drawCount : drawCounts)
+	{
+		std::vector<int> drawMaterials = MakeDrawList(drawCount);
+		std::cout << drawCount << " draws, 16 materials:" << std::endl;
+
+		const bool bDrawModes[] = { false, true };
+		for (bool bDraw : bDrawModes)
+		{
+			double oldMilliseconds = TimeMilliseconds([&]()
+			{
+				DrawOld(context, materials, drawMaterials, bDraw);
+			}, 10);
+			double newMilliseconds = TimeMilliseconds([&]()
+			{
+				DrawNew(context, drawMaterials, bDraw);
+			}, 10);
+
+			std::cout << std::fixed << std::setprecision(1)
+				<< (bDraw ? "- selection and draws: " : "- selection only:      ")
+				<< "tag " << oldMilliseconds * 1000.0 << " us, "
+				<< "table " << newMilliseconds * 1000.0 << " us, "
+				<< oldMilliseconds / newMilliseconds << " times as fast" << std::endl;
+		}
+	}
+
+	CHECK(glGetError() == GL_NO_ERROR);
+}
@@ -0,0 +1,412 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuildertests.cpp
+// ============
+// unit tests of the mesh builders
+//
+// Every builder is checked for the vertex and index counts its shape should
+// have, for indices that stay inside the vertices and inside a triangle, for
+// parts that add up to the index count, and for bounds that hold every
+// vertex. The meshes the scene loads are also hashed and compared with the
+// hashes recorded for MESH_GENERATOR_VERSION and OPTIMIZER_VERSION, so
+// changing what the builders or the optimizer output without bumping the
+// version, which keys the mesh cache, fails the tests.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "MeshBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	// the hashes of the scene's meshes each version outputs - add a row
+	// when a version is bumped
+	struct MESH_OUTPUT
+	{
+		uint32_t generatorVersion;    // MeshBuilder::MESH_GENERATOR_VERSION
+		uint32_t optimizerVersion;    // MeshOptimizer::OPTIMIZER_VERSION
+		uint64_t vertexHash;
+		uint64_t indexHash;
+	};
+	const MESH_OUTPUT g_MeshOutputs[] =
+	{
+		{ 1, 1, 0x9706c48570645589ull, 0xa1928bd3bd85b270ull },
+	};
+
+	/***********************************************************
+	 *  CheckMesh()
+	 *
+	 *  This function is used for checking the counts, indices,
+	 *  parts and bounds of a built mesh.
+	 ***********************************************************/
+	void CheckMesh(const MeshBuilder::MESH_DATA& mesh, size_t vertexCount, size_t indexCount, size_t partCount)
+	{
+		const size_t floatsPerVertex = MeshBuilder::FLOATS_PER_VERTEX;
+
+		CHECK(mesh.vertices.size() % floatsPerVertex == 0);
+		CHECK(mesh.vertices.size() / floatsPerVertex == vertexCount);
+		CHECK(mesh.indices.size() == indexCount);
+		CHECK(mesh.indices.size() % 3 == 0);
+		CHECK(mesh.partIndexCounts.size() == partCount);
+
+		// each part is whole triangles, and the parts cover the indices
+		size_t partTotal = 0;
+		for (uint32_t count : mesh.partIndexCounts)
+		{
+			CHECK(count % 3 == 0);
+			partTotal += count;
+		}
+		CHECK(partTotal == mesh.indices.size());
+
+		// no index past the vertices, and no triangle using a vertex twice
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const uint32_t* triangle = &mesh.indices[i];
+			CHECK(triangle[0] < vertexCount);
+			CHECK(triangle[1] < vertexCount);
+			CHECK(triangle[2] < vertexCount);
+			CHECK((triangle[0] != triangle[1]) && (triangle[1] != triangle[2]) && (triangle[0] != triangle[2]));
+		}
+
+		// the bounds are the box around the positions, and the sphere
+		// around its center holds all of them
+		glm::vec3 minimum = glm::vec3(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]);
+		glm::vec3 maximum = minimum;
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			glm::vec3 position = glm::vec3(mesh.vertices[i * floatsPerVertex],
+				mesh.vertices[i * floatsPerVertex + 1], mesh.vertices[i * floatsPerVertex + 2]);
+			minimum = glm::min(minimum, position);
+			maximum = glm::max(maximum, position);
+		}
+		CHECK(mesh.bounds.minimum == minimum);
+		CHECK(mesh.bounds.maximum == maximum);
+		CHECK(mesh.bounds.center == (minimum + maximum) * 0.5f);
+		float farthest = 0.0f;
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			glm::vec3 position = glm::vec3(mesh.vertices[i * floatsPerVertex],
+				mesh.vertices[i * floatsPerVertex + 1], mesh.vertices[i * floatsPerVertex + 2]);
+			farthest = std::max(farthest, glm::length(position - mesh.bounds.center));
+		}
+		CHECK(mesh.bounds.radius == farthest);
+	}
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used for adding bytes to a 64-bit
+	 *  FNV-1a hash.
+	 ***********************************************************/
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+		}
+	}
+
+	/***********************************************************
+	 *  HashSceneMeshes()
+	 *
+	 *  This function is used for hashing the meshes the scene
+	 *  loads, at every detail level, along with the rest of the
+	 *  builders with the defaults of the ShapeMeshes Load
+	 *  methods.  The vertices are rounded to 1/65536 first, so
+	 *  a math library that rounds a sine differently in the
+	 *  last bit does not change the hash.
+	 ***********************************************************/
+	void HashSceneMeshes(uint64_t& vertexHash, uint64_t& indexHash)
+	{
+		std::vector<MeshBuilder::MESH_DATA> meshes(13);
+		MeshBuilder::BuildBox(meshes[0]);
+		MeshBuilder::BuildCone(1.0f, 1.0f, 36, meshes[1]);
+		MeshBuilder::BuildCylinder(1.0f, 1.0f, 36, meshes[2]);
+		MeshBuilder::BuildPlane(2.0f, 2.0f, meshes[3]);
+		MeshBuilder::BuildPrism(meshes[4]);
+		MeshBuilder::BuildPyramid3(meshes[5]);
+		MeshBuilder::BuildPyramid4(1.0f, 1.0f, meshes[6]);
+		MeshBuilder::BuildSphere(16, 16, 1.0f, meshes[7]);
+		MeshBuilder::BuildTaperedCylinder(meshes[8]);
+		MeshBuilder::BuildTorus(1.0f, 0.3f, 30, 30, meshes[9]);
+		MeshBuilder::BuildTorus(1.0f, 0.06f, 24, 8, meshes[10]);
+		MeshBuilder::BuildExtraTorus(0.4f, 30, 30, meshes[11]);
+		MeshBuilder::BuildExtraTorus(0.6f, 30, 30, meshes[12]);
+
+		// the round meshes at the coarser detail levels, as
+		// SceneManager::PrepareScene() loads them for each of
+		// ShapeMeshes::DETAIL_LEVELS
+		for (int level = 1; level < 3; level++)
+		{
+			int divisor = 1 << level;
+			meshes.resize(meshes.size() + 3);
+			MeshBuilder::BuildCylinder(1.0f, 1.0f, 36 / divisor, meshes[meshes.size() - 3]);
+			MeshBuilder::BuildSphere(std::max(4, 16 / divisor), std::max(4, 16 / divisor), 1.0f, meshes[meshes.size() - 2]);
+			MeshBuilder::BuildTorus(1.0f, 0.06f, std::max(6, 24 / divisor), std::max(3, 8 / divisor), meshes.back());
+		}
+
+		vertexHash = 0xcbf29ce484222325ull;
+		indexHash = 0xcbf29ce484222325ull;
+		for (const MeshBuilder::MESH_DATA& mesh : meshes)
+		{
+			for (float value : mesh.vertices)
+			{
+				int32_t rounded = (int32_t)std::lround(value * 65536.0f);
+				HashBytes(vertexHash, &rounded, sizeof(rounded));
+			}
+			HashBytes(indexHash, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+			HashBytes(indexHash, mesh.partIndexCounts.data(), mesh.partIndexCounts.size() * sizeof(uint32_t));
+		}
+	}
+}
+
+TEST_CASE(BuildBoxCounts)
+{
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildBox(mesh);
+	CheckMesh(mesh, 24, 36, 6);
+	CHECK(mesh.bounds.minimum == glm::vec3(-0.5f));
+	CHECK(mesh.bounds.maximum == glm::vec3(0.5f));
+	for (uint32_t count : mesh.partIndexCounts)
+	{
+		CHECK(count == 6);
+	}
+}
+
+TEST_CASE(BuildConeCounts)
+{
+	const int slices[] = { 3, 18, 36 };
+	for (int numSlices : slices)
+	{
+		MeshBuilder::MESH_DATA mesh;
+		MeshBuilder::BuildCone(1.0f, 2.0f, numSlices, mesh);
+		// a fan of numSlices triangles and a strip of numSlices * 2 - 2
+		CheckMesh(mesh, numSlices * 3 + 4, numSlices * 9 - 6, 2);
+		CHECK(mesh.partIndexCounts[0] == (uint32_t)(numSlices * 3));
+		CHECK_NEAR(mesh.bounds.maximum.y, 2.0f, 0.0f);
+	}
+}
+
+TEST_CASE(BuildCylinderCounts)
+{
+	const int slices[] = { 3, 18, 36 };
+	for (int numSlices : slices)
+	{
+		MeshBuilder::MESH_DATA mesh;
+		MeshBuilder::BuildCylinder(0.5f, 1.0f, numSlices, mesh);
+		// two fans of numSlices triangles and a strip of numSlices * 2
+		CheckMesh(mesh, numSlices * 4 + 6, numSlices * 12, 3);
+		CHECK(mesh.partIndexCounts[0] == (uint32_t)(numSlices * 3));
+		CHECK(mesh.partIndexCounts[1] == (uint32_t)(numSlices * 3));
+		CHECK_NEAR(mesh.bounds.maximum.x, 0.5f, 1e-6f);
+	}
+}
+
+TEST_CASE(BuildPlaneCounts)
+{
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildPlane(4.0f, 2.0f, mesh);
+	CheckMesh(mesh, 4, 6, 1);
+	CHECK(mesh.bounds.minimum == glm::vec3(-2.0f, 0.0f, -1.0f));
+	CHECK(mesh.bounds.maximum == glm::vec3(2.0f, 0.0f, 1.0f));
+}
+
+TEST_CASE(BuildPrismCounts)
+{
+	// a single strip over every vertex
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildPrism(mesh);
+	size_t vertexCount = mesh.vertices.size() / MeshBuilder::FLOATS_PER_VERTEX;
+	CHECK(vertexCount == 32);
+	CheckMesh(mesh, vertexCount, (vertexCount - 2) * 3, 1);
+}
+
+TEST_CASE(BuildPyramid3Counts)
+{
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildPyramid3(mesh);
+	size_t vertexCount = mesh.vertices.size() / MeshBuilder::FLOATS_PER_VERTEX;
+	CHECK(vertexCount == 12);
+	CheckMesh(mesh, vertexCount, (vertexCount - 2) * 3, 1);
+}
+
+TEST_CASE(BuildPyramid4Counts)
+{
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildPyramid4(2.0f, 3.0f, mesh);
+	size_t vertexCount = mesh.vertices.size() / MeshBuilder::FLOATS_PER_VERTEX;
+	CHECK(vertexCount == 16);
+	CheckMesh(mesh, vertexCount, (vertexCount - 2) * 3, 1);
+	// the apex is at half the height, the base half the base size down
+	CHECK(mesh.bounds.maximum.y == 1.5f);
+	CHECK(mesh.bounds.minimum.y == -1.0f);
+}
+
+TEST_CASE(BuildSphereCounts)
+{
+	const int segments[][2] = { { 16, 16 }, { 8, 12 }, { 4, 4 } };
+	for (const int* latitudeLongitude : segments)
+	{
+		int latitudeSegments = latitudeLongitude[0];
+		int longitudeSegments = latitudeLongitude[1];
+		MeshBuilder::MESH_DATA mesh;
+		MeshBuilder::BuildSphere(latitudeSegments, longitudeSegments, 2.0f, mesh);
+		CheckMesh(mesh, (latitudeSegments + 1) * (longitudeSegments + 1), latitudeSegments * longitudeSegments * 6, 2);
+		CHECK_NEAR(mesh.bounds.maximum.y, 2.0f, 1e-6f);
+		CHECK_NEAR(mesh.bounds.radius, 2.0f, 1e-5f);
+	}
+}
+
+TEST_CASE(BuildTaperedCylinderCounts)
+{
+	// fans of 36 and 72 vertices for the bottom and the top, and a
+	// strip of 146 for the sides
+	MeshBuilder::MESH_DATA mesh;
+	MeshBuilder::BuildTaperedCylinder(mesh);
+	CheckMesh(mesh, 218, (34 + 70 + 144) * 3, 3);
+	CHECK(mesh.partIndexCounts[0] == 34 * 3);
+	CHECK(mesh.partIndexCounts[1] == 70 * 3);
+	CHECK(mesh.partIndexCounts[2] == 144 * 3);
+}
+
+TEST_CASE(BuildTorusCounts)
+{
+	const int segments[][2] = { { 30, 30 }, { 15, 15 }, { 8, 6 } };
+	for (const int* mainTube : segments)
+	{
+		MeshBuilder::MESH_DATA mesh;
+		MeshBuilder::BuildTorus(1.0f, 0.3f, mainTube[0], mainTube[1], mesh);
+		CheckMesh(mesh, (mainTube[0] + 1) * (mainTube[1] + 1), mainTube[0] * mainTube[1] * 6, 2);
+		CHECK_NEAR(mesh.bounds.maximum.x, 1.3f, 1e-6f);
+		CHECK(mesh.bounds.maximum.z <= 0.3f);
+	}
+}
+
+TEST_CASE(BuildExtraTorusCounts)
+{
+	// a closed grid, the seams share the first ring and tube segment
+	const int segments[][2] = { { 30, 30 }, { 24, 8 } };
+	for (const int* mainTube : segments)
+	{
+		MeshBuilder::MESH_DATA mesh;
+		MeshBuilder::BuildExtraTorus(0.05f, mainTube[0], mainTube[1], mesh);
+		CheckMesh(mesh, mainTube[0] * mainTube[1], mainTube[0] * mainTube[1] * 6, 1);
+		CHECK_NEAR(mesh.bounds.maximum.x, 1.05f, 1e-6f);
+	}
+
+	// thicknesses over 1 fall back to a tube radius of 0.1
+	MeshBuilder::MESH_DATA thick;
+	MeshBuilder::BuildExtraTorus(2.0f, 30, 30, thick);
+	CHECK_NEAR(thick.bounds.maximum.x, 1.1f, 1e-6f);
+}
+
+TEST_CASE(ComputeBoundsOfVertices)
+{
+	const float vertices[] = {
+		1.0f, 2.0f, 3.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
+		-1.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f,   1.0f, 1.0f,
+		0.0f, 1.0f, 2.0f,   0.0f, 0.0f, 1.0f,   0.5f, 0.5f
+	};
+	MeshBuilder::MESH_BOUNDS bounds = MeshBuilder::ComputeBounds(vertices, 3);
+	CHECK(bounds.minimum == glm::vec3(-1.0f, 0.0f, 1.0f));
+	CHECK(bounds.maximum == glm::vec3(1.0f, 2.0f, 3.0f));
+	CHECK(bounds.center == glm::vec3(0.0f, 1.0f, 2.0f));
+	CHECK_NEAR(bounds.radius, std::sqrt(3.0f), 1e-6f);
+
+	// no vertices gives the negative radius of an unloaded mesh
+	MeshBuilder::MESH_BOUNDS empty = MeshBuilder::ComputeBounds(vertices, 0);
+	CHECK(empty.radius < 0.0f);
+	empty = MeshBuilder::ComputeBounds(NULL, 3);
+	CHECK(empty.radius < 0.0f);
+}
+
+TEST_CASE(AppendTrianglesKeepsWinding)
+{
+	std::vector<uint32_t> indices;
+	CHECK(MeshBuilder::AppendTriangles(MeshBuilder::PRIMITIVE_TRIANGLE_FAN, 10, 5, indices) == 9);
+	const uint32_t fan[] = { 10, 11, 12,  10, 12, 13,  10, 13, 14 };
+	CHECK(std::equal(indices.begin(), indices.end(), fan));
+
+	// every other triangle of a strip is flipped, as OpenGL draws it
+	indices.clear();
+	CHECK(MeshBuilder::AppendTriangles(MeshBuilder::PRIMITIVE_TRIANGLE_STRIP, 0, 5, indices) == 9);
+	const uint32_t strip[] = { 0, 1, 2,  2, 1, 3,  2, 3, 4 };
+	CHECK(std::equal(indices.begin(), indices.end(), strip));
+
+	// a list drops the vertices left over after the last triangle
+	indices.clear();
+	CHECK(MeshBuilder::AppendTriangles(MeshBuilder::PRIMITIVE_TRIANGLES, 4, 8, indices) == 6);
+	CHECK(indices.back() == 9);
+
+	// too few vertices for a triangle appends nothing
+	indices.clear();
+	CHECK(MeshBuilder::AppendTriangles(MeshBuilder::PRIMITIVE_TRIANGLE_STRIP, 0, 2, indices) == 0);
+	CHECK(indices.empty());
+}
+
+TEST_CASE(OptimizedMeshesUseTheCacheBetter)
+{
+	// the grids the scene draws at full detail need fewer vertex shader
+	// runs per triangle once their triangles are reordered - fans,
+	// strips and thin tubes whose rings fit the cache are already in
+	// about as good an order, so those are not checked
+	MeshBuilder::MESH_DATA sphere;
+	MeshBuilder::BuildSphere(16, 16, 1.0f, sphere);
+	CHECK(sphere.cacheAfter.acmr < sphere.cacheBefore.acmr);
+
+	MeshBuilder::MESH_DATA torus;
+	MeshBuilder::BuildTorus(1.0f, 0.3f, 30, 30, torus);
+	CHECK(torus.cacheAfter.acmr < torus.cacheBefore.acmr);
+
+	MeshBuilder::MESH_DATA extraTorus;
+	MeshBuilder::BuildExtraTorus(0.05f, 30, 30, extraTorus);
+	CHECK(extraTorus.cacheAfter.acmr < extraTorus.cacheBefore.acmr);
+}
+
+TEST_CASE(MeshCacheVersionsMatchOutput)
+{
+	uint64_t vertexHash = 0;
+	uint64_t indexHash = 0;
+	HashSceneMeshes(vertexHash, indexHash);
+
+	// the vertices only depend on the builders, the indices on both
+	// the builders and the optimizer that orders them
+	bool bVertexVersionFound = false;
+	bool bVertexHashMatches = false;
+	bool bIndexVersionFound = false;
+	bool bIndexHashMatches = false;
+	for (const MESH_OUTPUT& output : g_MeshOutputs)
+	{
+		if (output.generatorVersion != MeshBuilder::MESH_GENERATOR_VERSION)
+		{
+			continue;
+		}
+		bVertexVersionFound = true;
+		bVertexHashMatches = bVertexHashMatches || (output.vertexHash == vertexHash);
+		if (output.optimizerVersion == MeshOptimizer::OPTIMIZER_VERSION)
+		{
+			bIndexVersionFound = true;
+			bIndexHashMatches = (output.indexHash == indexHash);
+		}
+	}
+
+	if (!bVertexHashMatches || !bIndexHashMatches)
+	{
+		std::cout << "Mesh output:vertices 0x" << std::hex << std::setfill('0') << std::setw(16) << vertexHash
+			<< ", indices 0x" << std::setw(16) << indexHash << std::dec << std::setfill(' ') << std::endl;
+		if (bVertexVersionFound && bIndexVersionFound)
+		{
+			std::cout << "Mesh output:changed, bump MESH_GENERATOR_VERSION or OPTIMIZER_VERSION" << std::endl;
+		}
+		else
+		{
+			std::cout << "Mesh output:no hashes for these versions, add them to g_MeshOutputs" << std::endl;
+		}
+	}
+	CHECK(bVertexVersionFound && bVertexHashMatches);
+	CHECK(bIndexVersionFound && bIndexHashMatches);
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// mipgeneratortests.cpp
+// ============
+// unit tests of stretching images with the mip generator
+//
+// Images of a size that has no texture array left are stretched into the
+// array nearest their size. Resizing to the same size has to give back the
+// same bytes, a flat image has to stay flat, and halving has to average each
+// pair of pixels like the box filter does.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "MipGenerator.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	/***********************************************************
+	 *  RandomImage()
+	 *
+	 *  This function is used for making an image of random
+	 *  bytes.
+	 ***********************************************************/
+	std::vector<unsigned char> RandomImage(int width, int height, int colorChannels, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<int> byte(0, 255);
+
+		std::vector<unsigned char> pixels((size_t)width * height * colorChannels);
+		for (unsigned char& value : pixels)
+		{
+			value = (unsigned char)byte(random);
+		}
+
+		return(pixels);
+	}
+}
+
+TEST_CASE(ResizeImageKeepsSameSize)
+{
+	const int colorChannels[] = { 3, 4 };
+	for (int channels : colorChannels)
+	{
+		std::vector<unsigned char> pixels = RandomImage(37, 19, channels, 1);
+		std::vector<unsigned char> resized;
+		CHECK(MipGenerator::ResizeImage(pixels.data(), 37, 19, channels, 37, 19, resized));
+		CHECK(resized == pixels);
+	}
+}
+
+TEST_CASE(ResizeImageKeepsFlatColor)
+{
+	// the sizes of the scene's odd images, to and from the common size
+	const int sizes[][4] = { { 1820, 1024, 1024, 1024 }, { 1024, 800, 1024, 1024 }, { 3, 5, 64, 32 } };
+	for (const int* size : sizes)
+	{
+		std::vector<unsigned char> pixels((size_t)size[0] * size[1] * 4);
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			pixels[i + 0] = 12;
+			pixels[i + 1] = 128;
+			pixels[i + 2] = 255;
+			pixels[i + 3] = 77;
+		}
+
+		std::vector<unsigned char> resized;
+		CHECK(MipGenerator::ResizeImage(pixels.data(), size[0], size[1], 4, size[2], size[3], resized));
+		CHECK(resized.size() == (size_t)size[2] * size[3] * 4);
+
+		bool bFlat = true;
+		for (size_t i = 0; i < resized.size(); i += 4)
+		{
+			bFlat = bFlat && (resized[i + 0] == 12) && (resized[i + 1] == 128) &&
+				(resized[i + 2] == 255) && (resized[i + 3] == 77);
+		}
+		CHECK(bFlat);
+	}
+}
+
+TEST_CASE(ResizeImageAveragesWhenHalving)
+{
+	const int width = 16;
+	const int height = 6;
+	std::vector<unsigned char> pixels = RandomImage(width, height, 3, 2);
+	std::vector<unsigned char> resized;
+	CHECK(MipGenerator::ResizeImage(pixels.data(), width, height, 3, width / 2, height / 2, resized));
+
+	// the center of each output pixel is between four source pixels
+	bool bAveraged = true;
+	for (int y = 0; y < height / 2; y++)
+	{
+		for (int x = 0; x < width / 2; x++)
+		{
+			for (int channel = 0; channel < 3; channel++)
+			{
+				int sum = 0;
+				for (int k = 0; k < 4; k++)
+				{
+					sum += pixels[((size_t)(2 * y + k / 2) * width + 2 * x + k % 2) * 3 + channel];
+				}
+				bAveraged = bAveraged && (resized[((size_t)y * (width / 2) + x) * 3 + channel] == (sum + 2) / 4);
+			}
+		}
+	}
+	CHECK(bAveraged);
+}
+
+TEST_CASE(ResizeImageRejectsBadImages)
+{
+	std::vector<unsigned char> pixels = RandomImage(4, 4, 4, 3);
+	std::vector<unsigned char> resized(1);
+	CHECK(!MipGenerator::ResizeImage(NULL, 4, 4, 4, 2, 2, resized));
+	CHECK(!MipGenerator::ResizeImage(pixels.data(), 4, 4, 2, 2, 2, resized));
+	CHECK(!MipGenerator::ResizeImage(pixels.data(), 4, 4, 4, 0, 2, resized));
+	CHECK(resized.empty());
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// testframework.h
+// ============
+// register and run the unit tests and benchmarks
+//
+// Each test file registers its functions with TEST_CASE() or BENCHMARK().
+// CHECK() records a failed expression with its file and line and carries on,
+// so one run reports every failing check. The tests run by default and from
+// ctest; the benchmarks only run when --bench is passed, as some of them
+// take seconds on a slow machine.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+class TestRegistry
+{
+public:
+	typedef void (*TEST_FUNCTION)();
+
+	// one registered test or benchmark
+	struct TEST_ENTRY
+	{
+		const char* name;
+		TEST_FUNCTION function;
+		bool bBenchmark;
+	};
+
+	// add a test or benchmark, returns true so it can initialize a static
+	static bool Register(const char* name, TEST_FUNCTION function, bool bBenchmark);
+	static const std::vector<TEST_ENTRY>& GetEntries();
+
+	// record a failed check
+	static void ReportFailure(const char* expression, const char* file, int line);
+	static int GetFailureCount();
+};
+
+// define a test, or a benchmark that is only run with --bench
+#define TEST_CASE(name) \
+	static void name(); \
+	static const bool name##Registered = TestRegistry::Register(#name, &name, false); \
+	static void name()
+#define BENCHMARK(name) \
+	static void name(); \
+	static const bool name##Registered = TestRegistry::Register(#name, &name, true); \
+	static void name()
+
+// record a failure when the expression is false
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			TestRegistry::ReportFailure(#expression, __FILE__, __LINE__); \
+		} \
+	} while (0)
+#define CHECK_NEAR(actual, expected, tolerance) \
+	CHECK(std::fabs((double)(actual) - (double)(expected)) <= (double)(tolerance))
+
+// the fastest of several runs of a function, in milliseconds
+template <typename FUNCTION>
+double TimeMilliseconds(FUNCTION function, int runs = 3)
+{
+	double fastest = 0.0;
+	for (int run = 0; run < runs; run++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		double milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+		if ((run == 0) || (milliseconds < fastest))
+		{
+			fastest = milliseconds;
+		}
+	}
+
+	return(fastest);
+}
+
+// a random float between the limits, made from the bits rather than with
+// std::uniform_real_distribution so every standard library gives the same
+// values for a seed
+inline float RandomFloat(std::mt19937& random, float low, float high)
+{
+	return(low + (high - low) * ((float)(random() >> 8) / 16777216.0f));
+}
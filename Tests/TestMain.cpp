@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// testmain.cpp
+// ============
+// runs the registered unit tests, or the benchmarks with --bench
+//
+// --filter=TEXT only runs the tests and benchmarks whose name contains TEXT.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	// failed checks since the start of the run
+	int g_FailureCount = 0;
+
+	std::vector<TestRegistry::TEST_ENTRY>& GetEntryList()
+	{
+		static std::vector<TestRegistry::TEST_ENTRY> entries;
+		return(entries);
+	}
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for adding a test or a benchmark to
+ *  the list that main() runs.
+ ***********************************************************/
+bool TestRegistry::Register(const char* name, TEST_FUNCTION function, bool bBenchmark)
+{
+	TEST_ENTRY entry = { name, function, bBenchmark };
+	GetEntryList().push_back(entry);
+	return(true);
+}
+
+/***********************************************************
+ *  GetEntries()
+ *
+ *  This method returns the registered tests and benchmarks.
+ ***********************************************************/
+const std::vector<TestRegistry::TEST_ENTRY>& TestRegistry::GetEntries()
+{
+	return(GetEntryList());
+}
+
+/***********************************************************
+ *  ReportFailure()
+ *
+ *  This method is used for printing a failed check and
+ *  counting it.
+ ***********************************************************/
+void TestRegistry::ReportFailure(const char* expression, const char* file, int line)
+{
+	std::cout << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+	g_FailureCount++;
+}
+
+/***********************************************************
+ *  GetFailureCount()
+ *
+ *  This method returns the number of failed checks.
+ ***********************************************************/
+int TestRegistry::GetFailureCount()
+{
+	return(g_FailureCount);
+}
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function runs the tests, or the benchmarks when
+ *  --bench is passed, and fails if any check failed.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	bool bBenchmarks = false;
+	std::string filter;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			bBenchmarks = true;
+		}
+		else if (strncmp(argv[i], "--filter=", 9) == 0)
+		{
+			filter = argv[i] + 9;
+		}
+	}
+
+	int run = 0;
+	for (const TestRegistry::TEST_ENTRY& entry : TestRegistry::GetEntries())
+	{
+		if ((entry.bBenchmark != bBenchmarks) ||
+			((!filter.empty()) && (std::string(entry.name).find(filter) == std::string::npos)))
+		{
+			continue;
+		}
+
+		int failuresBefore = TestRegistry::GetFailureCount();
+		std::cout << (bBenchmarks ? "Benchmark:" : "Test:") << entry.name << std::endl;
+		entry.function();
+		if (TestRegistry::GetFailureCount() != failuresBefore)
+		{
+			std::cout << "FAILED:" << entry.name << std::endl;
+		}
+		run++;
+	}
+
+	std::cout << run << (bBenchmarks ? " benchmarks" : " tests") << " run, "
+		<< TestRegistry::GetFailureCount() << " checks failed" << std::endl;
+
+	return((TestRegistry::GetFailureCount() == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,288 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkerneltests.cpp
+// ============
+// unit tests and benchmarks of the transform kernel
+//
+// The matrices of every kernel are compared with multiplying the glm
+// matrices translation * rotationZ * rotationY * rotationX * scale, and the
+// SSE2 and AVX2 kernels with the scalar one, which they have to match float
+// for float. The benchmark times the glm path and each kernel the CPU
+// supports over 10^3 to 10^6 transforms, in the style of the glm perf tests.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TestFramework.h"
+#include "TransformKernel.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	typedef TransformKernel::TRANSFORM_ARRAYS TRANSFORM_ARRAYS;
+	typedef TransformKernel::MATRIX_ARRAYS MATRIX_ARRAYS;
+
+	/***********************************************************
+	 *  RandomTransforms()
+	 *
+	 *  This function is used for making transforms with angles
+	 *  of up to three turns either way, the quarter turns the
+	 *  scene uses most, and scales and positions like the
+	 *  scene's objects.
+	 ***********************************************************/
+	TRANSFORM_ARRAYS RandomTransforms(size_t count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+
+		TRANSFORM_ARRAYS transforms;
+		transforms.Resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::vec3 scale(RandomFloat(random, 0.01f, 20.0f),
+				RandomFloat(random, 0.01f, 20.0f), RandomFloat(random, 0.01f, 20.0f));
+			glm::vec3 rotation(RandomFloat(random, -1080.0f, 1080.0f),
+				RandomFloat(random, -1080.0f, 1080.0f), RandomFloat(random, -1080.0f, 1080.0f));
+			glm::vec3 position(RandomFloat(random, -100.0f, 100.0f),
+				RandomFloat(random, -100.0f, 100.0f), RandomFloat(random, -100.0f, 100.0f));
+			if (i % 4 == 0)
+			{
+				rotation = glm::vec3(90.0f * (float)(int)(i % 9) - 360.0f, 0.0f, -90.0f);
+			}
+			transforms.Set(i, scale, rotation, position);
+		}
+
+		return(transforms);
+	}
+
+	/***********************************************************
+	 *  ComposeWithGlm()
+	 *
+	 *  This function is used for building a matrix the way the
+	 *  scene did before the kernel, by multiplying the glm
+	 *  matrices.
+	 ***********************************************************/
+	glm::mat4 ComposeWithGlm(glm::vec3 scale, glm::vec3 rotationDegrees, glm::vec3 position)
+	{
+		glm::mat4 scaleMatrix = glm::scale(scale);
+		glm::mat4 rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 translation = glm::translate(position);
+
+		return(translation * rotationZ * rotationY * rotationX * scaleMatrix);
+	}
+
+	/***********************************************************
+	 *  ComposeAllWithGlm()
+	 *
+	 *  This function is used for building the matrices of every
+	 *  transform with glm.
+	 ***********************************************************/
+	void ComposeAllWithGlm(const TRANSFORM_ARRAYS& transforms, std::vector<glm::mat4>& matrices)
+	{
+		for (size_t i = 0; i < transforms.Size(); i++)
+		{
+			glm::vec3 scale, rotation, position;
+			transforms.Get(i, scale, rotation, position);
+			matrices[i] = ComposeWithGlm(scale, rotation, position);
+		}
+	}
+
+	/***********************************************************
+	 *  GetSupportedInstructionSets()
+	 *
+	 *  This function returns the kernels the CPU can run,
+	 *  slowest first, and leaves the fastest in use.
+	 ***********************************************************/
+	std::vector<TransformKernel::TRANSFORM_INSTRUCTION_SET> GetSupportedInstructionSets()
+	{
+		const TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSets[] =
+		{
+			TransformKernel::TRANSFORM_INSTRUCTIONS_SCALAR,
+			TransformKernel::TRANSFORM_INSTRUCTIONS_SSE2,
+			TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2
+		};
+
+		// asking for more than the CPU supports leaves the fastest
+		// it does support in use
+		std::vector<TransformKernel::TRANSFORM_INSTRUCTION_SET> supported;
+		for (TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSet : instructionSets)
+		{
+			TransformKernel::SetInstructionSet(instructionSet);
+			if (TransformKernel::GetInstructionSet() == instructionSet)
+			{
+				supported.push_back(instructionSet);
+			}
+		}
+
+		return(supported);
+	}
+
+	/***********************************************************
+	 *  ComposeWith()
+	 *
+	 *  This function is used for building a range of matrices
+	 *  with the passed in kernels, into matrices that start out
+	 *  as a value no kernel writes.
+	 ***********************************************************/
+	MATRIX_ARRAYS ComposeWith(TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSet,
+		const TRANSFORM_ARRAYS& transforms, size_t first, size_t count)
+	{
+		MATRIX_ARRAYS matrices;
+		matrices.Resize(transforms.Size());
+		for (std::vector<float>& element : matrices.elements)
+		{
+			std::fill(element.begin(), element.end(), -12345.0f);
+		}
+
+		TransformKernel::SetInstructionSet(instructionSet);
+		TransformKernel::ComposeTransforms(transforms, matrices, first, count);
+		return(matrices);
+	}
+
+	/***********************************************************
+	 *  MatchesBitForBit()
+	 *
+	 *  This function returns whether two sets of matrices hold
+	 *  the same bits.
+	 ***********************************************************/
+	bool MatchesBitForBit(const MATRIX_ARRAYS& first, const MATRIX_ARRAYS& second)
+	{
+		for (int element = 0; element < 16; element++)
+		{
+			if ((first.elements[element].size() != second.elements[element].size()) ||
+				(memcmp(first.elements[element].data(), second.elements[element].data(),
+					first.elements[element].size() * sizeof(float)) != 0))
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+}
+
+TEST_CASE(TransformKernelMatchesGlm)
+{
+	const size_t count = 10007;
+	TRANSFORM_ARRAYS transforms = RandomTransforms(count, 1);
+	std::vector<glm::mat4> expected(count);
+	ComposeAllWithGlm(transforms, expected);
+
+	for (TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSet : GetSupportedInstructionSets())
+	{
+		MATRIX_ARRAYS matrices = ComposeWith(instructionSet, transforms, 0, count);
+
+		// the rotation columns are off by a few units in the last
+		// place of the largest scale, glm's sines and cosines are
+		// rounded differently and it adds up more products
+		float largestError = 0.0f;
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::mat4 matrix = matrices.GetMatrix(i);
+			glm::vec3 scale, rotation, position;
+			transforms.Get(i, scale, rotation, position);
+			float largestScale = std::max(std::max(scale.x, scale.y), scale.z);
+
+			for (int column = 0; column < 3; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					float error = std::fabs(matrix[column][row] - expected[i][column][row]) / largestScale;
+					largestError = std::max(largestError, error);
+				}
+			}
+			CHECK(matrix[3] == expected[i][3]);
+		}
+		CHECK(largestError < 1e-6f);
+	}
+
+	TransformKernel::SetInstructionSet(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2);
+}
+
+TEST_CASE(TransformKernelInstructionSetsMatch)
+{
+	// counts and starts that leave transforms over after the
+	// groups of 4 and 8
+	const size_t count = 1003;
+	TRANSFORM_ARRAYS transforms = RandomTransforms(count, 2);
+	std::vector<TransformKernel::TRANSFORM_INSTRUCTION_SET> supported = GetSupportedInstructionSets();
+	CHECK(supported.front() == TransformKernel::TRANSFORM_INSTRUCTIONS_SCALAR);
+
+	const size_t ranges[][2] = { { 0, count }, { 1, 1 }, { 3, 13 }, { 5, 998 }, { 1000, 3 } };
+	for (const size_t* range : ranges)
+	{
+		MATRIX_ARRAYS reference = ComposeWith(TransformKernel::TRANSFORM_INSTRUCTIONS_SCALAR,
+			transforms, range[0], range[1]);
+		for (TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSet : supported)
+		{
+			CHECK(MatchesBitForBit(ComposeWith(instructionSet, transforms, range[0], range[1]), reference));
+		}
+
+		// the matrices outside the range are left alone
+		for (size_t i = 0; i < count; i++)
+		{
+			bool bInside = (i >= range[0]) && (i < range[0] + range[1]);
+			CHECK((reference.elements[15][i] == 1.0f) == bInside);
+		}
+	}
+
+	TransformKernel::SetInstructionSet(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2);
+}
+
+TEST_CASE(TransformKernelIgnoresBadRanges)
+{
+	TRANSFORM_ARRAYS transforms = RandomTransforms(10, 3);
+	MATRIX_ARRAYS matrices = ComposeWith(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2, transforms, 8, 3);
+	MATRIX_ARRAYS untouched = ComposeWith(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2, transforms, 0, 0);
+	CHECK(MatchesBitForBit(matrices, untouched));
+	CHECK(untouched.elements[15][0] == -12345.0f);
+
+	// matrices too small for the transforms
+	matrices.Resize(5);
+	TransformKernel::ComposeTransforms(transforms, matrices, 0, 10);
+	CHECK(matrices.elements[15][0] == -12345.0f);
+}
+
+BENCHMARK(TransformKernelAgainstGlm)
+{
+	std::vector<TransformKernel::TRANSFORM_INSTRUCTION_SET> supported = GetSupportedInstructionSets();
+
+	const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+	for (size_t count : counts)
+	{
+		TRANSFORM_ARRAYS transforms = RandomTransforms(count, 4);
+		std::vector<glm::mat4> glmMatrices(count);
+		MATRIX_ARRAYS matrices;
+		matrices.Resize(count);
+		int runs = (count >= 100000) ? 3 : 10;
+
+		std::cout << "translate * rotateZ * rotateY * rotateX * scale, " << count << " transforms:" << std::endl;
+		double glmMilliseconds = TimeMilliseconds([&]() { ComposeAllWithGlm(transforms, glmMatrices); }, runs);
+		std::cout << "- glm: " << (int)(glmMilliseconds * 1000.0) << " us" << std::endl;
+
+		for (TransformKernel::TRANSFORM_INSTRUCTION_SET instructionSet : supported)
+		{
+			TransformKernel::SetInstructionSet(instructionSet);
+			double milliseconds = TimeMilliseconds([&]()
+			{
+				TransformKernel::ComposeTransforms(transforms, matrices, 0, count);
+			}, runs);
+			std::cout << "- " << TransformKernel::GetInstructionSetName() << ": "
+				<< (int)(milliseconds * 1000.0) << " us, "
+				<< std::fixed << std::setprecision(1) << glmMilliseconds / milliseconds
+				<< " times as fast as glm" << std::endl;
+		}
+
+		// keeps the matrices from being optimized away
+		CHECK(matrices.elements[15][count - 1] == 1.0f);
+		CHECK(glmMatrices[count - 1][3][3] == 1.0f);
+	}
+
+	TransformKernel::SetInstructionSet(TransformKernel::TRANSFORM_INSTRUCTIONS_AVX2);
+}
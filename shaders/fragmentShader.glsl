@@ -4,6 +4,13 @@ out vec4 fragmentColor;
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+// surface of the object, set by the vertex shader
+flat in vec4 fragmentObjectColor;
+flat in vec2 fragmentUVscale;
+flat in int fragmentMaterialIndex;
+flat in int fragmentTextureArray;   // -1 to draw with the color
+flat in int fragmentTextureLayer;
+flat in int fragmentMirrorTexture;
 
 struct Material {
     vec3 diffuseColor;
@@ -49,28 +56,70 @@ struct SpotLight {
 };
 
 #define TOTAL_POINT_LIGHTS 5
+#define TOTAL_MATERIALS 32
+#define TOTAL_TEXTURE_ARRAYS 8
+
+// per-frame camera state, uploaded once per frame
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec3 flashlightPosition;
+    vec3 flashlightDirection;
+    bool bFlashlightActive;
+};
+
+// scene light sources - the spot light position, direction and
+// active flag are taken from the flashlight in FrameData
+layout (std140) uniform LightData
+{
+    DirectionalLight directionalLight;
+    PointLight pointLights[TOTAL_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
+// material table, selected per draw by the material index
+layout (std140) uniform MaterialData
+{
+    Material materials[TOTAL_MATERIALS];
+};
 
-uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
-uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
-
-// the scaled texture coordinate to use in calculations
-vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
+// every texture lives in a layer of one of the texture arrays
+uniform sampler2DArray textureArrays[TOTAL_TEXTURE_ARRAYS];
+
+// the surface of the object being drawn
+bool bUseTexture = false;
+vec4 objectColor = vec4(1.0f);
+int textureArray = 0;
+int textureLayer = 0;
+bool bMirrorTexture = false;
+
+// the material of the object being drawn
+Material material;
+// the object texture color for this fragment
+vec4 objectTextureColor = vec4(1.0f);
 
 // function prototypes
+vec4 SampleObjectTexture();
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void main()
 {   
+    material = materials[fragmentMaterialIndex];
+    bUseTexture = (fragmentTextureArray >= 0);
+    objectColor = fragmentObjectColor;
+    textureArray = fragmentTextureArray;
+    textureLayer = fragmentTextureLayer;
+    bMirrorTexture = (fragmentMirrorTexture != 0);
+    if(bUseTexture == true)
+    {
+        objectTextureColor = SampleObjectTexture();
+    }
+
     if(bUseLighting == true)
     {
         vec3 phongResult = vec3(0.0f);
@@ -98,14 +147,17 @@ void main()
             }
         } 
         // phase 3: spot light
-        if(spotLight.bActive == true)
+        if(bFlashlightActive == true)
         {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
+            SpotLight flashlight = spotLight;
+            flashlight.position = flashlightPosition;
+            flashlight.direction = flashlightDirection;
+            phongResult += CalcSpotLight(flashlight, norm, fragmentPosition, viewDir);    
         }
     
         if(bUseTexture == true)
         {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
+            fragmentColor = vec4(phongResult, objectTextureColor.a);
         }
         else
         {
@@ -116,7 +168,7 @@ void main()
     {
         if(bUseTexture == true)
         {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
+            fragmentColor = objectTextureColor;
         }
         else
         {
@@ -141,9 +193,9 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(objectTextureColor);
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectTextureColor);
+        specular = light.specular * spec * material.specularColor * vec3(objectTextureColor);
     }
     else
     {
@@ -173,8 +225,8 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(objectTextureColor);
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectTextureColor);
         specular = light.specular * specularComponent * material.specularColor;
     }
     else
@@ -210,9 +262,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     if(bUseTexture == true)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinateScaled));
+        ambient = light.ambient * vec3(objectTextureColor);
+        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectTextureColor);
+        specular = light.specular * spec * material.specularColor * vec3(objectTextureColor);
     }
     else
     {
@@ -226,3 +278,30 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
 }
+
+// sample the object texture from its layer of the selected texture array
+vec4 SampleObjectTexture()
+{
+    vec2 uv = fragmentTextureCoordinate * fragmentUVscale;
+    if(bMirrorTexture == true)
+    {
+        // mirrored repeat - every other repetition is flipped
+        vec2 t = mod(uv, 2.0f);
+        uv = mix(t, 2.0f - t, step(1.0f, t));
+    }
+    vec3 coord = vec3(uv, float(textureLayer));
+
+    // sampler arrays can only be indexed by constants in GLSL 3.30
+    switch(textureArray)
+    {
+        case 0: return texture(textureArrays[0], coord);
+        case 1: return texture(textureArrays[1], coord);
+        case 2: return texture(textureArrays[2], coord);
+        case 3: return texture(textureArrays[3], coord);
+        case 4: return texture(textureArrays[4], coord);
+        case 5: return texture(textureArrays[5], coord);
+        case 6: return texture(textureArrays[6], coord);
+        case 7: return texture(textureArrays[7], coord);
+    }
+    return vec4(1.0f);
+}
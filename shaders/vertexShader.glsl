@@ -2,19 +2,114 @@
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance data of instanced draws, the model matrix takes locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVscale;
+// material index, texture array (-1 for the color), texture layer, mirror flag
+layout (location = 9) in ivec4 inInstanceSurface;
+// offset and scale packed vertices are decoded with, the offset's w is 0
+// for vertices that are full floats
+layout (location = 10) in vec4 inInstanceDecodeOffset;
+layout (location = 11) in vec4 inInstanceDecodeScale;
+// columns of the inverse transpose of the model matrix, declared one by
+// one since a mat3 attribute is read back wrong by some drivers
+layout (location = 12) in vec3 inInstanceNormalColumn0;
+layout (location = 13) in vec3 inInstanceNormalColumn1;
+layout (location = 14) in vec3 inInstanceNormalColumn2;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// the same for every fragment of a draw, so not interpolated
+flat out vec4 fragmentObjectColor;
+flat out vec2 fragmentUVscale;
+flat out int fragmentMaterialIndex;
+flat out int fragmentTextureArray;
+flat out int fragmentTextureLayer;
+flat out int fragmentMirrorTexture;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// the inverse transpose of the model, computed once per draw on the CPU
+uniform mat3 normalMatrix = mat3(1.0f);
+uniform vec4 objectColor = vec4(1.0f);
+uniform bool bUseTexture = false;
+uniform int textureArray = 0;
+uniform int textureLayer = 0;
+uniform bool bMirrorTexture = false;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform int materialIndex = 0;
+uniform vec4 decodeOffset = vec4(0.0f);
+uniform vec4 decodeScale = vec4(1.0f);
+// true to take the model and surface of the object from the instance
+// attributes instead of the uniforms above
+uniform bool bInstanced = false;
+
+// per-frame camera state, shared with the fragment shader
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    vec3 flashlightPosition;
+    vec3 flashlightDirection;
+    bool bFlashlightActive;
+};
+
+// unfold a normal packed onto the octahedron
+vec3 DecodeOctahedral(vec2 folded)
+{
+   vec3 normal = vec3(folded, 1.0f - abs(folded.x) - abs(folded.y));
+   if(normal.z < 0.0f)
+   {
+      vec2 signs = vec2((normal.x >= 0.0f) ? 1.0f : -1.0f, (normal.y >= 0.0f) ? 1.0f : -1.0f);
+      normal.xy = (1.0f - abs(normal.yx)) * signs;
+   }
+   return(normalize(normal));
+}
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
-   fragmentTextureCoordinate = inTextureCoordinate;
+   mat4 objectModel = model;
+   mat3 objectNormalMatrix = normalMatrix;
+   vec4 vertexDecodeOffset = decodeOffset;
+   vec4 vertexDecodeScale = decodeScale;
+   fragmentObjectColor = objectColor;
+   fragmentUVscale = UVscale;
+   fragmentMaterialIndex = materialIndex;
+   fragmentTextureArray = (bUseTexture == true) ? textureArray : -1;
+   fragmentTextureLayer = textureLayer;
+   fragmentMirrorTexture = (bMirrorTexture == true) ? 1 : 0;
+   if(bInstanced == true)
+   {
+      objectModel = inInstanceModel;
+      objectNormalMatrix = mat3(inInstanceNormalColumn0, inInstanceNormalColumn1, inInstanceNormalColumn2);
+      fragmentObjectColor = inInstanceColor;
+      fragmentUVscale = inInstanceUVscale;
+      fragmentMaterialIndex = inInstanceSurface.x;
+      fragmentTextureArray = inInstanceSurface.y;
+      fragmentTextureLayer = inInstanceSurface.z;
+      fragmentMirrorTexture = inInstanceSurface.w;
+      vertexDecodeOffset = inInstanceDecodeOffset;
+      vertexDecodeScale = inInstanceDecodeScale;
+   }
+
+   // packed positions are stored in the box of their mesh, normals
+   // folded onto the octahedron and UVs divided by the largest one
+   vec3 vertexPosition = inVertexPosition;
+   vec3 vertexNormal = inVertexNormal;
+   vec2 textureCoordinate = inTextureCoordinate;
+   if(vertexDecodeOffset.w != 0.0f)
+   {
+      vertexPosition = vertexDecodeOffset.xyz + vertexDecodeScale.xyz * inVertexPosition;
+      vertexNormal = DecodeOctahedral(inVertexNormal.xy);
+      textureCoordinate = inTextureCoordinate * vertexDecodeScale.w;
+   }
+
+   fragmentPosition = vec3(objectModel * vec4(vertexPosition, 1.0));
+   gl_Position = projection * view * objectModel * vec4(vertexPosition, 1.0f);
+   // normals are moved into world space by the inverse transpose of the
+   // model, the same transform the baked static geometry is given
+   fragmentVertexNormal = normalize(objectNormalMatrix * vertexNormal);
+   fragmentTextureCoordinate = textureCoordinate;
 }
\ No newline at end of file